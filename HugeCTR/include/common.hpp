@@ -70,7 +70,7 @@ enum class Error_t {
   EndOfFile
 };
 
-enum class Check_t { Sum, None };
+enum class Check_t { Sum, None, CRC32C };
 
 enum class DataReaderSparse_t { Distributed, Localized };
 
@@ -412,4 +412,16 @@ struct DataReaderSparseParam {
   }
 };
 
+/**
+ * The shuffle buffer of the Norm data reader, which draws the samples of several open files of
+ * each worker at random from a pool of decoded samples.
+ */
+struct ShuffleBufferParam {
+  size_t memory_bytes{0}; /**< the pools of all the workers, 0 to read the samples in order */
+  int num_open_files{1};  /**< the files each worker reads at the same time */
+  unsigned long long seed{0};
+
+  bool enabled() const { return memory_bytes > 0; }
+};
+
 }  // namespace HugeCTR
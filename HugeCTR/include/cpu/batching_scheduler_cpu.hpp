@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cpu/session_inference_cpu.hpp>
+
+namespace HugeCTR {
+
+/**
+ * Histograms of a BatchingSchedulerCPU.
+ */
+struct BatchingStatsCPU {
+  size_t num_requests = 0;
+  size_t num_batches = 0;
+  /**
+   * bucket 0 counts the requests that waited less than 1us in the queue, bucket i > 0 those that
+   * waited in [2^(i-1), 2^i) us, the last bucket everything longer.
+   */
+  std::vector<size_t> queue_wait_us_histogram;
+  /**
+   * bucket i counts the batches filled to [i, i+1) / (size - 1) of max_batchsize, the last
+   * bucket the full batches.
+   */
+  std::vector<size_t> batch_fill_histogram;
+
+  std::string to_string() const;
+};
+
+/**
+ * Dynamic batching front-end of an InferenceSessionCPU.
+ * predict queues the request. Worker threads merge queued requests into batches of up to
+ * max_batchsize samples, run 1 predict per batch on the filled rows only, then scatter the
+ * predictions back to the requests. A batch is sent once it is full or once its oldest request
+ * waited max_queue_delay_us.
+ */
+template <typename TypeHashKey>
+class BatchingSchedulerCPU {
+ public:
+  static constexpr size_t kNumQueueWaitBuckets = 24;
+  static constexpr size_t kNumBatchFillBuckets = 11;
+
+  /**
+   * @param session the session to run the batches on, it must outlive the scheduler
+   * @param max_queue_delay_us the latency budget a request may spend waiting for other requests
+   * @param num_workers the number of batches in flight, the session needs as many workspaces
+   */
+  BatchingSchedulerCPU(InferenceSessionCPU<TypeHashKey>& session, size_t max_queue_delay_us,
+                       size_t num_workers = 1);
+  ~BatchingSchedulerCPU();
+  BatchingSchedulerCPU(const BatchingSchedulerCPU&) = delete;
+  BatchingSchedulerCPU& operator=(const BatchingSchedulerCPU&) = delete;
+
+  /**
+   * Same arguments as InferenceSessionCPU::predict, with the row_ptrs of the num_samples samples
+   * only. Blocks until the predictions are in h_output, can be called from any thread.
+   */
+  void predict(const float* h_dense, const void* h_embeddingcolumns, const int* h_row_ptrs,
+               float* h_output, int num_samples);
+
+  BatchingStatsCPU get_stats();
+  void reset_stats();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Request {
+    const float* h_dense;
+    const TypeHashKey* h_embeddingcolumns;
+    const int* h_row_ptrs;
+    float* h_output;
+    size_t num_samples;
+    Clock::time_point enqueue_time;
+    std::promise<void> done;
+  };
+
+  // the merged input of 1 batch
+  struct Batch {
+    std::vector<float> h_dense;
+    std::vector<TypeHashKey> h_embeddingcolumns;
+    std::vector<int> h_row_ptrs;
+    std::vector<float> h_output;
+  };
+
+  InferenceSessionCPU<TypeHashKey>& session_;
+  const size_t max_batchsize_;
+  const size_t dense_dim_;
+  const size_t slot_num_;
+  const std::chrono::microseconds max_queue_delay_;
+
+  std::deque<Request*> queue_;
+  size_t num_queued_samples_;
+  bool stopped_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::thread> workers_;
+
+  std::mutex stats_mutex_;
+  BatchingStatsCPU stats_;
+
+  void worker_();
+  void run_batch_(const std::vector<Request*>& requests, Batch& batch);
+};
+
+}  // namespace HugeCTR
@@ -28,7 +28,8 @@ void create_pipeline_cpu(const nlohmann::json& config,
                       std::vector<std::shared_ptr<Tensor2<float>>>& embeddingvecs,
                       std::vector<size_t>& embedding_table_slot_size,
                       std::vector<std::shared_ptr<LayerCPU>>* embeddings, NetworkCPU** network,
-                      const std::shared_ptr<CPUResource>& cpu_resource);
+                      const std::shared_ptr<CPUResource>& cpu_resource,
+                      const NetworkCPU* weight_source = nullptr);
 
 template <typename TypeEmbeddingComp>
 void create_pipeline_inference_cpu(const nlohmann::json& config,
@@ -39,6 +40,7 @@ void create_pipeline_inference_cpu(const nlohmann::json& config,
                                   std::vector<size_t>& embedding_table_slot_size,
                                   std::vector<std::shared_ptr<LayerCPU>>* embeddings,
                                   NetworkCPU** network,
-                                  const std::shared_ptr<CPUResource>& cpu_resource);
+                                  const std::shared_ptr<CPUResource>& cpu_resource,
+                      const NetworkCPU* weight_source = nullptr);
 
 } // namespace HugeCTR
\ No newline at end of file
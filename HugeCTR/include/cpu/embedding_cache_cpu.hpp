@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <common.hpp>
+#include <inference/inference_utils.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * Host memory embedding cache of the CPU inference path, the counterpart of the GPU
+ * embedding_cache. It sits between InferenceSessionCPU and the parameter server: hot keys are
+ * served from a set-associative cache per embedding table and only the missing keys are looked
+ * up from the parameter server, then inserted into the cache.
+ * 1 instance per model, it can be shared by all the InferenceSessionCPU of that model.
+ */
+template <typename TypeHashKey>
+class EmbeddingCacheCPU {
+ public:
+  /**
+   * Ctor of EmbeddingCacheCPU. The capacity of each table is host_cache_size_percentage of the
+   * keys in its sparse model file, in sets of host_cache_set_associativity ways. LFU counters
+   * are halved every host_cache_lfu_aging_queries_per_way queries per way.
+   * @param model_config_path the inference model configuration file
+   * @param inference_params the inference parameters of the model
+   * @param parameter_server the parameter server to look up the missing keys from
+   */
+  EmbeddingCacheCPU(const std::string& model_config_path, const InferenceParams& inference_params,
+                    const std::shared_ptr<HugectrUtility<TypeHashKey>>& parameter_server);
+
+  /**
+   * Ctor of EmbeddingCacheCPU with an explicit geometry.
+   * @param model_name the model name to query the parameter server with
+   * @param embedding_vec_size the emb_vec size of each embedding table
+   * @param capacity the number of emb_vec cached for each embedding table
+   * @param set_associativity the number of ways per set
+   * @param eviction_policy which way of a full set is evicted on insert
+   * @param parameter_server the parameter server to look up the missing keys from
+   * @param lfu_aging_queries_per_way LFU counters are halved each time a table has served this
+   * many queries per way, 0 disables the aging
+   */
+  EmbeddingCacheCPU(const std::string& model_name, const std::vector<size_t>& embedding_vec_size,
+                    const std::vector<size_t>& capacity, size_t set_associativity,
+                    CacheEvictionPolicy_t eviction_policy,
+                    const std::shared_ptr<HugectrUtility<TypeHashKey>>& parameter_server,
+                    size_t lfu_aging_queries_per_way = 8);
+
+  DISALLOW_COPY_AND_MOVE(EmbeddingCacheCPU)
+
+  /**
+   * Look up the emb_vec of the keys of one embedding table. Thread-safe.
+   * @param h_embeddingcolumns the keys to query
+   * @param length the number of keys
+   * @param h_embeddingoutputvector the output buffer, length * embedding_vec_size
+   * @param embedding_table_id which embedding table the keys belong to
+   * @param h_hit_rate if not nullptr, receives the hit rate of this query
+   */
+  void look_up(const TypeHashKey* h_embeddingcolumns, size_t length,
+               float* h_embeddingoutputvector, size_t embedding_table_id,
+               double* h_hit_rate = nullptr);
+
+  /**
+   * The hit rate of an embedding table over all the queries since construction.
+   */
+  double get_hit_rate(size_t embedding_table_id) const;
+
+  size_t get_num_embedding_tables() const { return tables_.size(); }
+
+ private:
+  struct CacheTable {
+    size_t embedding_vec_size;
+    size_t num_sets;
+    // Ways of set s are [s * set_associativity_, (s + 1) * set_associativity_)
+    std::vector<TypeHashKey> keys;
+    // 0: empty way; LRU: tick of the last access; LFU: number of accesses, halved once per aging
+    // period so that keys which used to be hot do not stay cached forever
+    std::vector<uint64_t> counters;
+    std::vector<float> values;
+    std::unique_ptr<std::mutex[]> set_locks;
+    // LFU only: the number of queries between two halvings (0: no aging), and the aging epoch
+    // each set has been aged to. Sets are aged lazily, the next time they are locked.
+    uint64_t aging_period;
+    std::vector<uint64_t> set_epochs;
+    std::atomic<uint64_t> num_hits{0};
+    std::atomic<uint64_t> num_queries{0};
+  };
+
+  void init_(const std::vector<size_t>& embedding_vec_size, const std::vector<size_t>& capacity);
+  // Copy the cached emb_vec of the key to dst and return true on hit
+  bool query_(CacheTable& table, TypeHashKey key, float* dst);
+  void insert_(CacheTable& table, TypeHashKey key, const float* src);
+  // Halve the LFU counters of the set once per aging period elapsed since it was last aged.
+  // The caller holds the lock of the set.
+  void age_set_(CacheTable& table, size_t set);
+  uint64_t touch_(uint64_t counter) {
+    return eviction_policy_ == CacheEvictionPolicy_t::LRU ? ++clock_ : counter + 1;
+  }
+
+  std::string model_name_;
+  size_t set_associativity_;
+  CacheEvictionPolicy_t eviction_policy_;
+  size_t lfu_aging_queries_per_way_;
+  std::shared_ptr<HugectrUtility<TypeHashKey>> parameter_server_;
+  std::vector<std::unique_ptr<CacheTable>> tables_;
+  // The LRU clock, shared by all the tables
+  std::atomic<uint64_t> clock_;
+};
+
+}  // namespace HugeCTR
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <common.hpp>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * Micro-kernel family of gemm_cpu. The best one the host supports is picked at runtime.
+ */
+enum class GemmIsaCPU { Scalar, AVX2, AVX512 };
+
+/**
+ * Activation fused into the output tile of gemm_cpu.
+ */
+enum class GemmActivationCPU { None, Relu };
+
+/**
+ * @return the best GemmIsaCPU supported by the host
+ */
+GemmIsaCPU get_gemm_isa_cpu();
+
+/**
+ * @return whether the host can run the micro-kernels of isa
+ */
+bool is_gemm_isa_supported_cpu(GemmIsaCPU isa);
+
+/**
+ * Round a float to the nearest bf16, ties to even.
+ * @return the bits of the bf16
+ */
+inline uint16_t float_to_bf16_cpu(float v) {
+  uint32_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  if ((bits & 0x7fffffffu) > 0x7f800000u) {
+    return static_cast<uint16_t>((bits >> 16) | 0x40u);  // keep NaN a quiet NaN
+  }
+  bits += 0x7fffu + ((bits >> 16) & 1u);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+/**
+ * Convert IEEE half precision values, like the bits of __half, to float.
+ */
+void half_to_float_cpu(const uint16_t* src, float* dst, size_t n);
+
+/**
+ * Convert floats to IEEE half precision values, rounding to the nearest even.
+ */
+void float_to_half_cpu(const float* src, uint16_t* dst, size_t n);
+
+/**
+ * The k x n right hand side of gemm_cpu, packed once into panels of kPanelWidth columns.
+ * Row p of a panel is kPanelWidth contiguous elements, and the last panel is zero padded,
+ * so a micro-kernel streams any k-block of a panel sequentially.
+ * The panels hold either floats or bf16. bf16 panels halve the memory traffic of the kernel
+ * and are widened to float by the micro-kernels.
+ */
+class PackedMatrixCPU {
+ public:
+  static constexpr size_t kPanelWidth = 16;
+
+  PackedMatrixCPU() : k_(0), n_(0), bf16_(false) {}
+
+  /**
+   * Pack a row-major k x n matrix, converting each element to float with conv.
+   * @param b the matrix, with a leading dimension of n
+   * @param k the number of rows
+   * @param n the number of columns
+   * @param conv the conversion to float
+   * @param bf16 whether to store the panels as bf16
+   */
+  template <typename T, typename Convert>
+  void pack(const T* b, size_t k, size_t n, Convert conv, bool bf16 = false) {
+    k_ = k;
+    n_ = n;
+    bf16_ = bf16;
+    if (bf16) {
+      data_.clear();
+      data_bf16_.assign(get_num_panels() * k * kPanelWidth, 0);
+      pack_panels_(b, data_bf16_.data(), [&conv](const T& v) { return float_to_bf16_cpu(conv(v)); });
+    } else {
+      data_bf16_.clear();
+      data_.assign(get_num_panels() * k * kPanelWidth, 0.0f);
+      pack_panels_(b, data_.data(), conv);
+    }
+  }
+
+  void pack(const float* b, size_t k, size_t n, bool bf16 = false) {
+    pack(b, k, n, [](float v) { return v; }, bf16);
+  }
+
+  bool empty() const { return data_.empty() && data_bf16_.empty(); }
+  bool is_bf16() const { return bf16_; }
+  size_t get_k() const { return k_; }
+  size_t get_n() const { return n_; }
+  size_t get_num_panels() const { return (n_ + kPanelWidth - 1) / kPanelWidth; }
+  size_t get_size_in_bytes() const {
+    return data_.size() * sizeof(float) + data_bf16_.size() * sizeof(uint16_t);
+  }
+  const float* get_panel(size_t panel) const { return data_.data() + panel * k_ * kPanelWidth; }
+  const uint16_t* get_panel_bf16(size_t panel) const {
+    return data_bf16_.data() + panel * k_ * kPanelWidth;
+  }
+
+ private:
+  size_t k_;
+  size_t n_;
+  bool bf16_;
+  std::vector<float> data_;
+  std::vector<uint16_t> data_bf16_;
+
+  template <typename T, typename U, typename Convert>
+  void pack_panels_(const T* b, U* data, Convert conv) {
+#pragma omp parallel for
+    for (size_t panel = 0; panel < get_num_panels(); panel++) {
+      const size_t col = panel * kPanelWidth;
+      const size_t width = std::min(kPanelWidth, n_ - col);
+      U* dst = data + panel * k_ * kPanelWidth;
+      for (size_t p = 0; p < k_; p++) {
+        for (size_t j = 0; j < width; j++) {
+          dst[p * kPanelWidth + j] = conv(b[p * n_ + col + j]);
+        }
+      }
+    }
+  }
+};
+
+/**
+ * c = act(a * b + bias), computed tile by tile with register-blocked micro-kernels.
+ * Bias, activation and the pre-activation copy are applied to each output tile while it is
+ * still in cache. Tiles are spread across the OpenMP threads once the product is large enough.
+ * @param a the row-major m x b.get_k() left hand side, with a leading dimension of lda
+ * @param lda the leading dimension of a
+ * @param m the number of rows of a and c
+ * @param b the packed right hand side
+ * @param bias b.get_n() floats added to each row of c, or nullptr
+ * @param act the activation
+ * @param c receives the row-major m x b.get_n() result, with a leading dimension of ldc
+ * @param ldc the leading dimension of c and c_pre_act
+ * @param c_pre_act receives a * b + bias before the activation, or nullptr
+ * @param isa the micro-kernel family, which must be supported by the host
+ */
+void gemm_cpu(const float* a, size_t lda, size_t m, const PackedMatrixCPU& b, const float* bias,
+              GemmActivationCPU act, float* c, size_t ldc, float* c_pre_act = nullptr,
+              GemmIsaCPU isa = get_gemm_isa_cpu());
+
+}  // namespace HugeCTR
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <fstream>
 #include <functional>
 #include <string>
@@ -37,6 +38,44 @@ class LayerCPU {
    */
   Tensors2<float> weights_;
 
+  /*
+   * the number of leading samples of the batch that fprop computes, 0 for the whole batch.
+   */
+  size_t active_batch_size_ = 0;
+
+  /*
+   * the batch size of the tensors, 0 if it is the leading dimension of all of them.
+   */
+  size_t max_batch_size_ = 0;
+
+  /*
+   * @return the number of rows to compute out of rows, the leading dimension of a tensor. A tensor
+   * of rows * max_batch_size_ rows, like the output of a reshape, holds the rows of a sample one
+   * after the other, and a tensor whose rows are not a multiple of the batch is computed whole.
+   */
+  size_t get_active_batch_size(size_t rows) const {
+    if (active_batch_size_ == 0) {
+      return rows;
+    }
+    if (max_batch_size_ == 0 || rows == max_batch_size_) {
+      return std::min(active_batch_size_, rows);
+    }
+    if (rows % max_batch_size_ != 0) {
+      return rows;
+    }
+    return std::min(active_batch_size_, max_batch_size_) * (rows / max_batch_size_);
+  }
+
+  /*
+   * @return the number of elements of the active rows of a tensor, see get_active_batch_size
+   */
+  template <typename T>
+  size_t get_active_num_elements(const Tensor2<T>& tensor) const {
+    const size_t batch_size = tensor.get_dimensions()[0];
+    return batch_size == 0 ? 0
+                           : tensor.get_num_elements() / batch_size * get_active_batch_size(batch_size);
+  }
+
  public:
   /*
    * Forward pass
@@ -59,6 +98,29 @@ class LayerCPU {
    */
   virtual void initialize() {}
 
+  /*
+   * Called once the weights are overwritten, so that layers can refresh the state they derive
+   * from them, like the packed weights of the fully connected layers
+   */
+  virtual void on_weights_updated() {}
+
+  /*
+   * Called instead of on_weights_updated on a layer whose weights alias those of source, the
+   * same layer of another network, so that it can share what source derived from them
+   */
+  virtual void share_weights_from(const LayerCPU& source) {}
+
+  /*
+   * Only compute the first batch_size samples in the next fprop, the content of the other rows of
+   * the outputs is undefined. 0 computes the whole batch again.
+   * @param max_batch_size the batch size of the tensors, so that the active rows of a tensor with
+   * several rows per sample are scaled, 0 if the leading dimension of every tensor is the batch
+   */
+  void set_active_batch_size(size_t batch_size, size_t max_batch_size = 0) {
+    active_batch_size_ = batch_size;
+    max_batch_size_ = max_batch_size;
+  }
+
 };
 
 }  // namespace HugeCTR
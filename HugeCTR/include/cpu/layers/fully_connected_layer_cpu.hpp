@@ -18,6 +18,7 @@
 
 #include <functional>
 #include <vector>
+#include <cpu/gemm_cpu.hpp>
 #include <cpu/layer_cpu.hpp>
 
 namespace HugeCTR {
@@ -50,6 +51,10 @@ class FullyConnectedLayerCPU<float> : public LayerCPU {
    * stores the references to the output tensors of this layer.
    */
   Tensors2<float> out_tensors_;
+  /*
+   * the kernel packed for gemm_cpu.
+   */
+  std::shared_ptr<const PackedMatrixCPU> packed_kernel_;
 
   Tensors2<float>& get_in_tensors(bool is_train) { return in_tensors_; }
 
@@ -63,6 +68,16 @@ class FullyConnectedLayerCPU<float> : public LayerCPU {
    */
   void bprop() final;
 
+  /**
+   * repack the kernel for gemm_cpu
+   */
+  void on_weights_updated() final;
+
+  /**
+   * share the packed kernel of source
+   */
+  void share_weights_from(const LayerCPU& source) final;
+
   /**
    * This is the constructor of the FullyConnectedLayer.
    * It will check whether the format combination of all tensors is supported or not.
@@ -19,6 +19,7 @@
 #include <functional>
 #include <vector>
 
+#include <cpu/gemm_cpu.hpp>
 #include <cpu/layer_cpu.hpp>
 #include <cpu/layers/fully_connected_layer_cpu.hpp>
 
@@ -55,6 +56,23 @@ class FullyConnectedLayerCPU<__half> : public LayerCPU {
    */
   Tensor2<__half> identity_tensor_;
 
+  /*
+   * the kernel packed for gemm_cpu, the fp32 bias, and the fp32 copies of the bottom and top
+   * tensors it runs on.
+   */
+  std::shared_ptr<const PackedMatrixCPU> packed_kernel_;
+  std::vector<float> bias_fp32_;
+  std::vector<float> bottom_fp32_;
+  std::vector<float> top_fp32_;
+  /*
+   * whether packed_kernel_ holds bf16 instead of fp32.
+   */
+  const bool use_bf16_packed_weights_;
+
+  /*
+   * the bias rounded like the weights, from the master weights.
+   */
+  void update_bias_fp32_();
 
   Tensor2<__half>& get_bottom_tensor(bool is_train) { return bottom_tensor_; }
 
@@ -68,6 +86,16 @@ class FullyConnectedLayerCPU<__half> : public LayerCPU {
    */
   void bprop() final;
 
+  /**
+   * repack the kernel for gemm_cpu
+   */
+  void on_weights_updated() final;
+
+  /**
+   * share the packed kernel of source
+   */
+  void share_weights_from(const LayerCPU& source) final;
+
   /**
    * This is the constructor of the FullyConnectedLayer.
    * It will check whether the format combination of all tensors is supported or not.
@@ -78,6 +106,8 @@ class FullyConnectedLayerCPU<__half> : public LayerCPU {
    * @param wgrad_buff: stores the gradient values of the weight calculated in backward pass
    * @param bottom_tensor: stores the tensor from bottom layer
    * @param top_tensor: stores the tensor to top layer
+   * @param use_bf16_packed_weights: keep the packed kernel as bf16, which halves its memory
+   * traffic but rounds the weights to bf16 instead of fp16
    * @param tensor_format: specifies the format of the weight tensor, either HW (row major) or WH
    * (col-major)
    */
@@ -86,7 +116,8 @@ class FullyConnectedLayerCPU<__half> : public LayerCPU {
       const std::shared_ptr<BufferBlock2<__half>>& weights_buff,
       const std::shared_ptr<BufferBlock2<__half>>& weights_grad_buff,
       const std::shared_ptr<GeneralBuffer2<HostAllocator>>& blobs_buff,
-      const Tensor2<__half>& bottom_tensor, const Tensor2<__half>& top_tensor);
+      const Tensor2<__half>& bottom_tensor, const Tensor2<__half>& top_tensor,
+      bool use_bf16_packed_weights = false);
   FullyConnectedLayerCPU(const FullyConnectedLayerCPU&) = delete;
   FullyConnectedLayerCPU& operator=(const FullyConnectedLayerCPU&);
 };
@@ -44,6 +44,12 @@ class NetworkCPU {
 
   Tensor2<float> pred_tensor_;
 
+  /*
+   * holds the weights and their gradients, aliased from weight_source_ if the network has one
+   */
+  std::shared_ptr<GeneralBuffer2<HostAllocator>> weight_buffer_;
+  const NetworkCPU* weight_source_;
+
   std::shared_ptr<CPUResource> cpu_resource_;
   // std::shared_ptr<GPUResource> gpu_resource_; /**< gpu resource */
 
@@ -79,8 +85,9 @@ class NetworkCPU {
 
   /**
    * Forward only for inference.
+   * @param num_samples only the first num_samples rows of the batch are computed, 0 for all
    */
-  void predict();
+  void predict(size_t num_samples = 0);
 
   /**
    * Get the pred tensor for inference.
@@ -94,7 +101,8 @@ class NetworkCPU {
 
 
   /**
-   * Read parameters from model_file.
+   * Read parameters from model_file. It is an error on a network that shares the weights of
+   * another one, load them into the source network instead.
    */
   void load_params_from_model(const std::string& model_file);
 
@@ -103,13 +111,24 @@ class NetworkCPU {
    */
   void initialize();
 
+  /**
+   * Refresh what is derived from the weights: their __half copy and the packed kernels of the
+   * layers. load_params_from_model calls it, call it again after modifying the weights directly.
+   * A network that shares the weights of another one picks up what the source derived instead,
+   * so call it on the source first.
+   */
+  void on_weights_updated();
+
   /**
    * factory method to create network
+   * @param weight_source if not nullptr, a network created from the same config whose weights
+   * are shared instead of allocated. It must outlive the new network.
    */
   static NetworkCPU* create_network(const nlohmann::json& j_array,
                                  std::vector<TensorEntry>& tensor_entries,
                                  const std::shared_ptr<CPUResource>& cpu_resource,
-                                 bool use_mixed_precision);
+                                 bool use_mixed_precision, bool use_bf16_packed_weights = false,
+                                 const NetworkCPU* weight_source = nullptr);
 };
 
 }  // namespace HugeCTR
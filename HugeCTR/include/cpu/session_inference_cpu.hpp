@@ -15,6 +15,8 @@
  */
 
 #pragma once
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
@@ -28,6 +30,8 @@
 
 #include <cpu/network_cpu.hpp>
 #include <cpu/embedding_feature_combiner_cpu.hpp>
+#include <cpu/embedding_cache_cpu.hpp>
+#include <cpu/unique_op_cpu.hpp>
 
 
 namespace HugeCTR {
@@ -35,38 +39,75 @@ namespace HugeCTR {
 template <typename TypeHashKey>
 class InferenceSessionCPU : public HugeCTRModel {
 private:
+  /*
+   * Everything 1 predict writes to. The network of workspace 0 owns the dense weights, the
+   * networks of the other workspaces share them.
+   */
+  struct Workspace {
+    std::vector<std::shared_ptr<Tensor2<int>>> row_ptrs_tensors;
+    std::vector<std::shared_ptr<Tensor2<float>>> embedding_features_tensors;
+    Tensor2<float> dense_input_tensor;
+
+    std::vector<std::shared_ptr<LayerCPU>> embedding_feature_combiners;
+    std::unique_ptr<NetworkCPU> network;
+
+    std::vector<size_t> h_embedding_offset;
+    std::vector<float> h_embeddingvectors;
+    std::vector<TypeHashKey> h_shuffled_embeddingcolumns;
+    std::vector<size_t> h_shuffled_embedding_offset;
+    // de-duplicated keys of one embedding table, their emb_vec, and the index of each queried key
+    // into them
+    std::unique_ptr<UniqueOpCPU<TypeHashKey>> unique_op;
+    std::vector<TypeHashKey> h_unique_embeddingcolumns;
+    std::vector<uint64_t> h_unique_index;
+    std::vector<float> h_unique_embeddingvectors;
+    std::vector<double> h_hit_rate;
+  };
+
   nlohmann::json config_;
   std::string model_name_;
   std::vector<size_t> embedding_table_slot_size_;
 
-  std::vector<std::shared_ptr<Tensor2<int>>> row_ptrs_tensors_;
-  std::vector<std::shared_ptr<Tensor2<float>>> embedding_features_tensors_;
-  Tensor2<float> dense_input_tensor_;
-
-  std::vector<std::shared_ptr<LayerCPU>> embedding_feature_combiners_;
-  std::unique_ptr<NetworkCPU> network_;
   std::shared_ptr<HugectrUtility<TypeHashKey>> parameter_server_;
+  std::shared_ptr<EmbeddingCacheCPU<TypeHashKey>> embedding_cache_;
 
-  std::vector<size_t> h_embedding_offset_;
-  std::vector<int*> h_row_ptrs_vec_;
+  // workspace pool, it grows on demand up to max_num_workspaces_
+  std::vector<std::unique_ptr<Workspace>> workspaces_;
+  std::vector<Workspace*> free_workspaces_;
+  size_t num_workspaces_;
+  size_t max_num_workspaces_;
+  size_t num_in_flight_;
+  int num_threads_;
+  std::mutex workspace_mutex_;
+  std::condition_variable workspace_cv_;
+  std::vector<double> h_hit_rate_;
 
-  float* h_embeddingvectors_;
-  void* h_shuffled_embeddingcolumns_;
-  size_t* h_shuffled_embedding_offset_;
-  
   std::shared_ptr<CPUResource> cpu_resource_;
-  
-  void separate_keys_by_table_(int* h_row_ptrs, const std::vector<size_t>& embedding_table_slot_size, int num_samples);
-  void look_up_(const void* h_embeddingcolumns, const std::vector<size_t>& h_embedding_offset, float* h_embeddingvectors);
+
+  std::unique_ptr<Workspace> create_workspace_(const NetworkCPU* weight_source);
+  Workspace* checkout_workspace_();
+  void checkin_workspace_(Workspace* workspace);
+  void separate_keys_by_table_(Workspace& workspace, int* h_row_ptrs, const std::vector<size_t>& embedding_table_slot_size, int num_samples);
+  void look_up_(Workspace& workspace, const void* h_embeddingcolumns);
 
 protected:
   InferenceParser inference_parser_;
   InferenceParams inference_params_;
 
 public:
-  InferenceSessionCPU(const std::string& model_config_path, const InferenceParams& inference_params, std::shared_ptr<HugectrUtility<TypeHashKey>>& ps);
+  // embedding_cache can be shared by the sessions of the same model, if it is nullptr and
+  // inference_params.use_host_embedding_cache is set, the session creates its own cache
+  InferenceSessionCPU(const std::string& model_config_path, const InferenceParams& inference_params, std::shared_ptr<HugectrUtility<TypeHashKey>>& ps,
+                      const std::shared_ptr<EmbeddingCacheCPU<TypeHashKey>>& embedding_cache = nullptr);
   virtual ~InferenceSessionCPU();
+  // predict can be called from several threads at once, each call uses its own workspace and the
+  // OpenMP threads are split between the calls in flight. Only the num_samples samples are computed,
+  // and num_samples predictions are written to h_output
   void predict(float* h_dense, void* h_embeddingcolumns, int* h_row_ptrs, float* h_output, int num_samples);
+  // Host embedding cache hit rate of each embedding table in the last predict
+  std::vector<double> get_hit_rate();
+  const InferenceParser& get_inference_parser() const { return inference_parser_; }
+  const InferenceParams& get_inference_params() const { return inference_params_; }
 };
 
 }  // namespace HugeCTR
\ No newline at end of file
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * Host counterpart of unique_op: de-duplicate the keys of a query before they are looked up.
+ * Keys go through an open-addressing hash table that is allocated once for the capacity and
+ * reused across calls. Each call only probes the first power of two slots >= 2 * len, so that
+ * small queries stay in cache however large the capacity is.
+ */
+template <typename TypeHashKey>
+class UniqueOpCPU {
+ public:
+  /**
+   * Ctor of UniqueOpCPU.
+   * @param capacity the max number of keys of a single unique call
+   */
+  UniqueOpCPU(size_t capacity);
+
+  DISALLOW_COPY(UniqueOpCPU)
+
+  size_t get_capacity() const { return capacity_; }
+
+  /**
+   * Unique operation.
+   * @param h_key the keys to de-duplicate
+   * @param len the number of keys, at most get_capacity()
+   * @param h_output_index receives, for each key, the position of the key in h_unique_key
+   * @param h_unique_key receives the unique keys
+   * @return the number of unique keys
+   */
+  size_t unique(const TypeHashKey* h_key, size_t len, uint64_t* h_output_index,
+                TypeHashKey* h_unique_key);
+
+ private:
+  size_t capacity_;
+  // A slot is occupied only if its epoch is the epoch of the current call, so that the table
+  // never needs to be cleared
+  uint32_t epoch_;
+  std::vector<uint32_t> slot_epochs_;
+  std::vector<TypeHashKey> slot_keys_;
+  std::vector<uint64_t> slot_index_;
+};
+
+/**
+ * Expand the emb_vec of the unique keys back to one emb_vec per queried key.
+ * @param h_unique_src the emb_vec of the unique keys
+ * @param h_unique_index the output index of UniqueOpCPU::unique
+ * @param h_decompress_dst receives len emb_vec
+ * @param len the number of queried keys
+ * @param emb_vec_size the emb_vec size
+ */
+void decompress_emb_vec_cpu(const float* h_unique_src, const uint64_t* h_unique_index,
+                            float* h_decompress_dst, size_t len, size_t emb_vec_size);
+
+}  // namespace HugeCTR
@@ -14,12 +14,18 @@
  * limitations under the License.
  */
 
+#pragma once
+
 #include <sys/stat.h>
 
+#include <cmath>
 #include <common.hpp>
+#include <cstdint>
+#include <data_readers/crc32c.hpp>
 #include <fstream>
 #include <memory>
 #include <random>
+#include <vector>
 
 namespace HugeCTR {
 
@@ -49,20 +55,47 @@ inline void check_make_dir(const std::string& finalpath) {
   }
 }
 
+/**
+ * The seed of an independent random stream, e.g. of a file, derived from the seed of the data set.
+ */
+inline std::mt19937::result_type get_stream_seed(uint64_t seed, uint64_t stream) {
+  // splitmix64, so that nearby streams get unrelated seeds
+  uint64_t z = seed + (stream + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return static_cast<std::mt19937::result_type>(z ^ (z >> 31));
+}
+
 template <typename T>
 class IDataSimulator {
  public:
   virtual ~IDataSimulator() {}
   virtual T get_num() = 0;
+  /**
+   * Draw n numbers, the same as n calls of get_num().
+   */
+  virtual void get_nums(T* nums, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      nums[i] = get_num();
+    }
+  }
 };
 
 template <typename T>
 class FloatUniformDataSimulator {
  public:
   FloatUniformDataSimulator(T min, T max) : gen_(std::random_device()()), dis_(min, max) {}
+  FloatUniformDataSimulator(T min, T max, std::mt19937::result_type seed)
+      : gen_(seed), dis_(min, max) {}
 
   T get_num() { return dis_(gen_); }
 
+  void get_nums(T* nums, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      nums[i] = dis_(gen_);
+    }
+  }
+
  private:
   std::mt19937 gen_;
   std::uniform_real_distribution<T> dis_;
@@ -72,9 +105,17 @@ template <typename T>
 class IntUniformDataSimulator : public IDataSimulator<T> {
  public:
   IntUniformDataSimulator(T min, T max) : gen_(std::random_device()()), dis_(min, max) {}
+  IntUniformDataSimulator(T min, T max, std::mt19937::result_type seed)
+      : gen_(seed), dis_(min, max) {}
 
   T get_num() override { return dis_(gen_); }
 
+  void get_nums(T* nums, size_t n) override {
+    for (size_t i = 0; i < n; i++) {
+      nums[i] = dis_(gen_);
+    }
+  }
+
  private:
   std::mt19937 gen_;
   std::uniform_int_distribution<T> dis_;
@@ -84,24 +125,44 @@ template <typename T>
 class IntPowerLawDataSimulator : public IDataSimulator<T> {
  public:
   IntPowerLawDataSimulator(T min, T max, float alpha)
-      : gen_(std::random_device()()), dis_(0, 1), alpha_(alpha) {
+      : IntPowerLawDataSimulator(min, max, alpha, std::random_device()()) {}
+
+  IntPowerLawDataSimulator(T min, T max, float alpha, std::mt19937::result_type seed)
+      : gen_(seed), dis_(0, 1), alpha_(alpha) {
     min_ = 1;
     max_ = max - min + 1;
     offset_ = min - 1;  // to handle the case min_ <= 0 and alpha_ < -1
+    // the terms of the inverse CDF which do not depend on the draw
+    scale_ = pow(max_, alpha_ + 1) - pow(min_, alpha_ + 1);
+    base_ = pow(min_, alpha_ + 1);
+    exponent_ = 1.0 / (alpha_ + 1.0);
   }
 
-  T get_num() override {
-    double x = dis_(gen_);
-    double y = (pow((pow(max_, alpha_ + 1) - pow(min_, alpha_ + 1)) * x + pow(min_, alpha_ + 1),
-                    1.0 / (alpha_ + 1.0)));
-    return static_cast<T>(round(y) + offset_);
+  T get_num() override { return transform(dis_(gen_)); }
+
+  void get_nums(T* nums, size_t n) override {
+    // the draws are taken first, so that the transform runs in a loop of its own
+    draws_.resize(n);
+    for (size_t i = 0; i < n; i++) {
+      draws_[i] = dis_(gen_);
+    }
+    for (size_t i = 0; i < n; i++) {
+      nums[i] = transform(draws_[i]);
+    }
   }
 
  private:
+  T transform(double x) const {
+    double y = pow(scale_ * x + base_, exponent_);
+    return static_cast<T>(round(y) + offset_);
+  }
+
   std::mt19937 gen_;
   std::uniform_real_distribution<float> dis_;
   float alpha_;
   double min_, max_, offset_;
+  double scale_, base_, exponent_;
+  std::vector<float> draws_;
 };
 
 /**
@@ -118,6 +179,13 @@ class Checker_Traits<Check_t::Sum> {
 
   static char accum(char pre, char x) { return pre + x; }
 
+  static char accum(char pre, const char* array, int N) {
+    for (int i = 0; i < N; i++) {
+      pre += array[i];
+    }
+    return pre;
+  }
+
   static void write(int N, char* array, char chk_bits, std::ofstream& stream) {
     stream.write(reinterpret_cast<char*>(&N), sizeof(int));
     stream.write(reinterpret_cast<char*>(array), N);
@@ -134,6 +202,8 @@ class Checker_Traits<Check_t::None> {
 
   static char accum(char pre, char x) { return 0; }
 
+  static char accum(char pre, const char* array, int N) { return 0; }
+
   static void write(int N, char* array, char chk_bits, std::ofstream& stream) {
     stream.write(reinterpret_cast<char*>(array), N);
   }
@@ -141,6 +211,26 @@ class Checker_Traits<Check_t::None> {
   static long long ID() { return 0; }
 };
 
+template <>
+class Checker_Traits<Check_t::CRC32C> {
+ public:
+  static char zero() { return 0; }
+
+  // the CRC32C is computed over the whole block by write
+  static char accum(char pre, char x) { return 0; }
+
+  static char accum(char pre, const char* array, int N) { return 0; }
+
+  static void write(int N, char* array, char chk_bits, std::ofstream& stream) {
+    uint32_t crc = crc32c(array, N);
+    stream.write(reinterpret_cast<char*>(&N), sizeof(int));
+    stream.write(reinterpret_cast<char*>(array), N);
+    stream.write(reinterpret_cast<char*>(&crc), sizeof(uint32_t));
+  }
+
+  static long long ID() { return 2; }
+};
+
 template <Check_t T>
 class DataWriter {
   std::vector<char> array_;
@@ -149,11 +239,9 @@ class DataWriter {
 
  public:
   DataWriter(std::ofstream& stream) : stream_(stream) { check_char_ = Checker_Traits<T>::zero(); }
-  void append(char* array, int N) {
-    for (int i = 0; i < N; i++) {
-      array_.push_back(array[i]);
-      check_char_ = Checker_Traits<T>::accum(check_char_, array[i]);
-    }
+  void append(const char* array, int N) {
+    array_.insert(array_.end(), array, array + N);
+    check_char_ = Checker_Traits<T>::accum(check_char_, array, N);
   }
   void write() {
     Checker_Traits<T>::write(static_cast<int>(array_.size()), array_.data(), check_char_, stream_);
@@ -53,12 +53,16 @@ public:
 
   virtual void create_drwg_norm(std::string file_list, 
                         Check_t check_type,
-                        bool start_reading_from_beginning = true) = 0;
+                        bool start_reading_from_beginning = true,
+                        bool data_shuffle = false,
+                        const ShuffleBufferParam& shuffle_buffer = ShuffleBufferParam()) = 0;
   virtual void create_drwg_raw( std::string file_name, 
                         long long num_samples,
                         bool float_label_dense,
                         bool data_shuffle, 
-                        bool start_reading_from_beginning = true) = 0;
+                        bool start_reading_from_beginning = true,
+                        unsigned long long seed = 0,
+                        bool use_huge_pages = false) = 0;
 
   virtual void create_drwg_parquet( std::string file_list,const std::vector<long long> slot_offset,
                             bool start_reading_from_beginning = true) = 0;
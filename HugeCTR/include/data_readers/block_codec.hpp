@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifdef ENABLE_COMPRESSION
+#include <lz4.h>
+#include <zstd.h>
+#endif
+#include <common.hpp>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * The codec of the blocks of a compressed data set.
+ */
+enum class Compression_t { None, LZ4, Zstd };
+
+inline const std::map<std::string, Compression_t>& get_compression_type_map() {
+  static const std::map<std::string, Compression_t> COMPRESSION_TYPE_MAP = {
+      {"None", Compression_t::None}, {"LZ4", Compression_t::LZ4}, {"Zstd", Compression_t::Zstd}};
+  return COMPRESSION_TYPE_MAP;
+}
+
+constexpr int kZstdDefaultLevel = 3;
+
+/**
+ * Throw if the blocks of a file are compressed with a codec HugeCTR is built without.
+ */
+inline void check_compression(Compression_t compression) {
+  switch (compression) {
+    case Compression_t::None:
+      return;
+    case Compression_t::LZ4:
+    case Compression_t::Zstd:
+#ifndef ENABLE_COMPRESSION
+      CK_THROW_(Error_t::WrongInput,
+                "compressed data set, but HugeCTR is built without ENABLE_COMPRESSION");
+#endif
+      return;
+    default:
+      CK_THROW_(Error_t::WrongInput,
+                "unknown compression: " + std::to_string(static_cast<int>(compression)));
+  }
+}
+
+/**
+ * Compress size bytes of src into a block, appended to dst.
+ * A block is the uint64_t size of the decompressed data followed by the data compressed with the
+ * codec, so that a reader can size its buffer before decompressing.
+ * @verbatim
+ * [uint64_t decompressed size] [compressed data]
+ * @endverbatim
+ * @param level the level of Zstd, ignored by LZ4
+ */
+inline void compress_block(Compression_t compression, const char* src, size_t size,
+                           std::vector<char>* dst, int level = kZstdDefaultLevel) {
+  check_compression(compression);
+#ifdef ENABLE_COMPRESSION
+  const size_t begin = dst->size();
+  const uint64_t raw_size = size;
+  switch (compression) {
+    case Compression_t::LZ4: {
+      if (size > static_cast<size_t>(LZ4_MAX_INPUT_SIZE)) {
+        CK_THROW_(Error_t::WrongInput, "block too large for LZ4: " + std::to_string(size));
+      }
+      dst->resize(begin + sizeof(uint64_t) + LZ4_compressBound(size));
+      const int len = LZ4_compress_default(src, dst->data() + begin + sizeof(uint64_t), size,
+                                           LZ4_compressBound(size));
+      if (len <= 0 && size > 0) {
+        CK_THROW_(Error_t::UnspecificError, "LZ4_compress_default failed");
+      }
+      dst->resize(begin + sizeof(uint64_t) + len);
+      break;
+    }
+    case Compression_t::Zstd: {
+      dst->resize(begin + sizeof(uint64_t) + ZSTD_compressBound(size));
+      const size_t len = ZSTD_compress(dst->data() + begin + sizeof(uint64_t),
+                                       ZSTD_compressBound(size), src, size, level);
+      if (ZSTD_isError(len)) {
+        CK_THROW_(Error_t::UnspecificError,
+                  std::string("ZSTD_compress failed: ") + ZSTD_getErrorName(len));
+      }
+      dst->resize(begin + sizeof(uint64_t) + len);
+      break;
+    }
+    default:
+      CK_THROW_(Error_t::WrongInput, "no codec to compress the block with");
+  }
+  memcpy(dst->data() + begin, &raw_size, sizeof(uint64_t));
+#endif
+}
+
+/**
+ * @return the decompressed size of a block, or -1 if it is too short to be one
+ */
+inline long long get_decompressed_size(const char* src, size_t size) {
+  if (size < sizeof(uint64_t)) {
+    return -1;
+  }
+  uint64_t raw_size;
+  memcpy(&raw_size, src, sizeof(uint64_t));
+  return static_cast<long long>(raw_size);
+}
+
+/**
+ * Decompress a block into dst, which must hold get_decompressed_size() bytes.
+ * It runs on the calling thread, the reader workers decompress their own blocks.
+ * @return false if the block is corrupted, or HugeCTR is built without its codec
+ */
+inline bool decompress_block(Compression_t compression, const char* src, size_t size, char* dst) {
+#ifdef ENABLE_COMPRESSION
+  const long long raw_size = get_decompressed_size(src, size);
+  if (raw_size < 0) {
+    return false;
+  }
+  src += sizeof(uint64_t);
+  size -= sizeof(uint64_t);
+  switch (compression) {
+    case Compression_t::LZ4: {
+      if (raw_size > LZ4_MAX_INPUT_SIZE) {
+        return false;
+      }
+      return LZ4_decompress_safe(src, dst, size, raw_size) == raw_size;
+    }
+    case Compression_t::Zstd: {
+      // a context per thread saves its allocation on every block
+      struct DCtxDeleter {
+        void operator()(ZSTD_DCtx* ctx) const { ZSTD_freeDCtx(ctx); }
+      };
+      thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> ctx(ZSTD_createDCtx());
+      const size_t len = ZSTD_decompressDCtx(ctx.get(), dst, raw_size, src, size);
+      return !ZSTD_isError(len) && len == static_cast<size_t>(raw_size);
+    }
+    default:
+      return false;
+  }
+#else
+  return false;
+#endif
+}
+
+}  // namespace HugeCTR
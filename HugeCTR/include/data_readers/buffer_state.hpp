@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace HugeCTR {
+
+enum class BufferState : int { FileEOF, Reading, ReadyForRead, Writing, ReadyForWrite };
+
+/**
+ * @brief The state of a buffer handed off between the threads of the data reader.
+ *
+ * It is used like std::atomic<BufferState>, and the wait functions block until the state changes
+ * instead of polling it: they spin for a short while, which is enough when the other thread is
+ * about to hand the buffer off, then sleep on a condition variable. Only the state changes made
+ * while a thread waits pay for the notification.
+ */
+class WaitableBufferState {
+  static constexpr int kSpinCount = 128;
+  // the abort condition of a wait is checked at least this often
+  static constexpr std::chrono::milliseconds kAbortCheckPeriod{10};
+
+  std::atomic<BufferState> state_;
+  std::atomic<int> num_waiters_{0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+
+  void notify() {
+    if (num_waiters_.load() > 0) {
+      // taking the lock orders the notification after the check of a waiter about to sleep
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_all();
+    }
+  }
+
+  // spinning only delays the other thread when it needs the same CPU
+  static int get_spin_count() {
+    static const int spin_count = std::thread::hardware_concurrency() > 1 ? kSpinCount : 0;
+    return spin_count;
+  }
+
+  static void cpu_relax() {
+#if defined(__x86_64__)
+    _mm_pause();
+#endif
+  }
+
+  /**
+   * Wait until try_acquire() succeeds or abort() is true.
+   * @return false if aborted
+   */
+  template <typename TryAcquire, typename Abort>
+  bool wait_until(TryAcquire try_acquire, Abort abort) {
+    const int spin_count = get_spin_count();
+    for (int i = 0; i < spin_count; i++) {
+      if (try_acquire()) {
+        return true;
+      }
+      cpu_relax();
+    }
+    num_waiters_++;
+    bool acquired;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!(acquired = try_acquire()) && !abort()) {
+        cv_.wait_for(lock, kAbortCheckPeriod);
+      }
+    }
+    num_waiters_--;
+    return acquired;
+  }
+
+ public:
+  WaitableBufferState() = default;
+  WaitableBufferState(BufferState state) : state_(state) {}
+
+  BufferState load() const { return state_.load(); }
+
+  void store(BufferState state) {
+    state_.store(state);
+    notify();
+  }
+
+  bool compare_exchange_weak(BufferState& expected, BufferState desired) {
+    if (state_.compare_exchange_weak(expected, desired)) {
+      notify();
+      return true;
+    }
+    return false;
+  }
+
+  bool compare_exchange_strong(BufferState& expected, BufferState desired) {
+    if (state_.compare_exchange_strong(expected, desired)) {
+      notify();
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * Block until the state is expected, then change it to desired.
+   * @param abort checked periodically, the wait gives up when it returns true
+   * @return false if the wait gave up
+   */
+  template <typename Abort>
+  bool wait_and_exchange(BufferState expected, BufferState desired, Abort abort) {
+    // the raw exchange, the lock of the wait may be held
+    if (!wait_until(
+            [this, expected, desired]() {
+              BufferState current = expected;
+              return state_.compare_exchange_strong(current, desired);
+            },
+            abort)) {
+      return false;
+    }
+    notify();
+    return true;
+  }
+
+  void wait_and_exchange(BufferState expected, BufferState desired) {
+    wait_and_exchange(expected, desired, []() { return false; });
+  }
+
+  /**
+   * Block until the state is expected.
+   * @return false if the wait gave up
+   */
+  template <typename Abort>
+  bool wait_for(BufferState expected, Abort abort) {
+    return wait_until([this, expected]() { return load() == expected; }, abort);
+  }
+};
+
+}  // namespace HugeCTR
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common.hpp>
+#include <data_readers/checker.hpp>
+#include <data_readers/crc32c.hpp>
+#include <data_readers/source.hpp>
+
+namespace HugeCTR {
+
+/**
+ * Each block is an int length, the data, and the uint32_t CRC32C of the data.
+ * The whole block is viewed in the buffer of the source and checked at once when its first bytes
+ * are read, then the reads are served from the view. Like CheckSum, a mismatch is reported by the
+ * read that ends the block.
+ */
+class CheckCRC32C : public Checker {
+ private:
+  const int MAX_TRY_{10};
+  const char* block_; /**< the data of the current block */
+  int block_size_;    /**< bytes of data in the current block */
+  int counter_;       /**< bytes of the current block not read yet */
+  bool block_ok_;     /**< whether the CRC32C of the current block matched */
+
+  /**
+   * View the next bytes_to_read bytes of the block, starting a new block if needed.
+   * @return `DataCheckError` at the end of a corrupted block, `BrokenFile` if the user reads past
+   * the block, the error of the source otherwise
+   */
+  Error_t next_view(const char** ptr, size_t bytes_to_read) {
+    if (counter_ == 0) {
+      int block_size = 0;
+      Error_t err = Checker::src_.read(reinterpret_cast<char*>(&block_size), sizeof(int));
+      if (err != Error_t::Success) {
+        return err;
+      }
+      if (block_size < 0) {
+        CK_THROW_(Error_t::BrokenFile, "block_size " + std::to_string(block_size) + "< 0");
+      }
+      const char* block = nullptr;
+      err = Checker::src_.read_view(&block, block_size + sizeof(uint32_t));
+      if (err != Error_t::Success) {
+        return err;
+      }
+      uint32_t check_sum;
+      memcpy(&check_sum, block + block_size, sizeof(uint32_t));
+      block_ = block;
+      block_size_ = block_size;
+      counter_ = block_size;
+      block_ok_ = crc32c(block, block_size) == check_sum;
+    }
+    // if user read more data than expected, return `BrokenFile`.
+    // User should check this error and call next_source to new a source.
+    if (static_cast<size_t>(counter_) < bytes_to_read) {
+      CK_THROW_(Error_t::BrokenFile, "counter_ " + std::to_string(counter_) + " < " +
+                                         std::to_string(bytes_to_read));
+    }
+    *ptr = block_ + (block_size_ - counter_);
+    counter_ -= bytes_to_read;
+    return counter_ == 0 && !block_ok_ ? Error_t::DataCheckError : Error_t::Success;
+  }
+
+ public:
+  CheckCRC32C(Source& src)
+      : Checker(src), block_(nullptr), block_size_(0), counter_(0), block_ok_(true) {}
+
+  /**
+   * Read "bytes_to_read" byte to the memory associated to ptr.
+   * Users don't need to manualy maintain the check bit offset, just specify
+   * number of bytes you really want to see in ptr.
+   * @param ptr pointer to user located buffer
+   * @param bytes_to_read bytes to read
+   * @return `DataCheckError` `OutOfBound` `Success` `UnspecificError`
+   */
+  Error_t read(char* ptr, size_t bytes_to_read) noexcept {
+    try {
+      const char* view = nullptr;
+      Error_t err = next_view(&view, bytes_to_read);
+      if (err == Error_t::Success || err == Error_t::DataCheckError) {
+        memcpy(ptr, view, bytes_to_read);
+      }
+      return err;
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+      return Error_t::BrokenFile;
+    }
+  }
+
+  /**
+   * Like read, but point ptr into the buffer of the source instead of copying.
+   * The view is valid until the next block starts.
+   * @param ptr receives the pointer to the bytes
+   * @param bytes_to_read bytes to read
+   * @return `DataCheckError` `OutOfBound` `Success` `UnspecificError`
+   */
+  Error_t read_view(const char** ptr, size_t bytes_to_read) noexcept {
+    try {
+      return next_view(ptr, bytes_to_read);
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+      return Error_t::BrokenFile;
+    }
+  }
+
+  /**
+   * Start a new file to read.
+   * @return `FileCannotOpen` or `UnspecificError`
+   */
+  Error_t next_source() {
+    // initialize
+    block_ = nullptr;
+    block_size_ = 0;
+    counter_ = 0;
+    block_ok_ = true;
+    for (int i = MAX_TRY_; i > 0; i--) {
+      Error_t flag_eof = Checker::src_.next_source();
+      if (flag_eof == Error_t::Success ||
+          flag_eof == Error_t::EndOfFile) {
+        return flag_eof;
+      }
+    }
+    CK_THROW_(Error_t::FileCannotOpen, "Checker::src_.next_source() == Error_t::Success failed");
+    return Error_t::FileCannotOpen; // to elimate compile error
+  }
+};
+
+}  // namespace HugeCTR
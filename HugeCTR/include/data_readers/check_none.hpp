@@ -37,8 +37,23 @@ class CheckNone : public Checker {
    */
   Error_t read(char* ptr, size_t bytes_to_read) noexcept {
     try {
-      Checker::src_.read(ptr, bytes_to_read);
-      return Error_t::Success;
+      return Checker::src_.read(ptr, bytes_to_read);
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+      return Error_t::BrokenFile;
+    }
+  }
+
+  /**
+   * Like read, but point ptr into the buffer of the source instead of copying.
+   * The view is valid until the next read.
+   * @param ptr receives the pointer to the bytes
+   * @param bytes_to_read bytes to read
+   * @return `DataCheckError` `OutOfBound` `Success` `UnspecificError`
+   */
+  Error_t read_view(const char** ptr, size_t bytes_to_read) noexcept {
+    try {
+      return Checker::src_.read_view(ptr, bytes_to_read);
     } catch (const std::runtime_error& rt_err) {
       std::cerr << rt_err.what() << std::endl;
       return Error_t::BrokenFile;
@@ -27,6 +27,45 @@ class CheckSum : public Checker {
   const int MAX_TRY_{10};
   int counter_; /**< once counter_==0 will do checksum */
   char accum_;  /**< sum of bytes */
+
+  /**
+   * Read the length of the block if a new one starts, and reserve bytes_to_read of it.
+   * @return `BrokenFile` if the user reads past the block, the error of the source otherwise
+   */
+  Error_t begin_read(size_t bytes_to_read) {
+    // if counter == 0 read int length and char check_sum
+    if (counter_ == 0) {
+      Error_t err = Checker::src_.read(reinterpret_cast<char*>(&counter_), sizeof(int));
+      if (err != Error_t::Success) {
+        counter_ = 0;
+        return err;
+      }
+    }
+    counter_ -= bytes_to_read;
+    // if user read more data than expected, return `BrokenFile`.
+    // User should check this error and call next_source to new a source.
+    if (counter_ < 0) {
+      CK_THROW_(Error_t::BrokenFile, "counter_ " + std::to_string(counter_) + "< 0");
+    }
+    return Error_t::Success;
+  }
+
+  void accumulate(const char* ptr, size_t bytes_to_read) {
+    for (size_t i = 0; i < bytes_to_read; i++) {
+      accum_ += ptr[i];
+    }
+  }
+
+  /**
+   * Compare the sum of the block with its check_sum, and start a new sum.
+   * @return `DataCheckError` `Success`
+   */
+  Error_t end_block(char check_sum) {
+    const bool match = accum_ == check_sum;
+    accum_ = 0;
+    return match ? Error_t::Success : Error_t::DataCheckError;
+  }
+
  public:
   CheckSum(Source& src) : Checker(src), counter_(0), accum_(0) {}
   /**
@@ -39,36 +78,53 @@ class CheckSum : public Checker {
    */
   Error_t read(char* ptr, size_t bytes_to_read) noexcept {
     try {
-      // if counter == 0 read int length and char check_sum
-      if (counter_ == 0) {
-        Checker::src_.read(reinterpret_cast<char*>(&counter_), sizeof(int));
+      Error_t err = begin_read(bytes_to_read);
+      if (err != Error_t::Success) {
+        return err;
       }
-      counter_ -= bytes_to_read;
-      // if user read more data than expected, return `BrokenFile`.
-      // User should check this error and call next_source to new a source.
-      if (counter_ < 0) {
-        CK_THROW_(Error_t::BrokenFile, "counter_ " + std::to_string(counter_) + "< 0");
-      } else {
-        Checker::src_.read(ptr, bytes_to_read);
-        for (unsigned int i = 0; i < bytes_to_read; i++) {
-          accum_ += ptr[i];
-        }
-        // do checksum when counter_ == 0.
-        if (counter_ == 0) {
-          char check_sum = 0;
-          Checker::src_.read(reinterpret_cast<char*>(&check_sum), sizeof(char));
-          if (accum_ == check_sum) {
-            accum_ = 0;
-            return Error_t::Success;
-          } else {
-            accum_ = 0;
-            return Error_t::DataCheckError;
-          }
-        } else {
-          return Error_t::Success;
+      err = Checker::src_.read(ptr, bytes_to_read);
+      if (err != Error_t::Success) {
+        return err;
+      }
+      accumulate(ptr, bytes_to_read);
+      // do checksum when counter_ == 0.
+      if (counter_ == 0) {
+        char check_sum = 0;
+        err = Checker::src_.read(reinterpret_cast<char*>(&check_sum), sizeof(char));
+        if (err != Error_t::Success) {
+          return err;
         }
+        return end_block(check_sum);
+      }
+      return Error_t::Success;
+    } catch (const std::runtime_error& rt_err) {
+      std::cerr << rt_err.what() << std::endl;
+      return Error_t::BrokenFile;
+    }
+  }
+
+  /**
+   * Like read, but point ptr into the buffer of the source instead of copying.
+   * The view is valid until the next read.
+   * @param ptr receives the pointer to the bytes
+   * @param bytes_to_read bytes to read
+   * @return `DataCheckError` `OutOfBound` `Success` `UnspecificError`
+   */
+  Error_t read_view(const char** ptr, size_t bytes_to_read) noexcept {
+    try {
+      Error_t err = begin_read(bytes_to_read);
+      if (err != Error_t::Success) {
+        return err;
+      }
+      // the check_sum of the block is viewed along with its last bytes, reading it separately
+      // could move the source to its next buffer under the view
+      const bool end_of_block = counter_ == 0;
+      err = Checker::src_.read_view(ptr, bytes_to_read + (end_of_block ? sizeof(char) : 0));
+      if (err != Error_t::Success) {
+        return err;
       }
-      return Error_t::UnspecificError;
+      accumulate(*ptr, bytes_to_read);
+      return end_of_block ? end_block((*ptr)[bytes_to_read]) : Error_t::Success;
     } catch (const std::runtime_error& rt_err) {
       std::cerr << rt_err.what() << std::endl;
       return Error_t::BrokenFile;
@@ -36,6 +36,15 @@ class Checker {
    */
   virtual Error_t read(char* ptr, size_t bytes_to_read) noexcept = 0;
 
+  /**
+   * Like read, but point ptr into the buffer of the source instead of copying, so that the
+   * caller can decode the data in place. The view is valid until the next read.
+   * @param ptr receives the pointer to the bytes
+   * @param bytes_to_read bytes to read
+   * @return `DataCheckError` `OutOfBound` `Success` `UnspecificError`
+   */
+  virtual Error_t read_view(const char** ptr, size_t bytes_to_read) noexcept = 0;
+
   /**
    * Start a new file to read.
    * @return `FileCannotOpen` or `UnspecificError`
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace HugeCTR {
+
+namespace crc32c_internal {
+
+constexpr uint32_t kPolynomial = 0x82f63b78u;  // Castagnoli, reflected
+
+/**
+ * Tables of the slicing-by-8 software fallback.
+ */
+inline const std::array<std::array<uint32_t, 256>, 8>& get_tables() {
+  static const std::array<std::array<uint32_t, 256>, 8> tables = [] {
+    std::array<std::array<uint32_t, 256>, 8> t{};
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; j++) {
+        crc = (crc >> 1) ^ (kPolynomial & (0u - (crc & 1u)));
+      }
+      t[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+      for (size_t k = 1; k < 8; k++) {
+        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+      }
+    }
+    return t;
+  }();
+  return tables;
+}
+
+inline uint32_t update_sw(uint32_t crc, const char* data, size_t len) {
+  const auto& t = get_tables();
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+  while (len >= 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    word ^= crc;
+    crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^ t[5][(word >> 16) & 0xff] ^
+          t[4][(word >> 24) & 0xff] ^ t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^
+          t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+    p += 8;
+    len -= 8;
+  }
+  while (len--) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) inline uint32_t update_hw(uint32_t crc, const char* data,
+                                                            size_t len) {
+  uint64_t crc64 = crc;
+  while (len >= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    data += 8;
+    len -= 8;
+  }
+  crc = static_cast<uint32_t>(crc64);
+  while (len--) {
+    crc = _mm_crc32_u8(crc, static_cast<unsigned char>(*data++));
+  }
+  return crc;
+}
+
+inline bool has_hw() {
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  return has_sse42;
+}
+#endif
+
+}  // namespace crc32c_internal
+
+/**
+ * Extend the CRC32C of the previous bytes with len bytes of data. The SSE4.2 crc32 instruction
+ * is used when the host has it.
+ * @param crc the CRC32C of the previous bytes, 0 for none
+ * @return the CRC32C of all the bytes
+ */
+inline uint32_t crc32c_extend(uint32_t crc, const char* data, size_t len) {
+  crc = ~crc;
+#if defined(__x86_64__)
+  if (crc32c_internal::has_hw()) {
+    return ~crc32c_internal::update_hw(crc, data, len);
+  }
+#endif
+  return ~crc32c_internal::update_sw(crc, data, len);
+}
+
+/**
+ * @return the CRC32C (Castagnoli) of len bytes of data
+ */
+inline uint32_t crc32c(const char* data, size_t len) { return crc32c_extend(0, data, len); }
+
+}  // namespace HugeCTR
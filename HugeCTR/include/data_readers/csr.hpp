@@ -56,25 +56,38 @@ class CSR {
 
   size_t check_point_row_;   /**< check point of size_of_row_offset_. */
   size_t check_point_value_; /**< check point of size_of_value__. */
+
+  template <typename Allocator>
+  void allocate(const std::shared_ptr<GeneralBuffer2<Allocator>>& buff, size_t num_rows,
+                size_t max_value_size) {
+    buff->reserve({num_rows + 1}, &row_offset_tensor_);
+    buff->reserve({max_value_size}, &value_tensor_);
+    buff->allocate();
+  }
+
  public:
   /**
    * Ctor
    * @param num_rows num of rows is expected
    * @param max_value_size max size of value buffer.
+   * @param pinned whether to allocate the buffers in pinned memory, to copy them to the device
    */
-  CSR(size_t num_rows, size_t max_value_size) : num_rows_(num_rows), max_value_size_(max_value_size),
-  size_of_row_offset_(0), size_of_value_(0) {
+  CSR(size_t num_rows, size_t max_value_size, bool pinned = true)
+      : num_rows_(num_rows),
+        max_value_size_(max_value_size),
+        size_of_row_offset_(0),
+        size_of_value_(0) {
     static_assert(std::is_same<T, long long>::value || std::is_same<T, unsigned int>::value,
                   "type not support");
     if (max_value_size <= 0 && num_rows <= 0) {
       CK_THROW_(Error_t::WrongInput, "max_value_size <= 0 && num_rows <= 0");
     }
 
-    std::shared_ptr<GeneralBuffer2<CudaHostAllocator>> buff =
-        GeneralBuffer2<CudaHostAllocator>::create();
-    buff->reserve({num_rows + 1}, &row_offset_tensor_);
-    buff->reserve({max_value_size}, &value_tensor_);
-    buff->allocate();
+    if (pinned) {
+      allocate(GeneralBuffer2<CudaHostAllocator>::create(), num_rows, max_value_size);
+    } else {
+      allocate(GeneralBuffer2<HostAllocator>::create(), num_rows, max_value_size);
+    }
 
     row_offset_ptr_ = row_offset_tensor_.get_ptr();
     value_ptr_ = value_tensor_.get_ptr();
@@ -78,8 +78,6 @@ class DataCollector {
         auto &current_src_buffer = thread_buffers_[counter_];
         // auto &next_src_buffer = thread_buffers_[(counter_ + 1) % thread_buffers_.size()];
         auto &dst_buffer = broadcast_buffer_;
-        auto src_expected = BufferState::ReadyForRead;
-        auto dst_expected = BufferState::ReadyForWrite;
         int local_gpu_count = resource_manager_->get_local_gpu_count();
         int batch_size = current_src_buffer->batch_size;
         int label_dim = current_src_buffer->label_dim;
@@ -94,9 +92,14 @@ class DataCollector {
         }
         
 
+        // block until the worker filled its buffer, then until the broadcast buffer is free
+        auto stopped = [this]() { return !loop_flag_.load(); };
         if ((current_src_buffer->state.load() == BufferState::Reading ||
-             current_src_buffer->state.compare_exchange_weak(src_expected, BufferState::Reading)) && (dst_buffer->state.load() == BufferState::Writing ||
-            dst_buffer->state.compare_exchange_weak(dst_expected, BufferState::Writing))){
+             current_src_buffer->state.wait_and_exchange(BufferState::ReadyForRead,
+                                                         BufferState::Reading, stopped)) &&
+            (dst_buffer->state.load() == BufferState::Writing ||
+             dst_buffer->state.wait_and_exchange(BufferState::ReadyForWrite, BufferState::Writing,
+                                                 stopped))) {
             assert(current_src_buffer->state.load() == BufferState::Reading);
             assert(dst_buffer->state.load() == BufferState::Writing);
 
@@ -161,8 +164,6 @@ class DataCollector {
 
             current_src_buffer->state.store(BufferState::ReadyForWrite);
             dst_buffer->state.store(BufferState::ReadyForRead);
-        } else {
-          usleep(2);
         }
       }
     }
@@ -203,11 +204,7 @@ class DataCollector {
 
   long long read_a_batch_to_device() {
     // MESSAGE_("data collector waiting read_a_batch_to_device");
-    BufferState expected = BufferState::ReadyForRead;
-    while (!broadcast_buffer_->state.compare_exchange_weak(expected, BufferState::Reading)) {
-      expected = BufferState::ReadyForRead;
-      usleep(2);
-    }
+    broadcast_buffer_->state.wait_and_exchange(BufferState::ReadyForRead, BufferState::Reading);
     long long current_batch_size = broadcast_buffer_->current_batch_size;
     if (current_batch_size != 0) {
       int local_gpu_count = resource_manager_->get_local_gpu_count();
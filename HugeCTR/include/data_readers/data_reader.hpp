@@ -276,21 +276,26 @@ class DataReader : public IDataReader {
   const std::vector<TensorBag2> &get_dense_tensors() const { return output_->dense_tensors; }
 
   void create_drwg_norm(std::string file_name, Check_t check_type,
-                        bool start_reading_from_beginning = true) override {
+                        bool start_reading_from_beginning = true,
+                        bool data_shuffle = false,
+                        const ShuffleBufferParam& shuffle_buffer = ShuffleBufferParam()) override {
     source_type_ = SourceType_t::FileList;
     worker_group_.reset(new DataReaderWorkerGroupNorm<TypeKey>(
         thread_buffers_, resource_manager_, file_name, repeat_, check_type, params_,
-        start_reading_from_beginning));
+        start_reading_from_beginning, data_shuffle, shuffle_buffer));
     file_name_ = file_name;
   }
 
   void create_drwg_raw(std::string file_name, long long num_samples, bool float_label_dense,
                        bool data_shuffle = false,
-                       bool start_reading_from_beginning = true) override {
+                       bool start_reading_from_beginning = true,
+                       unsigned long long seed = 0,
+                       bool use_huge_pages = false) override {
     source_type_ = SourceType_t::Mmap;
     worker_group_.reset(new DataReaderWorkerGroupRaw<TypeKey>(
         thread_buffers_, resource_manager_, file_name, num_samples, repeat_, params_, label_dim_,
-        dense_dim_, batchsize_, float_label_dense, data_shuffle, start_reading_from_beginning));
+        dense_dim_, batchsize_, float_label_dense, data_shuffle, start_reading_from_beginning,
+        seed, use_huge_pages));
     file_name_ = file_name;
   }
 
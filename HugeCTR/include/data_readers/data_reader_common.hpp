@@ -18,17 +18,16 @@
 #include <atomic>
 #include <common.hpp>
 #include <data_reader.hpp>
+#include <data_readers/buffer_state.hpp>
 #include <vector>
 
 namespace HugeCTR {
 
-enum class BufferState : int { FileEOF, Reading, ReadyForRead, Writing, ReadyForWrite };
-
 struct ThreadBuffer {
   std::vector<SparseTensorBag> device_sparse_buffers;  // same number as embedding number
   std::vector<unsigned char> is_fixed_length; // same number as embedding number
   TensorBag2 device_dense_buffers;
-  std::atomic<BufferState> state;
+  WaitableBufferState state;
   long long current_batch_size;
   int batch_size;
   size_t param_num;
@@ -45,7 +44,7 @@ struct BroadcastBuffer {
   std::vector<unsigned char> is_fixed_length; // same number as embedding number
   std::vector<TensorBag2> dense_tensors;  // same number as local device number
   std::vector<cudaEvent_t> finish_broadcast_events; // same number as local device number
-  std::atomic<BufferState> state;
+  WaitableBufferState state;
   long long current_batch_size;
   size_t param_num;
 
@@ -16,12 +16,17 @@
 
 #pragma once
 #include <common.hpp>
+#include <data_readers/check_crc32c.hpp>
 #include <data_readers/check_none.hpp>
 #include <data_readers/check_sum.hpp>
 #include <data_readers/csr.hpp>
 #include <data_readers/data_reader_worker_interface.hpp>
 #include <data_readers/file_list.hpp>
 #include <data_readers/file_source.hpp>
+#include <data_readers/sample_shuffle_buffer.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <vector>
 
@@ -40,26 +45,40 @@ class DataReaderWorker : public IDataReaderWorker {
   size_t total_slot_num_;
   std::vector<size_t> last_batch_nnz_;
 
-  Tensor2<float> temp_host_dense_buffer_; // read data to make checker move
   Tensor2<float> host_dense_buffer_;
   std::vector<CSR<T>> host_sparse_buffer_;
 
-  void read_new_file() {
+  /**
+   * An open file of a worker with a shuffle buffer.
+   */
+  struct Lane {
+    std::shared_ptr<Source> source;
+    std::shared_ptr<Checker> checker;
+    DataSetHeader header;
+    long long record_index{0};
+  };
+  std::unique_ptr<SampleShuffleBuffer> shuffle_buffer_; /**< null to read the samples in order */
+  std::vector<Lane> lanes_;
+  std::vector<size_t> open_lanes_; /**< the lanes which are not at the end of their files */
+  std::atomic<long long> shuffled_samples_{0};
+  std::atomic<long long> fill_nanoseconds_{0};
+  std::atomic<long long> draw_nanoseconds_{0};
+
+  void read_new_file(Checker& checker, DataSetHeader* header) {
     constexpr int MAX_TRY = 10;
     for (int i = 0; i < MAX_TRY; i++) {
-      if (checker_->next_source() == Error_t::EndOfFile) {
+      if (checker.next_source() == Error_t::EndOfFile) {
         throw internal_runtime_error(Error_t::EndOfFile, "EndOfFile");
       }
 
-      Error_t err =
-          checker_->read(reinterpret_cast<char*>(&data_set_header_), sizeof(DataSetHeader));
-      current_record_index_ = 0;
-      if (!(data_set_header_.error_check == 0 && check_type_ == Check_t::None) &&
-          !(data_set_header_.error_check == 1 && check_type_ == Check_t::Sum)) {
+      Error_t err = checker.read(reinterpret_cast<char*>(header), sizeof(DataSetHeader));
+      if (!(header->error_check == 0 && check_type_ == Check_t::None) &&
+          !(header->error_check == 1 && check_type_ == Check_t::Sum) &&
+          !(header->error_check == 2 && check_type_ == Check_t::CRC32C)) {
         ERROR_MESSAGE_("DataHeaderError");
         continue;
       }
-      if (static_cast<size_t>(data_set_header_.slot_num) != total_slot_num_) {
+      if (static_cast<size_t>(header->slot_num) != total_slot_num_) {
         ERROR_MESSAGE_("DataHeaderError");
         continue;
       }
@@ -70,38 +89,322 @@ class DataReaderWorker : public IDataReaderWorker {
     CK_THROW_(Error_t::BrokenFile, "failed to read a file");
   }
 
-  void create_checker() {
+  void read_new_file() {
+    read_new_file(*checker_, &data_set_header_);
+    current_record_index_ = 0;
+  }
+
+  void read_new_file(Lane& lane) {
+    read_new_file(*lane.checker, &lane.header);
+    lane.record_index = 0;
+    if (lane.header.label_dim + lane.header.dense_dim != buffer_->label_dim + buffer_->dense_dim) {
+      CK_THROW_(Error_t::WrongInput,
+                "data_set_header_.label_dim + data_set_header_.dense_dim != label_dense_dim");
+    }
+  }
+
+  /**
+   * View the next bytes_to_read bytes in the buffer of the source, the samples are decoded from
+   * there instead of being copied out field by field.
+   */
+  static const char* read_view(Checker& checker, size_t bytes_to_read, const char* what) {
+    const char* ptr = nullptr;
+    Error_t err = checker.read_view(&ptr, bytes_to_read);
+    CK_THROW_(err, std::string("failure in reading ") + what);
+    return ptr;
+  }
+
+  const char* read_view(size_t bytes_to_read, const char* what) {
+    return read_view(*checker_, bytes_to_read, what);
+  }
+
+  std::shared_ptr<Checker> create_checker(Source& source) {
     switch (check_type_) {
       case Check_t::Sum:
-        checker_ = std::make_shared<CheckSum>(*source_);
-        break;
+        return std::make_shared<CheckSum>(source);
       case Check_t::None:
-        checker_ = std::make_shared<CheckNone>(*source_);
-        break;
+        return std::make_shared<CheckNone>(source);
+      case Check_t::CRC32C:
+        return std::make_shared<CheckCRC32C>(source);
       default:
         assert(!"Error: no such Check_t && should never get here!!");
     }
+    return nullptr;
+  }
+
+  void create_checker() {
+    checker_ = create_checker(*source_);
+    if (shuffle_buffer_) {
+      lanes_.clear();
+      open_lanes_.clear();
+      lanes_.push_back({source_, checker_, DataSetHeader(), 0});
+      for (auto& source : lane_sources_) {
+        lanes_.push_back({source, create_checker(*source), DataSetHeader(), 0});
+      }
+      for (size_t i = 0; i < lanes_.size(); i++) {
+        open_lanes_.push_back(i);
+      }
+    }
+  }
+
+  /**
+   * The bytes of a decoded sample in the shuffle buffer: its label and dense features, the nnz of
+   * each slot, then the keys of all the slots.
+   */
+  size_t get_sample_bytes() const {
+    return sizeof(float) * (buffer_->label_dim + buffer_->dense_dim) +
+           sizeof(int) * total_slot_num_ + sizeof(T) * buffer_length_;
+  }
+
+  /**
+   * Decode the next sample of a lane into an entry of the shuffle buffer.
+   */
+  void read_sample(Lane& lane, char* entry) {
+    const size_t label_dense_bytes = sizeof(float) * (buffer_->label_dim + buffer_->dense_dim);
+    memcpy(entry, read_view(*lane.checker, label_dense_bytes, "label_dense"), label_dense_bytes);
+    char* nnz_entry = entry + label_dense_bytes;
+    char* key_entry = nnz_entry + sizeof(int) * total_slot_num_;
+    size_t num_keys = 0;
+    for (size_t k = 0; k < total_slot_num_; k++) {
+      int nnz;
+      memcpy(&nnz, read_view(*lane.checker, sizeof(int), "nnz"), sizeof(int));
+      if (nnz < 0 || num_keys + nnz > buffer_length_) {
+        CK_THROW_(Error_t::BrokenFile, "nnz < 0 || the features of a sample > buffer_length_");
+      }
+      memcpy(nnz_entry + sizeof(int) * k, &nnz, sizeof(int));
+      memcpy(key_entry + sizeof(T) * num_keys,
+             read_view(*lane.checker, sizeof(T) * nnz, "feature_ids_"), sizeof(T) * nnz);
+      num_keys += nnz;
+    }
+  }
+
+  /**
+   * Fill the shuffle buffer with the samples of the open files, each sample is read from one of
+   * them at random, until the buffer is full or all the files are read.
+   */
+  void fill_shuffle_buffer() {
+    while (!shuffle_buffer_->full() && !open_lanes_.empty()) {
+      const size_t open_lane_id = shuffle_buffer_->next_random(open_lanes_.size());
+      Lane& lane = lanes_[open_lanes_[open_lane_id]];
+      try {
+        if (!lane.checker->is_open()) {
+          read_new_file(lane);  // can throw Error_t::EOF
+        }
+        try {
+          read_sample(lane, shuffle_buffer_->free_entry());
+          shuffle_buffer_->commit();
+        } catch (const internal_runtime_error& rt_err) {
+          if (rt_err.get_error() == Error_t::DataCheckError) {
+            ERROR_MESSAGE_("Error_t::DataCheckError");
+          } else {          // Error_t::BrokenFile, Error_t::UnspecificEror, ...
+            read_new_file(lane);  // can throw Error_t::EOF
+            continue;
+          }
+        }
+        if (++lane.record_index >= lane.header.number_of_records) {
+          read_new_file(lane);  // can throw Error_t::EOF
+        }
+      } catch (const internal_runtime_error& rt_err) {
+        if (rt_err.get_error() != Error_t::EndOfFile) {
+          throw;
+        }
+        open_lanes_.erase(open_lanes_.begin() + open_lane_id);
+      }
+    }
+  }
+
+  /**
+   * Append a sample of the shuffle buffer to the batch.
+   */
+  void write_sample(const char* entry, int batch_idx) {
+    const int label_dense_dim = buffer_->label_dim + buffer_->dense_dim;
+    if (batch_idx >= buffer_->batch_size_start_idx &&
+        batch_idx < buffer_->batch_size_end_idx) {  // only read local device dense data
+      memcpy(host_dense_buffer_.get_ptr() +
+                 (batch_idx - buffer_->batch_size_start_idx) * label_dense_dim,
+             entry, sizeof(float) * label_dense_dim);
+    }
+    const char* nnz_entry = entry + sizeof(float) * label_dense_dim;
+    const char* key_entry = nnz_entry + sizeof(int) * total_slot_num_;
+    for (size_t param_id = 0; param_id < params_.size(); ++param_id) {
+      auto& param = params_[param_id];
+      auto& current_csr = host_sparse_buffer_[param_id];
+      for (int k = 0; k < param.slot_num; k++) {
+        int nnz;
+        memcpy(&nnz, nnz_entry, sizeof(int));
+        nnz_entry += sizeof(int);
+        current_csr.new_row();
+        memcpy(current_csr.get_value_tensor().get_ptr() + current_csr.get_num_values(),
+               key_entry, sizeof(T) * nnz);
+        current_csr.update_value_size(nnz);
+        key_entry += sizeof(T) * nnz;
+      }
+    }
+  }
+
+  /**
+   * Pad the batch with empty samples from batch_idx.
+   */
+  void write_empty_samples(int batch_idx) {
+    const int label_dense_dim = buffer_->label_dim + buffer_->dense_dim;
+    for (; batch_idx < buffer_->batch_size; ++batch_idx) {
+      for (size_t param_id = 0; param_id < params_.size(); ++param_id) {
+        for (int k = 0; k < params_[param_id].slot_num; k++) {
+          host_sparse_buffer_[param_id].new_row();
+        }
+      }
+      if (batch_idx >= buffer_->batch_size_start_idx &&
+          batch_idx < buffer_->batch_size_end_idx) {  // only read local device dense data
+        float* ptr = host_dense_buffer_.get_ptr() +
+                     (batch_idx - buffer_->batch_size_start_idx) * label_dense_dim;
+        for (int j = 0; j < label_dense_dim; j++) {
+          ptr[j] = 0.f;
+        }
+      }
+    }
+  }
+
+  /**
+   * Hand an empty batch then the FileEOF state to the collector at the end of the data set.
+   */
+  void write_eof() {
+    if (!wait_until_h2d_ready()) return;
+    buffer_->current_batch_size = 0;
+    assert(buffer_->state.load() == BufferState::Writing);
+    buffer_->state.store(BufferState::ReadyForRead);
+    is_eof_ = true;
+    if (!wait_until_h2d_ready()) return;
+    buffer_->state.store(BufferState::FileEOF);
+    wait_until_eof_released();
+  }
+
+  /**
+   * Read a batch of samples drawn at random from the shuffle buffer.
+   */
+  void read_a_shuffled_batch() {
+    using Clock = std::chrono::steady_clock;
+    auto elapsed_nanoseconds = [](Clock::time_point start) {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    };
+    auto start = Clock::now();
+    fill_shuffle_buffer();
+    fill_nanoseconds_ += elapsed_nanoseconds(start);
+    if (shuffle_buffer_->empty()) {
+      write_eof();
+      return;
+    }
+
+    for (auto& each_csr : host_sparse_buffer_) {
+      each_csr.reset();
+    }
+    int current_batch_size = 0;
+    while (current_batch_size < buffer_->batch_size) {
+      // the samples drawn are in the free entries, which are only filled again once they are
+      // written to the batch
+      if (shuffle_buffer_->empty()) {
+        start = Clock::now();
+        fill_shuffle_buffer();
+        fill_nanoseconds_ += elapsed_nanoseconds(start);
+        if (shuffle_buffer_->empty()) {
+          break;
+        }
+      }
+      start = Clock::now();
+      const int num_samples = std::min(static_cast<size_t>(buffer_->batch_size - current_batch_size),
+                                       shuffle_buffer_->size());
+      for (int i = 0; i < num_samples; i++) {
+        write_sample(shuffle_buffer_->draw(), current_batch_size++);
+      }
+      draw_nanoseconds_ += elapsed_nanoseconds(start);
+    }
+    write_empty_samples(current_batch_size);
+    shuffled_samples_ += current_batch_size;
+    write_batch(current_batch_size);
+  }
+
+  /**
+   * Close the CSR buffers of the batch and hand the batch to the collector.
+   */
+  void write_batch(long long current_batch_size) {
+    for (auto& each_csr : host_sparse_buffer_) {
+      each_csr.new_row();
+    }
+    // do h2d
+    // wait buffer and schedule
+    
+    if (!wait_until_h2d_ready()) return;
+    buffer_->current_batch_size = current_batch_size;
+    // without a device the batch is only parsed, it stays in the host buffers
+    if (gpu_resource_) {
+      CudaDeviceContext context(gpu_resource_->get_device_id());
+      auto dst_dense_tensor = Tensor2<float>::stretch_from(buffer_->device_dense_buffers);
+      CK_CUDA_THROW_(cudaMemcpyAsync(dst_dense_tensor.get_ptr(), host_dense_buffer_.get_ptr(),
+                                    host_dense_buffer_.get_size_in_bytes(), cudaMemcpyHostToDevice,
+                                    gpu_resource_->get_memcpy_stream()));
+
+      for (size_t param_id = 0; param_id < params_.size(); ++param_id) {
+        auto dst_sparse_tensor =
+            SparseTensor<T>::stretch_from(buffer_->device_sparse_buffers[param_id]);
+        if (buffer_->is_fixed_length[param_id] &&
+            last_batch_nnz_[param_id] == host_sparse_buffer_[param_id].get_num_values()) {
+          CK_CUDA_THROW_(cudaMemcpyAsync(dst_sparse_tensor.get_value_ptr(),
+                                        host_sparse_buffer_[param_id].get_value_tensor().get_ptr(),
+                                        host_sparse_buffer_[param_id].get_num_values() * sizeof(T),
+                                        cudaMemcpyHostToDevice,
+                                        gpu_resource_->get_memcpy_stream()));
+        } else {
+          sparse_tensor_helper::cuda::copy_async(dst_sparse_tensor, host_sparse_buffer_[param_id],
+                                                gpu_resource_->get_memcpy_stream());
+          last_batch_nnz_[param_id] = host_sparse_buffer_[param_id].get_num_values();
+        }
+      }
+      CK_CUDA_THROW_(cudaStreamSynchronize(gpu_resource_->get_memcpy_stream()));
+    }
+    assert(buffer_->state.load() == BufferState::Writing);
+    buffer_->state.store(BufferState::ReadyForRead);
+  }
+
+  template <typename Allocator>
+  void allocate_host_buffers(const std::shared_ptr<GeneralBuffer2<Allocator>>& buff, bool pinned) {
+    int batch_size = buffer_->batch_size;
+    buff->reserve({static_cast<size_t>(buffer_->batch_size_end_idx - buffer_->batch_size_start_idx),
+                   static_cast<size_t>(buffer_->label_dim + buffer_->dense_dim)},
+                  &host_dense_buffer_);
+
+    for (auto& param : params_) {
+      host_sparse_buffer_.emplace_back(batch_size * param.slot_num,
+                                       batch_size * param.max_feature_num, pinned);
+    }
+
+    buff->allocate();
   }
 
   void post_set_source() override {
     create_checker();
     auto expected = BufferState::FileEOF;
-    while (buffer_->state.compare_exchange_weak(expected, BufferState::ReadyForWrite)) {
-      expected = BufferState::FileEOF;
-      usleep(2);
-    }
+    buffer_->state.compare_exchange_strong(expected, BufferState::ReadyForWrite);
     is_eof_ = false;
   }
 
  public:
   /**
    * Ctor
+   * @param gpu_resource the device the batches are copied to, if null the batches are only parsed
+   * into host memory
+   * @param source the source to read, by default the files of file_list assigned to this worker
+   * @param shuffle_buffer the shuffle buffer of this worker, whose memory_bytes is the budget of
+   * this worker only
+   * @param lane_sources the sources read along with source, by default the worker reads
+   * shuffle_buffer.num_open_files files of file_list at the same time when source is null
    */
   DataReaderWorker(const int worker_id, const int worker_num,
                    const std::shared_ptr<GPUResource>& gpu_resource, int* loop_flag,
                    const std::shared_ptr<ThreadBuffer>& buffer, const std::string& file_list,
                    size_t buffer_length, bool repeat, Check_t check_type,
-                   const std::vector<DataReaderSparseParam>& params)
+                   const std::vector<DataReaderSparseParam>& params,
+                   const std::shared_ptr<Source>& source = nullptr,
+                   const ShuffleBufferParam& shuffle_buffer = ShuffleBufferParam(),
+                   const std::vector<std::shared_ptr<Source>>& lane_sources = {})
       : IDataReaderWorker(worker_id, worker_num, gpu_resource, !repeat, loop_flag, buffer),
         buffer_length_(buffer_length),
         check_type_(check_type),
@@ -115,36 +418,66 @@ class DataReaderWorker : public IDataReaderWorker {
     for (auto& p : params) {
       total_slot_num_ += p.slot_num;
     }
-    source_ = std::make_shared<FileSource>(worker_id, worker_num, file_list, repeat);
+    if (shuffle_buffer.enabled()) {
+      shuffle_buffer_.reset(new SampleShuffleBuffer(
+          get_sample_bytes(), shuffle_buffer.memory_bytes,
+          shuffle_buffer.seed * worker_num + worker_id));
+    }
+    if (source) {
+      source_ = source;
+      lane_sources_ = lane_sources;
+    } else if (shuffle_buffer.enabled()) {
+      // the files are distributed to the lanes like to worker_num * num_open_files workers
+      const int num_lanes = std::max(shuffle_buffer.num_open_files, 1);
+      for (int lane = 0; lane < num_lanes; lane++) {
+        auto lane_source = std::make_shared<FileSource>(worker_id * num_lanes + lane,
+                                                        worker_num * num_lanes, file_list, repeat);
+        if (lane == 0) {
+          source_ = lane_source;
+        } else {
+          lane_sources_.push_back(lane_source);
+        }
+      }
+    } else {
+      source_ = std::make_shared<FileSource>(worker_id, worker_num, file_list, repeat);
+    }
     create_checker();
 
-    int batch_size = buffer->batch_size;
-    int batch_size_start_idx = buffer->batch_size_start_idx;
-    int batch_size_end_idx = buffer->batch_size_end_idx;
-    int label_dim = buffer->label_dim;
-    int dense_dim = buffer->dense_dim;
-
-    CudaDeviceContext ctx(gpu_resource->get_device_id());
-    std::shared_ptr<GeneralBuffer2<CudaHostAllocator>> buff =
-        GeneralBuffer2<CudaHostAllocator>::create();
+    if (gpu_resource) {
+      CudaDeviceContext ctx(gpu_resource->get_device_id());
+      allocate_host_buffers(GeneralBuffer2<CudaHostAllocator>::create(), true);
+    } else {
+      allocate_host_buffers(GeneralBuffer2<HostAllocator>::create(), false);
+    }
+  }
 
-    buff->reserve({static_cast<size_t>(batch_size_end_idx - batch_size_start_idx),
-                   static_cast<size_t>(label_dim + dense_dim)},
-                  &host_dense_buffer_);
-    buff->reserve({static_cast<size_t>(label_dim + dense_dim)}, &temp_host_dense_buffer_);
+  /**
+   * The host buffers of the last batch, which are the batch itself for a worker without a device.
+   * They are overwritten as soon as read_a_batch is called again.
+   */
+  const Tensor2<float>& get_host_dense_buffer() const { return host_dense_buffer_; }
+  const std::vector<CSR<T>>& get_host_sparse_buffers() const { return host_sparse_buffer_; }
 
-    for (auto& param : params) {
-      host_sparse_buffer_.emplace_back(batch_size * param.slot_num,
-                                       batch_size * param.max_feature_num);
+  ShuffleBufferStats get_shuffle_buffer_stats() const {
+    ShuffleBufferStats stats;
+    if (shuffle_buffer_) {
+      stats.capacity = shuffle_buffer_->capacity();
+      stats.memory_bytes = shuffle_buffer_->get_memory_bytes();
+      stats.samples = shuffled_samples_;
+      stats.fill_seconds = fill_nanoseconds_ / 1e9;
+      stats.draw_seconds = draw_nanoseconds_ / 1e9;
     }
-
-    buff->allocate();
+    return stats;
   }
 
   /**
    * read a batch of data from data set to heap.
    */
   void read_a_batch() {
+    if (shuffle_buffer_) {
+      read_a_shuffled_batch();
+      return;
+    }
     long long current_batch_size = buffer_->batch_size;
     int label_dim = buffer_->label_dim;
     int dense_dim = buffer_->dense_dim;
@@ -163,17 +496,7 @@ class DataReaderWorker : public IDataReaderWorker {
       // of the datset, while Raw will output current_batchsize < batchsize. Comment by Alex Liu
       // (2021.7.4)
       if (err == Error_t::EndOfFile) {
-        if (!wait_until_h2d_ready()) return;
-        buffer_->current_batch_size = 0;
-        assert(buffer_->state.load() == BufferState::Writing);
-        buffer_->state.store(BufferState::ReadyForRead);
-        is_eof_ = true;
-        if (!wait_until_h2d_ready()) return;
-        buffer_->state.store(BufferState::FileEOF);
-        while (buffer_->state.load() != BufferState::ReadyForWrite) {
-          usleep(2);
-          if (*loop_flag_ == 0) return;
-        }
+        write_eof();
         return; // need this return to run from begining
       } else {
         throw;
@@ -211,17 +534,11 @@ class DataReaderWorker : public IDataReaderWorker {
       }
       try {
         try {
+          const char* label_dense = read_view(sizeof(float) * label_dense_dim, "label_dense");
           if (batch_idx >= batch_size_start_idx &&
               batch_idx < batch_size_end_idx) {  // only read local device dense data
-            CK_THROW_(checker_->read(reinterpret_cast<char*>(host_dense_buffer_.get_ptr() +
-                                                             (batch_idx - batch_size_start_idx) *
-                                                                 label_dense_dim),
-                                     sizeof(float) * label_dense_dim),
-                      "failure in reading label_dense");
-          }else {
-            CK_THROW_(checker_->read(reinterpret_cast<char*>(temp_host_dense_buffer_.get_ptr()),
-                                     sizeof(float) * label_dense_dim),
-                      "failure in reading label_dense");
+            memcpy(host_dense_buffer_.get_ptr() + (batch_idx - batch_size_start_idx) * label_dense_dim,
+                   label_dense, sizeof(float) * label_dense_dim);
           }
 
           for (size_t param_id = 0; param_id < params_.size(); ++param_id) {
@@ -233,18 +550,18 @@ class DataReaderWorker : public IDataReaderWorker {
             auto& current_csr = host_sparse_buffer_[param_id];
             for (int k = 0; k < param.slot_num; k++) {
               int nnz;
-              CK_THROW_(checker_->read(reinterpret_cast<char*>(&nnz), sizeof(int)),
-                        "failure in reading nnz");
+              memcpy(&nnz, read_view(sizeof(int), "nnz"), sizeof(int));
               if (nnz > (int)buffer_length_ || nnz < 0) {
                 ERROR_MESSAGE_("nnz > buffer_length_ | nnz < 0 nnz:" + std::to_string(nnz));
               }
+              if (nnz < 0) {
+                CK_THROW_(Error_t::BrokenFile, "nnz < 0");
+              }
               current_csr.new_row();
               size_t num_value = current_csr.get_num_values();
 
-              CK_THROW_(checker_->read(reinterpret_cast<char*>(
-                                           current_csr.get_value_tensor().get_ptr() + num_value),
-                                       sizeof(T) * nnz),
-                        "failure in reading feature_ids_");
+              memcpy(current_csr.get_value_tensor().get_ptr() + num_value,
+                     read_view(sizeof(T) * nnz, "feature_ids_"), sizeof(T) * nnz);
               current_csr.update_value_size(nnz);
             }
           }
@@ -277,41 +594,7 @@ class DataReaderWorker : public IDataReaderWorker {
       }
     }
 
-    for (auto& each_csr : host_sparse_buffer_) {
-      each_csr.new_row();
-    }
-    // do h2d
-    // wait buffer and schedule
-    
-    if (!wait_until_h2d_ready()) return;
-    buffer_->current_batch_size = current_batch_size;
-    {
-      CudaDeviceContext context(gpu_resource_->get_device_id());
-      auto dst_dense_tensor = Tensor2<float>::stretch_from(buffer_->device_dense_buffers);
-      CK_CUDA_THROW_(cudaMemcpyAsync(dst_dense_tensor.get_ptr(), host_dense_buffer_.get_ptr(),
-                                    host_dense_buffer_.get_size_in_bytes(), cudaMemcpyHostToDevice,
-                                    gpu_resource_->get_memcpy_stream()));
-
-      for (size_t param_id = 0; param_id < params_.size(); ++param_id) {
-        auto dst_sparse_tensor =
-            SparseTensor<T>::stretch_from(buffer_->device_sparse_buffers[param_id]);
-        if (buffer_->is_fixed_length[param_id] &&
-            last_batch_nnz_[param_id] == host_sparse_buffer_[param_id].get_num_values()) {
-          CK_CUDA_THROW_(cudaMemcpyAsync(dst_sparse_tensor.get_value_ptr(),
-                                        host_sparse_buffer_[param_id].get_value_tensor().get_ptr(),
-                                        host_sparse_buffer_[param_id].get_num_values() * sizeof(T),
-                                        cudaMemcpyHostToDevice,
-                                        gpu_resource_->get_memcpy_stream()));
-        } else {
-          sparse_tensor_helper::cuda::copy_async(dst_sparse_tensor, host_sparse_buffer_[param_id],
-                                                gpu_resource_->get_memcpy_stream());
-          last_batch_nnz_[param_id] = host_sparse_buffer_[param_id].get_num_values();
-        }
-      }
-      CK_CUDA_THROW_(cudaStreamSynchronize(gpu_resource_->get_memcpy_stream()));
-    }
-    assert(buffer_->state.load() == BufferState::Writing);
-    buffer_->state.store(BufferState::ReadyForRead);
+    write_batch(current_batch_size);
   }
 };
 
@@ -18,9 +18,11 @@
 
 #include <atomic>
 #include <common.hpp>
+#include <condition_variable>
 #include <data_readers/csr.hpp>
 #include <data_readers/data_reader_worker_interface.hpp>
 #include <fstream>
+#include <mutex>
 #include <thread>
 #include <vector>
 #include <tuple>
@@ -32,13 +34,17 @@ namespace HugeCTR {
  * @param data_reader a pointer of data_reader.
  * @param p_loop_flag a flag to control the loop,
           and break loop when IDataReaderWorker is destroyed.
+ * @param start_mutex start_cv notified when p_loop_flag or p_stop is set
+ * @param p_stop set when the thread has to exit, even if it was never started
  */
 
 static void data_reader_thread_func_(const std::shared_ptr<IDataReaderWorker>& data_reader,
-                                     int* p_loop_flag) {
+                                     int* p_loop_flag, std::mutex* start_mutex,
+                                     std::condition_variable* start_cv, bool* p_stop) {
   try {
-    while ((*p_loop_flag) == 0) {
-      usleep(2);
+    {
+      std::unique_lock<std::mutex> lock(*start_mutex);
+      start_cv->wait(lock, [p_loop_flag, p_stop]() { return *p_loop_flag != 0 || *p_stop; });
     }
 
     while (*p_loop_flag) {
@@ -53,6 +59,9 @@ class DataReaderWorkerGroup {
   std::vector<std::thread> data_reader_threads_; /**< A vector of the pointers of data reader .*/
  protected:
   int data_reader_loop_flag_{0};                 /**< p_loop_flag a flag to control the loop */
+  std::mutex start_mutex_;                       /**< guards the start of data_reader_loop_flag_ */
+  std::condition_variable start_cv_;
+  bool stop_{false};                             /**< guarded by start_mutex_ */
   DataReaderType_t data_reader_type_;
   std::vector<std::shared_ptr<IDataReaderWorker>>
       data_readers_; /**< A vector of DataReaderWorker' pointer.*/
@@ -68,7 +77,8 @@ class DataReaderWorkerGroup {
 
     for (auto& data_reader : data_readers_) {
       data_reader_threads_.emplace_back(data_reader_thread_func_, data_reader,
-                                        &data_reader_loop_flag_);
+                                        &data_reader_loop_flag_, &start_mutex_, &start_cv_,
+                                        &stop_);
       set_affinity(data_reader_threads_.back(), {}, true);
     }
   }
@@ -84,43 +94,73 @@ class DataReaderWorkerGroup {
     resource_manager_ = resource_manager;
   }
   bool is_started() const { return data_reader_loop_flag_; }
-  void start() { data_reader_loop_flag_ = 1; }
-  void end() {
-    // Make sure the data reader  threads escape the pre-main loop
-    if (data_reader_loop_flag_ == 0) {
+  void start() {
+    {
+      std::lock_guard<std::mutex> lock(start_mutex_);
       data_reader_loop_flag_ = 1;
-      sleep(2);
     }
-
-    // Data reader threads escape the main loop
-    data_reader_loop_flag_ = 0;
+    start_cv_.notify_all();
+  }
+  void end() {
+    // Data reader threads escape the pre-main loop, or the main loop and the buffer waits
+    {
+      std::lock_guard<std::mutex> lock(start_mutex_);
+      data_reader_loop_flag_ = 0;
+      stop_ = true;
+    }
+    start_cv_.notify_all();
     for (auto& data_reader : data_readers_) {
       data_reader->skip_read();
     }
+    join_data_reader_threads();
   }
 
-  virtual ~DataReaderWorkerGroup() {
+  virtual ~DataReaderWorkerGroup() { join_data_reader_threads(); }
+
+ private:
+  void join_data_reader_threads() {
     for (auto& data_reader_thread : data_reader_threads_) {
-      data_reader_thread.join();
+      if (data_reader_thread.joinable()) {
+        data_reader_thread.join();
+      }
     }
   }
 
+ public:
   void set_source(SourceType_t source_type, const std::string& file_name, bool repeat) {
     if (!((source_type == SourceType_t::FileList && data_reader_type_ == DataReaderType_t::Norm) ||
           (source_type == SourceType_t::Mmap && data_reader_type_ == DataReaderType_t::Raw))) {
       CK_THROW_(Error_t::WrongInput, "set_source only supports FileList for Norm & Mmap for Raw");
     }
     size_t num_workers = data_readers_.size();
+    size_t num_lanes = get_sources_per_worker();
     for (size_t worker_id = 0; worker_id < num_workers; worker_id++) {
       data_readers_[worker_id]->set_source(
-          create_source(worker_id, num_workers, file_name, repeat));
+          create_sources(worker_id, num_workers, num_lanes, file_name, repeat));
     }
     if (data_reader_loop_flag_ == 0) {
       start();
     }
   }
 
+ protected:
+  /**
+   * The sources of a worker which reads num_lanes files at the same time, the files are
+   * distributed to the lanes of all the workers like to num_workers * num_lanes workers.
+   */
+  std::vector<std::shared_ptr<Source>> create_sources(size_t worker_id, size_t num_workers,
+                                                     size_t num_lanes,
+                                                     const std::string& file_name, bool repeat) {
+    std::vector<std::shared_ptr<Source>> sources;
+    for (size_t lane = 0; lane < num_lanes; lane++) {
+      sources.push_back(create_source(worker_id * num_lanes + lane, num_workers * num_lanes,
+                                      file_name, repeat));
+    }
+    return sources;
+  }
+
 private:
+  virtual size_t get_sources_per_worker() const { return 1; }
   virtual std::shared_ptr<Source> create_source(size_t worker_id, size_t num_worker,
       const std::string& file_name, bool repeat) = 0;
 };
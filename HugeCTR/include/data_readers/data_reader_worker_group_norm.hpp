@@ -24,9 +24,29 @@ namespace HugeCTR {
 template <typename TypeKey>
 class DataReaderWorkerGroupNorm : public DataReaderWorkerGroup {
   std::string file_list_; /**< file list of data set */
+  bool data_shuffle_;      /**< whether to shuffle the blocks of a v2 data set */
+  std::shared_ptr<NormV2BlockList> block_list_; /**< the blocks read by the workers, v2 only */
+  ShuffleBufferParam shuffle_buffer_; /**< the shuffle buffer of all the workers, its seed also
+                                         permutes the blocks */
+  size_t max_record_bytes_{0};        /**< bounds the compressed blocks of a v2 data set */
+
+  size_t get_sources_per_worker() const override {
+    return shuffle_buffer_.enabled() ? std::max(shuffle_buffer_.num_open_files, 1) : 1;
+  }
 
   std::shared_ptr<Source> create_source(size_t worker_id, size_t num_worker,
       const std::string& file_name, bool repeat) override {
+    // the workers of a v2 data set share a new block list every time the source is set
+    if (worker_id == 0) {
+      block_list_ = is_norm_v2_file_list(file_name)
+                        ? std::make_shared<NormV2BlockList>(file_name, data_shuffle_,
+                                                            shuffle_buffer_.seed)
+                        : nullptr;
+    }
+    if (block_list_) {
+      return std::make_shared<FileSource>(block_list_, worker_id, num_worker, repeat,
+                                          max_record_bytes_);
+    }
     return std::make_shared<FileSource>(worker_id, num_worker, file_name, repeat);
   }
 
@@ -38,8 +58,12 @@ class DataReaderWorkerGroupNorm : public DataReaderWorkerGroup {
                             bool repeat,
                             Check_t check_type,
                             const std::vector<DataReaderSparseParam> &params,
-                            bool start_reading_from_beginning = true)
-      : DataReaderWorkerGroup(start_reading_from_beginning, DataReaderType_t::Norm) {
+                            bool start_reading_from_beginning = true,
+                            bool data_shuffle = false,
+                            const ShuffleBufferParam& shuffle_buffer = ShuffleBufferParam())
+      : DataReaderWorkerGroup(start_reading_from_beginning, DataReaderType_t::Norm),
+        data_shuffle_(data_shuffle),
+        shuffle_buffer_(shuffle_buffer) {
     if (file_list.empty()) {
       CK_THROW_(Error_t::WrongInput, "file_name.empty()");
     }
@@ -48,20 +72,63 @@ class DataReaderWorkerGroupNorm : public DataReaderWorkerGroup {
     
     // create data reader workers
     int max_feature_num_per_sample = 0;
+    int total_slot_num = 0;
     for (auto& param : params) {
       max_feature_num_per_sample += param.max_feature_num;
+      total_slot_num += param.slot_num;
 
       if (param.max_feature_num <= 0 || param.slot_num <= 0) {
         CK_THROW_(Error_t::WrongInput, "param.max_feature_num <= 0 || param.slot_num <= 0");
       }
     }
+    max_record_bytes_ = get_norm_v2_max_record_bytes(
+        output_buffers[0]->label_dim + output_buffers[0]->dense_dim, total_slot_num,
+        max_feature_num_per_sample, sizeof(TypeKey));
     
+    // the memory budget is shared by the workers
+    ShuffleBufferParam worker_shuffle_buffer = shuffle_buffer;
+    worker_shuffle_buffer.memory_bytes /= num_threads;
     for (int i = 0; i < num_threads; i++) {
+      auto sources = create_sources(i, num_threads, get_sources_per_worker(), file_list, repeat);
       std::shared_ptr<IDataReaderWorker> data_reader(new DataReaderWorker<TypeKey>(
-          i, num_threads, resource_manager_->get_local_gpu(i % local_gpu_count), &data_reader_loop_flag_, output_buffers[i], file_list, max_feature_num_per_sample, repeat, check_type, params));
+          i, num_threads, resource_manager_->get_local_gpu(i % local_gpu_count), &data_reader_loop_flag_, output_buffers[i], file_list, max_feature_num_per_sample, repeat, check_type, params,
+          sources[0], worker_shuffle_buffer, {sources.begin() + 1, sources.end()}));
       data_readers_.push_back(data_reader);
     }
+    if (shuffle_buffer_.enabled()) {
+      const auto stats = get_shuffle_buffer_stats();
+      MESSAGE_("shuffle buffer: " + std::to_string(stats.capacity) + " samples, " +
+               std::to_string(stats.memory_bytes >> 20) + " MiB, " +
+               std::to_string(get_sources_per_worker() * num_threads) + " open files");
+    }
     create_data_reader_threads();
   }
+
+  ~DataReaderWorkerGroupNorm() {
+    const auto stats = get_shuffle_buffer_stats();
+    if (stats.samples > 0) {
+      MESSAGE_("shuffle buffer: " + std::to_string(stats.samples) + " samples drawn, " +
+               std::to_string(stats.fill_seconds) + " s to fill, " +
+               std::to_string(stats.draw_seconds) + " s to draw (in all the workers)");
+    }
+  }
+
+  /**
+   * The sum of the shuffle buffers of the workers.
+   */
+  ShuffleBufferStats get_shuffle_buffer_stats() const {
+    ShuffleBufferStats stats;
+    for (auto& data_reader : data_readers_) {
+      const auto worker_stats =
+          std::dynamic_pointer_cast<DataReaderWorker<TypeKey>>(data_reader)
+              ->get_shuffle_buffer_stats();
+      stats.capacity += worker_stats.capacity;
+      stats.memory_bytes += worker_stats.memory_bytes;
+      stats.samples += worker_stats.samples;
+      stats.fill_seconds += worker_stats.fill_seconds;
+      stats.draw_seconds += worker_stats.draw_seconds;
+    }
+    return stats;
+  }
 };
 }  // namespace HugeCTR
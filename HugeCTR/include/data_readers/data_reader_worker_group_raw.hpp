@@ -29,14 +29,29 @@ class DataReaderWorkerGroupRaw : public DataReaderWorkerGroup {
   long long stride_;
   long long batchsize_;
   bool data_shuffle_;
+  unsigned long long seed_; /**< the seed of the shuffle, the same on all the nodes */
+  bool use_huge_pages_;
+
+  // samples are shuffled in chunks of about this many bytes, several pages each
+  static constexpr long long kShuffleChunkBytes = 64 * 1024;
+  // the readahead thread advises this many batches per worker ahead of the workers
+  static constexpr long long kReadaheadBatchesPerWorker = 2;
+
+  std::shared_ptr<MmapOffsetList> create_offset_list(const std::string& file_name, int num_workers,
+                                                     bool repeat) {
+    const long long chunk_samples = std::max(kShuffleChunkBytes / stride_, 1ll);
+    return std::make_shared<MmapOffsetList>(file_name, num_samples_, stride_, batchsize_,
+                                            data_shuffle_, num_workers, repeat, chunk_samples, seed_,
+                                            kReadaheadBatchesPerWorker * num_workers,
+                                            use_huge_pages_);
+  }
 
   std::shared_ptr<Source> create_source(size_t worker_id, size_t num_worker,
       const std::string& file_name, bool repeat) override {
 
     std::shared_ptr<MmapOffsetList> mmap_offset_list;
     if (!worker_id && create_offset_) {
-      file_offset_list_.reset(new MmapOffsetList(
-          file_name, num_samples_, stride_, batchsize_, data_shuffle_, num_worker, repeat));
+      file_offset_list_ = create_offset_list(file_name, num_worker, repeat);
       create_offset_ = false;
     }
     mmap_offset_list = file_offset_list_;
@@ -53,11 +68,14 @@ class DataReaderWorkerGroupRaw : public DataReaderWorkerGroup {
                            const std::vector<DataReaderSparseParam> params,
                            int label_dim, int dense_dim,
                            int batchsize, bool float_label_dense, bool data_shuffle = false,
-                           bool start_reading_from_beginning = true)
+                           bool start_reading_from_beginning = true,
+                           unsigned long long seed = 0, bool use_huge_pages = false)
       : DataReaderWorkerGroup(start_reading_from_beginning, DataReaderType_t::Raw),
         num_samples_(num_samples),
         batchsize_(batchsize),
-        data_shuffle_(data_shuffle) {
+        data_shuffle_(data_shuffle),
+        seed_(seed),
+        use_huge_pages_(use_huge_pages) {
     // todo param check
     if (file_name.empty()) {
       CK_THROW_(Error_t::WrongInput, "file_name.empty()");
@@ -72,9 +90,8 @@ class DataReaderWorkerGroupRaw : public DataReaderWorkerGroup {
       }
       size_t stride = slots * sizeof(int) +
                       (label_dim + dense_dim) * (float_label_dense ? sizeof(float) : sizeof(int));
-      file_offset_list_.reset(new MmapOffsetList(file_name, num_samples, stride, batchsize,
-                                                 data_shuffle, num_workers, repeat));
       stride_ = stride;
+      file_offset_list_ = create_offset_list(file_name, num_workers, repeat);
     }
 
     for (size_t i = 0; i < num_workers; i++) {
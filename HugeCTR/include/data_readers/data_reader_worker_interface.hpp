@@ -18,6 +18,7 @@
 #include <common.hpp>
 #include <data_readers/source.hpp>
 #include <memory>
+#include <vector>
 
 namespace HugeCTR {
 class IDataReaderWorker {
@@ -25,13 +26,22 @@ class IDataReaderWorker {
   virtual void read_a_batch() {};
   virtual void skip_read() {};
   void set_source(std::shared_ptr<Source> source) {
+    set_source(std::vector<std::shared_ptr<Source>>{source});
+  }
+
+  /**
+   * Set the sources of a worker which reads several files at the same time, the first one
+   * becomes source_.
+   */
+  void set_source(const std::vector<std::shared_ptr<Source>>& sources) {
     if (!is_eof_) {
       CK_THROW_(Error_t::IllegalCall,
           "DataSource cannot be changed in the \"repeat\" mode or when a data reader worker is not in the EOF state.");
     }
 
     pre_set_source();
-    source_ = source;
+    source_ = sources.at(0);
+    lane_sources_.assign(sources.begin() + 1, sources.end());
     post_set_source();
   }
 
@@ -41,6 +51,7 @@ class IDataReaderWorker {
 
  protected:
   std::shared_ptr<Source> source_; /**< source: can be file or network */
+  std::vector<std::shared_ptr<Source>> lane_sources_; /**< the other sources read along source_ */
 
   int worker_id_;
   int worker_num_;
@@ -54,13 +65,17 @@ class IDataReaderWorker {
   IDataReaderWorker(const int worker_id, const int worker_num, const std::shared_ptr<GPUResource>& gpu_resource, bool is_eof, int *loop_flag, const std::shared_ptr<ThreadBuffer> &buff) : worker_id_(worker_id), worker_num_(worker_num), gpu_resource_(gpu_resource), is_eof_(is_eof), loop_flag_(loop_flag), buffer_(buff)  { }
 
   bool wait_until_h2d_ready() {
-    BufferState expected = BufferState::ReadyForWrite;
-    while (!buffer_->state.compare_exchange_weak(expected, BufferState::Writing)) {
-      expected = BufferState::ReadyForWrite;
-      usleep(2);
-      if(*loop_flag_ == 0) return false; // in case main thread exit
-    }
-    return true;
+    // in case main thread exit
+    return buffer_->state.wait_and_exchange(BufferState::ReadyForWrite, BufferState::Writing,
+                                            [this]() { return *loop_flag_ == 0; });
+  }
+
+  /**
+   * Wait for the collector to release the FileEOF buffer.
+   */
+  bool wait_until_eof_released() {
+    return buffer_->state.wait_for(BufferState::ReadyForWrite,
+                                   [this]() { return *loop_flag_ == 0; });
   }
   
  private:
@@ -15,6 +15,8 @@
  */
 
 #pragma once
+#include <sys/resource.h>
+#include <chrono>
 #include <common.hpp>
 #include <data_readers/check_none.hpp>
 #include <data_readers/csr.hpp>
@@ -38,25 +40,60 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
   Tensor2<float> host_dense_buffer_;
   std::vector<CSR<T>> host_sparse_buffer_;
 
+  // page faults taken while parsing the mmapped batches
+  long long num_parsed_batches_{0};
+  long long num_major_faults_{0};
+  long long parse_time_us_{0};
+  long long fault_parse_time_us_{0}; /**< parse time of the batches with a major fault */
+
+  static long long get_thread_major_faults() {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_majflt;
+  }
+
   void read_new_file() {
-    Error_t flag = source_->next_source();
-    if (flag == Error_t::EndOfFile) {
-      throw internal_runtime_error(Error_t::EndOfFile, "EndOfFile");
+    // a batch which cannot be read, e.g. with a corrupted block of a compressed file, is skipped
+    constexpr int MAX_TRY = 10;
+    for (int i = 0; i < MAX_TRY; i++) {
+      Error_t flag = source_->next_source();
+      if (flag == Error_t::EndOfFile) {
+        throw internal_runtime_error(Error_t::EndOfFile, "EndOfFile");
+      }
+      if (flag == Error_t::Success) {
+        return;
+      }
+      ERROR_MESSAGE_("failed to read a batch, skipped");
+    }
+    CK_THROW_(Error_t::BrokenFile, "failed to read a batch");
+  }
+
+  template <typename Allocator>
+  void allocate_host_buffers(const std::shared_ptr<GeneralBuffer2<Allocator>>& buff, bool pinned) {
+    int batch_size = buffer_->batch_size;
+    buff->reserve({static_cast<size_t>(buffer_->batch_size_end_idx - buffer_->batch_size_start_idx),
+                   static_cast<size_t>(buffer_->label_dim + buffer_->dense_dim)},
+                  &host_dense_buffer_);
+
+    for (auto& param : params_) {
+      host_sparse_buffer_.emplace_back(batch_size * param.slot_num,
+                                       batch_size * param.max_feature_num, pinned);
     }
+
+    buff->allocate();
   }
 
   void post_set_source() override {
     auto expected = BufferState::FileEOF;
-    while (buffer_->state.compare_exchange_weak(expected, BufferState::ReadyForWrite)) {
-      expected = BufferState::FileEOF;
-      usleep(2);
-    }
+    buffer_->state.compare_exchange_strong(expected, BufferState::ReadyForWrite);
     is_eof_ = false;
   }
 
  public:
   /**
    * Ctor
+   * @param gpu_resource the device the batches are copied to, if null the batches are only parsed
+   * into host memory
    */
   DataReaderWorkerRaw(const int worker_id, const int worker_num,
                       const std::shared_ptr<GPUResource>& gpu_resource, int* loop_flag,
@@ -74,30 +111,26 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
 
     source_ = std::make_shared<MmapSource>(file_offset_list, worker_id);
 
-    int batch_size = buffer->batch_size;
-    int batch_size_start_idx = buffer->batch_size_start_idx;
-    int batch_size_end_idx = buffer->batch_size_end_idx;
-    int label_dim = buffer->label_dim;
-    int dense_dim = buffer->dense_dim;
-
-    CudaDeviceContext ctx(gpu_resource->get_device_id());
-    std::shared_ptr<GeneralBuffer2<CudaHostAllocator>> buff =
-        GeneralBuffer2<CudaHostAllocator>::create();
-
-    buff->reserve({static_cast<size_t>(batch_size_end_idx - batch_size_start_idx),
-                   static_cast<size_t>(label_dim + dense_dim)},
-                  &host_dense_buffer_);
-
-    for (auto& param : params) {
-      host_sparse_buffer_.emplace_back(batch_size * param.slot_num,
-                                       batch_size * param.max_feature_num);
+    if (gpu_resource) {
+      CudaDeviceContext ctx(gpu_resource->get_device_id());
+      allocate_host_buffers(GeneralBuffer2<CudaHostAllocator>::create(), true);
+    } else {
+      allocate_host_buffers(GeneralBuffer2<HostAllocator>::create(), false);
     }
-
-    buff->allocate();
     for (auto& param : params) {
       total_slot_num_ += param.slot_num;
     }
   }
+
+  ~DataReaderWorkerRaw() {
+    if (num_parsed_batches_ > 0) {
+      MESSAGE_("Raw data reader worker " + std::to_string(worker_id_) + ": " +
+               std::to_string(num_parsed_batches_) + " batches, " +
+               std::to_string(num_major_faults_) + " major page faults, parse time " +
+               std::to_string(parse_time_us_) + " us, " + std::to_string(fault_parse_time_us_) +
+               " us of it in the batches with a major fault");
+    }
+  }
   /**
    * read a batch of data from data set to heap.
    */
@@ -114,10 +147,7 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
         is_eof_ = true;
         if (!wait_until_h2d_ready()) return;
         buffer_->state.store(BufferState::FileEOF);
-        while (buffer_->state.load() != BufferState::ReadyForWrite) {
-          usleep(2);
-          if (*loop_flag_ == 0) return;
-        }
+        wait_until_eof_released();
         return;
       } else {
         throw;
@@ -130,7 +160,12 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
                 << "batchsize: " << buffer_->batch_size << std::endl;
     }
 
-    char* data_buffer = source_->get_ptr();
+    // the source of a Raw worker is always a MmapSource
+    const std::vector<MmapChunk>& chunks = static_cast<MmapSource&>(*source_).get_chunks();
+    size_t chunk_id = 0;
+    long long sample_in_chunk = 0;
+    const long long major_faults_begin = get_thread_major_faults();
+    const auto parse_begin = std::chrono::steady_clock::now();
     int label_dim = buffer_->label_dim;
     int dense_dim = buffer_->dense_dim;
     int label_dense_dim = label_dim + dense_dim;
@@ -163,7 +198,11 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
         }
         continue;
       }
-      char* sample_cur = data_buffer + sample_length * batch_idx;
+      char* sample_cur = chunks[chunk_id].offset + sample_length * sample_in_chunk;
+      if (++sample_in_chunk == chunks[chunk_id].samples) {
+        chunk_id++;
+        sample_in_chunk = 0;
+      }
 
       if (batch_idx >= batch_size_start_idx &&
           batch_idx < batch_size_end_idx) {  // only read local device dense data
@@ -200,12 +239,25 @@ class DataReaderWorkerRaw : public IDataReaderWorker {
     for (auto& each_csr : host_sparse_buffer_) {
       each_csr.new_row();
     }
+    {
+      const long long major_faults = get_thread_major_faults() - major_faults_begin;
+      const long long parse_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::chrono::steady_clock::now() - parse_begin)
+                                          .count();
+      num_parsed_batches_++;
+      num_major_faults_ += major_faults;
+      parse_time_us_ += parse_time_us;
+      if (major_faults > 0) {
+        fault_parse_time_us_ += parse_time_us;
+      }
+    }
 
     // do h2d
     // wait buffer and schedule
     if (!wait_until_h2d_ready()) return;
     buffer_->current_batch_size = current_batchsize;
-    {
+    // without a device the batch is only parsed, it stays in the host buffers
+    if (gpu_resource_) {
       CudaDeviceContext context(gpu_resource_->get_device_id());
       auto dst_dense_tensor = Tensor2<float>::stretch_from(buffer_->device_dense_buffers);
       CK_CUDA_THROW_(cudaMemcpyAsync(dst_dense_tensor.get_ptr(), host_dense_buffer_.get_ptr(),
@@ -16,32 +16,277 @@
 
 #pragma once
 #include <common.hpp>
+#include <data_readers/block_codec.hpp>
 #include <data_readers/file_list.hpp>
+#include <data_readers/norm_v2_block_list.hpp>
 #include <data_readers/source.hpp>
-#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <memory>
 #include <vector>
 
 namespace HugeCTR {
 
+/**
+ * Reads the files of a data set in large aligned chunks with pread. The next chunk is read in the
+ * background while the current one is consumed, and read_view hands out pointers into the chunk
+ * so that the parser can decode the samples in place.
+ * With a NormV2BlockList, each source is a block of the list instead of a whole file, at the
+ * positions offset, offset + stride, ... of its sequence, and the reads are limited to the bytes
+ * of the block. A compressed block is read at once and
+ * decompressed on the calling thread, then the reads are served from the decompressed block.
+ */
 class FileSource : public Source {
  private:
-  FileList file_list_;           /**< file list of data set */
-  std::ifstream in_file_stream_; /**< file stream of data set file */
+  struct FreeDeleter {
+    void operator()(char* ptr) const { free(ptr); }
+  };
+  using ChunkPtr = std::unique_ptr<char, FreeDeleter>;
+  static constexpr size_t kAlignment = 4096;
+
+  std::unique_ptr<FileList> file_list_; /**< file list of data set */
+  std::shared_ptr<NormV2BlockList> block_list_; /**< blocks of a v2 data set, instead of file_list_ */
+  int fd_{-1};                   /**< file descriptor of the current file */
   std::string file_name_;        /**< file name of current file */
   const long long offset_;
   const long long stride_;
   bool repeat_;
   unsigned int counter_{0};
 
+  const size_t chunk_size_;      /**< bytes read by each pread */
+  ChunkPtr chunks_[2];           /**< the chunk being consumed and the one being read */
+  size_t chunk_id_{0};           /**< index of the chunk being consumed in chunks_ */
+  size_t chunk_pos_{0};          /**< read position in the current chunk */
+  size_t chunk_len_{0};          /**< valid bytes in the current chunk */
+  bool chunk_eof_{false};        /**< whether the current chunk is the last one of the file */
+  off_t file_offset_{0};         /**< file offset of the chunk being read */
+  off_t file_end_{std::numeric_limits<off_t>::max()}; /**< end of the bytes of the source */
+  std::future<ssize_t> next_chunk_; /**< the pread of the next chunk */
+  std::vector<char> spill_;      /**< a view that straddles 2 chunks is stitched here */
+
+  size_t max_record_bytes_{0};   /**< bounds the decompressed size of a block */
+  bool decompressed_{false};     /**< whether the reads are served from block_data_ */
+  std::vector<char> compressed_; /**< the compressed bytes of the current block */
+  std::vector<char> block_data_; /**< the decompressed current block */
+  size_t block_pos_{0};          /**< read position in block_data_ */
+  size_t block_len_{0};          /**< valid bytes in block_data_ */
+
+  static ChunkPtr allocate_chunk(size_t size) {
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, kAlignment, size) != 0) {
+      CK_THROW_(Error_t::OutOfMemory, "posix_memalign failed");
+    }
+    return ChunkPtr(static_cast<char*>(ptr));
+  }
+
+  /**
+   * pread until size bytes are read or the end of the file.
+   * @return the bytes read, or < 0 on error
+   */
+  static ssize_t pread_fully(int fd, char* buf, size_t size, off_t offset) {
+    size_t total = 0;
+    while (total < size) {
+      const ssize_t n = pread(fd, buf + total, size - total, offset + total);
+      if (n < 0) {
+        return n;
+      }
+      if (n == 0) {
+        break;
+      }
+      total += n;
+    }
+    return static_cast<ssize_t>(total);
+  }
+
+  void read_next_chunk_async() {
+    char* chunk = chunks_[chunk_id_ ^ 1].get();
+    const int fd = fd_;
+    const off_t offset = file_offset_;
+    const size_t chunk_size = std::min(static_cast<off_t>(chunk_size_), file_end_ - offset);
+    file_offset_ += chunk_size;
+    next_chunk_ = std::async(std::launch::async, [chunk, fd, chunk_size, offset]() {
+      return pread_fully(fd, chunk, chunk_size, offset);
+    });
+  }
+
+  /**
+   * Make the chunk read in the background the current one.
+   * @return `Success`, `OutOfBound` at the end of the file or `UnspecificError`
+   */
+  Error_t advance_chunk() {
+    if (chunk_eof_ || !next_chunk_.valid()) {
+      return Error_t::OutOfBound;
+    }
+    const ssize_t len = next_chunk_.get();
+    if (len < 0) {
+      return Error_t::UnspecificError;
+    }
+    chunk_id_ ^= 1;
+    chunk_pos_ = 0;
+    chunk_len_ = len;
+    chunk_eof_ = static_cast<size_t>(len) < chunk_size_;
+    if (!chunk_eof_) {
+      try {
+        read_next_chunk_async();
+      } catch (const std::runtime_error& rt_err) {
+        std::cerr << rt_err.what() << std::endl;
+        return Error_t::UnspecificError;
+      }
+    }
+    return chunk_len_ > 0 ? Error_t::Success : Error_t::OutOfBound;
+  }
+
+  void reset_chunks() {
+    if (next_chunk_.valid()) {
+      next_chunk_.wait();
+      next_chunk_ = std::future<ssize_t>();
+    }
+    chunk_pos_ = 0;
+    chunk_len_ = 0;
+    chunk_eof_ = false;
+    file_offset_ = 0;
+    file_end_ = std::numeric_limits<off_t>::max();
+    decompressed_ = false;
+  }
+
+  void close_file() {
+    reset_chunks();
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  /**
+   * Seek to the next block of block_list_, the file is kept open across its blocks.
+   */
+  Error_t next_block() {
+    NormV2BlockList::Block block;
+    const unsigned long long position = offset_ + static_cast<long long>(counter_) * stride_;
+    counter_++;
+    if (!block_list_->get_block(position, repeat_, &block)) {
+      close_file();
+      return Error_t::EndOfFile;
+    }
+    const std::string& file_name = block_list_->get_file_name(block.file_id);
+    if (fd_ < 0 || file_name != file_name_) {
+      close_file();
+      fd_ = open(file_name.c_str(), O_RDONLY);
+      if (fd_ < 0) {
+        CK_RETURN_(Error_t::FileCannotOpen, "open() failed: " + file_name);
+      }
+      file_name_ = file_name;
+    } else {
+      reset_chunks();
+    }
+    const Compression_t compression = block_list_->get_compression(block.file_id);
+    if (compression != Compression_t::None) {
+      return read_compressed_block(block.info, compression);
+    }
+    file_offset_ = block.info.offset;
+    file_end_ = block.info.offset + block.info.size;
+    posix_fadvise(fd_, block.info.offset, block.info.size, POSIX_FADV_WILLNEED);
+    read_next_chunk_async();
+    return Error_t::Success;
+  }
+
+  /**
+   * Read the whole compressed block and decompress it into block_data_.
+   */
+  Error_t read_compressed_block(const NormV2BlockInfo& info, Compression_t compression) {
+    const size_t size = info.size;
+    try {
+      if (compressed_.size() < size) {
+        compressed_.resize(size);
+      }
+    } catch (const std::bad_alloc&) {
+      CK_RETURN_(Error_t::BrokenFile, "a block of " + std::to_string(size) + " bytes in " +
+                                          file_name_);
+    }
+    if (pread_fully(fd_, compressed_.data(), size, info.offset) != static_cast<ssize_t>(size)) {
+      CK_RETURN_(Error_t::BrokenFile, "failed to read a block of " + file_name_);
+    }
+    // the size comes from the file, so it is bounded by the records of the block before the
+    // buffer is sized by it, the header taking at most a record
+    const long long raw_size = get_decompressed_size(compressed_.data(), size);
+    const long long records_bytes = raw_size - static_cast<long long>(sizeof(DataSetHeader));
+    if (records_bytes < 0 ||
+        records_bytes / static_cast<long long>(max_record_bytes_) > info.num_records) {
+      CK_RETURN_(Error_t::BrokenFile, "broken compressed block in " + file_name_ + ": " +
+                                          std::to_string(raw_size) + " bytes for " +
+                                          std::to_string(info.num_records) + " records");
+    }
+    try {
+      if (block_data_.size() < static_cast<size_t>(raw_size)) {
+        block_data_.resize(raw_size);
+      }
+    } catch (const std::bad_alloc&) {
+      CK_RETURN_(Error_t::OutOfMemory, "a block of " + std::to_string(raw_size) + " bytes in " +
+                                           file_name_);
+    }
+    if (!decompress_block(compression, compressed_.data(), size, block_data_.data())) {
+      CK_RETURN_(Error_t::BrokenFile, "failed to decompress a block of " + file_name_);
+    }
+    block_pos_ = 0;
+    block_len_ = raw_size;
+    decompressed_ = true;
+    return Error_t::Success;
+  }
+
  public:
+  /**
+   * Ctor
+   * @param chunk_size bytes read from the file at once, rounded up to the alignment
+   */
   FileSource(long long offset,
              long long stride,
              const std::string& file_list,
-             bool repeat)
-      : file_list_(file_list),
+             bool repeat,
+             size_t chunk_size = 4 * 1024 * 1024)
+      : file_list_(new FileList(file_list)),
       offset_(offset),
       stride_(stride),
-      repeat_(repeat) { }
+      repeat_(repeat),
+      chunk_size_((std::max(chunk_size, static_cast<size_t>(1)) + kAlignment - 1) / kAlignment *
+                  kAlignment) {
+    chunks_[0] = allocate_chunk(chunk_size_);
+    chunks_[1] = allocate_chunk(chunk_size_);
+  }
+
+  /**
+   * Ctor of a source that reads the blocks of a v2 data set
+   * @param block_list the blocks, shared with the sources of the other workers
+   * @param offset the first position of the source in the sequence of blocks, i.e. its worker
+   * @param stride the positions between the blocks of the source, i.e. the number of workers
+   * @param max_record_bytes the bytes of a record at most, see get_norm_v2_max_record_bytes
+   * @param chunk_size bytes read from the file at once, rounded up to the alignment
+   */
+  FileSource(const std::shared_ptr<NormV2BlockList>& block_list,
+             long long offset,
+             long long stride,
+             bool repeat,
+             size_t max_record_bytes,
+             size_t chunk_size = 4 * 1024 * 1024)
+      : block_list_(block_list),
+      offset_(offset),
+      stride_(stride),
+      repeat_(repeat),
+      chunk_size_((std::max(chunk_size, static_cast<size_t>(1)) + kAlignment - 1) / kAlignment *
+                  kAlignment),
+      max_record_bytes_(max_record_bytes) {
+    if (max_record_bytes_ == 0) {
+      CK_THROW_(Error_t::WrongInput, "max_record_bytes == 0");
+    }
+    chunks_[0] = allocate_chunk(chunk_size_);
+    chunks_[1] = allocate_chunk(chunk_size_);
+  }
+
+  ~FileSource() { close_file(); }
 
   /**
    * Read "bytes_to_read" byte to the memory associated to ptr.
@@ -50,42 +295,90 @@ class FileSource : public Source {
    * @return `FileCannotOpen` `OutOfBound` `Success` `UnspecificError`
    */
   Error_t read(char* ptr, size_t bytes_to_read) noexcept {
-    try {
-      if (!in_file_stream_.is_open()) {
-        return Error_t::FileCannotOpen;
-      }
-      if (bytes_to_read > 0) {
-        in_file_stream_.read(ptr, bytes_to_read);
+    if (fd_ < 0) {
+      return Error_t::FileCannotOpen;
+    }
+    if (decompressed_) {
+      const size_t n = std::min(bytes_to_read, block_len_ - block_pos_);
+      memcpy(ptr, block_data_.data() + block_pos_, n);
+      block_pos_ += n;
+      return n == bytes_to_read ? Error_t::Success : Error_t::OutOfBound;
+    }
+    while (bytes_to_read > 0) {
+      if (chunk_pos_ == chunk_len_) {
+        Error_t err = advance_chunk();
+        if (err != Error_t::Success) {
+          return err;
+        }
       }
-      if (in_file_stream_.gcount() != static_cast<int>(bytes_to_read)) {
+      const size_t n = std::min(bytes_to_read, chunk_len_ - chunk_pos_);
+      memcpy(ptr, chunks_[chunk_id_].get() + chunk_pos_, n);
+      chunk_pos_ += n;
+      ptr += n;
+      bytes_to_read -= n;
+    }
+    return Error_t::Success;
+  }
+
+  /**
+   * Point ptr to the next "bytes_to_read" bytes without copying them out of the chunk, unless
+   * they straddle 2 chunks. The view is valid until the next call to read, read_view or
+   * next_source.
+   * @return `FileCannotOpen` `OutOfBound` `Success` `UnspecificError`
+   */
+  Error_t read_view(const char** ptr, size_t bytes_to_read) noexcept {
+    if (fd_ < 0) {
+      return Error_t::FileCannotOpen;
+    }
+    if (decompressed_) {
+      if (block_len_ - block_pos_ < bytes_to_read) {
+        block_pos_ = block_len_;
         return Error_t::OutOfBound;
       }
+      *ptr = block_data_.data() + block_pos_;
+      block_pos_ += bytes_to_read;
       return Error_t::Success;
-    } catch (const std::runtime_error& rt_err) {
-      std::cerr << rt_err.what() << std::endl;
-      return Error_t::UnspecificError;
     }
+    if (chunk_len_ - chunk_pos_ >= bytes_to_read) {
+      *ptr = chunks_[chunk_id_].get() + chunk_pos_;
+      chunk_pos_ += bytes_to_read;
+      return Error_t::Success;
+    }
+    try {
+      if (spill_.size() < bytes_to_read) {
+        spill_.resize(bytes_to_read);
+      }
+    } catch (const std::bad_alloc&) {
+      return Error_t::OutOfMemory;
+    }
+    Error_t err = read(spill_.data(), bytes_to_read);
+    *ptr = spill_.data();
+    return err;
   }
 
   /**
-   * Start a new file to read.
-   * @return `Success`, `FileCannotOpen` or `UnspecificError`
+   * Start a new file, or a new block of a v2 data set, to read.
+   * @return `Success`, `EndOfFile`, `FileCannotOpen` or `UnspecificError`
    */
   Error_t next_source() noexcept {
     try {
-      if (in_file_stream_.is_open()) {
-        in_file_stream_.close();
+      if (block_list_) {
+        return next_block();
       }
-      std::string file_name = file_list_.get_a_file_with_id(offset_ + counter_ * stride_,
+      close_file();
+      std::string file_name = file_list_->get_a_file_with_id(offset_ + counter_ * stride_,
                                                             repeat_);
       counter_++;  // counter_ should be accum for every source.
       if (file_name.empty()) {
         return Error_t::EndOfFile;
       }
-      in_file_stream_.open(file_name, std::ifstream::binary);
-      if (!in_file_stream_.is_open()) {
-        CK_RETURN_(Error_t::FileCannotOpen, "in_file_stream_.is_open() failed: " + file_name);
+      fd_ = open(file_name.c_str(), O_RDONLY);
+      if (fd_ < 0) {
+        CK_RETURN_(Error_t::FileCannotOpen, "open() failed: " + file_name);
       }
+      file_name_ = file_name;
+      posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+      read_next_chunk_async();
       return Error_t::Success;
     } catch (const std::runtime_error& rt_err) {
       std::cerr << rt_err.what() << std::endl;
@@ -93,7 +386,7 @@ class FileSource : public Source {
     }
   }
 
-  bool is_open() noexcept { return in_file_stream_.is_open(); }
+  bool is_open() noexcept { return fd_ >= 0; }
 };
 
 }  // namespace HugeCTR
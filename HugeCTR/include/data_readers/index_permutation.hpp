@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstdint>
+
+namespace HugeCTR {
+
+/**
+ * @brief A pseudo-random permutation of [0, n) which is a pure function of the index and the key.
+ *
+ * A 4-round Feistel network over the smallest power of 4 >= n, cycle-walked into [0, n), so that
+ * any thread can map an index without the permutation being stored or shared.
+ */
+class IndexPermutation {
+  uint64_t n_;
+  int half_bits_{0};
+  uint64_t half_mask_{0};
+
+  static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+  }
+
+  uint64_t encrypt(uint64_t i, uint64_t key) const {
+    uint64_t left = i >> half_bits_;
+    uint64_t right = i & half_mask_;
+    for (uint64_t round = 0; round < 4; round++) {
+      const uint64_t next_right = left ^ (mix(right ^ key ^ (round << 56)) & half_mask_);
+      left = right;
+      right = next_right;
+    }
+    return (left << half_bits_) | right;
+  }
+
+ public:
+  IndexPermutation(uint64_t n) : n_(n) {
+    while ((uint64_t(1) << (2 * half_bits_)) < n_) {
+      half_bits_++;
+    }
+    half_mask_ = (uint64_t(1) << half_bits_) - 1;
+  }
+
+  /**
+   * @param key the key of the permutation, e.g. derived from a seed and the epoch
+   */
+  uint64_t operator()(uint64_t i, uint64_t key) const {
+    if (n_ <= 1) {
+      return i;
+    }
+    do {
+      i = encrypt(i, key);
+    } while (i >= n_);
+    return i;
+  }
+
+  static uint64_t make_key(uint64_t seed, uint64_t epoch) {
+    return mix(seed * 0x9e3779b97f4a7c15ull + epoch + 1);
+  }
+};
+
+}  // namespace HugeCTR
@@ -23,84 +23,269 @@
 #include <unistd.h>
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
-#include <random>
+#include <mutex>
+#include <thread>
 #include <vector>
 
+#include "data_readers/index_permutation.hpp"
+#include "data_readers/raw_compressed.hpp"
+
 namespace HugeCTR {
 
-struct MmapOffset {
-  char* offset;
+/**
+ * Contiguous samples of the file.
+ */
+struct MmapChunk {
+  char* offset;            /**< the samples in the mapping, or in the batch buffer once decompressed */
   long long samples;
+  long long first_sample;  /**< index of the first sample in the file */
+};
+
+/**
+ * The samples of a batch, in 1 or more chunks of the file.
+ */
+struct MmapOffset {
+  long long samples{0};
+  std::vector<MmapChunk> chunks;
 };
 
 /**
- * @brief A threads safe file list implementation.
+ * @brief The batches of a Raw data set, shared by the workers of a data reader.
  *
- * FileList reads file list from text file, and maintains a vector of file name. It supports
- * getting file names with multiple threads. All the threads will get the names in order.
- * Text file begins with the number of files, and then the list of file names.
- * @verbatim
- * Text file example:
- * 3
- * 1.txt
- * 2.txt
- * 3.txt
- * @endverbatim
+ * The file is mmapped. Batch i of each epoch is a fixed function of (round, worker_id), so the
+ * workers need no synchronization. With shuffle, the samples are grouped in chunks of
+ * chunk_samples, and the chunks are permuted with a key derived from the seed and the epoch, so
+ * each epoch has a different and reproducible order. The last partial chunk stays at the end.
+ * A readahead thread advises the kernel about the pages of the next readahead_batches batches.
+ * A compressed Raw file is not mapped: the chunks of a batch only have their sample indices, and
+ * the worker decompresses them with decompress_batch. The shuffle then permutes whole blocks.
  */
 class MmapOffsetList {
  private:
+  const long long num_samples_;
+  const long long stride_;
+  const long long batchsize_;
   const long long length_;
-  std::vector<MmapOffset> offsets_;
-  std::atomic<long long> counter_{0};
+  const long long num_batches_;   /**< batches per epoch */
+  const bool use_shuffle_;
+  long long chunk_samples_;       /**< granularity of the shuffle */
+  long long num_full_chunks_;     /**< chunks permuted by the shuffle */
+  IndexPermutation permutation_;
+  const uint64_t seed_;
   const int num_workers_;
   bool repeat_;
-  char* mmapped_data_;
+  char* mmapped_data_{nullptr};
   int fd_;
 
+  Compression_t compression_{Compression_t::None};
+  long long samples_per_block_{0};  /**< of a compressed file */
+  std::vector<RawBlockInfo> blocks_;  /**< of a compressed file */
+
+  const long long readahead_batches_;
+  std::thread readahead_thread_;
+  std::mutex readahead_mutex_;
+  std::condition_variable readahead_cv_;
+  long long requested_batch_{-1}; /**< the furthest batch asked to get_offset */
+  bool stop_readahead_{false};
+
+  /**
+   * The chunks of the batch at position pos since the first epoch.
+   */
+  void get_batch(long long pos, MmapOffset* offset) const {
+    const long long epoch = pos / num_batches_;
+    const long long begin = (pos % num_batches_) * batchsize_;
+    const long long end = std::min(begin + batchsize_, num_samples_);
+    const uint64_t key = IndexPermutation::make_key(seed_, epoch);
+    offset->samples = end - begin;
+    offset->chunks.clear();
+    for (long long i = begin; i < end;) {
+      long long first_sample = i;
+      long long samples = end - i;
+      if (use_shuffle_ && i < num_full_chunks_ * chunk_samples_) {
+        const long long chunk = permutation_(i / chunk_samples_, key);
+        const long long in_chunk = i % chunk_samples_;
+        first_sample = chunk * chunk_samples_ + in_chunk;
+        samples = std::min(samples, chunk_samples_ - in_chunk);
+      }
+      char* ptr = mmapped_data_ ? mmapped_data_ + first_sample * stride_ : nullptr;
+      // merge the chunks which happen to be contiguous
+      if (!offset->chunks.empty() &&
+          offset->chunks.back().first_sample + offset->chunks.back().samples == first_sample) {
+        offset->chunks.back().samples += samples;
+      } else {
+        offset->chunks.push_back({ptr, samples, first_sample});
+      }
+      i += samples;
+    }
+  }
+
+  void init_compressed(const RawCompressedFooter& footer) {
+    if (footer.stride != stride_ || footer.num_samples < num_samples_) {
+      CK_THROW_(Error_t::WrongInput, "the compressed file has " +
+                                         std::to_string(footer.num_samples) + " samples of " +
+                                         std::to_string(footer.stride) + " bytes");
+    }
+    if (footer.samples_per_block <= 0 || footer.samples_per_block > footer.num_samples) {
+      CK_THROW_(Error_t::BrokenFile,
+                "samples_per_block: " + std::to_string(footer.samples_per_block));
+    }
+    compression_ = static_cast<Compression_t>(footer.compression);
+    check_compression(compression_);
+    samples_per_block_ = footer.samples_per_block;
+    blocks_ = read_raw_compressed_index(fd_, footer);
+    for (const RawBlockInfo& info : blocks_) {
+      if (info.offset < 0 || info.size < 0 || info.offset + info.size > footer.index_offset) {
+        CK_THROW_(Error_t::BrokenFile, "a block is out of the file");
+      }
+    }
+    // a chunk smaller than a block would decompress the whole block for a part of it
+    chunk_samples_ = samples_per_block_;
+    num_full_chunks_ = num_samples_ / chunk_samples_;
+    permutation_ = IndexPermutation(num_full_chunks_);
+  }
+
+  /**
+   * Read and decompress a block of a compressed file into buffer.
+   */
+  void read_block(long long block_id, RawBatchBuffer* buffer) const {
+    const RawBlockInfo& info = blocks_[block_id];
+    if (buffer->compressed.size() < static_cast<size_t>(info.size)) {
+      buffer->compressed.resize(info.size);
+    }
+    buffer->block_id = -1;
+    if (pread(fd_, buffer->compressed.data(), info.size, info.offset) != info.size) {
+      CK_THROW_(Error_t::BrokenFile, "failed to read block " + std::to_string(block_id));
+    }
+    // the size comes from the file, so it is bounded by the samples of a block before the buffer
+    // is sized by it
+    const long long raw_size = get_decompressed_size(buffer->compressed.data(), info.size);
+    if (raw_size < 0 || raw_size > samples_per_block_ * stride_) {
+      CK_THROW_(Error_t::BrokenFile, "broken block " + std::to_string(block_id) + ": " +
+                                         std::to_string(raw_size) + " bytes");
+    }
+    if (buffer->block.size() < static_cast<size_t>(raw_size)) {
+      buffer->block.resize(raw_size);
+    }
+    if (!decompress_block(compression_, buffer->compressed.data(), info.size,
+                          buffer->block.data())) {
+      CK_THROW_(Error_t::BrokenFile, "failed to decompress block " + std::to_string(block_id));
+    }
+    buffer->block_id = block_id;
+    buffer->block_size = raw_size;
+  }
+
+  void readahead_func() {
+    const long page_size = sysconf(_SC_PAGESIZE);
+    long long advised_batch = -1;
+    MmapOffset offset;
+    while (true) {
+      long long first_batch, target_batch;
+      {
+        std::unique_lock<std::mutex> lock(readahead_mutex_);
+        readahead_cv_.wait(lock, [this, advised_batch] {
+          return stop_readahead_ || requested_batch_ + readahead_batches_ > advised_batch;
+        });
+        if (stop_readahead_) {
+          return;
+        }
+        // the requested batch itself is being read already
+        first_batch = std::max(advised_batch, requested_batch_) + 1;
+        target_batch = requested_batch_ + readahead_batches_;
+      }
+      if (!repeat_) {
+        target_batch = std::min(target_batch, num_batches_ - 1);
+      }
+      for (long long pos = first_batch; pos <= target_batch; pos++) {
+        get_batch(pos, &offset);
+        for (const MmapChunk& chunk : offset.chunks) {
+          if (!mmapped_data_) {
+            const RawBlockInfo& first = blocks_[chunk.first_sample / samples_per_block_];
+            const RawBlockInfo& last =
+                blocks_[(chunk.first_sample + chunk.samples - 1) / samples_per_block_];
+            posix_fadvise(fd_, first.offset, last.offset + last.size - first.offset,
+                          POSIX_FADV_WILLNEED);
+            continue;
+          }
+          const uintptr_t begin = reinterpret_cast<uintptr_t>(chunk.offset) & ~(page_size - 1);
+          const uintptr_t end = reinterpret_cast<uintptr_t>(chunk.offset) + chunk.samples * stride_;
+          madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+        }
+      }
+      advised_batch = std::max(advised_batch, target_batch);
+      if (!repeat_ && advised_batch == num_batches_ - 1) {
+        return;
+      }
+    }
+  }
+
  public:
-  // stride: samle size in byte
+  /**
+   * Ctor
+   * @param stride sample size in byte
+   * @param chunk_samples samples of the chunks shuffled as a whole, 0 for a batch
+   * @param seed the seed of the shuffle
+   * @param readahead_batches how many batches ahead of the workers to advise, 0 for none
+   * @param use_huge_pages whether to advise transparent huge pages for the mapping, only
+   * effective where the kernel supports them for file mappings
+   */
   MmapOffsetList(std::string file_name, long long num_samples, long long stride,
-                 long long batchsize, bool use_shuffle, int num_workers, bool repeat)
-      : length_(num_samples * stride),
+                 long long batchsize, bool use_shuffle, int num_workers, bool repeat,
+                 long long chunk_samples = 0, uint64_t seed = 0, long long readahead_batches = 0,
+                 bool use_huge_pages = false)
+      : num_samples_(num_samples),
+        stride_(stride),
+        batchsize_(batchsize),
+        length_(num_samples * stride),
+        num_batches_(batchsize > 0 ? (num_samples + batchsize - 1) / batchsize : 0),
+        use_shuffle_(use_shuffle),
+        chunk_samples_(std::max(chunk_samples > 0 ? std::min(chunk_samples, batchsize) : batchsize,
+                                1ll)),
+        num_full_chunks_(num_samples / chunk_samples_),
+        permutation_(num_full_chunks_),
+        seed_(seed),
         num_workers_(num_workers),
-        repeat_(repeat) {
+        repeat_(repeat),
+        readahead_batches_(readahead_batches) {
     try {
+      if (num_samples <= 0 || batchsize <= 0) {
+        CK_THROW_(Error_t::WrongInput, "num_samples <= 0 || batchsize <= 0");
+      }
       fd_ = open(file_name.c_str(), O_RDONLY, 0);
       if (fd_ == -1) {
         CK_THROW_(Error_t::BrokenFile, "Error open file for read");
         return;
       }
 
-      /* Get the size of the file. */
-      mmapped_data_ = (char*)mmap(0, length_, PROT_READ, MAP_PRIVATE, fd_, 0);
-      if (mmapped_data_ == MAP_FAILED) {
-        close(fd_);
-        CK_THROW_(Error_t::BrokenFile, "Error mmapping the file");
-        return;
-      }
-
-      auto offset_gen = [stride](char* mmapped_data, long long idx,
-                                 long long samples) -> MmapOffset {
-        char* offset = mmapped_data + idx * stride;
-        return {offset, samples};
-      };
-
-      offsets_.reserve(num_samples);
-      for (long long sample_idx = 0; sample_idx < num_samples; sample_idx += batchsize) {
-        if (sample_idx + batchsize <= num_samples) {
-          offsets_.emplace_back(offset_gen(mmapped_data_, sample_idx, batchsize));
-        } else {
-          offsets_.emplace_back(offset_gen(mmapped_data_, sample_idx, num_samples - sample_idx));
+      RawCompressedFooter footer;
+      if (read_raw_compressed_footer(fd_, &footer)) {
+        try {
+          init_compressed(footer);
+        } catch (const std::runtime_error&) {
+          close(fd_);
+          throw;
+        }
+      } else {
+        /* Get the size of the file. */
+        mmapped_data_ = (char*)mmap(0, length_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (mmapped_data_ == MAP_FAILED) {
+          close(fd_);
+          CK_THROW_(Error_t::BrokenFile, "Error mmapping the file");
+          return;
+        }
+        if (use_huge_pages) {
+          madvise(mmapped_data_, length_, MADV_HUGEPAGE);
+        }
+        // the pages are advised batch by batch, the default readaround only wastes IO then
+        if (readahead_batches_ > 0 && use_shuffle_) {
+          madvise(mmapped_data_, length_, MADV_RANDOM);
         }
       }
-      // shuffle
-      if (use_shuffle) {
-        std::random_device rd;
-        auto rng = std::default_random_engine{rd()};
-        std::shuffle(std::begin(offsets_), std::end(offsets_), rng);
+      if (readahead_batches_ > 0) {
+        readahead_thread_ = std::thread(&MmapOffsetList::readahead_func, this);
       }
-
     } catch (const std::runtime_error& rt_err) {
       std::cerr << rt_err.what() << std::endl;
       throw;
@@ -108,24 +293,74 @@ class MmapOffsetList {
   }
 
   ~MmapOffsetList() {
-    munmap(mmapped_data_, length_);
+    if (readahead_thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(readahead_mutex_);
+        stop_readahead_ = true;
+      }
+      readahead_cv_.notify_all();
+      readahead_thread_.join();
+    }
+    if (mmapped_data_) {
+      munmap(mmapped_data_, length_);
+    }
     close(fd_);
   }
 
-  MmapOffset get_offset(long long round, int worker_id) {
-    size_t worker_pos = round * num_workers_ + worker_id;
-    if (!repeat_ && worker_pos >= offsets_.size()) {
+  bool is_compressed() const { return mmapped_data_ == nullptr; }
+
+  /**
+   * Decompress the samples of a batch of a compressed file into buffer, and point its chunks to
+   * them. It runs on the calling worker, and the last block is kept for the next batch.
+   */
+  void decompress_batch(MmapOffset* offset, RawBatchBuffer* buffer) const {
+    const size_t batch_size = offset->samples * stride_;
+    if (buffer->samples.size() < batch_size) {
+      buffer->samples.resize(batch_size);
+    }
+    char* dst = buffer->samples.data();
+    for (MmapChunk& chunk : offset->chunks) {
+      chunk.offset = dst;
+      const long long end = chunk.first_sample + chunk.samples;
+      for (long long i = chunk.first_sample; i < end;) {
+        const long long block_id = i / samples_per_block_;
+        if (block_id != buffer->block_id) {
+          read_block(block_id, buffer);
+        }
+        const long long block_first = block_id * samples_per_block_;
+        const long long samples = std::min(end, block_first + samples_per_block_) - i;
+        if ((i - block_first + samples) * stride_ > buffer->block_size) {
+          CK_THROW_(Error_t::BrokenFile, "block " + std::to_string(block_id) + " is too short");
+        }
+        memcpy(dst, buffer->block.data() + (i - block_first) * stride_, samples * stride_);
+        dst += samples * stride_;
+        i += samples;
+      }
+    }
+  }
+
+  void get_offset(long long round, int worker_id, MmapOffset* offset) {
+    long long worker_pos = round * num_workers_ + worker_id;
+    if (!repeat_ && worker_pos >= num_batches_) {
       throw internal_runtime_error(Error_t::EndOfFile, "EndOfFile");
     }
-    size_t counter = (round * num_workers_ + worker_id) % offsets_.size();
     if (worker_id >= num_workers_) {
       CK_THROW_(Error_t::WrongInput, "worker_id >= num_workers_");
     }
-    if (counter == offsets_.size() - 1) {
-      // CK_THROW_(Error_t::OutOfBound, "End of File");
-      std::cout << "End of File, worker:  " << worker_id << std::endl;
+    get_batch(worker_pos, offset);
+    if (readahead_batches_ > 0) {
+      bool advanced = false;
+      {
+        std::lock_guard<std::mutex> lock(readahead_mutex_);
+        if (worker_pos > requested_batch_) {
+          requested_batch_ = worker_pos;
+          advanced = true;
+        }
+      }
+      if (advanced) {
+        readahead_cv_.notify_one();
+      }
     }
-    return offsets_[counter];
   }
 };
 }  // namespace HugeCTR
@@ -24,6 +24,7 @@ class MmapSource : public Source {
  private:
   std::shared_ptr<MmapOffsetList> mmap_offset_list_;
   MmapOffset offset_;
+  RawBatchBuffer batch_buffer_; /**< the decompressed batch of a compressed file */
   int worker_id_;
   long long round_{0};
 
@@ -31,21 +32,30 @@ class MmapSource : public Source {
   MmapSource(std::shared_ptr<MmapOffsetList> mmap_offset_list, int worker_id)
       : mmap_offset_list_(mmap_offset_list), worker_id_(worker_id) {}
 
-  char* get_ptr() { return offset_.offset; }
+  /**
+   * @return the first chunk of the batch, get_chunks has all of them
+   */
+  char* get_ptr() { return offset_.chunks.empty() ? nullptr : offset_.chunks.front().offset; }
+
+  const std::vector<MmapChunk>& get_chunks() const { return offset_.chunks; }
 
   // no use here
   bool is_open() noexcept { return true; }
 
   Error_t next_source() noexcept {
     try {
-      offset_ = mmap_offset_list_->get_offset(round_, worker_id_);
+      mmap_offset_list_->get_offset(round_, worker_id_, &offset_);
       round_++;
+      if (mmap_offset_list_->is_compressed()) {
+        mmap_offset_list_->decompress_batch(&offset_, &batch_buffer_);
+      }
       return Error_t::Success;
     } catch (const internal_runtime_error& rt_err) {
       Error_t err = rt_err.get_error();
       if (err == Error_t::EndOfFile) {
         return Error_t::EndOfFile;
       } else {
+        std::cerr << rt_err.what() << std::endl;
         return Error_t::UnspecificError;
       }
     } catch (const std::runtime_error& rt_err) {
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <common.hpp>
+#include <cstring>
+#include <data_readers/block_codec.hpp>
+#include <data_readers/crc32c.hpp>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * @brief The block-structured (v2) layout of the Norm format.
+ *
+ * A v2 file is a sequence of blocks followed by an index of the blocks and a footer.
+ * Each block is laid out as a whole v1 file: a DataSetHeader whose number_of_records is the number
+ * of records of the block, then the records, with the error check of the data set. A reader can
+ * therefore seek to any block and parse it like a file. All the blocks but the last one of a file
+ * have the same number of records.
+ * In a compressed file, each block is stored as a compressed block of block_codec.hpp, which the
+ * reader decompresses before parsing it.
+ * @verbatim
+ * [block 0] ... [block n-1] [NormV2BlockInfo x n] [NormV2Footer]
+ * @endverbatim
+ */
+struct NormV2BlockInfo {
+  long long offset;       // byte offset of the block in the file
+  long long size;         // bytes of the block in the file, its header included
+  long long num_records;  // the number of samples in this block
+  long long min_key;      // smallest key of the block, if the footer has_key_range
+  long long max_key;      // largest key of the block, if the footer has_key_range
+};
+
+struct NormV2Footer {
+  long long num_blocks;
+  long long index_offset;       // byte offset of the first NormV2BlockInfo
+  long long records_per_block;  // records of each block but the last one
+  long long has_key_range;      // 1: min_key and max_key of the blocks are valid
+  long long compression;        // the Compression_t of the blocks
+  long long reserved[2];        // reserved for future use
+  char magic[8];
+};
+
+constexpr char kNormV2Magic[8] = {'H', 'C', 'T', 'R', 'N', 'V', '2', '\0'};
+
+/**
+ * Read the footer of a file.
+ * @return false if the file is not in the v2 format
+ */
+inline bool read_norm_v2_footer(int fd, NormV2Footer* footer) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(NormV2Footer))) {
+    return false;
+  }
+  if (pread(fd, footer, sizeof(NormV2Footer), st.st_size - sizeof(NormV2Footer)) !=
+      static_cast<ssize_t>(sizeof(NormV2Footer))) {
+    return false;
+  }
+  return memcmp(footer->magic, kNormV2Magic, sizeof(kNormV2Magic)) == 0;
+}
+
+/**
+ * @return whether the file is in the v2 format, false if it cannot be opened
+ */
+inline bool is_norm_v2_file(const std::string& file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  NormV2Footer footer;
+  bool is_v2 = read_norm_v2_footer(fd, &footer);
+  close(fd);
+  return is_v2;
+}
+
+/**
+ * Read the block index of a v2 file.
+ */
+inline std::vector<NormV2BlockInfo> read_norm_v2_index(const std::string& file_name,
+                                                       NormV2Footer* footer = nullptr) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    CK_THROW_(Error_t::FileCannotOpen, "open() failed: " + file_name);
+  }
+  NormV2Footer tmp_footer;
+  if (!read_norm_v2_footer(fd, &tmp_footer)) {
+    close(fd);
+    CK_THROW_(Error_t::UnSupportedFormat, "not a Norm v2 file: " + file_name);
+  }
+  std::vector<NormV2BlockInfo> blocks(tmp_footer.num_blocks);
+  const ssize_t index_size = blocks.size() * sizeof(NormV2BlockInfo);
+  const ssize_t ret = pread(fd, blocks.data(), index_size, tmp_footer.index_offset);
+  close(fd);
+  if (ret != index_size) {
+    CK_THROW_(Error_t::BrokenFile, "failed to read the block index of " + file_name);
+  }
+  if (footer) {
+    *footer = tmp_footer;
+  }
+  return blocks;
+}
+
+/**
+ * The bytes of a record at most, its error check included, which bound the decompressed size of
+ * a block read from a compressed file.
+ * @param max_feature_num the keys of a record at most
+ */
+inline size_t get_norm_v2_max_record_bytes(int label_dense_dim, int slot_num, int max_feature_num,
+                                           size_t key_size) {
+  // the length and the CRC32C of the error check are the largest framing of a record
+  return sizeof(float) * label_dense_dim + sizeof(int) * slot_num + key_size * max_feature_num +
+         sizeof(int) + sizeof(uint32_t);
+}
+
+namespace norm_v2_internal {
+
+/**
+ * The DataSetHeader::error_check of a file checked with check_type.
+ */
+inline long long get_error_check(Check_t check_type) {
+  switch (check_type) {
+    case Check_t::None:
+      return 0;
+    case Check_t::Sum:
+      return 1;
+    case Check_t::CRC32C:
+      return 2;
+    default:
+      CK_THROW_(Error_t::WrongInput, "unknown check_type");
+  }
+  return -1;
+}
+
+/**
+ * Append data framed with the error check of check_type, as the readers expect it.
+ */
+inline void append_checked(std::vector<char>& out, const char* data, int len, Check_t check_type) {
+  if (check_type == Check_t::None) {
+    out.insert(out.end(), data, data + len);
+    return;
+  }
+  const char* len_ptr = reinterpret_cast<const char*>(&len);
+  out.insert(out.end(), len_ptr, len_ptr + sizeof(int));
+  out.insert(out.end(), data, data + len);
+  if (check_type == Check_t::Sum) {
+    char sum = 0;
+    for (int i = 0; i < len; i++) {
+      sum += data[i];
+    }
+    out.push_back(sum);
+  } else {
+    const uint32_t crc = crc32c(data, len);
+    const char* crc_ptr = reinterpret_cast<const char*>(&crc);
+    out.insert(out.end(), crc_ptr, crc_ptr + sizeof(uint32_t));
+  }
+}
+
+/**
+ * Reads the records of a v1 file with their error check framing.
+ */
+class RecordReader {
+  std::ifstream in_;
+  Check_t check_type_;
+  std::vector<char> payload_;
+
+  void read_bytes(char* ptr, size_t n) {
+    in_.read(ptr, n);
+    if (static_cast<size_t>(in_.gcount()) != n) {
+      CK_THROW_(Error_t::BrokenFile, "unexpected end of file");
+    }
+  }
+
+ public:
+  RecordReader(const std::string& file_name, Check_t check_type)
+      : in_(file_name, std::ifstream::binary), check_type_(check_type) {
+    if (!in_.is_open()) {
+      CK_THROW_(Error_t::FileCannotOpen, "open failed: " + file_name);
+    }
+  }
+
+  /**
+   * Read a framed block of a data set with an error check, and verify it.
+   */
+  const std::vector<char>& read_checked() {
+    int len = 0;
+    read_bytes(reinterpret_cast<char*>(&len), sizeof(int));
+    if (len < 0) {
+      CK_THROW_(Error_t::BrokenFile, "block length < 0");
+    }
+    payload_.resize(len);
+    read_bytes(payload_.data(), len);
+    bool ok;
+    if (check_type_ == Check_t::Sum) {
+      char sum = 0, expected;
+      for (char c : payload_) {
+        sum += c;
+      }
+      read_bytes(&expected, sizeof(char));
+      ok = sum == expected;
+    } else {
+      uint32_t expected;
+      read_bytes(reinterpret_cast<char*>(&expected), sizeof(uint32_t));
+      ok = crc32c(payload_.data(), len) == expected;
+    }
+    if (!ok) {
+      CK_THROW_(Error_t::DataCheckError, "error check failed");
+    }
+    return payload_;
+  }
+
+  /**
+   * Read raw bytes of a data set without an error check.
+   */
+  const char* read_raw(size_t n) {
+    payload_.resize(n);
+    read_bytes(payload_.data(), n);
+    return payload_.data();
+  }
+
+  DataSetHeader read_header() {
+    DataSetHeader header;
+    if (check_type_ == Check_t::None) {
+      memcpy(&header, read_raw(sizeof(DataSetHeader)), sizeof(DataSetHeader));
+    } else {
+      const std::vector<char>& payload = read_checked();
+      if (payload.size() != sizeof(DataSetHeader)) {
+        CK_THROW_(Error_t::BrokenFile, "wrong header size");
+      }
+      memcpy(&header, payload.data(), sizeof(DataSetHeader));
+    }
+    return header;
+  }
+
+  /**
+   * Read the payload of the next record: the label and dense, then nnz and keys of each slot.
+   */
+  template <typename T>
+  std::vector<char> read_record(const DataSetHeader& header) {
+    if (check_type_ != Check_t::None) {
+      return read_checked();
+    }
+    std::vector<char> record;
+    const size_t label_dense_size = sizeof(float) * (header.label_dim + header.dense_dim);
+    const char* label_dense = read_raw(label_dense_size);
+    record.insert(record.end(), label_dense, label_dense + label_dense_size);
+    for (long long k = 0; k < header.slot_num; k++) {
+      int nnz;
+      memcpy(&nnz, read_raw(sizeof(int)), sizeof(int));
+      if (nnz < 0) {
+        CK_THROW_(Error_t::BrokenFile, "nnz < 0");
+      }
+      const char* nnz_ptr = reinterpret_cast<const char*>(&nnz);
+      record.insert(record.end(), nnz_ptr, nnz_ptr + sizeof(int));
+      const char* keys = read_raw(sizeof(T) * nnz);
+      record.insert(record.end(), keys, keys + sizeof(T) * nnz);
+    }
+    return record;
+  }
+};
+
+}  // namespace norm_v2_internal
+
+/**
+ * Convert a file of the Norm format to the v2 layout. The records are kept as they are, with the
+ * error check of the source file.
+ * @param records_per_block the number of records of each block
+ * @param key_range whether to store the min and max key of each block in the index
+ * @param compression the codec to compress the blocks with
+ * @return the number of blocks written
+ */
+template <typename T>
+long long convert_norm_to_v2(const std::string& src_file, const std::string& dst_file,
+                             Check_t check_type, long long records_per_block,
+                             bool key_range = true,
+                             Compression_t compression = Compression_t::None) {
+  using namespace norm_v2_internal;
+  if (records_per_block <= 0) {
+    CK_THROW_(Error_t::WrongInput, "records_per_block <= 0");
+  }
+  RecordReader reader(src_file, check_type);
+  const DataSetHeader header = reader.read_header();
+  if (header.error_check != get_error_check(check_type)) {
+    CK_THROW_(Error_t::WrongInput, "the error check of the file does not match check_type");
+  }
+
+  std::ofstream out(dst_file, std::ofstream::binary);
+  if (!out.is_open()) {
+    CK_THROW_(Error_t::FileCannotOpen, "open failed: " + dst_file);
+  }
+  std::vector<NormV2BlockInfo> blocks;
+  std::vector<char> records, block, compressed;
+  long long offset = 0;
+  const size_t label_dense_size = sizeof(float) * (header.label_dim + header.dense_dim);
+  for (long long first = 0; first < header.number_of_records; first += records_per_block) {
+    NormV2BlockInfo info;
+    info.num_records = std::min(records_per_block, header.number_of_records - first);
+    info.min_key = std::numeric_limits<long long>::max();
+    info.max_key = std::numeric_limits<long long>::min();
+    records.clear();
+    for (long long i = 0; i < info.num_records; i++) {
+      const std::vector<char> record = reader.read_record<T>(header);
+      if (key_range) {
+        // walk the slots for the keys
+        size_t pos = label_dense_size;
+        for (long long k = 0; k < header.slot_num; k++) {
+          int nnz;
+          if (pos + sizeof(int) > record.size()) {
+            CK_THROW_(Error_t::BrokenFile, "record shorter than its slots");
+          }
+          memcpy(&nnz, record.data() + pos, sizeof(int));
+          pos += sizeof(int);
+          if (nnz < 0 || pos + sizeof(T) * nnz > record.size()) {
+            CK_THROW_(Error_t::BrokenFile, "record shorter than its keys");
+          }
+          for (int j = 0; j < nnz; j++) {
+            T key;
+            memcpy(&key, record.data() + pos, sizeof(T));
+            pos += sizeof(T);
+            info.min_key = std::min(info.min_key, static_cast<long long>(key));
+            info.max_key = std::max(info.max_key, static_cast<long long>(key));
+          }
+        }
+      }
+      append_checked(records, record.data(), record.size(), check_type);
+    }
+    DataSetHeader block_header = header;
+    block_header.number_of_records = info.num_records;
+    block.clear();
+    append_checked(block, reinterpret_cast<const char*>(&block_header), sizeof(DataSetHeader),
+                   check_type);
+    block.insert(block.end(), records.begin(), records.end());
+    if (compression != Compression_t::None) {
+      compressed.clear();
+      compress_block(compression, block.data(), block.size(), &compressed);
+      block.swap(compressed);
+    }
+    out.write(block.data(), block.size());
+    info.offset = offset;
+    info.size = block.size();
+    offset += block.size();
+    blocks.push_back(info);
+  }
+
+  NormV2Footer footer = {};
+  footer.num_blocks = blocks.size();
+  footer.index_offset = offset;
+  footer.records_per_block = records_per_block;
+  footer.has_key_range = key_range ? 1 : 0;
+  footer.compression = static_cast<long long>(compression);
+  memcpy(footer.magic, kNormV2Magic, sizeof(kNormV2Magic));
+  out.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(NormV2BlockInfo));
+  out.write(reinterpret_cast<const char*>(&footer), sizeof(NormV2Footer));
+  if (!out.good()) {
+    CK_THROW_(Error_t::BrokenFile, "failed to write " + dst_file);
+  }
+  return footer.num_blocks;
+}
+
+}  // namespace HugeCTR
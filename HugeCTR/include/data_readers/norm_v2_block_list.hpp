@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <common.hpp>
+#include <data_readers/file_list.hpp>
+#include <data_readers/index_permutation.hpp>
+#include <data_readers/norm_v2.hpp>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * @brief The blocks of all the v2 files of a file list, shared by the workers of a data reader.
+ *
+ * The blocks of all the epochs form one sequence, and the source of worker w of n reads the
+ * positions w, w + n, w + 2n, ... of it, so that a few large files are still read by all the
+ * workers, and every node of a multi-node job reads the same blocks into the same workers. With
+ * shuffle, each epoch is a permutation of the blocks keyed by the seed and the epoch.
+ */
+class NormV2BlockList {
+ public:
+  struct Block {
+    int file_id;
+    NormV2BlockInfo info;
+  };
+
+ private:
+  std::vector<std::string> file_names_;
+  std::vector<Compression_t> compressions_; /**< the codec of the blocks of each file */
+  std::vector<Block> blocks_;
+  bool shuffle_;
+  uint64_t seed_;
+  IndexPermutation permutation_;
+
+  static std::vector<Block> read_blocks(const std::string& file_list,
+                                        std::vector<std::string>* file_names,
+                                        std::vector<Compression_t>* compressions) {
+    std::vector<Block> blocks;
+    FileList list(file_list);
+    for (unsigned int id = 0;; id++) {
+      std::string file_name = list.get_a_file_with_id(id, false);
+      if (file_name.empty()) {
+        break;
+      }
+      NormV2Footer footer;
+      std::vector<NormV2BlockInfo> infos = read_norm_v2_index(file_name, &footer);
+      check_compression(static_cast<Compression_t>(footer.compression));
+      for (const NormV2BlockInfo& info : infos) {
+        blocks.push_back({static_cast<int>(file_names->size()), info});
+      }
+      file_names->push_back(file_name);
+      compressions->push_back(static_cast<Compression_t>(footer.compression));
+    }
+    return blocks;
+  }
+
+ public:
+  /**
+   * Ctor
+   * @param file_list the file list of the data set, all its files must be in the v2 format
+   * @param shuffle whether to permute the blocks of each epoch
+   * @param seed the seed of the permutations, the same on all the nodes
+   */
+  NormV2BlockList(const std::string& file_list, bool shuffle, unsigned long long seed = 0)
+      : blocks_(read_blocks(file_list, &file_names_, &compressions_)),
+        shuffle_(shuffle),
+        seed_(seed),
+        permutation_(blocks_.size()) {}
+
+  /**
+   * The block at a position of the sequence of the blocks of all the epochs.
+   * @param repeat whether the sequence goes on after the first epoch
+   * @return false at the end of the data set
+   */
+  bool get_block(unsigned long long position, bool repeat, Block* block) const {
+    if (blocks_.empty()) {
+      return false;
+    }
+    const uint64_t epoch = position / blocks_.size();
+    if (epoch > 0 && !repeat) {
+      return false;
+    }
+    const uint64_t i = position % blocks_.size();
+    *block = blocks_[shuffle_ ? permutation_(i, IndexPermutation::make_key(seed_, epoch)) : i];
+    return true;
+  }
+
+  const std::string& get_file_name(int file_id) const { return file_names_[file_id]; }
+
+  Compression_t get_compression(int file_id) const { return compressions_[file_id]; }
+
+  size_t get_num_blocks() const { return blocks_.size(); }
+};
+
+/**
+ * @return whether the data set of the file list is in the v2 format, decided by its first file
+ */
+inline bool is_norm_v2_file_list(const std::string& file_list) {
+  FileList list(file_list);
+  return is_norm_v2_file(list.get_a_file_with_id(0, false));
+}
+
+}  // namespace HugeCTR
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <common.hpp>
+#include <cstring>
+#include <data_readers/block_codec.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * @brief The compressed layout of the Raw format.
+ *
+ * The samples are grouped in blocks of samples_per_block samples, the last one may have fewer,
+ * and each block is stored as a compressed block of block_codec.hpp. The index of the blocks and
+ * a footer follow them, so that the blocks of any sample can be found without a scan.
+ * @verbatim
+ * [block 0] ... [block n-1] [RawBlockInfo x n] [RawCompressedFooter]
+ * @endverbatim
+ */
+struct RawBlockInfo {
+  long long offset;  // byte offset of the block in the file
+  long long size;    // bytes of the block in the file
+};
+
+struct RawCompressedFooter {
+  long long num_samples;
+  long long stride;             // bytes of a sample
+  long long samples_per_block;  // samples of each block but the last one
+  long long num_blocks;
+  long long index_offset;       // byte offset of the first RawBlockInfo
+  long long compression;        // the Compression_t of the blocks
+  long long reserved[2];        // reserved for future use
+  char magic[8];
+};
+
+constexpr char kRawCompressedMagic[8] = {'H', 'C', 'T', 'R', 'R', 'Z', '1', '\0'};
+
+/**
+ * Read the footer of a file.
+ * @return false if the file is not a compressed Raw file
+ */
+inline bool read_raw_compressed_footer(int fd, RawCompressedFooter* footer) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(RawCompressedFooter))) {
+    return false;
+  }
+  if (pread(fd, footer, sizeof(RawCompressedFooter), st.st_size - sizeof(RawCompressedFooter)) !=
+      static_cast<ssize_t>(sizeof(RawCompressedFooter))) {
+    return false;
+  }
+  return memcmp(footer->magic, kRawCompressedMagic, sizeof(kRawCompressedMagic)) == 0;
+}
+
+/**
+ * Read the block index of a compressed Raw file.
+ */
+inline std::vector<RawBlockInfo> read_raw_compressed_index(int fd,
+                                                           const RawCompressedFooter& footer) {
+  std::vector<RawBlockInfo> blocks(footer.num_blocks);
+  const ssize_t index_size = blocks.size() * sizeof(RawBlockInfo);
+  if (pread(fd, blocks.data(), index_size, footer.index_offset) != index_size) {
+    CK_THROW_(Error_t::BrokenFile, "failed to read the block index");
+  }
+  return blocks;
+}
+
+/**
+ * Writes the samples of a Raw data set in the compressed layout.
+ */
+class RawCompressedWriter {
+  std::ofstream out_;
+  std::string file_name_;
+  const long long stride_;
+  const long long samples_per_block_;
+  const Compression_t compression_;
+  const int level_;
+  std::vector<char> block_;      /**< the samples of the block being filled */
+  std::vector<char> compressed_;
+  std::vector<RawBlockInfo> blocks_;
+  long long offset_{0};
+  long long num_samples_{0};
+  bool closed_{false};
+
+  void write_block() {
+    if (block_.empty()) {
+      return;
+    }
+    compressed_.clear();
+    compress_block(compression_, block_.data(), block_.size(), &compressed_, level_);
+    out_.write(compressed_.data(), compressed_.size());
+    blocks_.push_back({offset_, static_cast<long long>(compressed_.size())});
+    offset_ += compressed_.size();
+    block_.clear();
+  }
+
+ public:
+  /**
+   * Ctor
+   * @param stride bytes of a sample
+   * @param samples_per_block samples compressed together, which are also the granularity of
+   * the shuffle of the reader
+   * @param level the level of Zstd, ignored by LZ4
+   */
+  RawCompressedWriter(const std::string& file_name, long long stride, long long samples_per_block,
+                      Compression_t compression, int level = kZstdDefaultLevel)
+      : out_(file_name, std::ofstream::binary),
+        file_name_(file_name),
+        stride_(stride),
+        samples_per_block_(samples_per_block),
+        compression_(compression),
+        level_(level) {
+    if (!out_.is_open()) {
+      CK_THROW_(Error_t::FileCannotOpen, "open failed: " + file_name);
+    }
+    if (stride <= 0 || samples_per_block <= 0) {
+      CK_THROW_(Error_t::WrongInput, "stride <= 0 || samples_per_block <= 0");
+    }
+    if (compression == Compression_t::None) {
+      CK_THROW_(Error_t::WrongInput, "a compressed Raw file needs a codec");
+    }
+    block_.reserve(stride * samples_per_block);
+  }
+
+  ~RawCompressedWriter() {
+    if (!closed_) {
+      try {
+        close();
+      } catch (const std::runtime_error& rt_err) {
+        std::cerr << rt_err.what() << std::endl;
+      }
+    }
+  }
+
+  /**
+   * Append a sample of stride bytes.
+   */
+  void append(const char* sample) {
+    block_.insert(block_.end(), sample, sample + stride_);
+    num_samples_++;
+    if (num_samples_ % samples_per_block_ == 0) {
+      write_block();
+    }
+  }
+
+  /**
+   * Append a block already compressed with compress_block, e.g. on another thread.
+   * Only the last block of the file may have fewer than samples_per_block samples.
+   */
+  void append_compressed_block(const char* block, size_t size, long long num_samples) {
+    if (!block_.empty() || num_samples_ % samples_per_block_ != 0 ||
+        num_samples > samples_per_block_) {
+      CK_THROW_(Error_t::WrongInput, "the blocks before a compressed block must be full");
+    }
+    out_.write(block, size);
+    blocks_.push_back({offset_, static_cast<long long>(size)});
+    offset_ += size;
+    num_samples_ += num_samples;
+  }
+
+  /**
+   * Write the last block, the index and the footer.
+   */
+  void close() {
+    closed_ = true;
+    write_block();
+    RawCompressedFooter footer = {};
+    footer.num_samples = num_samples_;
+    footer.stride = stride_;
+    footer.samples_per_block = samples_per_block_;
+    footer.num_blocks = blocks_.size();
+    footer.index_offset = offset_;
+    footer.compression = static_cast<long long>(compression_);
+    memcpy(footer.magic, kRawCompressedMagic, sizeof(kRawCompressedMagic));
+    out_.write(reinterpret_cast<const char*>(blocks_.data()),
+               blocks_.size() * sizeof(RawBlockInfo));
+    out_.write(reinterpret_cast<const char*>(&footer), sizeof(RawCompressedFooter));
+    out_.close();
+    if (!out_.good()) {
+      CK_THROW_(Error_t::BrokenFile, "failed to write " + file_name_);
+    }
+  }
+
+  long long get_num_samples() const { return num_samples_; }
+};
+
+/**
+ * The decompressed samples of the batch of a worker.
+ */
+struct RawBatchBuffer {
+  std::vector<char> samples;    /**< the samples of the batch, in the order of its chunks */
+  std::vector<char> compressed; /**< the compressed bytes of block */
+  std::vector<char> block;      /**< the last block decompressed */
+  long long block_id{-1};
+  long long block_size{0};      /**< decompressed bytes of block */
+};
+
+}  // namespace HugeCTR
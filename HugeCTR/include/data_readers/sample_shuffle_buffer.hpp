@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <common.hpp>
+#include <random>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * The memory and the time of the shuffle buffer of a worker. The time to fill the pool includes
+ * the reading and the decoding of the samples, which the reader spends without a shuffle buffer
+ * too, the time to draw the samples out of the pool is the extra cost of the shuffle.
+ */
+struct ShuffleBufferStats {
+  size_t capacity{0};      /**< samples of the pool */
+  size_t memory_bytes{0};  /**< bytes of the pool */
+  long long samples{0};    /**< samples drawn */
+  double fill_seconds{0.0};
+  double draw_seconds{0.0};
+};
+
+/**
+ * @brief A bounded pool of decoded samples, which are drawn from it at random.
+ *
+ * The pool has a fixed number of entries of sample_bytes bytes each, as many as fit in the
+ * memory budget, so that its memory does not depend on the samples. The reader fills the free
+ * entries, then draws samples, each draw takes a random entry out of the pool. The entries of the
+ * drawn samples stay valid until the pool is filled again.
+ */
+class SampleShuffleBuffer {
+  const size_t sample_bytes_;
+  const size_t capacity_;
+  std::vector<char> data_;
+  std::vector<size_t> order_; /**< entries of the pool first, then the free ones */
+  size_t size_{0};            /**< samples in the pool */
+  std::mt19937_64 rng_;
+
+ public:
+  /**
+   * Ctor
+   * @param sample_bytes bytes of an entry, i.e. of the largest sample
+   * @param memory_bytes the memory budget of the pool
+   * @param seed the seed of the draws, the same seed gives the same draws
+   */
+  SampleShuffleBuffer(size_t sample_bytes, size_t memory_bytes, uint64_t seed)
+      : sample_bytes_(sample_bytes),
+        capacity_(sample_bytes > 0 ? memory_bytes / sample_bytes : 0),
+        rng_(seed) {
+    if (capacity_ == 0) {
+      CK_THROW_(Error_t::WrongInput, "the shuffle buffer cannot hold a sample of " +
+                                         std::to_string(sample_bytes) + " bytes");
+    }
+    data_.resize(capacity_ * sample_bytes_);
+    order_.resize(capacity_);
+    for (size_t i = 0; i < capacity_; i++) {
+      order_[i] = i;
+    }
+  }
+
+  /**
+   * The entry of the next sample inserted, the sample is in the pool after commit().
+   */
+  char* free_entry() {
+    assert(!full());
+    return data_.data() + order_[size_] * sample_bytes_;
+  }
+
+  void commit() { size_++; }
+
+  /**
+   * Take a random sample out of the pool.
+   * @return the entry of the sample, valid until the next call to free_entry()
+   */
+  const char* draw() {
+    assert(!empty());
+    const size_t i = next_random(size_);
+    size_--;
+    std::swap(order_[i], order_[size_]);
+    return data_.data() + order_[size_] * sample_bytes_;
+  }
+
+  /**
+   * A random integer in [0, bound), from the generator of the draws.
+   */
+  size_t next_random(size_t bound) { return rng_() % bound; }
+
+  bool full() const { return size_ == capacity_; }
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  size_t get_sample_bytes() const { return sample_bytes_; }
+  size_t get_memory_bytes() const { return data_.size() + order_.size() * sizeof(size_t); }
+};
+
+}  // namespace HugeCTR
@@ -33,6 +33,18 @@ class Source {
     return Error_t::Success;
   }
 
+  /**
+   * Point ptr to the next "bytes_to_read" bytes of the source instead of copying them.
+   * The view is valid until the next read.
+   * @param ptr receives the pointer to the bytes
+   * @param bytes_to_read bytes to read
+   * @return `DataCheckError` `OutOfBound` `Success` `UnspecificError`
+   */
+  virtual Error_t read_view(const char** ptr, size_t bytes_to_read) {
+    CK_THROW_(Error_t::BrokenFile, "Invalid Call");
+    return Error_t::Success;
+  }
+
   virtual char* get_ptr() {
     CK_THROW_(Error_t::BrokenFile, "Invalid Call");
     return nullptr;
@@ -155,6 +155,22 @@ class GeneralBuffer2 : public std::enable_shared_from_this<GeneralBuffer2<Alloca
   void *ptr_;
   size_t total_size_in_bytes_;
   std::vector<std::shared_ptr<BufferInternal>> reserved_buffers_;
+  // set when the memory is aliased from another buffer by allocate_shared
+  std::shared_ptr<GeneralBuffer2> memory_owner_;
+
+  size_t initialize_reserved_buffers() {
+    size_t offset = 0;
+    for (const std::shared_ptr<BufferInternal> &buffer : reserved_buffers_) {
+      buffer->initialize(this->shared_from_this(), offset);
+      size_t size_in_bytes = buffer->get_size_in_bytes();
+      if (size_in_bytes % 32 != 0) {
+        size_in_bytes += (32 - size_in_bytes % 32);
+      }
+      offset += size_in_bytes;
+    }
+    reserved_buffers_.clear();
+    return offset;
+  }
   
   GeneralBuffer2() : ptr_(nullptr), total_size_in_bytes_(0) {}
 
@@ -167,7 +183,7 @@ class GeneralBuffer2 : public std::enable_shared_from_this<GeneralBuffer2<Alloca
   GeneralBuffer2 &operator=(const GeneralBuffer2 &) = delete;
 
   ~GeneralBuffer2() {
-    if (allocated()) {
+    if (allocated() && !memory_owner_) {
       allocator_.deallocate(ptr_);
     }
   }
@@ -177,23 +193,33 @@ class GeneralBuffer2 : public std::enable_shared_from_this<GeneralBuffer2<Alloca
       CK_THROW_(Error_t::WrongInput, "Memory has already been allocated.");
     }
 
-    size_t offset = 0;
-    for (const std::shared_ptr<BufferInternal> &buffer : reserved_buffers_) {
-      buffer->initialize(this->shared_from_this(), offset);
-      size_t size_in_bytes = buffer->get_size_in_bytes();
-      if (size_in_bytes % 32 != 0) {
-        size_in_bytes += (32 - size_in_bytes % 32);
-      }
-      offset += size_in_bytes;
-    }
-    reserved_buffers_.clear();
-    total_size_in_bytes_ = offset;
+    total_size_in_bytes_ = initialize_reserved_buffers();
 
     if (total_size_in_bytes_ != 0) {
       ptr_ = allocator_.allocate(total_size_in_bytes_);
     }
   }
 
+  /**
+   * Lay out the reserved buffers like allocate(), but alias the memory of other instead of
+   * allocating it, so that the tensors of both buffers share their storage. other must be
+   * allocated with the same layout, and stays alive as long as this buffer.
+   */
+  void allocate_shared(const std::shared_ptr<GeneralBuffer2> &other) {
+    if (ptr_ != nullptr) {
+      CK_THROW_(Error_t::WrongInput, "Memory has already been allocated.");
+    }
+    if (!other->allocated()) {
+      CK_THROW_(Error_t::IllegalCall, "The shared buffer is not allocated.");
+    }
+    total_size_in_bytes_ = initialize_reserved_buffers();
+    if (total_size_in_bytes_ != other->total_size_in_bytes_) {
+      CK_THROW_(Error_t::WrongInput, "The layout of the shared buffer is different.");
+    }
+    ptr_ = other->ptr_;
+    memory_owner_ = other;
+  }
+
   template <typename T>
   std::shared_ptr<BufferBlock2<T>> create_block() {
     if (allocated()) {
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace HugeCTR {
+
+// 64-bit finalizer of MurmurHash3, used by the host hash tables. Keys are often dense integer
+// ranges, the finalizer spreads them over all the bits of the hash.
+inline size_t murmur_hash3_fmix64(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<size_t>(h);
+}
+
+// 64-bit MurmurHash64A of the len bytes at key, for fingerprinting byte strings such as
+// embedding vectors. Unlike std::hash its value is defined and identical on every platform.
+inline uint64_t murmur_hash64a(const void* key, size_t len, uint64_t seed = 0) {
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  const unsigned char* data = static_cast<const unsigned char*>(key);
+  const unsigned char* end = data + (len / 8) * 8;
+  uint64_t h = seed ^ (len * m);
+  for (; data != end; data += 8) {
+    uint64_t k;
+    memcpy(&k, data, sizeof(k));
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+  switch (len & 7) {
+    case 7: h ^= static_cast<uint64_t>(data[6]) << 48;  // fall through
+    case 6: h ^= static_cast<uint64_t>(data[5]) << 40;  // fall through
+    case 5: h ^= static_cast<uint64_t>(data[4]) << 32;  // fall through
+    case 4: h ^= static_cast<uint64_t>(data[3]) << 24;  // fall through
+    case 3: h ^= static_cast<uint64_t>(data[2]) << 16;  // fall through
+    case 2: h ^= static_cast<uint64_t>(data[1]) << 8;   // fall through
+    case 1:
+      h ^= static_cast<uint64_t>(data[0]);
+      h *= m;
+  }
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+}  // namespace HugeCTR
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <common.hpp>
+#include <cstdint>
+#include <hashtable/hash_functions.hpp>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace HugeCTR {
+
+// CPU embedding table of the inference parameter server.
+// All emb_vec of a table live in one contiguous value arena (row i = i-th key of the sparse model
+// file), and an open-addressing (linear probing) index maps each key to its row in the arena.
+// The arena is either owned host memory or a read-only mmap of the emb_vector file.
+// The index is split into 2^shard_bits_ equally sized shards selected by the high bits of the hash,
+// so that it can be built by several threads without synchronization.
+template <typename TypeHashKey>
+class flat_embedding_table {
+ public:
+  flat_embedding_table(size_t embedding_vec_size, float default_emb_vec_value);
+  ~flat_embedding_table();
+
+  flat_embedding_table(flat_embedding_table&& other) noexcept;
+  flat_embedding_table& operator=(flat_embedding_table&& other) noexcept;
+  DISALLOW_COPY(flat_embedding_table)
+
+  // Take over the value arena and build the key index, keys[i] owns the i-th emb_vec in vectors.
+  // If a key shows up more than once, the first row is kept.
+  void load(const TypeHashKey* keys, size_t num_keys, std::vector<float>&& vectors,
+            size_t num_threads = 1);
+
+  // Map vec_file read-only as the value arena and build the key index from the i64 keys of the
+  // sparse model key file, keys[i] owns the i-th emb_vec in vec_file
+  void load_mmap(const long long* keys, size_t num_keys, const std::string& vec_file,
+                 size_t num_threads);
+
+  // Map vec_file read-only as the value arena and restore the key index persisted by dump_index.
+  // Return false and leave the table untouched if index_file does not match the table, vec_file
+  // or the key file it was built from.
+  bool load_mmap_from_index(const std::string& index_file, const std::string& vec_file,
+                            const std::string& key_file);
+
+  // Persist the key index built from key_file, so that later load_mmap_from_index calls can skip
+  // building it as long as key_file is not replaced
+  void dump_index(const std::string& index_file, const std::string& key_file) const;
+
+  // Return the emb_vec of the key, or nullptr if the key is not in the table
+  const float* find(TypeHashKey key) const { return find_(key, hash_(key)); }
+
+  // Copy the emb_vec of each key into h_embeddingoutputvector, missing keys get the default emb_vec.
+  // Large batches are split across num_threads OpenMP threads.
+  void look_up(const TypeHashKey* h_embeddingcolumns, size_t length, float* h_embeddingoutputvector,
+               size_t num_threads = 1) const;
+
+  size_t size() const { return num_keys_; }
+  size_t capacity() const { return slots_.size(); }
+  size_t embedding_vec_size() const { return embedding_vec_size_; }
+  bool is_mapped() const { return mapped_values_ != nullptr; }
+  // Host memory held by the key index and the value arena, a mapped arena is not counted
+  size_t memory_footprint_in_byte() const;
+
+ private:
+  struct slot {
+    TypeHashKey key;
+    size_t row;
+  };
+  // Layout of the file written by dump_index, followed by the keys then the rows of all the slots.
+  // They are written as two arrays rather than as slots, so that the padding of a slot with 32-bit
+  // keys never reaches the file.
+  struct index_file_header {
+    long long key_size_in_byte;
+    long long embedding_vec_size;
+    long long num_rows;
+    long long num_keys;
+    long long shard_bits;
+    long long shard_capacity;
+    // Identify the key file the index was built from, a copy of another key file gets another
+    // inode and ctime even if it keeps the size and mtime
+    long long key_file_size;
+    long long key_file_inode;
+    long long key_file_mtime_ns;
+    long long key_file_ctime_ns;
+    long long layout_version;
+    long long reserved;
+  };
+  static constexpr long long INDEX_LAYOUT_VERSION_ = 1;
+  // Fill the key_file_* fields of header, return false if key_file cannot be stat'ed
+  static bool stat_key_file_(const std::string& key_file, index_file_header* header);
+  static constexpr size_t EMPTY_ROW_ = std::numeric_limits<size_t>::max();
+  // Slots are kept at most MAX_LOAD_FACTOR_ full to bound the probe length
+  static constexpr double MAX_LOAD_FACTOR_ = 0.7;
+  // Below this many keys per thread, building the index is not worth spawning threads
+  static constexpr size_t MIN_KEYS_PER_THREAD_ = 1 << 16;
+  // Below this many queried keys per thread, look_up stays on the caller's thread
+  static constexpr size_t MIN_QUERIES_PER_THREAD_ = 1 << 10;
+  // look_up resolves keys in blocks of this size, prefetching all slots then all rows of a block
+  static constexpr size_t PREFETCH_BLOCK_SIZE_ = 16;
+  // dump_index and load_mmap_from_index move the keys and the rows through a buffer of this many
+  static constexpr size_t INDEX_STAGING_SLOTS_ = 1 << 20;
+
+  static size_t hash_(TypeHashKey key) { return murmur_hash3_fmix64(static_cast<uint64_t>(key)); }
+  // The low bits of the hash select the slot within a shard, the high bits select the shard
+  size_t shard_of_(size_t hash) const {
+    return shard_bits_ == 0 ? 0 : hash >> (std::numeric_limits<size_t>::digits - shard_bits_);
+  }
+
+  const float* find_(TypeHashKey key, size_t hash) const {
+    if (num_keys_ == 0) {
+      return nullptr;
+    }
+    const slot* shard = slots_.data() + shard_of_(hash) * (mask_ + 1);
+    size_t pos = hash & mask_;
+    while (shard[pos].row != EMPTY_ROW_) {
+      if (shard[pos].key == key) {
+        return values_ + shard[pos].row * embedding_vec_size_;
+      }
+      pos = (pos + 1) & mask_;
+    }
+    return nullptr;
+  }
+
+  void look_up_chunk_(const TypeHashKey* h_embeddingcolumns, size_t length,
+                      float* h_embeddingoutputvector) const;
+  template <typename TypeFileKey>
+  void build_index_(const TypeFileKey* keys, size_t num_keys, size_t num_threads);
+  void map_values_(const std::string& vec_file, size_t num_rows);
+  void unmap_values_();
+
+  size_t embedding_vec_size_;
+  float default_emb_vec_value_;
+  size_t num_keys_;
+  size_t num_rows_;
+  size_t shard_bits_;
+  size_t mask_;
+  std::vector<slot> slots_;
+  // Filled with default_emb_vec_value_, copied for the missing keys
+  std::vector<float> default_emb_vec_;
+  // The value arena, points to either host_values_ or mapped_values_
+  const float* values_;
+  std::vector<float> host_values_;
+  void* mapped_values_;
+  size_t mapped_size_in_byte_;
+};
+
+}  // namespace HugeCTR
@@ -22,6 +22,7 @@
 
 namespace HugeCTR {
 enum INFER_TYPE { TRITON, OTHER };
+enum class CacheEvictionPolicy_t { LRU, LFU };
 
 struct InferenceParams {
   std::string model_name;
@@ -37,11 +38,30 @@ struct InferenceParams {
   float scaler;
   bool use_algorithm_search;
   bool use_cuda_graph;
+  bool use_mmap_sparse_model;
+  bool use_host_embedding_cache;
+  float host_cache_size_percentage;
+  size_t host_cache_set_associativity;
+  CacheEvictionPolicy_t host_cache_eviction_policy;
+  size_t host_cache_lfu_aging_queries_per_way;
+  bool use_bf16_packed_weights;
+  size_t num_cpu_workspaces;
+  size_t num_look_up_threads;
+  std::string sparse_model_index_cache_dir;
   InferenceParams(const std::string& model_name, const size_t max_batchsize, const float hit_rate_threshold,
                   const std::string& dense_model_file, const std::vector<std::string>& sparse_model_files,
                   const int device_id, const bool use_gpu_embedding_cache, const float cache_size_percentage,
                   const bool i64_input_key, const bool use_mixed_precision = false, const float scaler = 1.0,
-                  const bool use_algorithm_search = true, const bool use_cuda_graph = true);
+                  const bool use_algorithm_search = true, const bool use_cuda_graph = true,
+                  const bool use_mmap_sparse_model = false, const bool use_host_embedding_cache = false,
+                  const float host_cache_size_percentage = 0.1,
+                  const size_t host_cache_set_associativity = 8,
+                  const CacheEvictionPolicy_t host_cache_eviction_policy = CacheEvictionPolicy_t::LRU,
+                  const size_t host_cache_lfu_aging_queries_per_way = 8,
+                  const bool use_bf16_packed_weights = false,
+                  const size_t num_cpu_workspaces = 0,
+                  const size_t num_look_up_threads = 0,
+                  const std::string& sparse_model_index_cache_dir = "");
 };
 
 struct parameter_server_config{
@@ -51,6 +71,7 @@ struct parameter_server_config{
   std::vector<std::vector<bool>> distributed_emb_; // The file format flag per embedding table per model
   std::vector<std::vector<size_t>> embedding_vec_size_; // The emb_vec_size per embedding table per model
   std::vector<std::vector<float>> default_emb_vec_value_; // The defualt emb_vec value when emb_id cannot be found, per embedding table per model
+  std::vector<size_t> num_look_up_threads_; // The max # of threads a look_up can be split across, per model
 };
 
 // Base interface class for parameter_server
@@ -28,6 +28,7 @@
 #include <vector>
 #include <unordered_map>
 #include <inference/inference_utils.hpp>
+#include <inference/flat_embedding_table.hpp>
 
 namespace HugeCTR {
 
@@ -47,8 +48,8 @@ class parameter_server : public parameter_server_base, public HugectrUtility<Typ
  private:
   // The framework name
   std::string framework_name_;
-  // Currently, embedding tables are implemented as CPU hashtable, 1 hashtable per embedding table per model
-  std::vector<std::vector<std::unordered_map<TypeHashKey, std::vector<float>>>> cpu_embedding_table_;
+  // Currently, embedding tables are implemented as CPU open-addressing hashtable over a contiguous value arena, 1 table per embedding table per model
+  std::vector<std::vector<flat_embedding_table<TypeHashKey>>> cpu_embedding_table_;
   // The parameter server configuration
   parameter_server_config ps_config_;
 };
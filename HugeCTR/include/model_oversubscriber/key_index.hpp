@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <common.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * @brief A compact key<-->slot_id<-->index mapping of the sparse model.
+ *
+ * The keys are kept in a sorted array, each next to a word which packs its slot_id and index: 16
+ * bytes per key instead of the 50+ bytes of a node of an unordered_map. A key is looked up in a
+ * radix table, which maps the high bits of the key to the one or two keys of the array it falls
+ * between, then by binary search among them. A lookup thus misses the cache about as often as in
+ * an unordered_map, once in the table and once in the array. Where the keys are dense, a bucket of
+ * the table holds a nested table over the lower bits, so that a skewed key costs one more table
+ * lookup instead of a long binary search. The keys inserted after the array is built go to a small
+ * hash map, which is merged into the array once it grows past a fraction of it.
+ * find() and contains() can be called by several threads at the same time, insert(), merge() and
+ * build() cannot.
+ */
+template <typename TypeKey>
+class KeyIndex {
+  using DeltaMapType = std::unordered_map<TypeKey, std::pair<size_t, size_t>>;
+
+  static constexpr int kIndexBits = 40;            /**< the low bits of a value, the slot_id above */
+  static constexpr size_t kMinMergeSize = 1 << 16; /**< delta keys never merged below this */
+  static constexpr size_t kKeysPerBucket = 2;
+  static constexpr size_t kMaxBucketKeys = 64;     /**< larger buckets get a nested table */
+  static constexpr int kMaxTableBits = 26;
+  static constexpr size_t kNodeFlag = size_t(1) << 63;
+
+  /**
+   * A radix table over the keys [begin, end), whose offsets from the smallest key start at base.
+   * Bucket b holds the keys whose (offset - base) >> shift is b.
+   */
+  struct RadixNode {
+    uint64_t base;
+    int shift;
+    size_t begin;
+    size_t first_entry; /**< of the num_buckets + 1 entries of the node in table_ */
+  };
+
+  /**
+   * A key and its value share a cache line, so that a lookup misses the cache once in the array.
+   */
+  struct Entry {
+    TypeKey key;
+    uint64_t value; /**< slot_id << kIndexBits | index */
+  };
+
+  std::vector<Entry> entries_; /**< sorted by key */
+  /**
+   * The first position of each bucket, or kNodeFlag | the node of a bucket with a nested table.
+   */
+  std::vector<size_t> table_;
+  std::vector<RadixNode> nodes_;
+  DeltaMapType delta_;
+
+  static uint64_t offset_of(TypeKey key, TypeKey min_key) {
+    return static_cast<uint64_t>(key) - static_cast<uint64_t>(min_key);
+  }
+
+  static uint64_t pack(size_t slot_id, size_t index) {
+    if (index >> kIndexBits || slot_id >> (64 - kIndexBits)) {
+      CK_THROW_(Error_t::OutOfBound, "slot_id " + std::to_string(slot_id) + " or index " +
+                                         std::to_string(index) + " out of range");
+    }
+    return static_cast<uint64_t>(slot_id) << kIndexBits | index;
+  }
+
+  static size_t slot_id_of(uint64_t value) { return value >> kIndexBits; }
+  static size_t index_of(uint64_t value) { return value & ((uint64_t(1) << kIndexBits) - 1); }
+
+  size_t entry_position_(size_t entry) const {
+    return (entry & kNodeFlag) ? nodes_[entry & ~kNodeFlag].begin : entry;
+  }
+
+  /**
+   * Build the table of the keys [begin, end), whose offsets lie in [base, base + range], with
+   * about kKeysPerBucket keys per bucket. The buckets which still hold more than kMaxBucketKeys
+   * keys get a nested table.
+   * @return the node
+   */
+  size_t build_node_(size_t begin, size_t end, uint64_t base, uint64_t range) {
+    int bits = 1;
+    while (bits < kMaxTableBits && (kKeysPerBucket << bits) < end - begin) {
+      bits++;
+    }
+    int shift = 0;
+    while ((range >> shift) >= (uint64_t(1) << bits)) {
+      shift++;
+    }
+    const size_t num_buckets = static_cast<size_t>(range >> shift) + 1;
+    const size_t node_id = nodes_.size();
+    const size_t first_entry = table_.size();
+    nodes_.push_back({base, shift, begin, first_entry});
+    table_.resize(first_entry + num_buckets + 1);
+
+    size_t pos = begin;
+    for (size_t b = 0; b < num_buckets; b++) {
+      table_[first_entry + b] = pos;
+      while (pos < end && ((offset_of(entries_[pos].key, entries_.front().key) - base) >> shift) == b) {
+        pos++;
+      }
+    }
+    table_[first_entry + num_buckets] = end;
+    if (shift > 0) {
+      for (size_t b = 0; b < num_buckets; b++) {
+        const size_t bucket_begin = table_[first_entry + b];
+        const size_t bucket_end = table_[first_entry + b + 1];
+        if (bucket_end - bucket_begin > kMaxBucketKeys) {
+          const uint64_t bucket_base = base + (static_cast<uint64_t>(b) << shift);
+          const size_t child = build_node_(bucket_begin, bucket_end, bucket_base,
+                                           (uint64_t(1) << shift) - 1);
+          table_[first_entry + b] = kNodeFlag | child;
+        }
+      }
+    }
+    return node_id;
+  }
+
+  void build_table_() {
+    table_.clear();
+    nodes_.clear();
+    if (!entries_.empty()) {
+      build_node_(0, entries_.size(), 0, offset_of(entries_.back().key, entries_.front().key));
+    }
+    table_.shrink_to_fit();
+    nodes_.shrink_to_fit();
+  }
+
+  /**
+   * @return the position of key in entries_, or entries_.size() if it is not there
+   */
+  size_t find_position_(TypeKey key) const {
+    if (entries_.empty() || key < entries_.front().key || entries_.back().key < key) {
+      return entries_.size();
+    }
+    const uint64_t offset = offset_of(key, entries_.front().key);
+    const RadixNode* node = &nodes_[0];
+    while (true) {
+      const size_t entry = node->first_entry + ((offset - node->base) >> node->shift);
+      if (table_[entry] & kNodeFlag) {
+        node = &nodes_[table_[entry] & ~kNodeFlag];
+        continue;
+      }
+      const auto begin = entries_.begin() + table_[entry];
+      const auto end = entries_.begin() + entry_position_(table_[entry + 1]);
+      const auto it = std::lower_bound(
+          begin, end, key, [](const Entry& entry, TypeKey key) { return entry.key < key; });
+      return (it != end && it->key == key) ? it - entries_.begin() : entries_.size();
+    }
+  }
+
+ public:
+  /**
+   * @brief Replace the mapping with the given keys, in any order. Of the duplicate keys only the
+   *        first one is kept, like unordered_map::insert.
+   * @param slot_ids The slot_ids of the keys, or empty if they are all 0, i.e. distributed
+   *                 embedding.
+   */
+  void build(const std::vector<TypeKey>& keys, const std::vector<size_t>& slot_ids,
+             const std::vector<size_t>& indices) {
+    if (keys.size() != indices.size() || (!slot_ids.empty() && keys.size() != slot_ids.size())) {
+      CK_THROW_(Error_t::WrongInput, "keys, slot_ids and indices differ in size");
+    }
+    const size_t num_keys = keys.size();
+    std::vector<size_t> order(num_keys);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+    clear();
+    entries_.reserve(num_keys);
+    for (size_t i : order) {
+      if (!entries_.empty() && entries_.back().key == keys[i]) {
+        continue;
+      }
+      entries_.push_back({keys[i], pack(slot_ids.empty() ? 0 : slot_ids[i], indices[i])});
+    }
+    entries_.shrink_to_fit();
+    build_table_();
+  }
+
+  bool find(TypeKey key, size_t& slot_id, size_t& index) const {
+    const size_t pos = find_position_(key);
+    if (pos != entries_.size()) {
+      slot_id = slot_id_of(entries_[pos].value);
+      index = index_of(entries_[pos].value);
+      return true;
+    }
+    if (!delta_.empty()) {
+      auto iter = delta_.find(key);
+      if (iter != delta_.end()) {
+        slot_id = iter->second.first;
+        index = iter->second.second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool contains(TypeKey key) const {
+    return find_position_(key) != entries_.size() || delta_.find(key) != delta_.end();
+  }
+
+  /**
+   * @brief Insert a key which is not in the mapping yet, a key which is already there is left
+   *        unchanged.
+   * @return whether the key was inserted
+   */
+  bool insert(TypeKey key, size_t slot_id, size_t index) {
+    pack(slot_id, index);
+    if (find_position_(key) != entries_.size() ||
+        !delta_.emplace(key, std::make_pair(slot_id, index)).second) {
+      return false;
+    }
+    if (delta_.size() > std::max(kMinMergeSize, entries_.size() / 8)) {
+      merge();
+    }
+    return true;
+  }
+
+  /**
+   * @brief Merge the inserted keys into the sorted array.
+   */
+  void merge() {
+    if (delta_.empty()) {
+      return;
+    }
+    std::vector<std::pair<TypeKey, std::pair<size_t, size_t>>> delta(delta_.begin(),
+                                                                     delta_.end());
+    DeltaMapType().swap(delta_);
+    std::sort(delta.begin(), delta.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<Entry> entries;
+    entries.reserve(entries_.size() + delta.size());
+    size_t i = 0, j = 0;
+    while (i < entries_.size() || j < delta.size()) {
+      if (j == delta.size() || (i < entries_.size() && entries_[i].key < delta[j].first)) {
+        entries.push_back(entries_[i]);
+        i++;
+      } else {
+        entries.push_back({delta[j].first, pack(delta[j].second.first, delta[j].second.second)});
+        j++;
+      }
+    }
+    entries_.swap(entries);
+    build_table_();
+  }
+
+  /**
+   * @brief Call func(key, slot_id, index) for every key, the sorted ones first, then the
+   *        inserted ones which are not merged yet.
+   */
+  template <typename Func>
+  void for_each(Func func) const {
+    for (const Entry& entry : entries_) {
+      func(entry.key, slot_id_of(entry.value), index_of(entry.value));
+    }
+    for (const auto& pair : delta_) {
+      func(pair.first, pair.second.first, pair.second.second);
+    }
+  }
+
+  size_t size() const { return entries_.size() + delta_.size(); }
+  bool empty() const { return size() == 0; }
+
+  void clear() {
+    std::vector<Entry>().swap(entries_);
+    std::vector<size_t>().swap(table_);
+    std::vector<RadixNode>().swap(nodes_);
+    DeltaMapType().swap(delta_);
+  }
+
+  /**
+   * @return the host memory of the sorted arrays and the radix table, the unmerged keys excluded
+   */
+  size_t get_memory_bytes() const {
+    return entries_.capacity() * sizeof(Entry) +
+           table_.capacity() * sizeof(size_t) + nodes_.capacity() * sizeof(RadixNode);
+  }
+};
+
+}  // namespace HugeCTR
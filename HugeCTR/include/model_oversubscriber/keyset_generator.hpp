@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <common.hpp>
+#include <data_readers/check_crc32c.hpp>
+#include <data_readers/check_none.hpp>
+#include <data_readers/check_sum.hpp>
+#include <data_readers/file_source.hpp>
+#include <data_readers/mmap_source.hpp>
+#include <data_readers/norm_v2_block_list.hpp>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace HugeCTR {
+
+struct KeysetGeneratorParams {
+  DataReaderType_t format{DataReaderType_t::Norm}; /**< Norm or Raw */
+  Check_t check_type{Check_t::Sum};                /**< of a Norm data set */
+  std::vector<int> slot_num; /**< the slots of each embedding, in the order of the samples */
+  int label_dim{1};          /**< of a Raw data set */
+  int dense_dim{13};         /**< of a Raw data set */
+  long long num_samples{0};  /**< of a Raw data set */
+  int num_threads{1};
+  long long min_count{1};    /**< the keys which occur fewer times are left out */
+  size_t top_k{0};           /**< only the top_k most frequent keys of an embedding, 0 for all */
+  bool write_counts{false};  /**< whether to write the count of each key next to its keyset */
+  size_t max_record_bytes{1 << 20}; /**< of a Norm data set, bounds its compressed blocks */
+};
+
+struct KeysetStats {
+  std::vector<size_t> unique_keys;  /**< of each embedding in the data set */
+  std::vector<size_t> written_keys; /**< of each embedding in its keyset file */
+  long long samples{0};
+  long long skipped_samples{0};     /**< which fail the check of the data set */
+  double seconds{0.0};
+};
+
+/**
+ * The keyset file of each embedding: prefix.keyset for a single embedding, prefix.<i>.keyset
+ * otherwise.
+ */
+inline std::vector<std::string> get_keyset_file_names(const std::string& prefix,
+                                                      size_t num_embeddings) {
+  if (num_embeddings == 1) {
+    return {prefix + ".keyset"};
+  }
+  std::vector<std::string> file_names;
+  for (size_t i = 0; i < num_embeddings; i++) {
+    file_names.push_back(prefix + "." + std::to_string(i) + ".keyset");
+  }
+  return file_names;
+}
+
+namespace keyset_generator_internal {
+
+inline uint64_t hash_key(uint64_t key) { return key * 0x9e3779b97f4a7c15ULL; }
+
+/**
+ * An open addressing map from the keys to their counts.
+ */
+template <typename TypeKey>
+class KeyCounter {
+  std::vector<TypeKey> keys_;
+  std::vector<uint64_t> counts_; /**< 0 for an empty slot */
+  int bits_{0};
+  size_t size_{0};
+
+  size_t slot(TypeKey key) const {
+    return static_cast<size_t>(hash_key(static_cast<uint64_t>(key)) >> (64 - bits_));
+  }
+
+  void rehash(int bits) {
+    std::vector<TypeKey> keys;
+    std::vector<uint64_t> counts;
+    keys.swap(keys_);
+    counts.swap(counts_);
+    bits_ = bits;
+    keys_.assign(size_t(1) << bits, 0);
+    counts_.assign(size_t(1) << bits, 0);
+    size_ = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+      if (counts[i] > 0) {
+        add(keys[i], counts[i]);
+      }
+    }
+  }
+
+ public:
+  KeyCounter() { rehash(10); }
+
+  void add(TypeKey key, uint64_t count = 1) {
+    if (2 * (size_ + 1) > counts_.size()) {
+      rehash(bits_ + 1);
+    }
+    size_t i = slot(key);
+    while (counts_[i] > 0) {
+      if (keys_[i] == key) {
+        counts_[i] += count;
+        return;
+      }
+      i = (i + 1) & (counts_.size() - 1);
+    }
+    keys_[i] = key;
+    counts_[i] = count;
+    size_++;
+  }
+
+  void merge(const KeyCounter& other) {
+    for (size_t i = 0; i < other.counts_.size(); i++) {
+      if (other.counts_[i] > 0) {
+        add(other.keys_[i], other.counts_[i]);
+      }
+    }
+  }
+
+  template <typename Func>
+  void for_each(Func func) const {
+    for (size_t i = 0; i < counts_.size(); i++) {
+      if (counts_[i] > 0) {
+        func(keys_[i], counts_[i]);
+      }
+    }
+  }
+
+  size_t size() const { return size_; }
+
+  void clear() {
+    KeyCounter empty;
+    std::swap(*this, empty);
+  }
+};
+
+/**
+ * Run task(i) for i in [0, num_tasks) on num_threads threads and rethrow the first exception.
+ */
+template <typename Task>
+void parallel_for(int num_tasks, int num_threads, Task task) {
+  std::mutex mutex;
+  int next = 0;
+  std::exception_ptr error;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < std::min(num_tasks, num_threads); t++) {
+    threads.emplace_back([&]() {
+      while (true) {
+        int i;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (next == num_tasks || error) {
+            return;
+          }
+          i = next++;
+        }
+        try {
+          task(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace keyset_generator_internal
+
+/**
+ * @brief Writes the keyset files of a data set, which the model oversubscriber loads.
+ *
+ * The data set is read with the sources of the data readers, by num_threads threads which each
+ * count the keys of their part of it. The counts are kept in shards by the hash of the keys, so
+ * that the counts of the threads are merged shard by shard in parallel. A keyset file is the
+ * array of the keys of an embedding, sorted, or from the most to the least frequent with top_k.
+ */
+template <typename TypeKey>
+class KeysetGenerator {
+  using KeyCounter = keyset_generator_internal::KeyCounter<TypeKey>;
+
+  KeysetGeneratorParams params_;
+  int num_shards_;
+  std::vector<int> embedding_of_slot_;
+
+  /**
+   * The counts of a thread, per embedding and shard.
+   */
+  struct ThreadCounts {
+    std::vector<std::vector<KeyCounter>> counters;
+    long long samples{0};
+    long long skipped_samples{0};
+  };
+
+  void add_key(ThreadCounts* counts, int embedding, TypeKey key) const {
+    const uint64_t hash = keyset_generator_internal::hash_key(static_cast<uint64_t>(key));
+    // the low bits of the hash pick the shard, the high ones the slot of the counter
+    counts->counters[embedding][hash % num_shards_].add(key);
+  }
+
+  std::shared_ptr<Checker> create_checker(Source& source) const {
+    switch (params_.check_type) {
+      case Check_t::Sum:
+        return std::make_shared<CheckSum>(source);
+      case Check_t::None:
+        return std::make_shared<CheckNone>(source);
+      case Check_t::CRC32C:
+        return std::make_shared<CheckCRC32C>(source);
+      default:
+        CK_THROW_(Error_t::WrongInput, "Not supported check type");
+    }
+    return nullptr;
+  }
+
+  static const char* read_view(Checker& checker, size_t bytes_to_read) {
+    const char* ptr = nullptr;
+    Error_t err = checker.read_view(&ptr, bytes_to_read);
+    CK_THROW_(err, "failure in reading the data set");
+    return ptr;
+  }
+
+  void count_norm(const std::shared_ptr<Source>& source, ThreadCounts* counts) const {
+    auto checker = create_checker(*source);
+    const int total_slot_num = embedding_of_slot_.size();
+    // the keys of a sample are only counted once the whole sample passes the check
+    std::vector<std::pair<int, TypeKey>> sample_keys;
+    while (checker->next_source() == Error_t::Success) {
+      DataSetHeader header;
+      Error_t err = checker->read(reinterpret_cast<char*>(&header), sizeof(DataSetHeader));
+      CK_THROW_(err, "failure in reading the header");
+      if (header.slot_num != total_slot_num) {
+        CK_THROW_(Error_t::WrongInput, "the slots of the data set are not the slots of the "
+                                       "embeddings: " + std::to_string(header.slot_num));
+      }
+      const size_t label_dense_bytes = sizeof(float) * (header.label_dim + header.dense_dim);
+      for (long long i = 0; i < header.number_of_records; i++) {
+        sample_keys.clear();
+        try {
+          read_view(*checker, label_dense_bytes);
+          for (int k = 0; k < total_slot_num; k++) {
+            int nnz;
+            memcpy(&nnz, read_view(*checker, sizeof(int)), sizeof(int));
+            if (nnz < 0) {
+              CK_THROW_(Error_t::BrokenFile, "nnz < 0");
+            }
+            const char* keys = read_view(*checker, sizeof(TypeKey) * nnz);
+            for (int j = 0; j < nnz; j++) {
+              TypeKey key;
+              memcpy(&key, keys + sizeof(TypeKey) * j, sizeof(TypeKey));
+              sample_keys.emplace_back(embedding_of_slot_[k], key);
+            }
+          }
+        } catch (const internal_runtime_error& rt_err) {
+          if (rt_err.get_error() != Error_t::DataCheckError) {
+            throw;
+          }
+          counts->skipped_samples++;
+          continue;
+        }
+        for (const auto& embedding_key : sample_keys) {
+          add_key(counts, embedding_key.first, embedding_key.second);
+        }
+        counts->samples++;
+      }
+    }
+  }
+
+  void count_raw(const std::shared_ptr<MmapOffsetList>& offset_list, int thread_id,
+                 ThreadCounts* counts) const {
+    MmapSource source(offset_list, thread_id);
+    const int label_dense_dim = params_.label_dim + params_.dense_dim;
+    const int total_slot_num = embedding_of_slot_.size();
+    const size_t stride = sizeof(int) * (label_dense_dim + total_slot_num);
+    Error_t err;
+    while ((err = source.next_source()) == Error_t::Success) {
+      for (const MmapChunk& chunk : source.get_chunks()) {
+        for (long long i = 0; i < chunk.samples; i++) {
+          const char* feature_ids = chunk.offset + i * stride + sizeof(int) * label_dense_dim;
+          for (int k = 0; k < total_slot_num; k++) {
+            int key;
+            memcpy(&key, feature_ids + sizeof(int) * k, sizeof(int));
+            add_key(counts, embedding_of_slot_[k], static_cast<TypeKey>(key));
+          }
+        }
+      }
+      counts->samples += source.get_num_of_items_in_source();
+    }
+    if (err != Error_t::EndOfFile) {
+      CK_THROW_(err, "failure in reading the data set");
+    }
+  }
+
+  /**
+   * Write the keys of an embedding with count >= min_count, the top_k most frequent ones if
+   * top_k > 0.
+   * @return the number of keys written
+   */
+  size_t write_keyset(std::vector<std::pair<TypeKey, uint64_t>>& keys,
+                      const std::string& file_name) const {
+    auto end = std::remove_if(keys.begin(), keys.end(), [this](const std::pair<TypeKey, uint64_t>& key) {
+      return key.second < static_cast<uint64_t>(params_.min_count);
+    });
+    keys.erase(end, keys.end());
+    if (params_.top_k > 0 && keys.size() > params_.top_k) {
+      auto more_frequent = [](const std::pair<TypeKey, uint64_t>& a,
+                              const std::pair<TypeKey, uint64_t>& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+      };
+      std::nth_element(keys.begin(), keys.begin() + params_.top_k, keys.end(), more_frequent);
+      keys.resize(params_.top_k);
+      std::sort(keys.begin(), keys.end(), more_frequent);
+    } else {
+      std::sort(keys.begin(), keys.end());
+    }
+
+    std::vector<TypeKey> key_array(keys.size());
+    std::vector<uint64_t> count_array(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      key_array[i] = keys[i].first;
+      count_array[i] = keys[i].second;
+    }
+    std::ofstream keyset_stream(file_name, std::ofstream::binary);
+    keyset_stream.write(reinterpret_cast<const char*>(key_array.data()),
+                        key_array.size() * sizeof(TypeKey));
+    if (!keyset_stream.good()) {
+      CK_THROW_(Error_t::BrokenFile, "failed to write " + file_name);
+    }
+    if (params_.write_counts) {
+      std::ofstream count_stream(file_name + ".count", std::ofstream::binary);
+      count_stream.write(reinterpret_cast<const char*>(count_array.data()),
+                         count_array.size() * sizeof(uint64_t));
+      if (!count_stream.good()) {
+        CK_THROW_(Error_t::BrokenFile, "failed to write " + file_name + ".count");
+      }
+    }
+    return keys.size();
+  }
+
+ public:
+  KeysetGenerator(const KeysetGeneratorParams& params)
+      : params_(params), num_shards_(4 * std::max(params.num_threads, 1)) {
+    if (params_.format != DataReaderType_t::Norm && params_.format != DataReaderType_t::Raw) {
+      CK_THROW_(Error_t::WrongInput, "the keysets of a Norm or Raw data set only");
+    }
+    if (params_.slot_num.empty()) {
+      CK_THROW_(Error_t::WrongInput, "slot_num.empty()");
+    }
+    params_.num_threads = std::max(params_.num_threads, 1);
+    for (size_t i = 0; i < params_.slot_num.size(); i++) {
+      if (params_.slot_num[i] <= 0) {
+        CK_THROW_(Error_t::WrongInput, "slot_num <= 0");
+      }
+      embedding_of_slot_.insert(embedding_of_slot_.end(), params_.slot_num[i], i);
+    }
+  }
+
+  /**
+   * Read a data set and write the keyset file of each embedding.
+   * @param source the file list of a Norm data set, or the file of a Raw data set
+   * @param keyset_files a file per embedding
+   */
+  KeysetStats generate(const std::string& source, const std::vector<std::string>& keyset_files) {
+    namespace internal = keyset_generator_internal;
+    const auto start = std::chrono::steady_clock::now();
+    const size_t num_embeddings = params_.slot_num.size();
+    if (keyset_files.size() != num_embeddings) {
+      CK_THROW_(Error_t::WrongInput, "a keyset file per embedding is needed");
+    }
+
+    std::vector<ThreadCounts> counts(params_.num_threads);
+    for (auto& thread_counts : counts) {
+      thread_counts.counters.resize(num_embeddings, std::vector<KeyCounter>(num_shards_));
+    }
+    if (params_.format == DataReaderType_t::Norm) {
+      // the threads share the blocks of a v2 data set like the workers of the data reader
+      auto block_list = is_norm_v2_file_list(source)
+                            ? std::make_shared<NormV2BlockList>(source, false)
+                            : nullptr;
+      internal::parallel_for(params_.num_threads, params_.num_threads, [&](int t) {
+        std::shared_ptr<Source> file_source =
+            block_list ? std::make_shared<FileSource>(block_list, t, params_.num_threads, false,
+                                                      params_.max_record_bytes)
+                       : std::make_shared<FileSource>(t, params_.num_threads, source, false);
+        count_norm(file_source, &counts[t]);
+      });
+    } else {
+      const long long stride =
+          sizeof(int) * (params_.label_dim + params_.dense_dim + embedding_of_slot_.size());
+      constexpr long long kBatchSamples = 16384;
+      auto offset_list = std::make_shared<MmapOffsetList>(
+          source, params_.num_samples, stride, kBatchSamples, false, params_.num_threads, false);
+      internal::parallel_for(params_.num_threads, params_.num_threads,
+                             [&](int t) { count_raw(offset_list, t, &counts[t]); });
+    }
+
+    // merge the shards of the threads, then write the keys of each embedding
+    KeysetStats stats;
+    for (const auto& thread_counts : counts) {
+      stats.samples += thread_counts.samples;
+      stats.skipped_samples += thread_counts.skipped_samples;
+    }
+    std::vector<std::vector<std::pair<TypeKey, uint64_t>>> shard_keys(num_embeddings *
+                                                                       num_shards_);
+    internal::parallel_for(num_embeddings * num_shards_, params_.num_threads, [&](int i) {
+      const int embedding = i / num_shards_;
+      const int shard = i % num_shards_;
+      KeyCounter& merged = counts[0].counters[embedding][shard];
+      for (size_t t = 1; t < counts.size(); t++) {
+        merged.merge(counts[t].counters[embedding][shard]);
+        counts[t].counters[embedding][shard].clear();
+      }
+      shard_keys[i].reserve(merged.size());
+      merged.for_each(
+          [&](TypeKey key, uint64_t count) { shard_keys[i].emplace_back(key, count); });
+      merged.clear();
+    });
+    stats.unique_keys.resize(num_embeddings);
+    stats.written_keys.resize(num_embeddings);
+    internal::parallel_for(num_embeddings, params_.num_threads, [&](int embedding) {
+      std::vector<std::pair<TypeKey, uint64_t>> keys;
+      for (int shard = 0; shard < num_shards_; shard++) {
+        auto& one_shard = shard_keys[embedding * num_shards_ + shard];
+        keys.insert(keys.end(), one_shard.begin(), one_shard.end());
+        std::vector<std::pair<TypeKey, uint64_t>>().swap(one_shard);
+      }
+      stats.unique_keys[embedding] = keys.size();
+      stats.written_keys[embedding] = write_keyset(keys, keyset_files[embedding]);
+    });
+    stats.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+  }
+
+  /**
+   * Like generate, in the background, e.g. for the data set of the next pass while the current
+   * one is trained on. C++ only, Python runs the keyset_generator tool in a separate process.
+   */
+  std::future<KeysetStats> generate_async(const std::string& source,
+                                          const std::vector<std::string>& keyset_files) {
+    return std::async(std::launch::async,
+                      [this, source, keyset_files]() { return generate(source, keyset_files); });
+  }
+};
+
+}  // namespace HugeCTR
@@ -32,7 +32,8 @@ public:
       std::vector<std::shared_ptr<IEmbedding>>& embeddings,
       const std::vector<std::string>& sparse_embedding_files,
       std::shared_ptr<ResourceManager> resource_manager,
-      bool use_mixed_precision, bool is_i64_key) {
+      bool use_mixed_precision, bool is_i64_key,
+      bool use_log_structured_store = false) {
     std::vector<SparseEmbeddingHashParams> embedding_params;
     if (is_i64_key) {
       for (auto& embedding : embeddings) {
@@ -40,14 +41,16 @@ public:
         embedding_params.push_back(param);
       }
       impl_base_.reset(new ModelOversubscriberImpl<long long>(use_host_ps,
-          embeddings, embedding_params, sparse_embedding_files, resource_manager));
+          embeddings, embedding_params, sparse_embedding_files, resource_manager,
+          use_log_structured_store));
     } else {
       for (auto& embedding : embeddings) {
         const auto& param = embedding->get_embedding_params();
         embedding_params.push_back(param);
       }
       impl_base_.reset(new ModelOversubscriberImpl<unsigned>(use_host_ps,
-          embeddings, embedding_params, sparse_embedding_files, resource_manager));
+          embeddings, embedding_params, sparse_embedding_files, resource_manager,
+          use_log_structured_store));
     }
   }
 
@@ -59,7 +62,15 @@ public:
     impl_base_->update(keyset_file);
   }
 
+  void prefetch(std::vector<std::string>& keyset_file_list) {
+    impl_base_->prefetch(keyset_file_list);
+  }
+
+  void prefetch(std::string& keyset_file) { impl_base_->prefetch(keyset_file); }
+
   void update_sparse_model_file() { impl_base_->update_sparse_model_file(); }
+
+  size_t get_num_pushed_vectors() const { return impl_base_->get_num_pushed_vectors(); }
 };
 
 }  // namespace HugeCTR
@@ -22,6 +22,8 @@
 #include "HugeCTR/include/model_oversubscriber/parameter_server_manager.hpp"
 
 #include <algorithm>
+#include <functional>
+#include <future>
 #include <iterator>
 
 namespace HugeCTR {
@@ -31,7 +33,10 @@ public:
   virtual void dump() = 0;
   virtual void update(std::vector<std::string>& keyset_file_list) = 0;
   virtual void update(std::string& keyset_file) = 0;
+  virtual void prefetch(std::vector<std::string>& keyset_file_list) = 0;
+  virtual void prefetch(std::string& keyset_file) = 0;
   virtual void update_sparse_model_file() = 0;
+  virtual size_t get_num_pushed_vectors() const = 0;
   virtual ~ModelOversubscriberImplBase() = default;
 };
 
@@ -40,6 +45,19 @@ template <typename TypeKey>
 class ModelOversubscriberImpl : public ModelOversubscriberImplBase {
   std::vector<std::shared_ptr<IEmbedding>> embeddings_;
   ParameterServerManager<TypeKey> ps_manager_;
+  bool async_write_back_; /**< whether the evicted keys are pushed in the background */
+  // of each embedding, the keys on the devices which are in the sparse model, sorted, and the
+  // fingerprints of their vectors there, so that only the vectors changed on the devices are
+  // pushed back
+  std::vector<std::vector<TypeKey>> pulled_keys_;
+  std::vector<std::vector<uint64_t>> pulled_fingerprints_;
+  size_t num_dumped_{0};
+  size_t num_pushed_{0};
+  std::vector<std::string> prefetched_keyset_file_list_;
+  std::vector<size_t> prefetched_hit_sizes_; /**< rows of each staging buffer bag */
+  std::vector<std::vector<uint64_t>> prefetched_fingerprints_;
+  double prefetch_seconds_{0.0};
+  std::future<void> background_task_; /**< the last one of the chained background tasks */
 
   size_t get_max_embedding_size_() {
     size_t max_embedding_size = 0;
@@ -57,20 +75,62 @@ class ModelOversubscriberImpl : public ModelOversubscriberImplBase {
    */
   void load_(std::vector<std::string>& keyset_file_list);
 
+  /**
+   * @brief Dump the embeddings from devices, and push the vectors which differ from the
+   *        sparse model to sparse_model_entity_.
+   */
+  void dump_();
+
+  /**
+   * @brief Find which of the num rows of buf_bag, dumped from the i-th embedding, differ from
+   *        the sparse model: the new keys, and the keys whose vectors no longer match the
+   *        fingerprints they were pulled with.
+   * @param fingerprints The fingerprints of the rows.
+   * @param is_dirty Whether each row is to be pushed.
+   */
+  void find_dirty_rows_(size_t i, BufferBag& buf_bag, size_t num,
+                        std::vector<uint64_t>& fingerprints, std::vector<char>& is_dirty);
+
+  /**
+   * @brief Record the keys of the num rows of buf_bag as the ones on the devices of the i-th
+   *        embedding, whose vectors in the sparse model have the fingerprints.
+   */
+  void set_pulled_(size_t i, BufferBag& buf_bag, size_t num,
+                   const std::vector<uint64_t>& fingerprints);
+
+  /**
+   * @brief Run task in a background thread after the previous background task.
+   */
+  void run_in_background_(std::function<void()> task);
+
+  /**
+   * @brief Wait for the background tasks, and rethrow the error of any of them.
+   */
+  void wait_for_background_();
+
+  /**
+   * @brief Replace the embeddings of the current pass on devices with the prefetched ones.
+   *        The keys kept in the next pass are moved from the devices to the staging buffer
+   *        bags, and only the evicted ones are pushed to the parameter servers.
+   */
+  void switch_to_prefetched_();
+
 public:
   ModelOversubscriberImpl(bool use_host_ps,
       std::vector<std::shared_ptr<IEmbedding>>& embeddings,
       const std::vector<SparseEmbeddingHashParams>& embedding_params,
       const std::vector<std::string>& sparse_embedding_files,
-      std::shared_ptr<ResourceManager> resource_manager);
+      std::shared_ptr<ResourceManager> resource_manager,
+      bool use_log_structured_store = false);
 
   ModelOversubscriberImpl(const ModelOversubscriberImpl&) = delete;
   ModelOversubscriberImpl& operator=(const ModelOversubscriberImpl&) = delete;
 
-  ~ModelOversubscriberImpl() = default;
+  ~ModelOversubscriberImpl();
 
   /**
-     * @brief Dump the downloaded embeddings from GPUs to sparse_model_entity_.
+     * @brief Dump the downloaded embeddings from GPUs to sparse_model_entity_. Only the
+     *        vectors changed since they were pulled are written.
      */
     void dump() override;
 
@@ -88,9 +148,29 @@ public:
    */
   void update(std::string& keyset_file) override;
 
+  /**
+   * @brief Pull the embeddings of the next pass from the parameter servers to the staging
+   *        buffer bags in a background thread, while the current pass is trained. The next
+   *        update with the same keyset files only copies them to the devices.
+   * @param keyset_file_list The file list storing keyset files of the next pass.
+   */
+  void prefetch(std::vector<std::string>& keyset_file_list) override;
+
+  /**
+   * @brief Pull the embeddings of the next pass in a background thread.
+   * @param keyset_file A single file storing keysets of the next pass for all embeddings.
+   */
+  void prefetch(std::string& keyset_file) override;
+
   void update_sparse_model_file() override {
+    wait_for_background_();
     ps_manager_.update_sparse_model_file();
   }
+
+  /**
+   * @brief Number of vectors pushed to the sparse model by the last dump() or update().
+   */
+  size_t get_num_pushed_vectors() const override { return num_pushed_; }
 };
 
 }  // namespace HugeCTR
@@ -36,10 +36,13 @@ class ParameterServer {
    * @param embedding_type The type of embedding table object.
    * @param emb_vec_size Embedding vector size.
    * @param resource_manager The object of ResourceManager.
+   * @param use_log_structured_store Whether the sparse model is a log-structured
+   *        SparseModelStore instead of a SparseModelFile.
    */
   ParameterServer(bool use_host_ps, const std::string &sparse_model_file,
                   Embedding_t embedding_type, size_t emb_vec_size,
-                  std::shared_ptr<ResourceManager> resource_manager);
+                  std::shared_ptr<ResourceManager> resource_manager,
+                  bool use_log_structured_store = false);
 
   ParameterServer(const ParameterServer&) = delete;
   ParameterServer& operator=(const ParameterServer&) = delete;
@@ -51,7 +54,22 @@ class ParameterServer {
    * @param keyset_file The file storing keyset to be loaded.
    */
   void load_keyset_from_file(std::string keyset_file);
-  
+
+  /**
+   * @brief Load the keyset from keyset_file and pull their embedding vectors, like
+   *        load_keyset_from_file followed by pull, but without synchronizing the processes,
+   *        so that it can run in a background thread.
+   * @param keyset_file The file storing keyset to be loaded.
+   * @param buf_bag The buffer bag for keys, slot_id, and hash_table_val.
+   * @param hit_size The number of keys to be loaded to be loaded to buffer bag.
+   */
+  void prefetch(const std::string& keyset_file, BufferBag &buf_bag, size_t& hit_size);
+
+  /**
+   * @brief The keyset loaded the last time, sorted.
+   */
+  const std::vector<TypeKey>& get_keyset() const { return keyset_; }
+
   /**
    * @brief Pull embedding vectors from the sparse embedding model according to
    *        keyset_. It only loads embedding vectors that their corresponding
@@ -26,13 +26,16 @@ template <typename TypeKey>
 class ParameterServerManager {
   std::vector<std::shared_ptr<ParameterServer<TypeKey>>> ps_;
   BufferBag buf_bag_;
+  std::vector<size_t> emb_vec_sizes_;
+  std::vector<BufferBag> staging_buf_bags_; /**< one per ps_, allocated for prefetching */
 
 public:
   ParameterServerManager(bool use_host_ps,
       const std::vector<std::string>& sparse_embedding_files,
       const std::vector<Embedding_t>& embedding_types,
       const std::vector<SparseEmbeddingHashParams>& embedding_params,
-      size_t buffer_size, std::shared_ptr<ResourceManager> resource_manager);
+      size_t buffer_size, std::shared_ptr<ResourceManager> resource_manager,
+      bool use_log_structured_store = false);
 
   ParameterServerManager(const ParameterServerManager&) = delete;
   ParameterServerManager& operator=(const ParameterServerManager&) = delete;
@@ -43,6 +46,18 @@ public:
 
   BufferBag& get_buffer_bag() { return buf_bag_; }
 
+  /**
+   * @brief Allocate a staging buffer bag for each parameter server, to which the embedding
+   *        vectors of the next pass are pulled while the current one is trained. They share the
+   *        host/device tensors used by load_parameters with the buffer bag of the manager.
+   * @param buffer_sizes The number of keys each staging buffer bag holds.
+   */
+  void allocate_staging_buffer_bags(const std::vector<size_t>& buffer_sizes);
+
+  bool has_staging_buffer_bags() const { return !staging_buf_bags_.empty(); }
+
+  BufferBag& get_staging_buffer_bag(int i) { return staging_buf_bags_[i]; }
+
   void update_sparse_model_file() {
     for (auto& ps : ps_) { ps->flush_emb_tbl_to_ssd(); }
   }
@@ -18,26 +18,42 @@
 
 #include "embedding.hpp"
 #include "model_oversubscriber/sparse_model_file.hpp"
+#include "model_oversubscriber/sparse_model_store.hpp"
 
 namespace HugeCTR {
 
 template <typename TypeKey>
 class SparseModelEntity {
   using HashTableType = std::unordered_map<TypeKey, std::pair<size_t, size_t>>;
+  using KeyIndexType = KeyIndex<TypeKey>;
 
   bool use_host_ps_;
   std::vector<float> host_emb_tabel_;
-  HashTableType exist_key_idx_mapping_;
-  HashTableType new_key_idx_mapping_;
+  std::vector<uint8_t> is_dirty_row_; /**< rows of host_emb_tabel_ not flushed to disk yet */
+  KeyIndexType exist_key_idx_mapping_; /**< keys in the sparse model file */
+  KeyIndexType new_key_idx_mapping_;   /**< keys not flushed to the file yet */
   bool is_distributed_;
   size_t emb_vec_size_;
   std::shared_ptr<ResourceManager> resource_manager_;
-  SparseModelFile<TypeKey> sparse_model_file_;
+  // only one of them is used, depending on use_log_structured_store
+  std::unique_ptr<SparseModelFile<TypeKey>> sparse_model_file_;
+  std::unique_ptr<SparseModelStore<TypeKey>> sparse_model_store_;
+
+  bool ssd_contains_(TypeKey key) const {
+    return sparse_model_store_ ? sparse_model_store_->contains(key)
+                               : sparse_model_file_->get_key_index_map().contains(key);
+  }
 
 public:
+  /**
+   * @param use_log_structured_store Whether the sparse model on disk is a SparseModelStore,
+   *                                 with atomic passes and sequential writes, instead of a
+   *                                 SparseModelFile.
+   */
   SparseModelEntity(bool use_host_ps, const std::string &sparse_model_file,
       Embedding_t embedding_type, size_t emb_vec_size,
-      std::shared_ptr<ResourceManager> resource_manager);
+      std::shared_ptr<ResourceManager> resource_manager,
+      bool use_log_structured_store = false);
 
   /**
    * @brief Load embedding features (embedding vectors) through provided keys either from disk
@@ -64,7 +80,8 @@ public:
 
   /**
    * @brief Write the sparse model stored in the host memory to the disk. This function can only
-   *        be called when use_host_ps_==true, or a runtime error will be thrown out.
+   *        be called when use_host_ps_==true, or a runtime error will be thrown out. Only the
+   *        vectors dumped since the last flush are written.
    */
   void flush_emb_tbl_to_ssd();
 };
@@ -17,13 +17,27 @@
 #pragma once
 
 #include <resource_manager.hpp>
+#include <model_oversubscriber/key_index.hpp>
 
 #include <memory>
 #include <vector>
-#include <unordered_map>
 
 namespace HugeCTR {
 
+/**
+ * The last dump of embedding vectors to the file: the rows written, the runs of nearby rows they
+ * were coalesced into, how many of those went through O_DIRECT, the bytes written and the bytes
+ * read back to fill the gaps between the rows of a run.
+ */
+struct DumpStats {
+  size_t rows{0};
+  size_t runs{0};
+  size_t direct_runs{0};
+  size_t bytes_written{0};
+  size_t bytes_read{0};
+  double seconds{0.0};
+};
+
 template <typename TypeKey>
 class SparseModelFile {
   struct EmbeddingTableFile;
@@ -37,23 +51,27 @@ class SparseModelFile {
     const char* get_slot_file() { return emb_tbl_->slot_file.c_str(); }
   };
 
-  using HashTableType = std::unordered_map<TypeKey, std::pair<size_t, size_t>>;
+  using KeyIndexType = KeyIndex<TypeKey>;
 
   MmapHandler mmap_handler_;
-  HashTableType key_idx_map_;
+  KeyIndexType key_idx_map_;
   bool is_distributed_;
   size_t emb_vec_size_;
   std::shared_ptr<ResourceManager> resource_manager_;
+  DumpStats last_dump_stats_;
 
   void map_embedding_to_memory_();
   void sync_mmaped_embedding_with_disk_();
   void unmap_embedding_from_memory_();
+  void write_rows_(std::vector<std::pair<size_t, size_t>>& rows, const float *vecs);
 
 public:
   SparseModelFile(const std::string &sparse_model_file, Embedding_t embedding_type,
       size_t emb_vec_size, std::shared_ptr<ResourceManager> resource_manager);
 
-  HashTableType& get_key_index_map() { return key_idx_map_; }
+  const KeyIndexType& get_key_index_map() const { return key_idx_map_; }
+
+  const DumpStats& get_last_dump_stats() const { return last_dump_stats_; }
 
   /**
    * @brief Load embedding features (embedding vectors) through provided keys from disk.
@@ -74,7 +92,10 @@ public:
    *        The keyset stored in keys (and corresponding embedding vectors) must exist in
    *        the embedding file stored in disk. Or, a run-time error will be thrown out.
    *        This API can only be called by a single processor each time because updating
-   *        a file by multiple processors through mmap simultaneous will cause unexpected results.
+   *        a file by multiple processors simultaneous will cause unexpected results.
+   *        The vectors are written in the order of the file, nearby rows coalesced into runs
+   *        which are written at once, and only the written ranges are synced. Of the keys
+   *        dumped more than once the last vector is written.
    * 
    * @param keys Vector storing the keyset, their corresponding embedding vectors will be dumped.
    * @param vec_indices The memory indices of vectors in vecs. These indices are corresponding to
@@ -116,7 +137,7 @@ public:
    *                          memory based embedding table.
    * @param vecs Vector to store the loaded embedding vectors corresponding to mem_key_index_map.
    */
-  void load_emb_tbl_to_mem(HashTableType& mem_key_index_map, std::vector<float>& vecs);
+  void load_emb_tbl_to_mem(KeyIndexType& mem_key_index_map, std::vector<float>& vecs);
 };
 
 }  // namespace HugeCTR
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <resource_manager.hpp>
+#include <model_oversubscriber/key_index.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace HugeCTR {
+
+/**
+ * @brief A log-structured storage engine of the sparse model, an alternative to the
+ *        SparseModelFile which updates the vectors in place.
+ *
+ * Each rank keeps its part of the embedding table in the folder rank_<id> of the sparse model:
+ * - immutable segment files, each holding <key, slot_id, emb_vector> sorted by key,
+ * - a write-ahead log (WAL), to which every pass is appended and synced before it returns,
+ * - a MANIFEST listing the live segments and the current WAL, replaced by an atomic rename.
+ * A pass goes to the WAL and to a memtable in the host memory, or straight to a new segment
+ * when it is larger than the memtable. A full memtable is written to a new segment, which is
+ * then committed with the MANIFEST together with a new, empty WAL. So all the writes are
+ * sequential, and a crash leaves either the whole pass or none of it.
+ * A key is looked up in the memtable, then in the index of each segment, newest first. Once
+ * there are more than max_segments segments, a background thread merges them into one and drops
+ * the stale versions of the keys, so a key is looked up in max_segments + 1 places at most;
+ * when it falls behind by another max_segments segments, the writes wait for it.
+ * Reloading a sparse model needs the same number of processes as the one which wrote it.
+ */
+template <typename TypeKey>
+class SparseModelStore {
+  using KeyIndexType = KeyIndex<TypeKey>;
+
+  struct Segment;
+  using SegmentPtr = std::shared_ptr<const Segment>;
+
+  std::string folder_name_;
+  bool is_distributed_;
+  size_t emb_vec_size_;
+  size_t max_memtable_bytes_;
+  size_t max_segments_;
+  std::shared_ptr<ResourceManager> resource_manager_;
+
+  // the memtable, only used by the thread which calls the public APIs
+  KeyIndexType mem_index_; /**< key --> slot_id, row of the memtable */
+  std::vector<TypeKey> mem_keys_;
+  std::vector<size_t> mem_slots_;
+  std::vector<float> mem_vecs_;
+  int wal_fd_{-1};
+  size_t wal_bytes_{0};
+
+  // the state shared with the compaction thread, guarded by mutex_
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  std::vector<SegmentPtr> segments_; /**< oldest first */
+  uint64_t next_file_id_{0};
+  uint64_t wal_id_{0};
+  bool compaction_requested_{false};
+  bool compacting_{false};
+  bool stop_{false};
+  std::string compaction_error_;
+  std::thread compaction_thread_;
+
+  std::string file_name_(const std::string &kind, uint64_t id) const;
+  std::vector<SegmentPtr> get_segments_() const;
+  void write_manifest_();
+  void recover_();
+  void replay_wal_();
+  void open_wal_();
+  void insert_to_memtable_(TypeKey key, size_t slot_id, const float *vec);
+  SegmentPtr write_segment_(uint64_t id, const std::vector<TypeKey> &keys,
+                            const std::vector<size_t> &slots,
+                            const std::vector<const float *> &vecs);
+  void flush_memtable_(SegmentPtr pass_segment);
+  void check_compaction_error_();
+  void compact_();
+  void compaction_loop_();
+
+  /**
+   * Call func(key, slot_id, vec) for the newest version of every key of the segments, and of
+   * the memtable if with_memtable, in key order.
+   */
+  template <typename Func>
+  void for_each_live_(const std::vector<SegmentPtr> &segments, bool with_memtable, Func func);
+
+public:
+  /**
+   * @brief Open the store in the folder sparse_model_store, or create it if it doesn't exist.
+   *        The WAL of an interrupted run is replayed up to its last complete pass.
+   * @param max_memtable_bytes The size of the WAL at which the memtable is written to a
+   *                           segment, a larger pass is written as a segment at once.
+   * @param max_segments The number of segments which triggers a compaction.
+   */
+  SparseModelStore(const std::string &sparse_model_store, Embedding_t embedding_type,
+                   size_t emb_vec_size, std::shared_ptr<ResourceManager> resource_manager,
+                   size_t max_memtable_bytes = 256 * 1024 * 1024, size_t max_segments = 4);
+
+  SparseModelStore(const SparseModelStore &) = delete;
+  SparseModelStore &operator=(const SparseModelStore &) = delete;
+
+  /**
+   * @brief Stop the compaction thread. The memtable is left in the WAL, and is replayed when
+   *        the store is opened again.
+   */
+  ~SparseModelStore();
+
+  bool contains(TypeKey key) const;
+
+  size_t get_num_segments() const { return get_segments_().size(); }
+
+  /**
+   * @brief Load embedding features (embedding vectors) through provided keys from the store.
+   *        Every key must exist, or a run-time error will be thrown out.
+   * @param keys Vector stroing the keyset, their corresponding embedding vectors will be loaded.
+   * @param slots Vector to store the loaded slot_id. It will be ignored when using
+   *              DistributedEmbedding.
+   * @param vecs Vector to store the loaded embedding vectors.
+   */
+  void load_exist_vec_by_key(const std::vector<TypeKey> &keys, std::vector<size_t> &slots,
+                             std::vector<float> &vecs);
+
+  /**
+   * @brief Write the embedding vectors of a pass, of the existing keys and of the new ones,
+   *        as one atomic update: once this returns, the whole pass survives a crash. Of the keys
+   *        written more than once the last vector is kept.
+   * @param keys Vector storing the keyset, their corresponding embedding vectors (and slot_ids
+   *             if localized embedding is used) will be written.
+   * @param slots Array storing the slot_id of the keys. It will be ignored when using
+   *              DistributedEmbedding.
+   * @param vec_indices The memory indices of vectors in vecs. These indices are corresponding to
+   *                    embedding vectors mapping by keys.
+   * @param vecs Array storing the embedding vectors to be written.
+   */
+  void commit(const std::vector<TypeKey> &keys, const size_t *slots,
+              const std::vector<size_t> &vec_indices, const float *vecs);
+
+  /**
+   * @brief Write the memtable to a segment, and start a new WAL.
+   */
+  void flush();
+
+  /**
+   * @brief Merge all the segments into one, and wait for it.
+   */
+  void compact();
+
+  /**
+   * @brief Load the embedding table (<key, emb_vector> for distributed embedding and
+   *        <key, slot_id, emb_vec> for localized embedding) from the store to the host memory,
+   *        in key order.
+   * @param mem_key_index_map The constructed key<-->slot_id<-->mem_idx mapping of the host
+   *                          memory based embedding table.
+   * @param vecs Vector to store the loaded embedding vectors corresponding to mem_key_index_map.
+   */
+  void load_emb_tbl_to_mem(KeyIndexType &mem_key_index_map, std::vector<float> &vecs);
+};
+
+}  // namespace HugeCTR
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <data_generator.hpp>
+#include <data_readers/norm_v2.hpp>
+#include <data_readers/raw_compressed.hpp>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace HugeCTR {
+
+namespace parallel_data_generator_internal {
+
+constexpr size_t kWriteBufferSize = 16 << 20;  // bytes buffered by the stream of a Norm file
+constexpr long long kRecordsPerBatch = 4096;   // Norm records sampled together
+constexpr long long kBlocksPerSegment = 64;    // Raw blocks generated by a task
+
+/**
+ * Run task(i) for every i of [0, num_tasks) on num_threads threads, which claim the tasks in
+ * order. The first exception of a task stops the claiming and is rethrown.
+ */
+template <typename Task>
+void parallel_for(long long num_tasks, int num_threads, Task task) {
+  std::atomic<long long> next{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto run = [&]() {
+    for (long long i; (i = next++) < num_tasks;) {
+      try {
+        task(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        next = num_tasks;
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < std::max(1, num_threads); i++) {
+    threads.emplace_back(run);
+  }
+  run();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+inline void make_parent_dir(const std::string& file_name) {
+  const size_t last_slash_idx = file_name.rfind('/');
+  if (std::string::npos != last_slash_idx) {
+    check_make_dir(file_name.substr(0, last_slash_idx));
+  }
+}
+
+template <typename T, Check_t CK_T>
+void generate_norm_file(const std::string& file_name, uint64_t seed, long long file_id,
+                        int num_records, int slot_num, const std::vector<size_t>& voc_size_array,
+                        int label_dim, int dense_dim, const std::vector<int>& nnz_array,
+                        bool long_tail, float alpha) {
+  // the records go to the file in large writes
+  std::vector<char> write_buffer(kWriteBufferSize);
+  std::ofstream out_stream;
+  out_stream.rdbuf()->pubsetbuf(write_buffer.data(), write_buffer.size());
+  out_stream.open(file_name, std::ofstream::binary);
+  if (!out_stream.is_open()) {
+    CK_THROW_(Error_t::FileCannotOpen, "open failed: " + file_name);
+  }
+  DataWriter<CK_T> data_writer(out_stream);
+  DataSetHeader header = {
+      Checker_Traits<CK_T>::ID(), num_records, label_dim, dense_dim, slot_num, 0, 0, 0};
+  data_writer.append(reinterpret_cast<char*>(&header), sizeof(DataSetHeader));
+  data_writer.write();
+
+  // a stream for the label and dense, and one per slot
+  const uint64_t first_stream = file_id * (slot_num + 1);
+  FloatUniformDataSimulator<float> fdata_sim(0, 1, get_stream_seed(seed, first_stream));
+  std::vector<std::unique_ptr<IDataSimulator<T>>> ldata_sim_vec;
+  size_t accum = 0;
+  for (int k = 0; k < slot_num; k++) {
+    const size_t accum_next = accum + voc_size_array[k];
+    const auto slot_seed = get_stream_seed(seed, first_stream + 1 + k);
+    if (long_tail) {
+      ldata_sim_vec.emplace_back(
+          new IntPowerLawDataSimulator<T>(accum, accum_next - 1, alpha, slot_seed));
+    } else {
+      ldata_sim_vec.emplace_back(new IntUniformDataSimulator<T>(accum, accum_next - 1, slot_seed));
+    }
+    accum = accum_next;
+  }
+
+  const int label_dense_dim = label_dim + dense_dim;
+  std::vector<float> label_dense;
+  std::vector<std::vector<T>> keys(slot_num);
+  std::vector<char> record;
+  for (long long first = 0; first < num_records; first += kRecordsPerBatch) {
+    const long long n = std::min(kRecordsPerBatch, num_records - first);
+    label_dense.resize(n * label_dense_dim);
+    fdata_sim.get_nums(label_dense.data(), label_dense.size());
+    for (int k = 0; k < slot_num; k++) {
+      keys[k].resize(n * nnz_array[k]);
+      ldata_sim_vec[k]->get_nums(keys[k].data(), keys[k].size());
+    }
+    for (long long i = 0; i < n; i++) {
+      record.clear();
+      const char* label_dense_ptr =
+          reinterpret_cast<const char*>(label_dense.data() + i * label_dense_dim);
+      record.insert(record.end(), label_dense_ptr,
+                    label_dense_ptr + label_dense_dim * sizeof(float));
+      for (int k = 0; k < slot_num; k++) {
+        const int nnz = nnz_array[k];
+        const char* nnz_ptr = reinterpret_cast<const char*>(&nnz);
+        record.insert(record.end(), nnz_ptr, nnz_ptr + sizeof(int));
+        const char* key_ptr = reinterpret_cast<const char*>(keys[k].data() + i * nnz);
+        record.insert(record.end(), key_ptr, key_ptr + nnz * sizeof(T));
+      }
+      data_writer.append(record.data(), record.size());
+      data_writer.write();
+    }
+  }
+  out_stream.close();
+  if (!out_stream.good()) {
+    CK_THROW_(Error_t::BrokenFile, "failed to write " + file_name);
+  }
+}
+
+}  // namespace parallel_data_generator_internal
+
+/**
+ * Generate a Norm data set like data_generation_for_test2, with the files generated in parallel.
+ * Every file draws from its own random streams, derived from seed, so the data set only depends
+ * on seed and not on num_threads. With a compression, the files are written in the compressed
+ * block-structured layout of norm_v2.hpp.
+ */
+template <typename T, Check_t CK_T>
+void parallel_data_generation_for_norm(std::string file_list_name, std::string data_prefix,
+                                       int num_files, int num_records_per_file, int slot_num,
+                                       std::vector<size_t> voc_size_array, int label_dim,
+                                       int dense_dim, std::vector<int> nnz_array, bool long_tail,
+                                       float alpha, uint64_t seed, int num_threads,
+                                       Compression_t compression = Compression_t::None,
+                                       long long records_per_block = 4096) {
+  using namespace parallel_data_generator_internal;
+  if (slot_num != (int)voc_size_array.size() || slot_num != (int)nnz_array.size()) {
+    CK_THROW_(Error_t::WrongInput,
+              "slot_num != voc_size_array.size() || slot_num != nnz_array.size()");
+  }
+  if (file_exist(file_list_name)) {
+    std::cout << "File (" + file_list_name +
+                     ") exist. To generate new dataset plesae remove this file."
+              << std::endl;
+    return;
+  }
+  make_parent_dir(data_prefix);
+
+  parallel_for(num_files, num_threads, [&](long long k) {
+    const std::string file_name(data_prefix + std::to_string(k) + ".data");
+    if (compression == Compression_t::None) {
+      generate_norm_file<T, CK_T>(file_name, seed, k, num_records_per_file, slot_num,
+                                  voc_size_array, label_dim, dense_dim, nnz_array, long_tail,
+                                  alpha);
+      return;
+    }
+    const std::string tmp_name = file_name + ".tmp";
+    generate_norm_file<T, CK_T>(tmp_name, seed, k, num_records_per_file, slot_num, voc_size_array,
+                                label_dim, dense_dim, nnz_array, long_tail, alpha);
+    convert_norm_to_v2<T>(tmp_name, file_name, CK_T, records_per_block, true, compression);
+    std::remove(tmp_name.c_str());
+  });
+
+  std::ofstream file_list_stream(file_list_name, std::ofstream::out);
+  file_list_stream << (std::to_string(num_files) + "\n");
+  for (int k = 0; k < num_files; k++) {
+    file_list_stream << (data_prefix + std::to_string(k) + ".data\n");
+  }
+  file_list_stream.close();
+  std::cout << file_list_name << " done!" << std::endl;
+}
+
+/**
+ * Generate a Raw data set like data_generation_for_raw, with the samples generated in parallel.
+ * The samples are generated in segments of whole blocks, each with its own random streams derived
+ * from seed, and written in order, so the file only depends on seed and samples_per_block.
+ * With a compression, the blocks are compressed by the generating threads and the file is written
+ * in the layout of raw_compressed.hpp.
+ * @param samples_per_block samples of a block, 0 for 64 KiB of samples
+ */
+template <typename T = unsigned int>
+void parallel_data_generation_for_raw(std::string file_name, long long num_samples, int label_dim,
+                                      int dense_dim, bool float_label_dense,
+                                      std::vector<size_t> slot_size, std::vector<int> nnz_array,
+                                      bool long_tail, float alpha, uint64_t seed, int num_threads,
+                                      Compression_t compression = Compression_t::None,
+                                      long long samples_per_block = 0) {
+  static_assert(std::is_same<T, long long>::value || std::is_same<T, unsigned int>::value,
+                "type not support");
+  using namespace parallel_data_generator_internal;
+  if (nnz_array.empty()) {
+    nnz_array.assign(slot_size.size(), 1);
+  }
+  if (slot_size.size() != nnz_array.size()) {
+    CK_THROW_(Error_t::WrongInput, "slot_size.size() != nnz_array.size()");
+  }
+  const size_t size_label_dense = float_label_dense ? sizeof(float) : sizeof(T);
+  long long stride = (label_dim + dense_dim) * size_label_dense;
+  for (int nnz : nnz_array) {
+    stride += nnz * sizeof(T);
+  }
+  if (samples_per_block <= 0) {
+    samples_per_block = std::max(1LL, 65536 / stride);
+  }
+  const long long segment_samples = samples_per_block * kBlocksPerSegment;
+  const long long num_segments = (num_samples + segment_samples - 1) / segment_samples;
+  make_parent_dir(file_name);
+
+  std::unique_ptr<RawCompressedWriter> writer;
+  std::ofstream out_stream;
+  if (compression != Compression_t::None) {
+    writer.reset(new RawCompressedWriter(file_name, stride, samples_per_block, compression));
+  } else {
+    out_stream.open(file_name, std::ofstream::binary);
+    if (!out_stream.is_open()) {
+      CK_THROW_(Error_t::FileCannotOpen, "open failed: " + file_name);
+    }
+  }
+
+  // the segments are written in order, a thread waits for the turn of its segment
+  std::mutex write_mutex;
+  std::condition_variable write_cv;
+  long long next_segment = 0;
+  bool failed = false;
+  parallel_for(num_segments, num_threads, [&](long long segment) {
+    try {
+      const long long first = segment * segment_samples;
+      const long long n = std::min(segment_samples, num_samples - first);
+      std::vector<char> samples(n * stride);
+      char* sample = samples.data();
+      for (long long i = first; i < first + n; i++) {
+        for (int j = 0; j < label_dim + dense_dim; j++) {
+          // the label alternates and the dense features are their index
+          T label_dense_int = j < label_dim ? i % 2 : j - label_dim;
+          float label_dense_float = static_cast<float>(label_dense_int);
+          memcpy(sample, float_label_dense ? reinterpret_cast<char*>(&label_dense_float)
+                                           : reinterpret_cast<char*>(&label_dense_int),
+                 size_label_dense);
+          sample += size_label_dense;
+        }
+        sample += stride - (label_dim + dense_dim) * size_label_dense;
+      }
+      long long key_offset = (label_dim + dense_dim) * size_label_dense;
+      std::vector<long long> keys;
+      for (size_t j = 0; j < slot_size.size(); j++) {
+        const auto slot_seed = get_stream_seed(seed, segment * slot_size.size() + j);
+        std::unique_ptr<IDataSimulator<long long>> ldata_sim;
+        if (long_tail) {
+          ldata_sim.reset(
+              new IntPowerLawDataSimulator<long long>(0, slot_size[j] - 1, alpha, slot_seed));
+        } else {
+          ldata_sim.reset(new IntUniformDataSimulator<long long>(0, slot_size[j] - 1, slot_seed));
+        }
+        const int nnz = nnz_array[j];
+        keys.resize(n * nnz);
+        ldata_sim->get_nums(keys.data(), keys.size());
+        for (long long i = 0; i < n; i++) {
+          for (int k = 0; k < nnz; k++) {
+            const long long num_tmp = keys[i * nnz + k];
+            T sparse = num_tmp > static_cast<long long>(std::numeric_limits<T>::max())
+                           ? std::numeric_limits<T>::max()
+                           : num_tmp;
+            memcpy(samples.data() + i * stride + key_offset + k * sizeof(T), &sparse, sizeof(T));
+          }
+        }
+        key_offset += nnz * sizeof(T);
+      }
+
+      std::vector<char> compressed;
+      std::vector<size_t> block_ends;
+      if (writer) {
+        for (long long i = 0; i < n; i += samples_per_block) {
+          const long long block_samples = std::min(samples_per_block, n - i);
+          compress_block(compression, samples.data() + i * stride, block_samples * stride,
+                         &compressed);
+          block_ends.push_back(compressed.size());
+        }
+      }
+
+      std::unique_lock<std::mutex> lock(write_mutex);
+      write_cv.wait(lock, [&]() { return next_segment == segment || failed; });
+      if (failed) {
+        return;
+      }
+      if (writer) {
+        size_t begin = 0;
+        for (long long b = 0; b < static_cast<long long>(block_ends.size()); b++) {
+          const long long block_samples = std::min(samples_per_block, n - b * samples_per_block);
+          writer->append_compressed_block(compressed.data() + begin, block_ends[b] - begin,
+                                          block_samples);
+          begin = block_ends[b];
+        }
+      } else {
+        out_stream.write(samples.data(), samples.size());
+      }
+      next_segment++;
+      write_cv.notify_all();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(write_mutex);
+      failed = true;
+      write_cv.notify_all();
+      throw;
+    }
+  });
+
+  if (writer) {
+    writer->close();
+  } else {
+    out_stream.close();
+    if (!out_stream.good()) {
+      CK_THROW_(Error_t::BrokenFile, "failed to write " + file_name);
+    }
+  }
+}
+
+}  // namespace HugeCTR
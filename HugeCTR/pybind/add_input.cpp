@@ -118,15 +118,23 @@ void add_input(Input& input, DataReaderParams& reader_params,
   switch (format) {
     case DataReaderType_t::Norm: {
       bool start_right_now = repeat_dataset;
-      train_data_reader->create_drwg_norm(source_data, check_type, start_right_now);
+      ShuffleBufferParam shuffle_buffer;
+      shuffle_buffer.memory_bytes = reader_params.shuffle_buffer_mb << 20;
+      shuffle_buffer.num_open_files = reader_params.shuffle_open_files;
+      shuffle_buffer.seed = reader_params.shuffle_seed;
+      train_data_reader->create_drwg_norm(source_data, check_type, start_right_now,
+                                          reader_params.shuffle_blocks, shuffle_buffer);
       evaluate_data_reader->create_drwg_norm(eval_source, check_type, start_right_now);
       break;
     }
     case DataReaderType_t::Raw: {
       train_data_reader->create_drwg_raw(source_data, num_samples, float_label_dense,
-                                         true, false);
+                                         true, false, reader_params.shuffle_seed,
+                                         reader_params.use_huge_pages);
       evaluate_data_reader->create_drwg_raw(eval_source, eval_num_samples,
-                                            float_label_dense, false, false);
+                                            float_label_dense, false, false,
+                                            reader_params.shuffle_seed,
+                                            reader_params.use_huge_pages);
       break;
     }
     case DataReaderType_t::Parquet: {
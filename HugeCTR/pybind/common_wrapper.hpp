@@ -48,6 +48,7 @@ void CommonPybind(pybind11::module& m) {
   pybind11::enum_<HugeCTR::Check_t>(m, "Check_t")
       .value("Sum", HugeCTR::Check_t::Sum)
       .value("Non", HugeCTR::Check_t::None)
+      .value("CRC32C", HugeCTR::Check_t::CRC32C)
       .export_values();
   pybind11::enum_<HugeCTR::DataReaderSparse_t>(m, "DataReaderSparse_t")
       .value("Distributed", HugeCTR::DataReaderSparse_t::Distributed)
@@ -269,11 +269,18 @@ std::shared_ptr<InferenceSessionPy> CreateInferenceSession(const std::string& mo
 void InferencePybind(pybind11::module &m) {
   pybind11::module infer = m.def_submodule("inference", "inference submodule of hugectr");
 
+  pybind11::enum_<HugeCTR::CacheEvictionPolicy_t>(infer, "CacheEvictionPolicy_t")
+      .value("LRU", HugeCTR::CacheEvictionPolicy_t::LRU)
+      .value("LFU", HugeCTR::CacheEvictionPolicy_t::LFU)
+      .export_values();
+
   pybind11::class_<HugeCTR::InferenceParams, std::shared_ptr<HugeCTR::InferenceParams>>(infer, "InferenceParams")
     .def(pybind11::init<const std::string&, const size_t, const float,
                   const std::string&, const std::vector<std::string>&,
                   const int, const bool, const float, const bool,
-                  const bool, const float, const bool, const bool>(),
+                  const bool, const float, const bool, const bool, const bool,
+                  const bool, const float, const size_t, const CacheEvictionPolicy_t,
+                  const size_t, const bool, const size_t, const size_t, const std::string&>(),
       pybind11::arg("model_name"),
       pybind11::arg("max_batchsize"),
       pybind11::arg("hit_rate_threshold"),
@@ -286,7 +293,17 @@ void InferencePybind(pybind11::module &m) {
       pybind11::arg("use_mixed_precision") = false,
       pybind11::arg("scaler") = 1.0,
       pybind11::arg("use_algorithm_search") = true,
-      pybind11::arg("use_cuda_graph") = true);
+      pybind11::arg("use_cuda_graph") = true,
+      pybind11::arg("use_mmap_sparse_model") = false,
+      pybind11::arg("use_host_embedding_cache") = false,
+      pybind11::arg("host_cache_size_percentage") = 0.1,
+      pybind11::arg("host_cache_set_associativity") = 8,
+      pybind11::arg("host_cache_eviction_policy") = HugeCTR::CacheEvictionPolicy_t::LRU,
+      pybind11::arg("host_cache_lfu_aging_queries_per_way") = 8,
+      pybind11::arg("use_bf16_packed_weights") = false,
+      pybind11::arg("num_cpu_workspaces") = 0,
+      pybind11::arg("num_look_up_threads") = 0,
+      pybind11::arg("sparse_model_index_cache_dir") = "");
 
   infer.def("CreateInferenceSession", &HugeCTR::python_lib::CreateInferenceSession,
     pybind11::arg("model_config_path"),
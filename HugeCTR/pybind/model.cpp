@@ -93,10 +93,13 @@ static void check_device(int device_id, int min_major, int min_minor) {
 ModelOversubscriberParams::ModelOversubscriberParams(
     bool _train_from_scratch, bool _use_host_memory_ps,
     std::vector<std::string>& _trained_sparse_models,
-    std::vector<std::string>& _dest_sparse_models)
+    std::vector<std::string>& _dest_sparse_models, bool _use_log_structured_store,
+    bool _use_async_prefetch)
   : use_model_oversubscriber(true), use_host_memory_ps(_use_host_memory_ps),
     train_from_scratch(_train_from_scratch),
-    trained_sparse_models(_trained_sparse_models), dest_sparse_models(_dest_sparse_models) {}
+    trained_sparse_models(_trained_sparse_models), dest_sparse_models(_dest_sparse_models),
+    use_log_structured_store(_use_log_structured_store),
+    use_async_prefetch(_use_async_prefetch) {}
 
 ModelOversubscriberParams::ModelOversubscriberParams() : use_model_oversubscriber(false) {}
 
@@ -105,7 +108,10 @@ DataReaderParams::DataReaderParams(DataReaderType_t data_reader_type,
                                    std::string eval_source, Check_t check_type, int cache_eval_data,
                                    long long num_samples, long long eval_num_samples,
                                    bool float_label_dense, int num_workers,
-                                   std::vector<long long int> slot_size_array)
+                                   std::vector<long long int> slot_size_array,
+                                   size_t shuffle_buffer_mb, int shuffle_open_files,
+                                   unsigned long long shuffle_seed, bool shuffle_blocks,
+                                   bool use_huge_pages)
                                    
     : data_reader_type(data_reader_type),
       source(source),
@@ -117,7 +123,12 @@ DataReaderParams::DataReaderParams(DataReaderType_t data_reader_type,
       eval_num_samples(eval_num_samples),
       float_label_dense(float_label_dense),
       num_workers(num_workers),
-      slot_size_array(slot_size_array) {}
+      slot_size_array(slot_size_array),
+      shuffle_buffer_mb(shuffle_buffer_mb),
+      shuffle_open_files(shuffle_open_files),
+      shuffle_seed(shuffle_seed),
+      shuffle_blocks(shuffle_blocks),
+      use_huge_pages(use_huge_pages) {}
 
 Input::Input(int label_dim, std::string label_name, int dense_dim, std::string dense_name,
              std::vector<DataReaderSparseParam>& data_reader_sparse_param_array)
@@ -492,10 +503,13 @@ void Model::compile() {
   init_params_for_dense_();
   init_params_for_sparse_();
   if (mos_params_->use_model_oversubscriber && mos_params_->train_from_scratch) {
-    init_model_oversubscriber_(mos_params_->use_host_memory_ps, mos_params_->dest_sparse_models);
+    init_model_oversubscriber_(mos_params_->use_host_memory_ps, mos_params_->dest_sparse_models,
+                               mos_params_->use_log_structured_store);
   }
   if (mos_params_->use_model_oversubscriber && !mos_params_->train_from_scratch) {
-    init_model_oversubscriber_(mos_params_->use_host_memory_ps, mos_params_->trained_sparse_models);
+    init_model_oversubscriber_(mos_params_->use_host_memory_ps,
+                               mos_params_->trained_sparse_models,
+                               mos_params_->use_log_structured_store);
   }
   int num_total_gpus = resource_manager_->get_global_gpu_count();
   for (const auto& metric : solver_.metrics_spec) {
@@ -749,6 +763,13 @@ void Model::fit(int num_epochs, int max_iter, int display, int eval_interval, in
         data_reader_train->set_source(reader_params_.source[f]);
         data_reader_train_status_ = true;
         model_oversubscriber->update(reader_params_.keyset[f]);
+        if (mos_params_->use_async_prefetch) {
+          // the keyset of the next source is pulled while this one is trained
+          size_t next_f = (f + 1) % reader_params_.source.size();
+          if (next_f != 0 || e + 1 < mos_epochs) {
+            model_oversubscriber->prefetch(reader_params_.keyset[next_f]);
+          }
+        }
         do {
           float lr = lr_sch_->get_next();
           this->set_learning_rate(lr);
@@ -1167,7 +1188,8 @@ Error_t Model::download_sparse_params_to_files_(const std::vector<std::string>&
 
 template <typename TypeEmbeddingComp>
 std::shared_ptr<ModelOversubscriber> Model::create_model_oversubscriber_(
-    bool use_host_memory_ps, const std::vector<std::string>& sparse_embedding_files) {
+    bool use_host_memory_ps, const std::vector<std::string>& sparse_embedding_files,
+    bool use_log_structured_store) {
   try {
     if (sparse_embedding_files.empty()) {
       CK_THROW_(Error_t::WrongInput,
@@ -1176,7 +1198,8 @@ std::shared_ptr<ModelOversubscriber> Model::create_model_oversubscriber_(
     }
     return std::shared_ptr<ModelOversubscriber>(
         new ModelOversubscriber(use_host_memory_ps, embeddings_, sparse_embedding_files,
-            resource_manager_, solver_.use_mixed_precision, solver_.i64_input_key));
+            resource_manager_, solver_.use_mixed_precision, solver_.i64_input_key,
+            use_log_structured_store));
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
     throw rt_err;
@@ -1293,13 +1316,13 @@ void Model::init_params_for_sparse_() {
 }
 
 void Model::init_model_oversubscriber_(bool use_host_memory_ps,
-    const std::vector<std::string>& sparse_embedding_files) {
+    const std::vector<std::string>& sparse_embedding_files, bool use_log_structured_store) {
   if (solver_.use_mixed_precision) {
     model_oversubscriber_ = create_model_oversubscriber_<__half>(
-        use_host_memory_ps, sparse_embedding_files);
+        use_host_memory_ps, sparse_embedding_files, use_log_structured_store);
   } else {
     model_oversubscriber_ = create_model_oversubscriber_<float>(
-        use_host_memory_ps, sparse_embedding_files);
+        use_host_memory_ps, sparse_embedding_files, use_log_structured_store);
   }
   mos_created_ = true;
 }
@@ -107,6 +107,11 @@ struct DataReaderParams {
   bool float_label_dense;
   int num_workers;
   std::vector<long long int> slot_size_array;
+  size_t shuffle_buffer_mb;
+  int shuffle_open_files;
+  unsigned long long shuffle_seed;
+  bool shuffle_blocks;
+  bool use_huge_pages;
   DataReaderParams(DataReaderType_t data_reader_type,
        std::vector<std::string> source,
        std::vector<std::string> keyset,
@@ -117,7 +122,12 @@ struct DataReaderParams {
        long long eval_num_samples,
        bool float_label_dense,
        int num_workers,
-       std::vector<long long int> slot_size_array = std::vector<long long int>());
+       std::vector<long long int> slot_size_array = std::vector<long long int>(),
+       size_t shuffle_buffer_mb = 0,
+       int shuffle_open_files = 4,
+       unsigned long long shuffle_seed = 0,
+       bool shuffle_blocks = false,
+       bool use_huge_pages = false);
 };
 
 struct Input {
@@ -160,9 +170,13 @@ struct ModelOversubscriberParams {
   bool train_from_scratch;
   std::vector<std::string> trained_sparse_models;
   std::vector<std::string> dest_sparse_models;
+  bool use_log_structured_store;
+  bool use_async_prefetch;
   ModelOversubscriberParams(bool train_from_scratch, bool use_host_memory_ps,
                            std::vector<std::string>& trained_sparse_models,
-                           std::vector<std::string>& dest_sparse_models);
+                           std::vector<std::string>& dest_sparse_models,
+                           bool use_log_structured_store = false,
+                           bool use_async_prefetch = false);
   ModelOversubscriberParams();
 };
 
@@ -440,11 +454,13 @@ class Model {
   
   template <typename TypeEmbeddingComp>
   std::shared_ptr<ModelOversubscriber> create_model_oversubscriber_(
-      bool use_host_memory_ps, const std::vector<std::string>& sparse_embedding_files);
+      bool use_host_memory_ps, const std::vector<std::string>& sparse_embedding_files,
+      bool use_log_structured_store);
   void init_params_for_dense_();
   void init_params_for_sparse_();
   void init_model_oversubscriber_(
-      bool use_host_memory_ps, const std::vector<std::string>& sparse_embedding_files);
+      bool use_host_memory_ps, const std::vector<std::string>& sparse_embedding_files,
+      bool use_log_structured_store);
   Error_t load_params_for_dense_(const std::string& model_file);
   Error_t load_params_for_sparse_(const std::vector<std::string>& embedding_file);
   Error_t load_opt_states_for_dense_(const std::string& dense_opt_states_file);
@@ -28,7 +28,8 @@ namespace python_lib {
 std::shared_ptr<ModelOversubscriberParams> CreateMOS(
     bool train_from_scratch, bool use_host_memory_ps,
     std::vector<std::string>& trained_sparse_models,
-    std::vector<std::string>& dest_sparse_models) {
+    std::vector<std::string>& dest_sparse_models, bool use_log_structured_store,
+    bool use_async_prefetch) {
   std::shared_ptr<ModelOversubscriberParams> mos_params;
   if (train_from_scratch) {
     if (dest_sparse_models.empty()) {
@@ -40,7 +41,7 @@ std::shared_ptr<ModelOversubscriberParams> CreateMOS(
         if (fs::exists(sparse_model) && fs::is_directory(sparse_model) &&
             !fs::is_empty(sparse_model)) {
           std::string file_name(sparse_model + "/key");
-          if(fs::file_size(file_name) != 0) {
+          if(!fs::exists(file_name) || fs::file_size(file_name) != 0) {
             CK_THROW_(Error_t::WrongInput,
                 sparse_model + " exist and not empty, please use another name");
           } else {
@@ -61,7 +62,8 @@ std::shared_ptr<ModelOversubscriberParams> CreateMOS(
     });
   }
   mos_params.reset(new ModelOversubscriberParams(train_from_scratch,
-      use_host_memory_ps, trained_sparse_models, dest_sparse_models));
+      use_host_memory_ps, trained_sparse_models, dest_sparse_models, use_log_structured_store,
+      use_async_prefetch));
   return mos_params;
 }
 
@@ -70,7 +72,9 @@ void ModelOversubscriberPybind(pybind11::module &m) {
     pybind11::arg("train_from_scratch"),
     pybind11::arg("use_host_memory_ps") = true,
     pybind11::arg("trained_sparse_models") = std::vector<std::string>(),
-    pybind11::arg("dest_sparse_models") = std::vector<std::string>());
+    pybind11::arg("dest_sparse_models") = std::vector<std::string>(),
+    pybind11::arg("use_log_structured_store") = false,
+    pybind11::arg("use_async_prefetch") = false);
   pybind11::class_<HugeCTR::ModelOversubscriberParams,
       std::shared_ptr<HugeCTR::ModelOversubscriberParams>>(
           m, "ModelOversubscriberParams");
@@ -83,6 +87,14 @@ void ModelOversubscriberPybind(pybind11::module &m) {
    .def("update",
         pybind11::overload_cast<std::vector<std::string>&>(
             &HugeCTR::ModelOversubscriber::update),
+        pybind11::arg("keyset_file_list"))
+   .def("prefetch",
+        pybind11::overload_cast<std::string&>(
+            &HugeCTR::ModelOversubscriber::prefetch),
+        pybind11::arg("keyset_file"))
+   .def("prefetch",
+        pybind11::overload_cast<std::vector<std::string>&>(
+            &HugeCTR::ModelOversubscriber::prefetch),
         pybind11::arg("keyset_file_list"));
 }
 
@@ -27,13 +27,17 @@ void ModelPybind(pybind11::module &m) {
   pybind11::class_<HugeCTR::DataReaderParams, std::shared_ptr<HugeCTR::DataReaderParams>>(
       m, "DataReaderParams")
       .def(pybind11::init<DataReaderType_t, std::vector<std::string>, std::vector<std::string>,
-                          std::string, Check_t, int, long long, long long, bool, int,std::vector<long long int>>(),
+                          std::string, Check_t, int, long long, long long, bool, int,std::vector<long long int>,
+                          size_t, int, unsigned long long, bool, bool>(),
            pybind11::arg("data_reader_type"), pybind11::arg("source"),
            pybind11::arg("keyset") = std::vector<std::string>(), pybind11::arg("eval_source"),
            pybind11::arg("check_type"), pybind11::arg("cache_eval_data") = 0,
            pybind11::arg("num_samples") = 0, pybind11::arg("eval_num_samples") = 0,
            pybind11::arg("float_label_dense") = false, pybind11::arg("num_workers") = 12,
-           pybind11::arg("slot_size_array") = std::vector<size_t>());
+           pybind11::arg("slot_size_array") = std::vector<size_t>(),
+           pybind11::arg("shuffle_buffer_mb") = 0, pybind11::arg("shuffle_open_files") = 4,
+           pybind11::arg("shuffle_seed") = 0, pybind11::arg("shuffle_blocks") = false,
+           pybind11::arg("use_huge_pages") = false);
   pybind11::class_<HugeCTR::Input, std::shared_ptr<HugeCTR::Input>>(m, "Input")
       .def(pybind11::init<int, std::string, int, std::string,
                           std::vector<DataReaderSparseParam> &>(),
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cpu/batching_scheduler_cpu.hpp>
+#include <cstring>
+
+namespace HugeCTR {
+
+std::string BatchingStatsCPU::to_string() const {
+  std::string str = "requests: " + std::to_string(num_requests) +
+                    ", batches: " + std::to_string(num_batches) + "\nqueue wait (us):";
+  const size_t num_wait_buckets = queue_wait_us_histogram.size();
+  for (size_t i = 0; i < num_wait_buckets; i++) {
+    if (queue_wait_us_histogram[i] == 0) {
+      continue;
+    }
+    const std::string bound = i + 1 == num_wait_buckets ? ">=" + std::to_string(1ul << (i - 1))
+                                                        : "<" + std::to_string(1ul << i);
+    str += " " + bound + ": " + std::to_string(queue_wait_us_histogram[i]);
+  }
+  str += "\nbatch fill (%):";
+  const size_t num_fill_buckets = batch_fill_histogram.size();
+  for (size_t i = 0; i < num_fill_buckets; i++) {
+    if (batch_fill_histogram[i] == 0) {
+      continue;
+    }
+    str += " " + std::to_string(i * 100 / (num_fill_buckets - 1)) + ": " +
+           std::to_string(batch_fill_histogram[i]);
+  }
+  return str;
+}
+
+template <typename TypeHashKey>
+BatchingSchedulerCPU<TypeHashKey>::BatchingSchedulerCPU(InferenceSessionCPU<TypeHashKey>& session,
+                                                        size_t max_queue_delay_us,
+                                                        size_t num_workers)
+    : session_(session),
+      max_batchsize_(session.get_inference_params().max_batchsize),
+      dense_dim_(session.get_inference_parser().dense_dim),
+      slot_num_(session.get_inference_parser().slot_num),
+      max_queue_delay_(max_queue_delay_us),
+      num_queued_samples_(0),
+      stopped_(false) {
+  if (num_workers == 0) {
+    CK_THROW_(Error_t::WrongInput, "num_workers must be > 0");
+  }
+  reset_stats();
+  for (size_t i = 0; i < num_workers; i++) {
+    workers_.emplace_back(&BatchingSchedulerCPU::worker_, this);
+  }
+}
+
+template <typename TypeHashKey>
+BatchingSchedulerCPU<TypeHashKey>::~BatchingSchedulerCPU() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  cv_.notify_all();
+  // the workers drain the queue before they exit
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+template <typename TypeHashKey>
+void BatchingSchedulerCPU<TypeHashKey>::predict(const float* h_dense,
+                                                const void* h_embeddingcolumns,
+                                                const int* h_row_ptrs, float* h_output,
+                                                int num_samples) {
+  if (num_samples <= 0 || static_cast<size_t>(num_samples) > max_batchsize_) {
+    CK_THROW_(Error_t::WrongInput, "num_samples must be in [1, max_batchsize]");
+  }
+  const size_t num_keys = h_row_ptrs[num_samples * slot_num_] - h_row_ptrs[0];
+  if (num_keys > num_samples * session_.get_inference_parser().max_feature_num_per_sample) {
+    CK_THROW_(Error_t::WrongInput, "Too many keys in the request");
+  }
+
+  Request request;
+  request.h_dense = h_dense;
+  request.h_embeddingcolumns = static_cast<const TypeHashKey*>(h_embeddingcolumns);
+  request.h_row_ptrs = h_row_ptrs;
+  request.h_output = h_output;
+  request.num_samples = num_samples;
+  std::future<void> done = request.done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    request.enqueue_time = Clock::now();
+    queue_.push_back(&request);
+    num_queued_samples_ += request.num_samples;
+  }
+  cv_.notify_all();
+  // rethrows what the batch of the request threw
+  done.get();
+}
+
+template <typename TypeHashKey>
+void BatchingSchedulerCPU<TypeHashKey>::worker_() {
+  Batch batch;
+  batch.h_dense.resize(max_batchsize_ * dense_dim_);
+  batch.h_embeddingcolumns.resize(max_batchsize_ *
+                                  session_.get_inference_parser().max_feature_num_per_sample);
+  batch.h_row_ptrs.resize(max_batchsize_ * slot_num_ + 1);
+  batch.h_output.resize(max_batchsize_);
+  std::vector<Request*> requests;
+
+  while (true) {
+    requests.clear();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // wait until the batch is full or the oldest request is out of budget
+      while (true) {
+        cv_.wait(lock, [this] { return stopped_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          return;
+        }
+        const Clock::time_point deadline = queue_.front()->enqueue_time + max_queue_delay_;
+        if (stopped_ || num_queued_samples_ >= max_batchsize_ || Clock::now() >= deadline) {
+          break;
+        }
+        cv_.wait_until(lock, deadline);
+      }
+      size_t num_samples = 0;
+      while (!queue_.empty() && num_samples + queue_.front()->num_samples <= max_batchsize_) {
+        num_samples += queue_.front()->num_samples;
+        requests.push_back(queue_.front());
+        queue_.pop_front();
+      }
+      num_queued_samples_ -= num_samples;
+    }
+    // the rest of the queue may already fill another batch
+    cv_.notify_all();
+    run_batch_(requests, batch);
+  }
+}
+
+template <typename TypeHashKey>
+void BatchingSchedulerCPU<TypeHashKey>::run_batch_(const std::vector<Request*>& requests,
+                                                   Batch& batch) {
+  const Clock::time_point start_time = Clock::now();
+
+  // merge the requests, the row_ptrs of each one are rebased onto its keys in the batch
+  size_t num_samples = 0;
+  size_t num_keys = 0;
+  batch.h_row_ptrs[0] = 0;
+  for (const Request* request : requests) {
+    const size_t num_rows = request->num_samples * slot_num_;
+    const int first_key = request->h_row_ptrs[0];
+    const size_t request_num_keys = request->h_row_ptrs[num_rows] - first_key;
+    memcpy(batch.h_dense.data() + num_samples * dense_dim_, request->h_dense,
+           request->num_samples * dense_dim_ * sizeof(float));
+    memcpy(batch.h_embeddingcolumns.data() + num_keys, request->h_embeddingcolumns + first_key,
+           request_num_keys * sizeof(TypeHashKey));
+    int* h_row_ptrs = batch.h_row_ptrs.data() + num_samples * slot_num_;
+    for (size_t i = 1; i <= num_rows; i++) {
+      h_row_ptrs[i] = request->h_row_ptrs[i] - first_key + static_cast<int>(num_keys);
+    }
+    num_samples += request->num_samples;
+    num_keys += request_num_keys;
+  }
+
+  try {
+    session_.predict(batch.h_dense.data(), batch.h_embeddingcolumns.data(),
+                     batch.h_row_ptrs.data(), batch.h_output.data(), num_samples);
+  } catch (...) {
+    for (Request* request : requests) {
+      request->done.set_exception(std::current_exception());
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.num_requests += requests.size();
+    stats_.num_batches++;
+    for (const Request* request : requests) {
+      const size_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 start_time - request->enqueue_time)
+                                 .count();
+      size_t bucket = 0;
+      while (bucket + 1 < kNumQueueWaitBuckets && (wait_us >> bucket) != 0) {
+        bucket++;
+      }
+      stats_.queue_wait_us_histogram[bucket]++;
+    }
+    stats_.batch_fill_histogram[num_samples * (kNumBatchFillBuckets - 1) / max_batchsize_]++;
+  }
+
+  // scatter the predictions, this wakes up the requests
+  size_t offset = 0;
+  for (Request* request : requests) {
+    memcpy(request->h_output, batch.h_output.data() + offset, request->num_samples * sizeof(float));
+    offset += request->num_samples;
+    request->done.set_value();
+  }
+}
+
+template <typename TypeHashKey>
+BatchingStatsCPU BatchingSchedulerCPU<TypeHashKey>::get_stats() {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return stats_;
+}
+
+template <typename TypeHashKey>
+void BatchingSchedulerCPU<TypeHashKey>::reset_stats() {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  stats_.num_requests = 0;
+  stats_.num_batches = 0;
+  stats_.queue_wait_us_histogram.assign(kNumQueueWaitBuckets, 0);
+  stats_.batch_fill_histogram.assign(kNumBatchFillBuckets, 0);
+}
+
+template class BatchingSchedulerCPU<unsigned int>;
+template class BatchingSchedulerCPU<long long>;
+
+}  // namespace HugeCTR
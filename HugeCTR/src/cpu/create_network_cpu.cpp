@@ -89,7 +89,7 @@ void create_layers(const nlohmann::json& j_array, std::vector<TensorEntry>& tens
                    const std::shared_ptr<BufferBlock2<__half>>& weight_buff_half,
                    const std::shared_ptr<BufferBlock2<float>>& wgrad_buff,
                    const std::shared_ptr<BufferBlock2<__half>>& wgrad_buff_half,
-                   bool use_mixed_precision,
+                   bool use_mixed_precision, bool use_bf16_packed_weights,
                    std::vector<std::unique_ptr<LayerCPU>>& layers) {
   for (unsigned int i = 1; i < j_array.size(); i++) {
     const nlohmann::json& j = j_array[i];
@@ -281,7 +281,8 @@ void create_layers(const nlohmann::json& j_array, std::vector<TensorEntry>& tens
 
           // establish layer
           layers.emplace_back(new FusedFullyConnectedLayerCPU(
-              weight_buff, weight_buff_half, wgrad_buff_half, blobs_buff, in_tensor, fc_out_tensor));
+              weight_buff, weight_buff_half, wgrad_buff_half, blobs_buff, in_tensor, fc_out_tensor,
+              use_bf16_packed_weights));
         } else {
           CK_THROW_(Error_t::WrongInput, "FusedInnerProduct support half only");
         }
@@ -338,7 +339,8 @@ void create_layers(const nlohmann::json& j_array, std::vector<TensorEntry>& tens
 
           // establish layer
           layers.emplace_back(new FullyConnectedLayerCPU<__half>(
-              weight_buff, weight_buff_half, wgrad_buff_half, blobs_buff, in_tensor, fc_out_tensor));
+              weight_buff, weight_buff_half, wgrad_buff_half, blobs_buff, in_tensor, fc_out_tensor,
+              use_bf16_packed_weights));
           output_tensor_entries.push_back(
               {input_output_info.output_names[0], fc_out_tensor.shrink()});
         } else {
@@ -691,7 +693,9 @@ void create_layers(const nlohmann::json& j_array, std::vector<TensorEntry>& tens
 NetworkCPU* NetworkCPU::create_network(const nlohmann::json& j_array,
                                  std::vector<TensorEntry>& tensor_entries,
                                  const std::shared_ptr<CPUResource>& cpu_resource,
-                                 bool use_mixed_precision) {
+                                 bool use_mixed_precision,
+                                 bool use_bf16_packed_weights,
+                                 const NetworkCPU* weight_source) {
   NetworkCPU* network = new NetworkCPU(cpu_resource, use_mixed_precision);
 
   auto& layers = network->layers_;
@@ -699,15 +703,18 @@ NetworkCPU* NetworkCPU::create_network(const nlohmann::json& j_array,
   std::shared_ptr<GeneralBuffer2<HostAllocator>> blobs_buff =
       GeneralBuffer2<HostAllocator>::create();
 
-  std::shared_ptr<BufferBlock2<float>> weight_buff = blobs_buff->create_block<float>();
-  std::shared_ptr<BufferBlock2<__half>> weight_buff_half = blobs_buff->create_block<__half>();
-  std::shared_ptr<BufferBlock2<float>> wgrad_buff = blobs_buff->create_block<float>();
-  std::shared_ptr<BufferBlock2<__half>> wgrad_buff_half = blobs_buff->create_block<__half>();
+  // the weights live apart from the blobs, so that networks of the same model can share them
+  std::shared_ptr<GeneralBuffer2<HostAllocator>> weight_buffer =
+      GeneralBuffer2<HostAllocator>::create();
+  std::shared_ptr<BufferBlock2<float>> weight_buff = weight_buffer->create_block<float>();
+  std::shared_ptr<BufferBlock2<__half>> weight_buff_half = weight_buffer->create_block<__half>();
+  std::shared_ptr<BufferBlock2<float>> wgrad_buff = weight_buffer->create_block<float>();
+  std::shared_ptr<BufferBlock2<__half>> wgrad_buff_half = weight_buffer->create_block<__half>();
 
   // create layers
   create_layers(j_array, tensor_entries, blobs_buff, weight_buff,
                 weight_buff_half, wgrad_buff, wgrad_buff_half,
-                use_mixed_precision, layers);
+                use_mixed_precision, use_bf16_packed_weights, layers);
 
   TensorEntry pred_tensor_entry = tensor_entries.back();
   network->pred_tensor_ = Tensor2<float>::stretch_from(pred_tensor_entry.bag);
@@ -716,6 +723,13 @@ NetworkCPU* NetworkCPU::create_network(const nlohmann::json& j_array,
   network->wgrad_tensor_ = wgrad_buff->as_tensor();
   network->wgrad_tensor_half_ = wgrad_buff_half->as_tensor();
   blobs_buff->allocate();
+  if (weight_source) {
+    weight_buffer->allocate_shared(weight_source->weight_buffer_);
+    network->weight_source_ = weight_source;
+  } else {
+    weight_buffer->allocate();
+  }
+  network->weight_buffer_ = weight_buffer;
 
   return network;
 }
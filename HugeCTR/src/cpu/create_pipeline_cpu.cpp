@@ -29,7 +29,8 @@ void create_pipeline_inference_cpu(const nlohmann::json& config,
                                   std::vector<size_t>& embedding_table_slot_size,
                                   std::vector<std::shared_ptr<LayerCPU>>* embeddings,
                                   NetworkCPU** network,
-                                  const std::shared_ptr<CPUResource>& cpu_resource) {
+                                  const std::shared_ptr<CPUResource>& cpu_resource,
+                                  const NetworkCPU* weight_source) {
   std::vector<TensorEntry> tensor_entries;
 
   auto j_layers_array = get_json(config, "layers");
@@ -53,7 +54,8 @@ void create_pipeline_inference_cpu(const nlohmann::json& config,
   input_buffer->allocate();
 
   *network = NetworkCPU::create_network(j_layers_array, tensor_entries, cpu_resource,
-                                      inference_params.use_mixed_precision);                  
+                                      inference_params.use_mixed_precision,
+                                      inference_params.use_bf16_packed_weights, weight_source);
 }
 
 
@@ -65,13 +67,16 @@ void create_pipeline_cpu(const nlohmann::json& config,
                       std::vector<std::shared_ptr<Tensor2<float>>>& embeddingvecs,
                       std::vector<size_t>& embedding_table_slot_size,
                       std::vector<std::shared_ptr<LayerCPU>>* embeddings, NetworkCPU** network,
-                      const std::shared_ptr<CPUResource>& cpu_resource) {
+                      const std::shared_ptr<CPUResource>& cpu_resource,
+                      const NetworkCPU* weight_source) {
   if (inference_params.use_mixed_precision) {
     create_pipeline_inference_cpu<__half>(config, tensor_active, inference_params, dense_input, rows, embeddingvecs,
-                                        embedding_table_slot_size, embeddings, network, cpu_resource);
+                                        embedding_table_slot_size, embeddings, network, cpu_resource,
+                                        weight_source);
   } else {
     create_pipeline_inference_cpu<float>(config, tensor_active, inference_params, dense_input, rows, embeddingvecs,
-                                        embedding_table_slot_size, embeddings, network, cpu_resource);
+                                        embedding_table_slot_size, embeddings, network, cpu_resource,
+                                        weight_source);
   }
 }
 
@@ -84,7 +89,8 @@ template void create_pipeline_inference_cpu<float>(const nlohmann::json& config,
                                   std::vector<size_t>& embedding_table_slot_size,
                                   std::vector<std::shared_ptr<LayerCPU>>* embeddings,
                                   NetworkCPU** network,
-                                  const std::shared_ptr<CPUResource>& cpu_resource);
+                                  const std::shared_ptr<CPUResource>& cpu_resource,
+                                  const NetworkCPU* weight_source);
 template void create_pipeline_inference_cpu<__half>(const nlohmann::json& config,
                                   std::map<std::string, bool> tensor_active,
                                   const InferenceParams& inference_params,
@@ -94,6 +100,7 @@ template void create_pipeline_inference_cpu<__half>(const nlohmann::json& config
                                   std::vector<size_t>& embedding_table_slot_size,
                                   std::vector<std::shared_ptr<LayerCPU>>* embeddings,
                                   NetworkCPU** network,
-                                  const std::shared_ptr<CPUResource>& cpu_resource);
+                                  const std::shared_ptr<CPUResource>& cpu_resource,
+                                  const NetworkCPU* weight_source);
 
 } // namespace HugeCTR
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cpu/embedding_cache_cpu.hpp>
+#include <cstring>
+#include <experimental/filesystem>
+#include <hashtable/hash_functions.hpp>
+#include <parser.hpp>
+
+namespace HugeCTR {
+
+namespace fs = std::experimental::filesystem;
+
+template <typename TypeHashKey>
+EmbeddingCacheCPU<TypeHashKey>::EmbeddingCacheCPU(
+    const std::string& model_config_path, const InferenceParams& inference_params,
+    const std::shared_ptr<HugectrUtility<TypeHashKey>>& parameter_server)
+    : model_name_(inference_params.model_name),
+      set_associativity_(inference_params.host_cache_set_associativity),
+      eviction_policy_(inference_params.host_cache_eviction_policy),
+      lfu_aging_queries_per_way_(inference_params.host_cache_lfu_aging_queries_per_way),
+      parameter_server_(parameter_server),
+      clock_(0) {
+  InferenceParser inference_parser(read_json_file(model_config_path));
+  if (inference_parser.num_embedding_tables != inference_params.sparse_model_files.size()) {
+    CK_THROW_(Error_t::WrongInput,
+              "Error: the number of embedding tables is not consistent with sparse_model_files");
+  }
+  std::vector<size_t> capacity;
+  for (const auto& sparse_model_file : inference_params.sparse_model_files) {
+    const std::string key_file(sparse_model_file + "/key");
+    if (fs::file_size(key_file) % sizeof(long long) != 0) {
+      CK_THROW_(Error_t::WrongInput, "Error: embeddings file size is not correct");
+    }
+    const size_t row_num = fs::file_size(key_file) / sizeof(long long);
+    capacity.emplace_back(static_cast<size_t>(
+        static_cast<double>(inference_params.host_cache_size_percentage) * row_num));
+  }
+  init_(inference_parser.embed_vec_size_for_tables, capacity);
+}
+
+template <typename TypeHashKey>
+EmbeddingCacheCPU<TypeHashKey>::EmbeddingCacheCPU(
+    const std::string& model_name, const std::vector<size_t>& embedding_vec_size,
+    const std::vector<size_t>& capacity, size_t set_associativity,
+    CacheEvictionPolicy_t eviction_policy,
+    const std::shared_ptr<HugectrUtility<TypeHashKey>>& parameter_server,
+    size_t lfu_aging_queries_per_way)
+    : model_name_(model_name),
+      set_associativity_(set_associativity),
+      eviction_policy_(eviction_policy),
+      lfu_aging_queries_per_way_(lfu_aging_queries_per_way),
+      parameter_server_(parameter_server),
+      clock_(0) {
+  init_(embedding_vec_size, capacity);
+}
+
+template <typename TypeHashKey>
+void EmbeddingCacheCPU<TypeHashKey>::init_(const std::vector<size_t>& embedding_vec_size,
+                                           const std::vector<size_t>& capacity) {
+  if (embedding_vec_size.size() != capacity.size()) {
+    CK_THROW_(Error_t::WrongInput, "Error: embedding_vec_size and capacity size mismatch");
+  }
+  if (set_associativity_ == 0) {
+    CK_THROW_(Error_t::WrongInput, "Error: host_cache_set_associativity should be at least 1");
+  }
+  if (!parameter_server_) {
+    CK_THROW_(Error_t::WrongInput, "Error: EmbeddingCacheCPU needs a parameter server");
+  }
+  for (size_t i = 0; i < capacity.size(); i++) {
+    std::unique_ptr<CacheTable> table(new CacheTable());
+    table->embedding_vec_size = embedding_vec_size[i];
+    table->num_sets = std::max<size_t>(1, capacity[i] / set_associativity_);
+    const size_t num_ways = table->num_sets * set_associativity_;
+    table->keys.resize(num_ways);
+    table->counters.resize(num_ways, 0);
+    table->values.resize(num_ways * table->embedding_vec_size);
+    table->set_locks.reset(new std::mutex[table->num_sets]);
+    table->aging_period = num_ways * lfu_aging_queries_per_way_;
+    if (eviction_policy_ == CacheEvictionPolicy_t::LFU && table->aging_period != 0) {
+      table->set_epochs.resize(table->num_sets, 0);
+    }
+    MESSAGE_("Host embedding cache of table " + std::to_string(i) + ": " +
+             std::to_string(table->num_sets) + " sets x " + std::to_string(set_associativity_) +
+             " ways, " +
+             std::to_string(table->values.size() * sizeof(float) / (1024.0 * 1024.0)) + " MB");
+    tables_.emplace_back(std::move(table));
+  }
+}
+
+template <typename TypeHashKey>
+void EmbeddingCacheCPU<TypeHashKey>::age_set_(CacheTable& table, size_t set) {
+  if (eviction_policy_ != CacheEvictionPolicy_t::LFU || table.aging_period == 0) {
+    return;
+  }
+  const uint64_t epoch = table.num_queries.load(std::memory_order_relaxed) / table.aging_period;
+  const uint64_t num_halvings = epoch - table.set_epochs[set];
+  if (num_halvings == 0) {
+    return;
+  }
+  table.set_epochs[set] = epoch;
+  const size_t first_way = set * set_associativity_;
+  for (size_t way = first_way; way < first_way + set_associativity_; way++) {
+    // An occupied way keeps a counter of at least 1, 0 marks an empty way
+    if (table.counters[way] != 0) {
+      table.counters[way] =
+          std::max<uint64_t>(1, num_halvings < 64 ? table.counters[way] >> num_halvings : 0);
+    }
+  }
+}
+
+template <typename TypeHashKey>
+bool EmbeddingCacheCPU<TypeHashKey>::query_(CacheTable& table, TypeHashKey key, float* dst) {
+  const size_t set = murmur_hash3_fmix64(static_cast<uint64_t>(key)) % table.num_sets;
+  const size_t first_way = set * set_associativity_;
+  std::lock_guard<std::mutex> lock(table.set_locks[set]);
+  age_set_(table, set);
+  for (size_t way = first_way; way < first_way + set_associativity_; way++) {
+    if (table.counters[way] != 0 && table.keys[way] == key) {
+      table.counters[way] = touch_(table.counters[way]);
+      memcpy(dst, table.values.data() + way * table.embedding_vec_size,
+             table.embedding_vec_size * sizeof(float));
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename TypeHashKey>
+void EmbeddingCacheCPU<TypeHashKey>::insert_(CacheTable& table, TypeHashKey key,
+                                             const float* src) {
+  const size_t set = murmur_hash3_fmix64(static_cast<uint64_t>(key)) % table.num_sets;
+  const size_t first_way = set * set_associativity_;
+  std::lock_guard<std::mutex> lock(table.set_locks[set]);
+  age_set_(table, set);
+  // An empty way or the way with the smallest counter is the victim, the key itself may have been
+  // inserted by another session in the meantime
+  size_t victim = first_way;
+  for (size_t way = first_way; way < first_way + set_associativity_; way++) {
+    if (table.counters[way] != 0 && table.keys[way] == key) {
+      return;
+    }
+    if (table.counters[way] < table.counters[victim]) {
+      victim = way;
+    }
+  }
+  table.keys[victim] = key;
+  table.counters[victim] = touch_(0);
+  memcpy(table.values.data() + victim * table.embedding_vec_size, src,
+         table.embedding_vec_size * sizeof(float));
+}
+
+template <typename TypeHashKey>
+void EmbeddingCacheCPU<TypeHashKey>::look_up(const TypeHashKey* h_embeddingcolumns, size_t length,
+                                             float* h_embeddingoutputvector,
+                                             size_t embedding_table_id, double* h_hit_rate) {
+  if (embedding_table_id >= tables_.size()) {
+    CK_THROW_(Error_t::OutOfBound, "Error: embedding_table_id is out of bound");
+  }
+  CacheTable& table = *tables_[embedding_table_id];
+  const size_t embedding_vec_size = table.embedding_vec_size;
+
+  std::vector<TypeHashKey> missing_keys;
+  std::vector<size_t> missing_index;
+  for (size_t i = 0; i < length; i++) {
+    if (!query_(table, h_embeddingcolumns[i], h_embeddingoutputvector + i * embedding_vec_size)) {
+      missing_keys.emplace_back(h_embeddingcolumns[i]);
+      missing_index.emplace_back(i);
+    }
+  }
+
+  // Query all the missing keys from the parameter server at once, then fill them in the cache
+  if (!missing_keys.empty()) {
+    std::vector<float> missing_vectors(missing_keys.size() * embedding_vec_size);
+    parameter_server_->look_up(missing_keys.data(), missing_keys.size(), missing_vectors.data(),
+                               model_name_, embedding_table_id);
+    for (size_t i = 0; i < missing_keys.size(); i++) {
+      const float* src = missing_vectors.data() + i * embedding_vec_size;
+      memcpy(h_embeddingoutputvector + missing_index[i] * embedding_vec_size, src,
+             embedding_vec_size * sizeof(float));
+      insert_(table, missing_keys[i], src);
+    }
+  }
+
+  const size_t num_hits = length - missing_keys.size();
+  table.num_hits += num_hits;
+  table.num_queries += length;
+  if (h_hit_rate != nullptr) {
+    *h_hit_rate = length == 0 ? 1.0 : static_cast<double>(num_hits) / length;
+  }
+}
+
+template <typename TypeHashKey>
+double EmbeddingCacheCPU<TypeHashKey>::get_hit_rate(size_t embedding_table_id) const {
+  if (embedding_table_id >= tables_.size()) {
+    CK_THROW_(Error_t::OutOfBound, "Error: embedding_table_id is out of bound");
+  }
+  const CacheTable& table = *tables_[embedding_table_id];
+  const uint64_t num_queries = table.num_queries;
+  return num_queries == 0 ? 0.0 : static_cast<double>(table.num_hits) / num_queries;
+}
+
+template class EmbeddingCacheCPU<unsigned int>;
+template class EmbeddingCacheCPU<long long>;
+
+}  // namespace HugeCTR
@@ -124,7 +124,7 @@ void EmbeddingFeatureCombinerCPU<TypeEmbedding>::fprop(bool is_train) {
  
   auto in_dims = in_tensors_[0]->get_dimensions();
   auto out_dims = out_tensors_[0].get_dimensions();
-  embedding_feature_combine_cpu(input, output, row_ptrs, batch_size_, slot_num_,
+  embedding_feature_combine_cpu(input, output, row_ptrs, get_active_batch_size(batch_size_), slot_num_,
                               embedding_vec_size_, combiner_type_);
 }
 
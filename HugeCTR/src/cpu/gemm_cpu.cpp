@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <omp.h>
+
+#include <cmath>
+#include <cpu/gemm_cpu.hpp>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace HugeCTR {
+
+namespace {
+
+constexpr size_t kNR = PackedMatrixCPU::kPanelWidth;
+// Depth of a k-block, so that the k-block of a panel (16 KB) stays in L1
+constexpr size_t kKC = 256;
+// A task of gemm_cpu computes kMC rows by kNC panels of c
+constexpr size_t kMC = 48;
+constexpr size_t kNC = 4;
+// Below this many multiply-adds the product runs on the calling thread
+constexpr size_t kMinParallelWork = 1 << 20;
+
+// Write or accumulate the first nr columns of a row-major MR_ x kNR tile into c
+template <size_t MR_>
+void store_tile(const float* tile, float* c, size_t ldc, size_t nr, bool accumulate) {
+  for (size_t r = 0; r < MR_; r++) {
+    float* c_row = c + r * ldc;
+    const float* t_row = tile + r * kNR;
+    if (accumulate) {
+      for (size_t j = 0; j < nr; j++) c_row[j] += t_row[j];
+    } else {
+      for (size_t j = 0; j < nr; j++) c_row[j] = t_row[j];
+    }
+  }
+}
+
+inline float to_float(float v) { return v; }
+
+inline float to_float(uint16_t bf16) {
+  const uint32_t bits = static_cast<uint32_t>(bf16) << 16;
+  float v;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+template <typename TB>
+const TB* get_panel(const PackedMatrixCPU& b, size_t panel);
+
+template <>
+const float* get_panel<float>(const PackedMatrixCPU& b, size_t panel) {
+  return b.get_panel(panel);
+}
+
+template <>
+const uint16_t* get_panel<uint16_t>(const PackedMatrixCPU& b, size_t panel) {
+  return b.get_panel_bf16(panel);
+}
+
+struct ScalarKernel {
+  // 3 rows x 16 floats of accumulators still fit the 16 xmm of the SSE2 baseline
+  static constexpr size_t kMR = 3;
+
+  template <size_t MR_, typename TB>
+  static void compute(const float* a, size_t lda, const TB* bp, size_t kc, float* c, size_t ldc,
+                      size_t nr, bool accumulate) {
+    float acc[MR_ * kNR] = {};
+    for (size_t p = 0; p < kc; p++) {
+      float b_row[kNR];
+      for (size_t j = 0; j < kNR; j++) b_row[j] = to_float(bp[p * kNR + j]);
+      for (size_t r = 0; r < MR_; r++) {
+        const float av = a[r * lda + p];
+        for (size_t j = 0; j < kNR; j++) acc[r * kNR + j] += av * b_row[j];
+      }
+    }
+    store_tile<MR_>(acc, c, ldc, nr, accumulate);
+  }
+};
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2,fma"))) inline void load_b_avx2(const float* bp, __m256& b0,
+                                                             __m256& b1) {
+  b0 = _mm256_loadu_ps(bp);
+  b1 = _mm256_loadu_ps(bp + 8);
+}
+
+// bf16 is the upper half of a float
+__attribute__((target("avx2,fma"))) inline void load_b_avx2(const uint16_t* bp, __m256& b0,
+                                                             __m256& b1) {
+  const __m256i lo = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bp)));
+  const __m256i hi =
+      _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bp + 8)));
+  b0 = _mm256_castsi256_ps(_mm256_slli_epi32(lo, 16));
+  b1 = _mm256_castsi256_ps(_mm256_slli_epi32(hi, 16));
+}
+
+__attribute__((target("avx512f"))) inline __m512 load_b_avx512(const float* bp) {
+  return _mm512_loadu_ps(bp);
+}
+
+__attribute__((target("avx512f"))) inline __m512 load_b_avx512(const uint16_t* bp) {
+  // The maskz forms avoid the _mm512_undefined_epi32() that trips -Wmaybe-uninitialized
+  const __m512i v = _mm512_maskz_cvtepu16_epi32(
+      0xffff, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bp)));
+  return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(0xffff, v, 16));
+}
+
+struct AVX2Kernel {
+  static constexpr size_t kMR = 6;
+
+  // 6 rows x 2 ymm of accumulators, 2 ymm of b and 1 of broadcast a: 15 of the 16 ymm
+  template <size_t MR_, typename TB>
+  __attribute__((target("avx2,fma"))) static void compute(const float* a, size_t lda,
+                                                           const TB* bp, size_t kc, float* c,
+                                                           size_t ldc, size_t nr,
+                                                           bool accumulate) {
+    __m256 acc0[MR_];
+    __m256 acc1[MR_];
+    for (size_t r = 0; r < MR_; r++) {
+      acc0[r] = _mm256_setzero_ps();
+      acc1[r] = _mm256_setzero_ps();
+    }
+    for (size_t p = 0; p < kc; p++) {
+      __m256 b0, b1;
+      load_b_avx2(bp + p * kNR, b0, b1);
+      for (size_t r = 0; r < MR_; r++) {
+        const __m256 av = _mm256_broadcast_ss(a + r * lda + p);
+        acc0[r] = _mm256_fmadd_ps(av, b0, acc0[r]);
+        acc1[r] = _mm256_fmadd_ps(av, b1, acc1[r]);
+      }
+    }
+    if (nr == kNR) {
+      for (size_t r = 0; r < MR_; r++) {
+        float* c_row = c + r * ldc;
+        if (accumulate) {
+          acc0[r] = _mm256_add_ps(acc0[r], _mm256_loadu_ps(c_row));
+          acc1[r] = _mm256_add_ps(acc1[r], _mm256_loadu_ps(c_row + 8));
+        }
+        _mm256_storeu_ps(c_row, acc0[r]);
+        _mm256_storeu_ps(c_row + 8, acc1[r]);
+      }
+    } else {
+      float tile[MR_ * kNR];
+      for (size_t r = 0; r < MR_; r++) {
+        _mm256_storeu_ps(tile + r * kNR, acc0[r]);
+        _mm256_storeu_ps(tile + r * kNR + 8, acc1[r]);
+      }
+      store_tile<MR_>(tile, c, ldc, nr, accumulate);
+    }
+  }
+};
+
+struct AVX512Kernel {
+  static constexpr size_t kMR = 12;
+
+  // One zmm per row of the tile, so twice the rows of AVX2Kernel keep the FMA ports busy
+  template <size_t MR_, typename TB>
+  __attribute__((target("avx512f"))) static void compute(const float* a, size_t lda,
+                                                          const TB* bp, size_t kc, float* c,
+                                                          size_t ldc, size_t nr,
+                                                          bool accumulate) {
+    __m512 acc[MR_];
+    for (size_t r = 0; r < MR_; r++) acc[r] = _mm512_setzero_ps();
+    for (size_t p = 0; p < kc; p++) {
+      const __m512 b = load_b_avx512(bp + p * kNR);
+      for (size_t r = 0; r < MR_; r++) {
+        acc[r] = _mm512_fmadd_ps(_mm512_set1_ps(a[r * lda + p]), b, acc[r]);
+      }
+    }
+    const __mmask16 mask = static_cast<__mmask16>((1u << nr) - 1);
+    for (size_t r = 0; r < MR_; r++) {
+      float* c_row = c + r * ldc;
+      if (accumulate) {
+        acc[r] = _mm512_add_ps(acc[r], _mm512_maskz_loadu_ps(mask, c_row));
+      }
+      _mm512_mask_storeu_ps(c_row, mask, acc[r]);
+    }
+  }
+};
+
+#endif
+
+// Instantiate Kernel::compute for every row count up to Kernel::kMR
+template <typename Kernel, size_t MR_, typename TB>
+void run_kernel(size_t mr, const float* a, size_t lda, const TB* bp, size_t kc, float* c,
+                size_t ldc, size_t nr, bool accumulate) {
+  if (mr == MR_) {
+    Kernel::template compute<MR_>(a, lda, bp, kc, c, ldc, nr, accumulate);
+  } else if constexpr (MR_ > 1) {
+    run_kernel<Kernel, MR_ - 1>(mr, a, lda, bp, kc, c, ldc, nr, accumulate);
+  }
+}
+
+// Bias, pre-activation copy and activation of the rows x [col_begin, col_end) tile of c
+void apply_epilogue(float* c, size_t ldc, float* c_pre_act, size_t rows, size_t col_begin,
+                    size_t col_end, const float* bias, GemmActivationCPU act) {
+  for (size_t i = 0; i < rows; i++) {
+    float* c_row = c + i * ldc;
+    if (bias) {
+      for (size_t j = col_begin; j < col_end; j++) c_row[j] += bias[j];
+    }
+    if (c_pre_act) {
+      float* pre_act_row = c_pre_act + i * ldc;
+      for (size_t j = col_begin; j < col_end; j++) pre_act_row[j] = c_row[j];
+    }
+    if (act == GemmActivationCPU::Relu) {
+      for (size_t j = col_begin; j < col_end; j++) c_row[j] = c_row[j] < 0.0f ? 0.0f : c_row[j];
+    }
+  }
+}
+
+template <typename Kernel, typename TB>
+void gemm_task(const float* a, size_t lda, size_t row_begin, size_t row_end,
+               const PackedMatrixCPU& b, size_t panel_begin, size_t panel_end, const float* bias,
+               GemmActivationCPU act, float* c, size_t ldc, float* c_pre_act) {
+  const size_t k = b.get_k();
+  const size_t n = b.get_n();
+  const size_t col_begin = panel_begin * kNR;
+  const size_t col_end = std::min(n, panel_end * kNR);
+  if (k == 0) {
+    for (size_t i = row_begin; i < row_end; i++) {
+      std::fill(c + i * ldc + col_begin, c + i * ldc + col_end, 0.0f);
+    }
+  }
+  for (size_t p0 = 0; p0 < k; p0 += kKC) {
+    const size_t kc = std::min(kKC, k - p0);
+    for (size_t panel = panel_begin; panel < panel_end; panel++) {
+      const TB* bp = get_panel<TB>(b, panel) + p0 * kNR;
+      const size_t col = panel * kNR;
+      const size_t nr = std::min(kNR, n - col);
+      for (size_t i = row_begin; i < row_end; i += Kernel::kMR) {
+        const size_t mr = std::min(Kernel::kMR, row_end - i);
+        run_kernel<Kernel, Kernel::kMR>(mr, a + i * lda + p0, lda, bp, kc, c + i * ldc + col, ldc,
+                                        nr, p0 != 0);
+      }
+    }
+  }
+  apply_epilogue(c + row_begin * ldc, ldc, c_pre_act ? c_pre_act + row_begin * ldc : nullptr,
+                 row_end - row_begin, col_begin, col_end, bias, act);
+}
+
+template <typename Kernel, typename TB>
+void gemm(const float* a, size_t lda, size_t m, const PackedMatrixCPU& b, const float* bias,
+          GemmActivationCPU act, float* c, size_t ldc, float* c_pre_act) {
+  const size_t num_row_tasks = (m + kMC - 1) / kMC;
+  const size_t num_panel_tasks = (b.get_num_panels() + kNC - 1) / kNC;
+  const size_t num_tasks = num_row_tasks * num_panel_tasks;
+  const bool parallel = m * b.get_k() * b.get_n() >= kMinParallelWork && num_tasks > 1;
+  const int num_threads =
+      parallel ? static_cast<int>(std::min<size_t>(omp_get_max_threads(), num_tasks)) : 1;
+
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+  for (size_t task = 0; task < num_tasks; task++) {
+    const size_t row_begin = (task / num_panel_tasks) * kMC;
+    const size_t panel_begin = (task % num_panel_tasks) * kNC;
+    gemm_task<Kernel, TB>(a, lda, row_begin, std::min(m, row_begin + kMC), b, panel_begin,
+                      std::min(b.get_num_panels(), panel_begin + kNC), bias, act, c, ldc,
+                      c_pre_act);
+  }
+}
+
+template <typename Kernel>
+void gemm(const float* a, size_t lda, size_t m, const PackedMatrixCPU& b, const float* bias,
+          GemmActivationCPU act, float* c, size_t ldc, float* c_pre_act) {
+  if (b.is_bf16()) {
+    gemm<Kernel, uint16_t>(a, lda, m, b, bias, act, c, ldc, c_pre_act);
+  } else {
+    gemm<Kernel, float>(a, lda, m, b, bias, act, c, ldc, c_pre_act);
+  }
+}
+
+float half_to_float(uint16_t h) {
+  const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+  const uint32_t exponent = (h >> 10) & 0x1fu;
+  const uint32_t mantissa = h & 0x3ffu;
+  uint32_t bits;
+  if (exponent == 0) {
+    // zero or subnormal, mantissa * 2^-24
+    const float v = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+    return sign ? -v : v;
+  } else if (exponent == 0x1f) {
+    bits = sign | 0x7f800000u | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+  float v;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+uint16_t float_to_half(float v) {
+  uint32_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+  bits &= 0x7fffffffu;
+  if (bits > 0x7f800000u) {
+    return sign | 0x7e00u;
+  }
+  // 65520 and above round to infinity
+  if (bits >= 0x477ff000u) {
+    return sign | 0x7c00u;
+  }
+  // below 2^-14 the result is subnormal, scaling by 2^24 is exact
+  if (bits < 0x38800000u) {
+    return sign | static_cast<uint16_t>(std::nearbyint(std::fabs(v) * 16777216.0f));
+  }
+  bits += 0xfffu + ((bits >> 13) & 1u);
+  return sign | static_cast<uint16_t>((bits - (112u << 23)) >> 13);
+}
+
+#if defined(__x86_64__)
+
+bool has_f16c() {
+  static const bool f16c = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+  return f16c;
+}
+
+__attribute__((target("avx,f16c"))) size_t half_to_float_f16c(const uint16_t* src, float* dst,
+                                                               size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(dst + i,
+                     _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+  }
+  return i;
+}
+
+__attribute__((target("avx,f16c"))) size_t float_to_half_f16c(const float* src, uint16_t* dst,
+                                                               size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+  }
+  return i;
+}
+
+#endif
+
+}  // namespace
+
+void half_to_float_cpu(const uint16_t* src, float* dst, size_t n) {
+  size_t i = 0;
+#if defined(__x86_64__)
+  if (has_f16c()) {
+    i = half_to_float_f16c(src, dst, n);
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = half_to_float(src[i]);
+  }
+}
+
+void float_to_half_cpu(const float* src, uint16_t* dst, size_t n) {
+  size_t i = 0;
+#if defined(__x86_64__)
+  if (has_f16c()) {
+    i = float_to_half_f16c(src, dst, n);
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = float_to_half(src[i]);
+  }
+}
+
+bool is_gemm_isa_supported_cpu(GemmIsaCPU isa) {
+  switch (isa) {
+    case GemmIsaCPU::Scalar:
+      return true;
+#if defined(__x86_64__)
+    case GemmIsaCPU::AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case GemmIsaCPU::AVX512:
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+GemmIsaCPU get_gemm_isa_cpu() {
+  static const GemmIsaCPU isa = is_gemm_isa_supported_cpu(GemmIsaCPU::AVX512) ? GemmIsaCPU::AVX512
+                                : is_gemm_isa_supported_cpu(GemmIsaCPU::AVX2) ? GemmIsaCPU::AVX2
+                                                                              : GemmIsaCPU::Scalar;
+  return isa;
+}
+
+void gemm_cpu(const float* a, size_t lda, size_t m, const PackedMatrixCPU& b, const float* bias,
+              GemmActivationCPU act, float* c, size_t ldc, float* c_pre_act, GemmIsaCPU isa) {
+  if (!is_gemm_isa_supported_cpu(isa)) {
+    CK_THROW_(Error_t::WrongInput, "gemm_cpu: the micro-kernels are not supported by this host");
+  }
+  if (m == 0 || b.get_n() == 0) {
+    return;
+  }
+  switch (isa) {
+#if defined(__x86_64__)
+    case GemmIsaCPU::AVX512:
+      gemm<AVX512Kernel>(a, lda, m, b, bias, act, c, ldc, c_pre_act);
+      break;
+    case GemmIsaCPU::AVX2:
+      gemm<AVX2Kernel>(a, lda, m, b, bias, act, c, ldc, c_pre_act);
+      break;
+#endif
+    default:
+      gemm<ScalarKernel>(a, lda, m, b, bias, act, c, ldc, c_pre_act);
+      break;
+  }
+}
+
+}  // namespace HugeCTR
@@ -109,14 +109,14 @@ void AddLayerCPU<T>::fprop(bool is_train) {
 
   T* output = out_tensors_[0].get_ptr();
 
-  add_cpu(h_inputs_.get_ptr(), output, size_, num_);
+  add_cpu(h_inputs_.get_ptr(), output, get_active_num_elements(in_tensors_[0]), num_);
 }
 
 template <>
 void AddLayerCPU<__half>::fprop(bool is_train) {
   __half* output = out_tensors_[0].get_ptr();
 
-  add_cpu(h_inputs_.get_ptr(), output, size_, num_);
+  add_cpu(h_inputs_.get_ptr(), output, get_active_num_elements(in_tensors_[0]), num_);
 }
 
 template <typename T>
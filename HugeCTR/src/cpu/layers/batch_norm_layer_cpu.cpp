@@ -220,7 +220,7 @@ void BatchNormLayerCPU<T>::initialize() {}
 
 template <typename T>
 void BatchNormLayerCPU<T>::fprop(bool is_train) {
-  int batch_size = in_tensors_[0].get_dimensions()[0];
+  int batch_size = get_active_batch_size(in_tensors_[0].get_dimensions()[0]);
   int num_feature = in_tensors_[0].get_dimensions()[1];
 
   Tensor2<T>& in_tensor = in_tensors_[0];
@@ -49,7 +49,7 @@ template <typename From, typename To>
 void CastLayerCPU<From, To>::fprop(bool is_train) {
   const From* bottom = bottom_tensor_.get_ptr();
   To* top = top_tensor_.get_ptr();
-  int len = bottom_tensor_.get_num_elements();
+  int len = get_active_num_elements(bottom_tensor_);
   cast_cpu(top, bottom, len);
 }
 
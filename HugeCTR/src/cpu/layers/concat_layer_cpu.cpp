@@ -97,7 +97,7 @@ ConcatLayerCPU<T>::ConcatLayerCPU(const Tensors2<T>& in_tensors, Tensor2<T>& out
 
 template <typename T>
 void ConcatLayerCPU<T>::fprop(bool is_train) {
-  size_t height = out_tensor_.get_dimensions()[0];
+  size_t height = get_active_batch_size(out_tensor_.get_dimensions()[0]);
   int n_ins = in_tensors_.size();
   std::vector<size_t> widths;
   size_t new_width = 0;
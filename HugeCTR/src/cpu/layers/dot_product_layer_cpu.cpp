@@ -115,7 +115,7 @@ void DotProductLayerCPU<T>::fprop(bool is_train) {
     initialized_ = true;
   }
   T* output = out_tensors_[0].get_ptr();
-  dot_product_cpu(h_inputs_.get_ptr(), output, size_, num_);
+  dot_product_cpu(h_inputs_.get_ptr(), output, get_active_num_elements(in_tensors_[0]), num_);
 }
 
 template <typename T>
@@ -63,10 +63,7 @@ DropoutLayerCPU<T>::DropoutLayerCPU(const Tensor2<T>& in_tensor, const Tensor2<T
 template <typename T>
 void DropoutLayerCPU<T>::fprop(bool is_train) {
   FloatUniformDataSimulator<float> ldata_sim(0.f, 1.f);
-  size_t num = 1;
-  for (auto dim : in_tensors_[0].get_dimensions()) {
-    num *= dim;
-  }
+  size_t num = get_active_num_elements(in_tensors_[0]);
   float* h_mask = mask_.get_ptr();
   for (size_t i = 0; i < num; i++) {
     h_mask[i] = ldata_sim.get_num();
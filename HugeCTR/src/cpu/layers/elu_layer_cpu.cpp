@@ -58,7 +58,7 @@ void EluLayerCPU<T>::fprop(bool is_train) {
   const Tensor2<T>& in_tensor = in_tensors_[0];
   Tensor2<T>& out_tensor = out_tensors_[0];
 
-  const int len = in_tensor.get_num_elements();
+  const int len = get_active_num_elements(in_tensor);
 
   T alpha = alpha_;
 
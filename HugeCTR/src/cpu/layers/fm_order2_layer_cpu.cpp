@@ -133,7 +133,7 @@ template <typename T>
 void FmOrder2LayerCPU<T>::fprop(bool is_train) {
   const T* in = in_tensors_[0].get_ptr();
   T* out = out_tensors_[0].get_ptr();
-  fm_order2_fprop_cpu(in, out, batch_size_, slot_num_, embedding_vec_size_);
+  fm_order2_fprop_cpu(in, out, get_active_batch_size(batch_size_), slot_num_, embedding_vec_size_);
 }
 
 template <typename T>
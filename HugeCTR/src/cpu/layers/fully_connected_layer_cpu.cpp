@@ -24,23 +24,6 @@ namespace HugeCTR {
 
 namespace {
 
-void cpu_mm(float *a, float *b, float *c, int m, int k, int n) {
-  for (int i = 0; i < m; ++i) {
-    for (int j = 0; j < n; ++j) {
-      c[i * n + j] = 0.0f;
-      for (int kk = 0; kk < k; ++kk) c[i * n + j] += a[i * k + kk] * b[kk * n + j];
-    }
-  }
-}
-
-void cpu_add_bias(float *out, float *bias, int m, int n) {
-  for (int i = 0; i < m; ++i) {
-    for (int j = 0; j < n; ++j) {
-      out[i * n + j] += bias[j];
-    }
-  }
-}
-
 void transpose(float *a, int m, int n) {
   std::unique_ptr<float[]> tmp(new float[m * n]);
   for (int i = 0; i < m; ++i)
@@ -109,7 +92,6 @@ void FullyConnectedLayerCPU<float>::fprop(bool is_train) {
   Tensor2<float>& in_tensor = get_in_tensors(is_train)[0];
   Tensor2<float>& out_tensor = out_tensors_[0];
 
-  float* weight = weights_[0].get_ptr();
   float* bias = weights_[1].get_ptr();
   float* in = in_tensor.get_ptr();
   float* out = out_tensor.get_ptr();
@@ -119,12 +101,25 @@ void FullyConnectedLayerCPU<float>::fprop(bool is_train) {
 
   int m, n, k;
 
-  m = in_tensor_dim[0];
+  m = get_active_batch_size(in_tensor_dim[0]);
   n = out_tensor_dim[1];
   k = in_tensor_dim[1];
 
-  cpu_mm(in, weight, out, m, k, n);
-  cpu_add_bias(out, bias, m, n);
+  if (!packed_kernel_) {
+    on_weights_updated();
+  }
+  gemm_cpu(in, k, m, *packed_kernel_, bias, GemmActivationCPU::None, out, n);
+}
+
+void FullyConnectedLayerCPU<float>::on_weights_updated() {
+  const auto& weight_dim = weights_[0].get_dimensions();
+  auto packed_kernel = std::make_shared<PackedMatrixCPU>();
+  packed_kernel->pack(weights_[0].get_ptr(), weight_dim[0], weight_dim[1]);
+  packed_kernel_ = packed_kernel;
+}
+
+void FullyConnectedLayerCPU<float>::share_weights_from(const LayerCPU& source) {
+  packed_kernel_ = dynamic_cast<const FullyConnectedLayerCPU<float>&>(source).packed_kernel_;
 }
 
 void FullyConnectedLayerCPU<float>::bprop() {}
@@ -21,28 +21,8 @@ namespace HugeCTR {
 
 namespace {
 
-void cpu_mm(__half *c, const __half *a, bool transpose_a, const __half *b, bool transpose_b,
-                   int m, int k, int n) {
-  for (int i = 0; i < m; ++i) {
-    for (int j = 0; j < n; ++j) {
-      float sum = 0.0f;
-      for (int kk = 0; kk < k; ++kk) {
-        int ai = transpose_a ? kk * m + i : i * k + kk;
-        int bi = transpose_b ? j * k + kk : kk * n + j;
-        sum += a[ai] * b[bi];
-      }
-      c[i * n + j] = sum;
-    }
-  }
-}
-
-void cpu_add_bias(__half *top, const __half *bias, int m, int n) {
-  for (int i = 0; i < m; ++i) {
-    for (int j = 0; j < n; ++j) {
-      top[i * n + j] = top[i * n + j] + bias[j];
-    }
-  }
-}
+// The master weights rounded to the __half weights the layer computes with
+float round_to_half(float v) { return __half2float(__float2half(v)); }
 
 void cpu_reverse_add_bias(__half *bias_grad, const __half *top, int m, int n) {
   for (int i = 0; i < n; ++i) {
@@ -60,8 +40,9 @@ FullyConnectedLayerCPU<__half>::FullyConnectedLayerCPU(
     const std::shared_ptr<BufferBlock2<__half>>& weights_buff,
     const std::shared_ptr<BufferBlock2<__half>>& weights_grad_buff,
     const std::shared_ptr<GeneralBuffer2<HostAllocator>>& blobs_buff,
-    const Tensor2<__half>& bottom_tensor, const Tensor2<__half>& top_tensor)
-    : LayerCPU() {
+    const Tensor2<__half>& bottom_tensor, const Tensor2<__half>& top_tensor,
+    bool use_bf16_packed_weights)
+    : LayerCPU(), use_bf16_packed_weights_(use_bf16_packed_weights) {
   const auto& bottom_tensor_dim = bottom_tensor.get_dimensions();
   const auto& top_tensor_dim = top_tensor.get_dimensions();
 
@@ -108,6 +89,8 @@ FullyConnectedLayerCPU<__half>::FullyConnectedLayerCPU(
     weights_grad_.push_back(tensor);
   }
   blobs_buff->reserve(identity_dim, &identity_tensor_);
+  bottom_fp32_.resize(m * k);
+  top_fp32_.resize(m * n);
 
   bottom_tensor_ = bottom_tensor;
   top_tensor_ = top_tensor;
@@ -115,20 +98,48 @@ FullyConnectedLayerCPU<__half>::FullyConnectedLayerCPU(
 
 void FullyConnectedLayerCPU<__half>::fprop(bool is_train) {
 
-  const __half* kernel = weights_half_[0].get_ptr();
-  const __half* bias = weights_half_[1].get_ptr();
   const __half* bottom = get_bottom_tensor(is_train).get_ptr();
   __half* top = top_tensor_.get_ptr();
 
   const auto& bottom_tensor_dim = get_bottom_tensor(is_train).get_dimensions();
   const auto& top_tensor_dim = top_tensor_.get_dimensions();
 
-  size_t m = bottom_tensor_dim[0];
+  size_t m = get_active_batch_size(bottom_tensor_dim[0]);
   size_t n = top_tensor_dim[1];
   size_t k = bottom_tensor_dim[1];
 
-  cpu_mm(top, bottom, false, kernel, false, m, k, n);
-  cpu_add_bias(top, bias, m, n);
+  if (!packed_kernel_) {
+    on_weights_updated();
+  }
+  half_to_float_cpu(reinterpret_cast<const uint16_t*>(bottom), bottom_fp32_.data(), m * k);
+  gemm_cpu(bottom_fp32_.data(), k, m, *packed_kernel_, bias_fp32_.data(), GemmActivationCPU::None,
+           top_fp32_.data(), n);
+  float_to_half_cpu(top_fp32_.data(), reinterpret_cast<uint16_t*>(top), m * n);
+}
+
+void FullyConnectedLayerCPU<__half>::on_weights_updated() {
+  const auto& kernel_dim = weights_[0].get_dimensions();
+  auto packed_kernel = std::make_shared<PackedMatrixCPU>();
+  if (use_bf16_packed_weights_) {
+    packed_kernel->pack(weights_[0].get_ptr(), kernel_dim[0], kernel_dim[1], true);
+  } else {
+    packed_kernel->pack(weights_[0].get_ptr(), kernel_dim[0], kernel_dim[1], round_to_half);
+  }
+  packed_kernel_ = packed_kernel;
+  update_bias_fp32_();
+}
+
+void FullyConnectedLayerCPU<__half>::share_weights_from(const LayerCPU& source) {
+  packed_kernel_ = dynamic_cast<const FullyConnectedLayerCPU<__half>&>(source).packed_kernel_;
+  update_bias_fp32_();
+}
+
+void FullyConnectedLayerCPU<__half>::update_bias_fp32_() {
+  const float* bias = weights_[1].get_ptr();
+  bias_fp32_.resize(weights_[1].get_num_elements());
+  for (size_t i = 0; i < bias_fp32_.size(); i++) {
+    bias_fp32_[i] = round_to_half(bias[i]);
+  }
 }
 
 void FullyConnectedLayerCPU<__half>::bprop() {}
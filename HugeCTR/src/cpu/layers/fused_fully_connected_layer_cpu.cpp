@@ -21,30 +21,8 @@ namespace HugeCTR {
 
 namespace {
 
-void cpu_mm(__half *c, const __half *a, bool transpose_a, const __half *b, bool transpose_b,
-                   int m, int k, int n) {
-  for (int i = 0; i < m; ++i) {
-    for (int j = 0; j < n; ++j) {
-      float sum = 0.0f;
-      for (int kk = 0; kk < k; ++kk) {
-        int ai = transpose_a ? kk * m + i : i * k + kk;
-        int bi = transpose_b ? j * k + kk : kk * n + j;
-        sum += a[ai] * b[bi];
-      }
-      c[i * n + j] = sum;
-    }
-  }
-}
-
-void cpu_add_bias_and_re(__half *top, __half *middle, const __half *bias, int m, int n) {
-  for (int i = 0; i < m; ++i) {
-    for (int j = 0; j < n; ++j) {
-      __half t = top[i * n + j] + bias[j];
-      middle[i * n + j] = t;
-      top[i * n + j] = t < 0 ? __float2half(0.0f) : t;
-    }
-  }
-}
+// The master weights rounded to the __half weights the layer computes with
+float round_to_half(float v) { return __half2float(__float2half(v)); }
 
 void cpu_reverse_add_bias_and_re(__half *bias_grad, __half *middle, const __half *top, int m,
                                         int n) {
@@ -71,8 +49,9 @@ FusedFullyConnectedLayerCPU::FusedFullyConnectedLayerCPU(
     const std::shared_ptr<BufferBlock2<__half>>& weights_buff,
     const std::shared_ptr<BufferBlock2<__half>>& weights_grad_buff,
     const std::shared_ptr<GeneralBuffer2<HostAllocator>>& blobs_buff,
-    const Tensor2<__half>& bottom_tensor, const Tensor2<__half>& top_tensor)
-    : LayerCPU() {
+    const Tensor2<__half>& bottom_tensor, const Tensor2<__half>& top_tensor,
+    bool use_bf16_packed_weights)
+    : LayerCPU(), use_bf16_packed_weights_(use_bf16_packed_weights) {
   const auto& bottom_tensor_dim = bottom_tensor.get_dimensions();
   const auto& top_tensor_dim = top_tensor.get_dimensions();
 
@@ -128,12 +107,13 @@ FusedFullyConnectedLayerCPU::FusedFullyConnectedLayerCPU(
   top_tensor_ = top_tensor;
   blobs_buff->reserve(top_tensor_.get_dimensions(), &middle_tensor_);
   blobs_buff->reserve(bias_dim, &bias_grad_tensor_);
+  bottom_fp32_.resize(m * k);
+  middle_fp32_.resize(m * n);
+  top_fp32_.resize(m * n);
 }
 
 void FusedFullyConnectedLayerCPU::fprop(bool is_train) {
 
-  const __half* kernel = weights_half_[0].get_ptr();
-  const __half* bias = weights_half_[1].get_ptr();
   const __half* bottom = get_bottom_tensor(is_train).get_ptr();
   __half* middle = middle_tensor_.get_ptr();
   __half* top = top_tensor_.get_ptr();
@@ -141,12 +121,43 @@ void FusedFullyConnectedLayerCPU::fprop(bool is_train) {
   const auto& bottom_tensor_dim = get_bottom_tensor(is_train).get_dimensions();
   const auto& top_tensor_dim = top_tensor_.get_dimensions();
 
-  size_t m = bottom_tensor_dim[0];
+  size_t m = get_active_batch_size(bottom_tensor_dim[0]);
   size_t n = top_tensor_dim[1];
   size_t k = bottom_tensor_dim[1];
 
-  cpu_mm(top, bottom, false, kernel, false, m, k, n);
-  cpu_add_bias_and_re(top, middle, bias, m, n);
+  if (!packed_kernel_) {
+    on_weights_updated();
+  }
+  half_to_float_cpu(reinterpret_cast<const uint16_t*>(bottom), bottom_fp32_.data(), m * k);
+  gemm_cpu(bottom_fp32_.data(), k, m, *packed_kernel_, bias_fp32_.data(), GemmActivationCPU::Relu,
+           top_fp32_.data(), n, middle_fp32_.data());
+  float_to_half_cpu(middle_fp32_.data(), reinterpret_cast<uint16_t*>(middle), m * n);
+  float_to_half_cpu(top_fp32_.data(), reinterpret_cast<uint16_t*>(top), m * n);
+}
+
+void FusedFullyConnectedLayerCPU::on_weights_updated() {
+  const auto& kernel_dim = weights_[0].get_dimensions();
+  auto packed_kernel = std::make_shared<PackedMatrixCPU>();
+  if (use_bf16_packed_weights_) {
+    packed_kernel->pack(weights_[0].get_ptr(), kernel_dim[0], kernel_dim[1], true);
+  } else {
+    packed_kernel->pack(weights_[0].get_ptr(), kernel_dim[0], kernel_dim[1], round_to_half);
+  }
+  packed_kernel_ = packed_kernel;
+  update_bias_fp32_();
+}
+
+void FusedFullyConnectedLayerCPU::share_weights_from(const LayerCPU& source) {
+  packed_kernel_ = dynamic_cast<const FusedFullyConnectedLayerCPU&>(source).packed_kernel_;
+  update_bias_fp32_();
+}
+
+void FusedFullyConnectedLayerCPU::update_bias_fp32_() {
+  const float* bias = weights_[1].get_ptr();
+  bias_fp32_.resize(weights_[1].get_num_elements());
+  for (size_t i = 0; i < bias_fp32_.size(); i++) {
+    bias_fp32_[i] = round_to_half(bias[i]);
+  }
 }
 
 void FusedFullyConnectedLayerCPU::bprop() {}
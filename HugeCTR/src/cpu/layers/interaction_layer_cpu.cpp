@@ -186,7 +186,7 @@ void InteractionLayerCPU<T>::fprop(bool is_train) {
   T *in_emb = get_in_tensors(is_train)[1].get_ptr();
   T *mat = internal_tensors_[1].get_ptr();
   T *gather = out_tensors_[0].get_ptr();
-  size_t h = internal_tensors_[0].get_dimensions()[0];
+  size_t h = get_active_batch_size(internal_tensors_[0].get_dimensions()[0]);
   size_t out_w = internal_tensors_[0].get_dimensions()[1];
   size_t in_w = get_in_tensors(is_train)[0].get_dimensions()[1];
   size_t n_emb = get_in_tensors(is_train)[1].get_dimensions()[1];
@@ -163,7 +163,7 @@ MultiCrossLayerCPU::MultiCrossLayerCPU(const std::shared_ptr<BufferBlock2<float>
 
 void MultiCrossLayerCPU::fprop(bool is_train) {
   size_t vec_length = in_tensors_[0].get_dimensions()[1];
-  size_t batchsize = in_tensors_[0].get_dimensions()[0];
+  size_t batchsize = get_active_batch_size(in_tensors_[0].get_dimensions()[0]);
   Tensors2<float> kernel_tensors;
   Tensors2<float> bias_tensors;
   Tensors2<float> output_tensors;
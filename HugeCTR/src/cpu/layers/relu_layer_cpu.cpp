@@ -65,7 +65,7 @@ ReluLayerCPU<T>::ReluLayerCPU(const Tensor2<T>& in_tensor, const Tensor2<T>& out
 template <typename T>
 void ReluLayerCPU<T>::fprop(bool is_train) {
 
-  int len = in_tensors_[0].get_num_elements();
+  int len = get_active_num_elements(in_tensors_[0]);
 
   relu_cpu<T>(out_tensors_[0].get_ptr(), in_tensors_[0].get_ptr(), len);
 }
@@ -131,13 +131,14 @@ template <typename T>
 void ReshapeLayerCPU<T>::fprop(bool is_train) {
   T* h_in = in_tensors_[0].get_ptr();
   T* h_out = out_tensors_[0].get_ptr();
-  size_t num_elements = in_tensors_[0].get_num_elements();
   if (in_place_) {
+    const size_t num_elements = get_active_num_elements(in_tensors_[0]);
     for (size_t i = 0; i < num_elements; i++) {
       h_out[i] = h_in[i];
     }
   } else {
-    reshape_fprop_cpu(batch_size_, n_slot_, vector_length_, num_elements, selected_, h_in, h_out);
+    reshape_fprop_cpu(batch_size_, n_slot_, vector_length_, in_tensors_[0].get_num_elements(),
+                      selected_, h_in, h_out);
   }
 }
 
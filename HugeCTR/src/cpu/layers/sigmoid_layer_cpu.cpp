@@ -73,7 +73,7 @@ SigmoidLayerCPU<T>::SigmoidLayerCPU(const Tensor2<T>& in_tensor, const Tensor2<T
 template <typename T>
 void SigmoidLayerCPU<T>::fprop(bool is_train) {
 
-  int len = in_tensors_[0].get_num_elements();
+  int len = get_active_num_elements(in_tensors_[0]);
 
   sigmoid_cpu<T>(out_tensors_[0].get_ptr(), in_tensors_[0].get_ptr(), len);
 }
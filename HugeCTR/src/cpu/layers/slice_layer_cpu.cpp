@@ -117,7 +117,7 @@ void SliceLayerCPU<T>::fprop(bool is_train) {
   for (auto out_tensor : out_tensors_) {
     out.push_back(out_tensor.get_ptr());
   }
-  size_t height = in_tensors_[0].get_dimensions()[0];
+  size_t height = get_active_batch_size(in_tensors_[0].get_dimensions()[0]);
   size_t width = in_tensors_[0].get_dimensions()[1];
   slice_fprop_cpu(height, width, ranges_, n_out_tensors, in, out.data());
 }
@@ -122,7 +122,8 @@ void WeightMultiplyLayerCPU<T>::fprop(bool is_train) {
   T* input = in_tensors_[0].get_ptr();
   T* weight = weights_[0].get_ptr();
   T* output = out_tensors_[0].get_ptr();
-  weight_multiply_cpu(input, weight, output, batch_size_, slot_num_, embedding_vec_size_);
+  weight_multiply_cpu(input, weight, output, get_active_batch_size(batch_size_), slot_num_,
+                      embedding_vec_size_);
 }
 
 template <typename T>
@@ -20,7 +20,8 @@ namespace HugeCTR {
 
 NetworkCPU::NetworkCPU(const std::shared_ptr<CPUResource>& cpu_resource,
                       bool use_mixed_precision)
-    : cpu_resource_(cpu_resource),
+    : weight_source_(nullptr),
+      cpu_resource_(cpu_resource),
       use_mixed_precision_(use_mixed_precision) {
 }
 
@@ -35,18 +36,21 @@ void NetworkCPU::conv_weight_(Tensor2<__half>& target, const Tensor2<float>& sou
   }
 }
 
-void NetworkCPU::predict() {
-  if (use_mixed_precision_) {
-    conv_weight_(weight_tensor_half_, weight_tensor_);
-  }
+void NetworkCPU::predict(size_t num_samples) {
+  // the prediction has a row per sample, the other tensors may have several
+  const size_t batch_size = pred_tensor_.get_dimensions()[0];
   // forward
   for (auto& layer : layers_) {
+    layer->set_active_batch_size(num_samples, batch_size);
     layer->fprop(false);
   }
   return;
 }
 
 void NetworkCPU::load_params_from_model(const std::string& model_file) {
+  if (weight_source_) {
+    CK_THROW_(Error_t::IllegalCall, "The weights are shared, load them into the source network");
+  }
   std::ifstream model_stream(model_file, std::ifstream::binary);
   if (!model_stream.is_open()) {
     CK_THROW_(Error_t::WrongInput,
@@ -54,9 +58,25 @@ void NetworkCPU::load_params_from_model(const std::string& model_file) {
   }
   model_stream.read((char*)weight_tensor_.get_ptr(), weight_tensor_.get_size_in_bytes());
   model_stream.close();
+  on_weights_updated();
   return;
 }
 
+void NetworkCPU::on_weights_updated() {
+  if (weight_source_) {
+    for (size_t i = 0; i < layers_.size(); i++) {
+      layers_[i]->share_weights_from(*weight_source_->layers_[i]);
+    }
+    return;
+  }
+  if (use_mixed_precision_) {
+    conv_weight_(weight_tensor_half_, weight_tensor_);
+  }
+  for (auto& layer : layers_) {
+    layer->on_weights_updated();
+  }
+}
+
 void NetworkCPU::initialize() {
   for (auto& layer : layers_) {
     layer->initialize();
@@ -17,6 +17,8 @@
 #include <cpu/session_inference_cpu.hpp>
 #include <cpu/create_pipeline_cpu.hpp>
 #include <cpu_resource.hpp>
+#include <omp.h>
+#include <algorithm>
 #include <iostream>
 #include <vector>
 namespace HugeCTR {
@@ -24,34 +26,40 @@ namespace HugeCTR {
 template <typename TypeHashKey>
 InferenceSessionCPU<TypeHashKey>::InferenceSessionCPU(const std::string& config_file,
                                         const InferenceParams& inference_params,
-                                        std::shared_ptr<HugectrUtility<TypeHashKey>>& ps)
+                                        std::shared_ptr<HugectrUtility<TypeHashKey>>& ps,
+                                        const std::shared_ptr<EmbeddingCacheCPU<TypeHashKey>>& embedding_cache)
     : config_(read_json_file(config_file)),
       embedding_table_slot_size_({0}),
       parameter_server_(ps),
+      embedding_cache_(embedding_cache),
+      num_workspaces_(1),
+      num_in_flight_(0),
+      num_threads_(omp_get_max_threads()),
       inference_parser_(config_),
       inference_params_(inference_params) {
   try {
     cpu_resource_.reset(new CPUResource(0, {}));
-    NetworkCPU* network_ptr;
-    std::map<std::string, bool> tensor_active;
-
-    // create pipeline and initialize network
-    create_pipeline_cpu(config_, tensor_active, inference_params_, dense_input_tensor_, row_ptrs_tensors_, embedding_features_tensors_,
-                      embedding_table_slot_size_, &embedding_feature_combiners_, &network_ptr,  cpu_resource_);
-    network_ = std::move(std::unique_ptr<NetworkCPU>(network_ptr));
-    network_->initialize();
+    max_num_workspaces_ = inference_params_.num_cpu_workspaces > 0
+                              ? inference_params_.num_cpu_workspaces
+                              : static_cast<size_t>(omp_get_num_procs());
+
+    // the first workspace owns the dense weights
+    workspaces_.push_back(create_workspace_(nullptr));
+    NetworkCPU* network = workspaces_[0]->network.get();
+    network->initialize();
     if(inference_params_.dense_model_file.size() > 0) {
-      network_->load_params_from_model(inference_params_.dense_model_file);
+      network->load_params_from_model(inference_params_.dense_model_file);
     }
+    free_workspaces_.push_back(workspaces_[0].get());
+    h_hit_rate_.resize(inference_parser_.num_embedding_tables, 0.0);
 
-    // allocate memory for embedding vector lookup
-    h_embeddingvectors_ = (float*)malloc(inference_params_.max_batchsize *  inference_parser_.max_embedding_vector_size_per_sample * sizeof(float));
-    if (inference_params_.i64_input_key) {
-      h_shuffled_embeddingcolumns_ = malloc(inference_params_.max_batchsize * inference_parser_.max_feature_num_per_sample * sizeof(long long));
-    } else {
-      h_shuffled_embeddingcolumns_ = malloc(inference_params_.max_batchsize * inference_parser_.max_feature_num_per_sample * sizeof(unsigned int));
+    // host embedding cache in front of the parameter server
+    if (!embedding_cache_ && inference_params_.use_host_embedding_cache) {
+      embedding_cache_ = std::make_shared<EmbeddingCacheCPU<TypeHashKey>>(config_file, inference_params_, parameter_server_);
+    }
+    if (embedding_cache_ && embedding_cache_->get_num_embedding_tables() != inference_parser_.num_embedding_tables) {
+      CK_THROW_(Error_t::WrongInput, "Error: the number of embedding tables of the host embedding cache is not consistent");
     }
-    h_shuffled_embedding_offset_ = (size_t *)malloc((inference_parser_.num_embedding_tables + 1) * sizeof(size_t));
   } catch (const std::runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
     throw;
@@ -60,36 +68,109 @@ InferenceSessionCPU<TypeHashKey>::InferenceSessionCPU(const std::string& config_
 }  // namespace HugeCTR
 
 template <typename TypeHashKey>
-InferenceSessionCPU<TypeHashKey>::~InferenceSessionCPU() {
-  free(h_embeddingvectors_);
-  free(h_shuffled_embeddingcolumns_);
-  free(h_shuffled_embedding_offset_);
+InferenceSessionCPU<TypeHashKey>::~InferenceSessionCPU() {}
+
+template <typename TypeHashKey>
+std::unique_ptr<typename InferenceSessionCPU<TypeHashKey>::Workspace>
+InferenceSessionCPU<TypeHashKey>::create_workspace_(const NetworkCPU* weight_source) {
+  std::unique_ptr<Workspace> workspace(new Workspace());
+  NetworkCPU* network_ptr;
+  std::map<std::string, bool> tensor_active;
+  // the slot sizes are the same for every workspace, only keep the ones of the first
+  std::vector<size_t> embedding_table_slot_size({0});
+
+  // create pipeline and initialize network
+  create_pipeline_cpu(config_, tensor_active, inference_params_, workspace->dense_input_tensor,
+                      workspace->row_ptrs_tensors, workspace->embedding_features_tensors,
+                      embedding_table_slot_size, &workspace->embedding_feature_combiners,
+                      &network_ptr, cpu_resource_, weight_source);
+  workspace->network.reset(network_ptr);
+  if (!weight_source) {
+    embedding_table_slot_size_ = embedding_table_slot_size;
+  }
+
+  // allocate memory for embedding vector lookup
+  const size_t max_query_length = inference_params_.max_batchsize * inference_parser_.max_feature_num_per_sample;
+  const size_t max_embeddingvectors_size = inference_params_.max_batchsize * inference_parser_.max_embedding_vector_size_per_sample;
+  workspace->h_embeddingvectors.resize(max_embeddingvectors_size);
+  workspace->h_shuffled_embeddingcolumns.resize(max_query_length);
+  workspace->h_shuffled_embedding_offset.resize(inference_parser_.num_embedding_tables + 1);
+  workspace->unique_op.reset(new UniqueOpCPU<TypeHashKey>(max_query_length));
+  workspace->h_unique_embeddingcolumns.resize(max_query_length);
+  workspace->h_unique_index.resize(max_query_length);
+  workspace->h_unique_embeddingvectors.resize(max_embeddingvectors_size);
+  workspace->h_hit_rate.resize(inference_parser_.num_embedding_tables, 0.0);
+  return workspace;
+}
+
+template <typename TypeHashKey>
+typename InferenceSessionCPU<TypeHashKey>::Workspace*
+InferenceSessionCPU<TypeHashKey>::checkout_workspace_() {
+  std::unique_lock<std::mutex> lock(workspace_mutex_);
+  if (free_workspaces_.empty() && num_workspaces_ < max_num_workspaces_) {
+    // reserve the workspace, then build it without holding the lock
+    num_workspaces_++;
+    num_in_flight_++;
+    const NetworkCPU* weight_source = workspaces_[0]->network.get();
+    lock.unlock();
+    std::unique_ptr<Workspace> workspace;
+    try {
+      workspace = create_workspace_(weight_source);
+      workspace->network->initialize();
+      workspace->network->on_weights_updated();
+    } catch (...) {
+      lock.lock();
+      num_workspaces_--;
+      num_in_flight_--;
+      throw;
+    }
+    lock.lock();
+    workspaces_.push_back(std::move(workspace));
+    return workspaces_.back().get();
+  }
+  workspace_cv_.wait(lock, [this] { return !free_workspaces_.empty(); });
+  Workspace* workspace = free_workspaces_.back();
+  free_workspaces_.pop_back();
+  num_in_flight_++;
+  return workspace;
+}
+
+template <typename TypeHashKey>
+void InferenceSessionCPU<TypeHashKey>::checkin_workspace_(Workspace* workspace) {
+  {
+    std::lock_guard<std::mutex> lock(workspace_mutex_);
+    free_workspaces_.push_back(workspace);
+    num_in_flight_--;
+  }
+  workspace_cv_.notify_one();
 }
 
 template <typename TypeHashKey>
-void InferenceSessionCPU<TypeHashKey>::separate_keys_by_table_(int* h_row_ptrs, const std::vector<size_t>& embedding_table_slot_size, int num_samples) {
+void InferenceSessionCPU<TypeHashKey>::separate_keys_by_table_(Workspace& workspace, int* h_row_ptrs, const std::vector<size_t>& embedding_table_slot_size, int num_samples) {
   size_t slot_num = inference_parser_.slot_num;
   size_t num_embedding_tables = inference_parser_.num_embedding_tables;
-  h_embedding_offset_.resize(num_samples*num_embedding_tables+1);
+  std::vector<size_t>& h_embedding_offset = workspace.h_embedding_offset;
+  h_embedding_offset.resize(num_samples*num_embedding_tables+1);
   for (int i = 0; i < num_samples; i++) {
     for (int j = 0; j < static_cast<int>(num_embedding_tables); j++) {
-      h_embedding_offset_[i*num_embedding_tables + j + 1] = h_row_ptrs[i*slot_num + static_cast<int>(embedding_table_slot_size[j+1])];
+      h_embedding_offset[i*num_embedding_tables + j + 1] = h_row_ptrs[i*slot_num + static_cast<int>(embedding_table_slot_size[j+1])];
     }
   }
 }
 
 template <typename TypeHashKey>
-void InferenceSessionCPU<TypeHashKey>::look_up_(const void* h_embeddingcolumns,
-                                  const std::vector<size_t>& h_embedding_offset,
-                                  float* h_embeddingvectors) {
+void InferenceSessionCPU<TypeHashKey>::look_up_(Workspace& workspace, const void* h_embeddingcolumns) {
+  const std::vector<size_t>& h_embedding_offset = workspace.h_embedding_offset;
+  size_t* h_shuffled_embedding_offset = workspace.h_shuffled_embedding_offset.data();
+  TypeHashKey* h_shuffled_embeddingcolumns = workspace.h_shuffled_embeddingcolumns.data();
   // Shuffle the input embeddingcolumns
   size_t num_sample = (h_embedding_offset.size() - 1) / inference_parser_.num_embedding_tables;
   size_t acc_offset = 0;
   for(unsigned int i = 0; i < inference_parser_.num_embedding_tables; i++) {
-    h_shuffled_embedding_offset_[i] = acc_offset;
+    h_shuffled_embedding_offset[i] = acc_offset;
     for(unsigned int j = 0; j < num_sample; j++){
-      TypeHashKey* dst_ptr = (TypeHashKey*)(h_shuffled_embeddingcolumns_) + acc_offset;
-      TypeHashKey* src_prt = (TypeHashKey*)(h_embeddingcolumns) + h_embedding_offset[j * inference_parser_.num_embedding_tables + i];
+      TypeHashKey* dst_ptr = h_shuffled_embeddingcolumns + acc_offset;
+      const TypeHashKey* src_prt = (const TypeHashKey*)(h_embeddingcolumns) + h_embedding_offset[j * inference_parser_.num_embedding_tables + i];
       size_t cpy_len = h_embedding_offset[j * inference_parser_.num_embedding_tables + i + 1] 
                       - h_embedding_offset[j * inference_parser_.num_embedding_tables + i];
       size_t cpy_len_in_byte = cpy_len * sizeof(TypeHashKey);
@@ -97,62 +178,94 @@ void InferenceSessionCPU<TypeHashKey>::look_up_(const void* h_embeddingcolumns,
       acc_offset += cpy_len;
     }
   }
-  h_shuffled_embedding_offset_[inference_parser_.num_embedding_tables] = acc_offset;
-  if(h_shuffled_embedding_offset_[inference_parser_.num_embedding_tables] != h_embedding_offset[num_sample * inference_parser_.num_embedding_tables]) {
+  h_shuffled_embedding_offset[inference_parser_.num_embedding_tables] = acc_offset;
+  if(h_shuffled_embedding_offset[inference_parser_.num_embedding_tables] != h_embedding_offset[num_sample * inference_parser_.num_embedding_tables]) {
     CK_THROW_(Error_t::WrongInput, "Error: embeddingcolumns buffer size is not consist before and after shuffle.");
   }
 
   // look up
   size_t acc_emb_vec_offset = 0;
   for(unsigned int i = 0; i < inference_parser_.num_embedding_tables; i++) {
-    TypeHashKey* h_query_key_ptr = (TypeHashKey*)(h_shuffled_embeddingcolumns_) + h_shuffled_embedding_offset_[i];
-    size_t query_length = h_shuffled_embedding_offset_[i + 1] - h_shuffled_embedding_offset_[i];
+    TypeHashKey* h_query_key_ptr = h_shuffled_embeddingcolumns + h_shuffled_embedding_offset[i];
+    size_t query_length = h_shuffled_embedding_offset[i + 1] - h_shuffled_embedding_offset[i];
     size_t query_length_in_float = query_length * inference_parser_.embed_vec_size_for_tables[i];
-    float* h_vals_retrieved_ptr = h_embeddingvectors + acc_emb_vec_offset;
-    parameter_server_ -> look_up(h_query_key_ptr, query_length, h_vals_retrieved_ptr, inference_params_.model_name, i);
+    float* h_vals_retrieved_ptr = workspace.h_embeddingvectors.data() + acc_emb_vec_offset;
+    // only look up each key once, then expand the emb_vec back to all the queried keys
+    size_t unique_length = workspace.unique_op->unique(h_query_key_ptr, query_length, workspace.h_unique_index.data(), workspace.h_unique_embeddingcolumns.data());
+    if (embedding_cache_) {
+      embedding_cache_->look_up(workspace.h_unique_embeddingcolumns.data(), unique_length, workspace.h_unique_embeddingvectors.data(), i, &workspace.h_hit_rate[i]);
+    } else {
+      parameter_server_ -> look_up(workspace.h_unique_embeddingcolumns.data(), unique_length, workspace.h_unique_embeddingvectors.data(), inference_params_.model_name, i);
+    }
+    decompress_emb_vec_cpu(workspace.h_unique_embeddingvectors.data(), workspace.h_unique_index.data(), h_vals_retrieved_ptr, query_length, inference_parser_.embed_vec_size_for_tables[i]);
     acc_emb_vec_offset += query_length_in_float;
   }
 }
 
 template <typename TypeHashKey>
 void InferenceSessionCPU<TypeHashKey>::predict(float* h_dense, void* h_embeddingcolumns, int *h_row_ptrs, float* h_output, int num_samples) {
-  size_t num_embedding_tables = inference_parser_.num_embedding_tables;
-  if (num_embedding_tables !=  row_ptrs_tensors_.size() || 
-      num_embedding_tables != embedding_features_tensors_.size() ||
-      num_embedding_tables != embedding_feature_combiners_.size()) {
-    CK_THROW_(Error_t::IllegalCall, "embedding feature combiner inconsistent");
+  Workspace* workspace = checkout_workspace_();
+  // split the OpenMP threads between the requests in flight, the setting is per calling thread
+  const int prev_num_threads = omp_get_max_threads();
+  {
+    std::lock_guard<std::mutex> lock(workspace_mutex_);
+    omp_set_num_threads(std::max(1, num_threads_ / static_cast<int>(num_in_flight_)));
   }
+  try {
+    if (num_samples <= 0 || static_cast<size_t>(num_samples) > inference_params_.max_batchsize) {
+      CK_THROW_(Error_t::WrongInput, "num_samples must be in [1, max_batchsize]");
+    }
+    size_t num_embedding_tables = inference_parser_.num_embedding_tables;
+    if (num_embedding_tables !=  workspace->row_ptrs_tensors.size() || 
+        num_embedding_tables != workspace->embedding_features_tensors.size() ||
+        num_embedding_tables != workspace->embedding_feature_combiners.size()) {
+      CK_THROW_(Error_t::IllegalCall, "embedding feature combiner inconsistent");
+    }
+
+    // embedding cache look up and update
+    separate_keys_by_table_(*workspace, h_row_ptrs, embedding_table_slot_size_, num_samples);
+    look_up_(*workspace, h_embeddingcolumns);
 
-  // embedding cache look up and update
-  separate_keys_by_table_(h_row_ptrs, embedding_table_slot_size_, num_samples);
-  look_up_(h_embeddingcolumns, h_embedding_offset_, h_embeddingvectors_);
+    // copy dense input of the samples to dense tensor
+    size_t dense_size = num_samples * inference_parser_.dense_dim;
+    size_t dense_size_in_bytes = dense_size * sizeof(float);
+    memcpy(workspace->dense_input_tensor.get_ptr(), h_dense, dense_size_in_bytes);
 
-  // copy dense input to dense tensor
-  auto dense_dims = dense_input_tensor_.get_dimensions();
-  size_t dense_size = 1;
-  for (auto dim : dense_dims) {
-    dense_size *= dim;
+    // bind row ptrs input to row ptrs tensor 
+    auto row_ptrs_dims = workspace->row_ptrs_tensors[0]->get_dimensions();
+    std::shared_ptr<TensorBuffer2> row_ptrs_buff = PreallocatedBuffer2<int>::create(h_row_ptrs, row_ptrs_dims);
+    bind_tensor_to_buffer(row_ptrs_dims, row_ptrs_buff, workspace->row_ptrs_tensors[0]);
+
+    // bind embedding vectors from looking up to embedding features tensor 
+    auto embedding_features_dims = workspace->embedding_features_tensors[0]->get_dimensions();
+    std::shared_ptr<TensorBuffer2> embeddding_features_buff = PreallocatedBuffer2<float>::create(workspace->h_embeddingvectors.data(), embedding_features_dims);
+    bind_tensor_to_buffer(embedding_features_dims, embeddding_features_buff, workspace->embedding_features_tensors[0]);
+
+    // feature combiner & dense network feedforward, only on the rows of the samples
+    workspace->embedding_feature_combiners[0]->set_active_batch_size(num_samples);
+    workspace->embedding_feature_combiners[0]->fprop(false);
+    workspace->network->predict(num_samples);
+
+    // copy the prediction result of the samples to output
+    float* h_pred = workspace->network->get_pred_tensor().get_ptr();
+    memcpy(h_output, h_pred, num_samples * sizeof(float));
+  } catch (...) {
+    omp_set_num_threads(prev_num_threads);
+    checkin_workspace_(workspace);
+    throw;
   }
-  size_t dense_size_in_bytes = dense_size * sizeof(float);
-  memcpy(dense_input_tensor_.get_ptr(), h_dense, dense_size_in_bytes);
-  
-  // bind row ptrs input to row ptrs tensor 
-  auto row_ptrs_dims = row_ptrs_tensors_[0]->get_dimensions();
-  std::shared_ptr<TensorBuffer2> row_ptrs_buff = PreallocatedBuffer2<int>::create(h_row_ptrs, row_ptrs_dims);
-  bind_tensor_to_buffer(row_ptrs_dims, row_ptrs_buff, row_ptrs_tensors_[0]);
-
-  // bind embedding vectors from looking up to embedding features tensor 
-  auto embedding_features_dims = embedding_features_tensors_[0]->get_dimensions();
-  std::shared_ptr<TensorBuffer2> embeddding_features_buff = PreallocatedBuffer2<float>::create(h_embeddingvectors_, embedding_features_dims);
-  bind_tensor_to_buffer(embedding_features_dims, embeddding_features_buff, embedding_features_tensors_[0]);
-  
-  // feature combiner & dense network feedforward, they are both using resource_manager_->get_local_gpu(0)->get_stream()
-  embedding_feature_combiners_[0]->fprop(false);
-  network_->predict();
-  
-  // copy the prediction result to output
-  float* h_pred = network_->get_pred_tensor().get_ptr();
-  memcpy(h_output, h_pred, inference_params_.max_batchsize*sizeof(float));
+  omp_set_num_threads(prev_num_threads);
+  {
+    std::lock_guard<std::mutex> lock(workspace_mutex_);
+    h_hit_rate_ = workspace->h_hit_rate;
+  }
+  checkin_workspace_(workspace);
+}
+
+template <typename TypeHashKey>
+std::vector<double> InferenceSessionCPU<TypeHashKey>::get_hit_rate() {
+  std::lock_guard<std::mutex> lock(workspace_mutex_);
+  return h_hit_rate_;
 }
 
 template class InferenceSessionCPU<unsigned int>;
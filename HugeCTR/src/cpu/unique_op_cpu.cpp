@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cpu/unique_op_cpu.hpp>
+#include <cstring>
+#include <hashtable/hash_functions.hpp>
+
+namespace HugeCTR {
+
+namespace {
+
+inline size_t num_slots_for(size_t len) {
+  size_t num_slots = 1;
+  while (num_slots < 2 * len) {
+    num_slots <<= 1;
+  }
+  return num_slots;
+}
+
+}  // namespace
+
+template <typename TypeHashKey>
+UniqueOpCPU<TypeHashKey>::UniqueOpCPU(size_t capacity) : capacity_(capacity), epoch_(0) {
+  // Keep the hash table at most half full
+  const size_t num_slots = num_slots_for(capacity_);
+  slot_epochs_.resize(num_slots, 0);
+  slot_keys_.resize(num_slots);
+  slot_index_.resize(num_slots);
+}
+
+template <typename TypeHashKey>
+size_t UniqueOpCPU<TypeHashKey>::unique(const TypeHashKey* h_key, size_t len,
+                                        uint64_t* h_output_index, TypeHashKey* h_unique_key) {
+  if (len > capacity_) {
+    CK_THROW_(Error_t::OutOfBound, "Error: the number of keys exceeds the UniqueOpCPU capacity");
+  }
+  if (++epoch_ == 0) {
+    std::fill(slot_epochs_.begin(), slot_epochs_.end(), 0);
+    epoch_ = 1;
+  }
+  const size_t mask = num_slots_for(len) - 1;
+  size_t num_unique = 0;
+  for (size_t i = 0; i < len; i++) {
+    const TypeHashKey key = h_key[i];
+    size_t pos = murmur_hash3_fmix64(static_cast<uint64_t>(key)) & mask;
+    while (true) {
+      if (slot_epochs_[pos] != epoch_) {
+        slot_epochs_[pos] = epoch_;
+        slot_keys_[pos] = key;
+        slot_index_[pos] = num_unique;
+        h_unique_key[num_unique] = key;
+        h_output_index[i] = num_unique++;
+        break;
+      }
+      if (slot_keys_[pos] == key) {
+        h_output_index[i] = slot_index_[pos];
+        break;
+      }
+      pos = (pos + 1) & mask;
+    }
+  }
+  return num_unique;
+}
+
+void decompress_emb_vec_cpu(const float* h_unique_src, const uint64_t* h_unique_index,
+                            float* h_decompress_dst, size_t len, size_t emb_vec_size) {
+  const size_t emb_vec_size_in_byte = emb_vec_size * sizeof(float);
+  for (size_t i = 0; i < len; i++) {
+    memcpy(h_decompress_dst + i * emb_vec_size, h_unique_src + h_unique_index[i] * emb_vec_size,
+           emb_vec_size_in_byte);
+  }
+}
+
+template class UniqueOpCPU<unsigned int>;
+template class UniqueOpCPU<long long>;
+
+}  // namespace HugeCTR
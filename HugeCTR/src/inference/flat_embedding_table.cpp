@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <experimental/filesystem>
+#include <fstream>
+#include <inference/flat_embedding_table.hpp>
+#include <numeric>
+#include <type_traits>
+
+namespace fs = std::experimental::filesystem;
+
+namespace HugeCTR {
+
+template <typename TypeHashKey>
+flat_embedding_table<TypeHashKey>::flat_embedding_table(size_t embedding_vec_size,
+                                                        float default_emb_vec_value)
+    : embedding_vec_size_(embedding_vec_size),
+      default_emb_vec_value_(default_emb_vec_value),
+      num_keys_(0),
+      num_rows_(0),
+      shard_bits_(0),
+      mask_(0),
+      default_emb_vec_(embedding_vec_size, default_emb_vec_value),
+      values_(nullptr),
+      mapped_values_(nullptr),
+      mapped_size_in_byte_(0) {
+  if (embedding_vec_size_ == 0) {
+    CK_THROW_(Error_t::WrongInput, "Error: embedding_vec_size should be larger than 0");
+  }
+}
+
+template <typename TypeHashKey>
+flat_embedding_table<TypeHashKey>::~flat_embedding_table() {
+  unmap_values_();
+}
+
+template <typename TypeHashKey>
+flat_embedding_table<TypeHashKey>::flat_embedding_table(flat_embedding_table&& other) noexcept
+    : embedding_vec_size_(other.embedding_vec_size_),
+      default_emb_vec_value_(other.default_emb_vec_value_),
+      num_keys_(other.num_keys_),
+      num_rows_(other.num_rows_),
+      shard_bits_(other.shard_bits_),
+      mask_(other.mask_),
+      slots_(std::move(other.slots_)),
+      default_emb_vec_(std::move(other.default_emb_vec_)),
+      values_(other.values_),
+      host_values_(std::move(other.host_values_)),
+      mapped_values_(other.mapped_values_),
+      mapped_size_in_byte_(other.mapped_size_in_byte_) {
+  other.num_keys_ = 0;
+  other.num_rows_ = 0;
+  other.values_ = nullptr;
+  other.mapped_values_ = nullptr;
+  other.mapped_size_in_byte_ = 0;
+}
+
+template <typename TypeHashKey>
+flat_embedding_table<TypeHashKey>& flat_embedding_table<TypeHashKey>::operator=(
+    flat_embedding_table&& other) noexcept {
+  if (this != &other) {
+    unmap_values_();
+    embedding_vec_size_ = other.embedding_vec_size_;
+    default_emb_vec_value_ = other.default_emb_vec_value_;
+    num_keys_ = other.num_keys_;
+    num_rows_ = other.num_rows_;
+    shard_bits_ = other.shard_bits_;
+    mask_ = other.mask_;
+    slots_ = std::move(other.slots_);
+    default_emb_vec_ = std::move(other.default_emb_vec_);
+    values_ = other.values_;
+    host_values_ = std::move(other.host_values_);
+    mapped_values_ = other.mapped_values_;
+    mapped_size_in_byte_ = other.mapped_size_in_byte_;
+    other.num_keys_ = 0;
+    other.num_rows_ = 0;
+    other.values_ = nullptr;
+    other.mapped_values_ = nullptr;
+    other.mapped_size_in_byte_ = 0;
+  }
+  return *this;
+}
+
+template <typename TypeHashKey>
+void flat_embedding_table<TypeHashKey>::load(const TypeHashKey* keys, size_t num_keys,
+                                             std::vector<float>&& vectors, size_t num_threads) {
+  if (vectors.size() != num_keys * embedding_vec_size_) {
+    CK_THROW_(Error_t::WrongInput, "Error: num_key != num_vec in embedding table");
+  }
+  unmap_values_();
+  host_values_ = std::move(vectors);
+  values_ = host_values_.data();
+  num_rows_ = num_keys;
+  build_index_(keys, num_keys, num_threads);
+}
+
+template <typename TypeHashKey>
+void flat_embedding_table<TypeHashKey>::load_mmap(const long long* keys, size_t num_keys,
+                                                  const std::string& vec_file,
+                                                  size_t num_threads) {
+  map_values_(vec_file, num_keys);
+  build_index_(keys, num_keys, num_threads);
+}
+
+template <typename TypeHashKey>
+bool flat_embedding_table<TypeHashKey>::stat_key_file_(const std::string& key_file,
+                                                       index_file_header* header) {
+  struct stat st;
+  if (stat(key_file.c_str(), &st) != 0) {
+    return false;
+  }
+  header->key_file_size = st.st_size;
+  header->key_file_inode = st.st_ino;
+  header->key_file_mtime_ns = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+  header->key_file_ctime_ns = st.st_ctim.tv_sec * 1000000000LL + st.st_ctim.tv_nsec;
+  return true;
+}
+
+template <typename TypeHashKey>
+bool flat_embedding_table<TypeHashKey>::load_mmap_from_index(const std::string& index_file,
+                                                             const std::string& vec_file,
+                                                             const std::string& key_file) {
+  std::ifstream index_stream(index_file, std::ifstream::binary);
+  if (!index_stream.is_open()) {
+    return false;
+  }
+  index_file_header header, key_file_header;
+  index_stream.read(reinterpret_cast<char*>(&header), sizeof(index_file_header));
+  if (!index_stream || !stat_key_file_(key_file, &key_file_header) ||
+      header.key_file_size != key_file_header.key_file_size ||
+      header.key_file_inode != key_file_header.key_file_inode ||
+      header.key_file_mtime_ns != key_file_header.key_file_mtime_ns ||
+      header.key_file_ctime_ns != key_file_header.key_file_ctime_ns ||
+      header.layout_version != INDEX_LAYOUT_VERSION_ ||
+      header.key_size_in_byte != sizeof(TypeHashKey) ||
+      static_cast<size_t>(header.embedding_vec_size) != embedding_vec_size_ ||
+      static_cast<size_t>(header.num_rows) * embedding_vec_size_ * sizeof(float) !=
+          fs::file_size(vec_file) ||
+      header.shard_bits < 0 || header.shard_bits >= 32 || header.shard_capacity <= 0 ||
+      (header.shard_capacity & (header.shard_capacity - 1)) != 0) {
+    return false;
+  }
+  const size_t shard_capacity = static_cast<size_t>(header.shard_capacity);
+  const size_t num_slots = shard_capacity << header.shard_bits;
+  if (sizeof(index_file_header) + num_slots * (sizeof(TypeHashKey) + sizeof(size_t)) !=
+      fs::file_size(index_file)) {
+    return false;
+  }
+
+  std::vector<slot> slots(num_slots);
+  auto read_column = [&](auto member) {
+    std::vector<std::decay_t<decltype(slots[0].*member)>> column(
+        std::min(num_slots, INDEX_STAGING_SLOTS_));
+    for (size_t begin = 0; begin < num_slots; begin += column.size()) {
+      const size_t end = std::min(begin + column.size(), num_slots);
+      index_stream.read(reinterpret_cast<char*>(column.data()),
+                        (end - begin) * sizeof(column[0]));
+      for (size_t i = begin; i < end; i++) {
+        slots[i].*member = column[i - begin];
+      }
+    }
+  };
+  read_column(&slot::key);
+  read_column(&slot::row);
+  if (!index_stream) {
+    return false;
+  }
+  map_values_(vec_file, static_cast<size_t>(header.num_rows));
+  slots_ = std::move(slots);
+  num_keys_ = static_cast<size_t>(header.num_keys);
+  shard_bits_ = static_cast<size_t>(header.shard_bits);
+  mask_ = shard_capacity - 1;
+  return true;
+}
+
+template <typename TypeHashKey>
+void flat_embedding_table<TypeHashKey>::dump_index(const std::string& index_file,
+                                                   const std::string& key_file) const {
+  index_file_header header;
+  memset(&header, 0, sizeof(index_file_header));
+  if (!stat_key_file_(key_file, &header)) {
+    CK_THROW_(Error_t::FileCannotOpen, "Cannot stat the file: " + key_file);
+  }
+  std::ofstream index_stream(index_file, std::ofstream::binary | std::ofstream::trunc);
+  if (!index_stream.is_open()) {
+    CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + index_file);
+  }
+  header.key_size_in_byte = sizeof(TypeHashKey);
+  header.embedding_vec_size = embedding_vec_size_;
+  header.num_rows = num_rows_;
+  header.num_keys = num_keys_;
+  header.shard_bits = shard_bits_;
+  header.shard_capacity = mask_ + 1;
+  header.layout_version = INDEX_LAYOUT_VERSION_;
+  index_stream.write(reinterpret_cast<const char*>(&header), sizeof(index_file_header));
+  auto write_column = [&](auto member) {
+    std::vector<std::decay_t<decltype(slots_[0].*member)>> column(
+        std::min(slots_.size(), INDEX_STAGING_SLOTS_));
+    for (size_t begin = 0; begin < slots_.size(); begin += column.size()) {
+      const size_t end = std::min(begin + column.size(), slots_.size());
+      for (size_t i = begin; i < end; i++) {
+        column[i - begin] = slots_[i].*member;
+      }
+      index_stream.write(reinterpret_cast<const char*>(column.data()),
+                         (end - begin) * sizeof(column[0]));
+    }
+  };
+  write_column(&slot::key);
+  write_column(&slot::row);
+  if (!index_stream) {
+    CK_THROW_(Error_t::BrokenFile, "Error: failed to write the file: " + index_file);
+  }
+}
+
+template <typename TypeHashKey>
+void flat_embedding_table<TypeHashKey>::look_up(const TypeHashKey* h_embeddingcolumns,
+                                                size_t length, float* h_embeddingoutputvector,
+                                                size_t num_threads) const {
+  num_threads = std::max<size_t>(1, std::min(num_threads, length / MIN_QUERIES_PER_THREAD_));
+  if (num_threads == 1) {
+    look_up_chunk_(h_embeddingcolumns, length, h_embeddingoutputvector);
+    return;
+  }
+
+  #pragma omp parallel num_threads(num_threads)
+  {
+    const size_t tid = omp_get_thread_num();
+    const size_t thread_num = omp_get_num_threads();
+    size_t sub_chunk_size = length / thread_num;
+    size_t res_chunk_size = length % thread_num;
+    const size_t idx = tid * sub_chunk_size;
+
+    if (tid == thread_num - 1) sub_chunk_size += res_chunk_size;
+
+    look_up_chunk_(h_embeddingcolumns + idx, sub_chunk_size,
+                   h_embeddingoutputvector + idx * embedding_vec_size_);
+  }
+}
+
+template <typename TypeHashKey>
+void flat_embedding_table<TypeHashKey>::look_up_chunk_(const TypeHashKey* h_embeddingcolumns,
+                                                       size_t length,
+                                                       float* h_embeddingoutputvector) const {
+  const size_t emb_vec_size_in_byte = sizeof(float) * embedding_vec_size_;
+  const size_t cache_line_size_in_float = 64 / sizeof(float);
+  size_t hashes[PREFETCH_BLOCK_SIZE_];
+  const float* srcs[PREFETCH_BLOCK_SIZE_];
+
+  // Each key costs a random access to its slot and another one to its row. Issue all the slot
+  // accesses of a block before probing any of them, then all the row accesses before copying,
+  // so that the cache misses of a block overlap instead of being served one after another.
+  for (size_t base = 0; base < length; base += PREFETCH_BLOCK_SIZE_) {
+    const size_t block_size = std::min(PREFETCH_BLOCK_SIZE_, length - base);
+    const TypeHashKey* keys = h_embeddingcolumns + base;
+
+    for (size_t i = 0; i < block_size; i++) {
+      hashes[i] = hash_(keys[i]);
+      if (num_keys_ != 0) {
+        __builtin_prefetch(slots_.data() + shard_of_(hashes[i]) * (mask_ + 1) +
+                           (hashes[i] & mask_));
+      }
+    }
+    for (size_t i = 0; i < block_size; i++) {
+      srcs[i] = find_(keys[i], hashes[i]);
+      if (srcs[i] != nullptr) {
+        for (size_t j = 0; j < embedding_vec_size_; j += cache_line_size_in_float) {
+          __builtin_prefetch(srcs[i] + j);
+        }
+      } else {
+        srcs[i] = default_emb_vec_.data();
+      }
+    }
+    for (size_t i = 0; i < block_size; i++) {
+      memcpy(h_embeddingoutputvector + (base + i) * embedding_vec_size_, srcs[i],
+             emb_vec_size_in_byte);
+    }
+  }
+}
+
+template <typename TypeHashKey>
+size_t flat_embedding_table<TypeHashKey>::memory_footprint_in_byte() const {
+  return slots_.capacity() * sizeof(slot) + host_values_.capacity() * sizeof(float);
+}
+
+template <typename TypeHashKey>
+template <typename TypeFileKey>
+void flat_embedding_table<TypeHashKey>::build_index_(const TypeFileKey* keys, size_t num_keys,
+                                                     size_t num_threads) {
+  num_threads = std::max<size_t>(1, std::min(num_threads, num_keys / MIN_KEYS_PER_THREAD_));
+  shard_bits_ = 0;
+  while ((size_t(1) << shard_bits_) < num_threads) {
+    shard_bits_++;
+  }
+  const size_t num_shards = size_t(1) << shard_bits_;
+
+  // The keys are split into num_threads chunks, numbered independently of the OpenMP team which
+  // may have fewer threads, so that both passes below see the same chunks
+  auto chunk_begin = [num_keys, num_threads](size_t chunk) {
+    return num_keys / num_threads * chunk;
+  };
+  auto chunk_end = [num_keys, num_threads, &chunk_begin](size_t chunk) {
+    return chunk == num_threads - 1 ? num_keys : chunk_begin(chunk + 1);
+  };
+
+  // Count the keys falling into each shard, per chunk
+  std::vector<std::vector<size_t>> shard_offsets(num_threads, std::vector<size_t>(num_shards, 0));
+  #pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+  for (size_t chunk = 0; chunk < num_threads; chunk++) {
+    for (size_t i = chunk_begin(chunk); i < chunk_end(chunk); i++) {
+      shard_offsets[chunk][shard_of_(hash_(static_cast<TypeHashKey>(keys[i])))]++;
+    }
+  }
+
+  // Turn the counts into the write offsets of each chunk in the shard-ordered staging buffer,
+  // keeping rows in file order within a shard so that the first row of a duplicate key wins
+  std::vector<size_t> shard_begin(num_shards + 1, 0);
+  for (size_t s = 0; s < num_shards; s++) {
+    size_t offset = shard_begin[s];
+    for (size_t c = 0; c < num_threads; c++) {
+      const size_t count = shard_offsets[c][s];
+      shard_offsets[c][s] = offset;
+      offset += count;
+    }
+    shard_begin[s + 1] = offset;
+  }
+  size_t max_shard_size = 0;
+  for (size_t s = 0; s < num_shards; s++) {
+    max_shard_size = std::max(max_shard_size, shard_begin[s + 1] - shard_begin[s]);
+  }
+
+  std::vector<slot> staging(num_keys);
+  #pragma omp parallel for num_threads(num_threads) schedule(static, 1)
+  for (size_t chunk = 0; chunk < num_threads; chunk++) {
+    for (size_t i = chunk_begin(chunk); i < chunk_end(chunk); i++) {
+      const TypeHashKey key = static_cast<TypeHashKey>(keys[i]);
+      staging[shard_offsets[chunk][shard_of_(hash_(key))]++] = slot{key, i};
+    }
+  }
+
+  // Power-of-2 shard capacity so that the probe sequence can wrap around with a mask
+  size_t shard_capacity = 1;
+  while (static_cast<double>(shard_capacity) * MAX_LOAD_FACTOR_ <
+         static_cast<double>(max_shard_size)) {
+    shard_capacity <<= 1;
+  }
+  mask_ = shard_capacity - 1;
+  slots_.assign(num_shards * shard_capacity, slot{TypeHashKey(), EMPTY_ROW_});
+
+  // Every shard is filled by exactly one thread
+  std::vector<size_t> shard_num_keys(num_shards, 0);
+  #pragma omp parallel for num_threads(num_threads)
+  for (size_t s = 0; s < num_shards; s++) {
+    slot* shard = slots_.data() + s * shard_capacity;
+    for (size_t i = shard_begin[s]; i < shard_begin[s + 1]; i++) {
+      size_t pos = hash_(staging[i].key) & mask_;
+      while (shard[pos].row != EMPTY_ROW_ && shard[pos].key != staging[i].key) {
+        pos = (pos + 1) & mask_;
+      }
+      if (shard[pos].row == EMPTY_ROW_) {
+        shard[pos] = staging[i];
+        shard_num_keys[s]++;
+      }
+    }
+  }
+  num_keys_ = std::accumulate(shard_num_keys.begin(), shard_num_keys.end(), size_t(0));
+}
+
+template <typename TypeHashKey>
+void flat_embedding_table<TypeHashKey>::map_values_(const std::string& vec_file,
+                                                    size_t num_rows) {
+  unmap_values_();
+  host_values_.clear();
+  host_values_.shrink_to_fit();
+  values_ = nullptr;
+  num_rows_ = num_rows;
+
+  const size_t vec_file_size_in_byte = fs::file_size(vec_file);
+  if (vec_file_size_in_byte != num_rows * embedding_vec_size_ * sizeof(float)) {
+    CK_THROW_(Error_t::WrongInput, "Error: num_key != num_vec in embedding file");
+  }
+  if (vec_file_size_in_byte == 0) {
+    return;
+  }
+
+  int fd = open(vec_file.c_str(), O_RDONLY);
+  if (fd == -1) {
+    CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + vec_file);
+  }
+  void* mapped = mmap(NULL, vec_file_size_in_byte, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    CK_THROW_(Error_t::WrongInput, "Mmap file " + vec_file + " failed");
+  }
+  // Rows are fetched in key order, readahead around a row would mostly be wasted
+  madvise(mapped, vec_file_size_in_byte, MADV_RANDOM);
+
+  mapped_values_ = mapped;
+  mapped_size_in_byte_ = vec_file_size_in_byte;
+  values_ = static_cast<const float*>(mapped);
+}
+
+template <typename TypeHashKey>
+void flat_embedding_table<TypeHashKey>::unmap_values_() {
+  if (mapped_values_ != nullptr) {
+    munmap(mapped_values_, mapped_size_in_byte_);
+    mapped_values_ = nullptr;
+    mapped_size_in_byte_ = 0;
+    values_ = nullptr;
+  }
+}
+
+template class flat_embedding_table<unsigned int>;
+template class flat_embedding_table<long long>;
+}  // namespace HugeCTR
@@ -15,7 +15,9 @@
  */
 
 #include <inference/parameter_server.hpp>
+#include <sys/stat.h>
 #include <experimental/filesystem>
+#include <thread>
 
 namespace fs = std::experimental::filesystem;
 
@@ -23,6 +25,22 @@ namespace HugeCTR {
 
 parameter_server_base::~parameter_server_base() {}
 
+namespace {
+
+// The key index of key_file in cache_dir is named after the device and inode of key_file, so that
+// the sparse models of several folders share the cache dir without colliding. Empty without a
+// cache dir.
+std::string cached_index_file(const std::string& cache_dir, const std::string& key_file) {
+  struct stat key_file_stat;
+  if (cache_dir.empty() || stat(key_file.c_str(), &key_file_stat) != 0) {
+    return std::string();
+  }
+  return cache_dir + "/" + std::to_string(key_file_stat.st_dev) + "_" +
+         std::to_string(key_file_stat.st_ino) + ".key_index";
+}
+
+}  // namespace
+
 template <typename TypeHashKey>
 parameter_server<TypeHashKey>::parameter_server(const std::string& framework_name, 
                                               const std::vector<std::string>& model_config_path,
@@ -83,24 +101,36 @@ parameter_server<TypeHashKey>::parameter_server(const std::string& framework_nam
     ps_config_.embedding_vec_size_.emplace_back(embedding_vec_size);
     ps_config_.default_emb_vec_value_.emplace_back(default_emb_vec_value);
 
+    // By default a look_up takes at most a quarter of the cores, so that the concurrent requests
+    // of the sessions sharing this parameter server do not oversubscribe the host
+    size_t num_look_up_threads = inference_params_array[i].num_look_up_threads;
+    if (num_look_up_threads == 0) {
+      num_look_up_threads = std::max<size_t>(1, std::thread::hardware_concurrency() / 4);
+    }
+    ps_config_.num_look_up_threads_.emplace_back(num_look_up_threads);
   }
 
   if(ps_config_.distributed_emb_.size() != model_config_path.size() ||
      ps_config_.embedding_vec_size_.size() != model_config_path.size() ||
-     ps_config_.default_emb_vec_value_.size() != model_config_path.size()){
+     ps_config_.default_emb_vec_value_.size() != model_config_path.size() ||
+     ps_config_.num_look_up_threads_.size() != model_config_path.size()){
     CK_THROW_(Error_t::WrongInput, "Wrong input: The size of parameter server parameters are not correct.");
   }
 
   // Load embeddings for each embedding table from each model
+  const size_t num_threads = std::thread::hardware_concurrency();
   for(unsigned int i = 0; i < model_config_path.size(); i++){
     size_t num_emb_table = (ps_config_.emb_file_name_[i]).size();
     // Temp vector of embedding table for this model
-    std::vector<std::unordered_map<TypeHashKey, std::vector<float>>> model_emb_table;
+    std::vector<flat_embedding_table<TypeHashKey>> model_emb_table;
     for(unsigned int j = 0; j < num_emb_table; j++){
+      Timer timer_load;
+      timer_load.start();
       // Create input file stream to read the embedding file
       const std::string emb_file_prefix = ps_config_.emb_file_name_[i][j] + "/";
       const std::string key_file = emb_file_prefix + "key";
       const std::string vec_file = emb_file_prefix + "emb_vector";
+      const std::string index_file = emb_file_prefix + "key_index";
       std::ifstream key_stream(key_file);
       std::ifstream vec_stream(vec_file);
       // Check if file is opened successfully
@@ -120,33 +150,61 @@ parameter_server<TypeHashKey>::parameter_server(const std::string& framework_nam
       }
       size_t num_float_val_in_vec_file = vec_file_size_in_byte / sizeof(float);
 
-      // The temp embedding table
-      std::vector<TypeHashKey> key_vec(num_key, 0);
-      if (std::is_same<TypeHashKey, long long>::value) {
-        key_stream.read(reinterpret_cast<char *>(key_vec.data()), key_file_size_in_byte);
+      flat_embedding_table<TypeHashKey> emb_table(ps_config_.embedding_vec_size_[i][j],
+                                                  ps_config_.default_emb_vec_value_[i][j]);
+      if (inference_params_array[i].use_mmap_sparse_model) {
+        // Serve emb_vec straight from the emb_vector file, only the key index lives in host memory.
+        // Reuse a key index dumped along with the model or persisted in the index cache dir, unless
+        // it was built from another key file. Loading never writes into the sparse model folder.
+        const std::string cache_dir = inference_params_array[i].sparse_model_index_cache_dir;
+        const std::string cached_index = cached_index_file(cache_dir, key_file);
+        bool index_loaded = false;
+        if (fs::exists(index_file)) {
+          index_loaded = emb_table.load_mmap_from_index(index_file, vec_file, key_file);
+        }
+        if (!index_loaded && !cached_index.empty() && fs::exists(cached_index)) {
+          index_loaded = emb_table.load_mmap_from_index(cached_index, vec_file, key_file);
+        }
+        if (!index_loaded) {
+          std::vector<long long> i64_key_vec(num_key, 0);
+          key_stream.read(reinterpret_cast<char *>(i64_key_vec.data()), key_file_size_in_byte);
+          emb_table.load_mmap(i64_key_vec.data(), num_key, vec_file, num_threads);
+          if (!cached_index.empty()) {
+            try {
+              fs::create_directories(cache_dir);
+              emb_table.dump_index(cached_index, key_file);
+            } catch (const std::exception&) {
+              MESSAGE_("Cannot persist the key index of " + ps_config_.emb_file_name_[i][j] + " in " + cache_dir + ", it will be rebuilt on the next load");
+            }
+          }
+        }
       } else {
-        std::vector<long long> i64_key_vec(num_key, 0);
-        key_stream.read(reinterpret_cast<char *>(i64_key_vec.data()), key_file_size_in_byte);
-        std::transform(i64_key_vec.begin(), i64_key_vec.end(), key_vec.begin(),
-                       [](long long key) { return static_cast<unsigned>(key); });
-      }
-
-      std::vector<float> vec_vec(num_float_val_in_vec_file, 0.0f);
-      vec_stream.read(reinterpret_cast<char *>(vec_vec.data()), vec_file_size_in_byte);
-
-      std::unordered_map<TypeHashKey, std::vector<float>> emb_table;
-      emb_table.reserve(num_key);
-      const size_t emb_vec_size = ps_config_.embedding_vec_size_[i][j];
-      for (size_t i = 0; i < num_key; i++) {
-        emb_table.emplace(key_vec[i],
-                          std::vector<float>(vec_vec.begin() + i     * emb_vec_size,
-                                             vec_vec.begin() + (i+1) * emb_vec_size));
+        // The temp embedding table
+        std::vector<TypeHashKey> key_vec(num_key, 0);
+        if (std::is_same<TypeHashKey, long long>::value) {
+          key_stream.read(reinterpret_cast<char *>(key_vec.data()), key_file_size_in_byte);
+        } else {
+          std::vector<long long> i64_key_vec(num_key, 0);
+          key_stream.read(reinterpret_cast<char *>(i64_key_vec.data()), key_file_size_in_byte);
+          std::transform(i64_key_vec.begin(), i64_key_vec.end(), key_vec.begin(),
+                         [](long long key) { return static_cast<unsigned>(key); });
+        }
+
+        // Read the emb_vec file straight into the value arena of the table
+        std::vector<float> vec_vec(num_float_val_in_vec_file, 0.0f);
+        vec_stream.read(reinterpret_cast<char *>(vec_vec.data()), vec_file_size_in_byte);
+        emb_table.load(key_vec.data(), num_key, std::move(vec_vec), num_threads);
       }
+      timer_load.stop();
+      MESSAGE_("Load " + std::to_string(emb_table.size()) + " keys from " + ps_config_.emb_file_name_[i][j] +
+               (emb_table.is_mapped() ? " (mmap)" : "") + ", host memory: " +
+               std::to_string(emb_table.memory_footprint_in_byte() / (1024 * 1024)) + " MB, time: " +
+               std::to_string(timer_load.elapsedSeconds()) + "s");
       // Insert temp embedding table into temp model embedding table
-      model_emb_table.emplace_back(emb_table);
+      model_emb_table.emplace_back(std::move(emb_table));
     }
     // Insert temp model embedding table into parameter server
-    cpu_embedding_table_.emplace_back(model_emb_table);
+    cpu_embedding_table_.emplace_back(std::move(model_emb_table));
   }
 }
 
@@ -169,23 +227,10 @@ void parameter_server<TypeHashKey>::look_up(const TypeHashKey* h_embeddingcolumn
     CK_THROW_(Error_t::WrongInput, "Error: parameter server unknown model name. Note that this error will also come out with using Triton LOAD/UNLOAD APIs which haven't been supported in HugeCTR backend.");
   }
 
-  // Search for the embedding ids in the corresponding embedding table
-  for(size_t i = 0; i < length; i++){
-    // Look-up the id in the table
-    auto result = cpu_embedding_table_[model_id][embedding_table_id].find(h_embeddingcolumns[i]);
-    // Check if the key is existed in embedding table
-    if(result != cpu_embedding_table_[model_id][embedding_table_id].end()){
-      // Find the embedding id
-      size_t emb_vec_offset = i * ps_config_.embedding_vec_size_[model_id][embedding_table_id];
-      memcpy(h_embeddingoutputvector + emb_vec_offset, (result -> second).data(), sizeof(float) * ps_config_.embedding_vec_size_[model_id][embedding_table_id]);
-    }
-    else{
-      // Cannot find the embedding id
-      size_t emb_vec_offset = i * ps_config_.embedding_vec_size_[model_id][embedding_table_id];
-      std::vector<float> default_emb_vec(ps_config_.embedding_vec_size_[model_id][embedding_table_id], ps_config_.default_emb_vec_value_[model_id][embedding_table_id]);
-      memcpy(h_embeddingoutputvector + emb_vec_offset, default_emb_vec.data(), sizeof(float) * ps_config_.embedding_vec_size_[model_id][embedding_table_id]);
-    }
-  }
+  // Search for the embedding ids in the corresponding embedding table, large batches are split across
+  // up to num_look_up_threads threads of the model
+  cpu_embedding_table_[model_id][embedding_table_id].look_up(h_embeddingcolumns, length, h_embeddingoutputvector,
+                                                             ps_config_.num_look_up_threads_[model_id]);
 }
 
 template class parameter_server<unsigned int>;
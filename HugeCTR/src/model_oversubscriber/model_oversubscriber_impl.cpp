@@ -15,6 +15,11 @@
  */
 
 #include "HugeCTR/include/model_oversubscriber/model_oversubscriber_impl.hpp"
+#include <hashtable/hash_functions.hpp>
+#include <utils.hpp>
+#include <omp.h>
+#include <execution>
+#include <numeric>
 #include <string>
 
 namespace HugeCTR {
@@ -29,6 +34,45 @@ std::vector<Embedding_t> get_embedding_type(
   return embedding_types;
 }
 
+// A row whose fingerprint matches the one it was pulled with is not written back, so the hash must
+// be a defined 64-bit one rather than the implementation-defined std::hash
+uint64_t get_fingerprint(const float *vec, size_t emb_vec_size) {
+  return murmur_hash64a(vec, emb_vec_size * sizeof(float));
+}
+
+void get_fingerprints(BufferBag& buf_bag, size_t num, size_t emb_vec_size,
+                      std::vector<uint64_t>& fingerprints) {
+  const float *vec_ptr = buf_bag.embedding.get_ptr();
+  fingerprints.resize(num);
+  #pragma omp parallel for
+  for (size_t row = 0; row < num; row++) {
+    fingerprints[row] = get_fingerprint(vec_ptr + row * emb_vec_size, emb_vec_size);
+  }
+}
+
+/**
+ * Copy the rows src_rows of src to the rows from dst_offset on of dst.
+ */
+template <typename TypeKey>
+void copy_rows(BufferBag& src, const std::vector<size_t>& src_rows, BufferBag& dst,
+               size_t dst_offset, size_t emb_vec_size, bool copy_slot_id) {
+  const TypeKey *src_key_ptr = Tensor2<TypeKey>::stretch_from(src.keys).get_ptr();
+  const size_t *src_slot_id_ptr = Tensor2<size_t>::stretch_from(src.slot_id).get_ptr();
+  const float *src_vec_ptr = src.embedding.get_ptr();
+  TypeKey *dst_key_ptr = Tensor2<TypeKey>::stretch_from(dst.keys).get_ptr() + dst_offset;
+  size_t *dst_slot_id_ptr = Tensor2<size_t>::stretch_from(dst.slot_id).get_ptr() + dst_offset;
+  float *dst_vec_ptr = dst.embedding.get_ptr() + dst_offset * emb_vec_size;
+
+  #pragma omp parallel for
+  for (size_t i = 0; i < src_rows.size(); i++) {
+    const size_t row = src_rows[i];
+    dst_key_ptr[i] = src_key_ptr[row];
+    if (copy_slot_id) dst_slot_id_ptr[i] = src_slot_id_ptr[row];
+    memcpy(dst_vec_ptr + i * emb_vec_size, src_vec_ptr + row * emb_vec_size,
+           emb_vec_size * sizeof(float));
+  }
+}
+
 }
 
 template <typename TypeKey>
@@ -36,11 +80,44 @@ ModelOversubscriberImpl<TypeKey>::ModelOversubscriberImpl(bool use_host_ps,
     std::vector<std::shared_ptr<IEmbedding>>& embeddings,
     const std::vector<SparseEmbeddingHashParams>& embedding_params,
     const std::vector<std::string>& sparse_embedding_files,
-    std::shared_ptr<ResourceManager> resource_manager)
+    std::shared_ptr<ResourceManager> resource_manager,
+    bool use_log_structured_store)
     : embeddings_(embeddings),
       ps_manager_(use_host_ps, sparse_embedding_files,
                   get_embedding_type(embeddings), embedding_params,
-                  get_max_embedding_size_(), resource_manager) {}
+                  get_max_embedding_size_(), resource_manager,
+                  use_log_structured_store),
+#ifdef ENABLE_MPI
+      // the SparseModelFile synchronizes the processes when it is written
+      async_write_back_(use_host_ps || use_log_structured_store),
+#else
+      async_write_back_(true),
+#endif
+      pulled_keys_(embeddings.size()),
+      pulled_fingerprints_(embeddings.size()) {}
+
+template <typename TypeKey>
+ModelOversubscriberImpl<TypeKey>::~ModelOversubscriberImpl() {
+  try {
+    wait_for_background_();
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+  }
+}
+
+template <typename TypeKey>
+void ModelOversubscriberImpl<TypeKey>::run_in_background_(std::function<void()> task) {
+  background_task_ = std::async(std::launch::async,
+      [prev_task = std::move(background_task_), task = std::move(task)]() mutable {
+        if (prev_task.valid()) prev_task.get();
+        task();
+      });
+}
+
+template <typename TypeKey>
+void ModelOversubscriberImpl<TypeKey>::wait_for_background_() {
+  if (background_task_.valid()) background_task_.get();
+}
 
 template <typename TypeKey>
 void ModelOversubscriberImpl<TypeKey>::load_(
@@ -57,6 +134,10 @@ void ModelOversubscriberImpl<TypeKey>::load_(
 
       size_t hit_size = 0;
       ptr_ps->pull(ps_manager_.get_buffer_bag(), hit_size);
+      std::vector<uint64_t> fingerprints;
+      get_fingerprints(ps_manager_.get_buffer_bag(), hit_size,
+                       embeddings_[i]->get_embedding_params().embedding_vec_size, fingerprints);
+      set_pulled_(i, ps_manager_.get_buffer_bag(), hit_size, fingerprints);
       embeddings_[i]->load_parameters(ps_manager_.get_buffer_bag(), hit_size);
     }
   } catch (const internal_runtime_error& rt_err) {
@@ -69,18 +150,183 @@ void ModelOversubscriberImpl<TypeKey>::load_(
 }
 
 template <typename TypeKey>
-void ModelOversubscriberImpl<TypeKey>::dump() {
-  try {
-    for (size_t i = 0; i < embeddings_.size(); i++) {
-      auto ptr_ps = ps_manager_.get_parameter_server(i);
+void ModelOversubscriberImpl<TypeKey>::switch_to_prefetched_() {
+  BufferBag& buf_bag = ps_manager_.get_buffer_bag();
+  for (size_t i = 0; i < embeddings_.size(); i++) {
+    auto ptr_ps = ps_manager_.get_parameter_server(i);
+    BufferBag& staging_buf_bag = ps_manager_.get_staging_buffer_bag(i);
+    const size_t emb_vec_size = embeddings_[i]->get_embedding_params().embedding_vec_size;
+    const bool is_distributed = embeddings_[i]->get_embedding_type() ==
+                                Embedding_t::DistributedSlotSparseEmbeddingHash;
+
+    size_t dump_size = 0;
+    embeddings_[i]->dump_parameters(buf_bag, &dump_size);
+    embeddings_[i]->reset();
+    std::vector<uint64_t> fingerprints;
+    std::vector<char> is_dirty;
+    find_dirty_rows_(i, buf_bag, dump_size, fingerprints, is_dirty);
+
+    // the keys trained in this pass are either kept for the next one, and then their vectors
+    // on devices replace the prefetched ones, or evicted
+    const auto& keyset = ptr_ps->get_keyset();
+    const size_t hit_size = prefetched_hit_sizes_[i];
+    // the vectors are pulled in the order of the sorted keyset
+    const TypeKey *prefetched_keys =
+        Tensor2<TypeKey>::stretch_from(staging_buf_bag.keys).get_ptr();
+    const TypeKey *dumped_keys = Tensor2<TypeKey>::stretch_from(buf_bag.keys).get_ptr();
+    const int64_t evicted = -1, appended = -2;
+    std::vector<int64_t> dst_rows(dump_size);
+    #pragma omp parallel for
+    for (size_t row = 0; row < dump_size; row++) {
+      const TypeKey key = dumped_keys[row];
+      if (!std::binary_search(keyset.begin(), keyset.end(), key)) {
+        dst_rows[row] = evicted;
+        continue;
+      }
+      auto it = std::lower_bound(prefetched_keys, prefetched_keys + hit_size, key);
+      dst_rows[row] = (it != prefetched_keys + hit_size && *it == key) ?
+                      it - prefetched_keys : appended;
+    }
+
+    // the evicted keys are pushed if they were changed on the devices
+    std::vector<size_t> evicted_rows, replaced_rows, appended_rows;
+    size_t num_evicted = 0;
+    for (size_t row = 0; row < dump_size; row++) {
+      if (dst_rows[row] == evicted) {
+        num_evicted++;
+        if (is_dirty[row]) evicted_rows.push_back(row);
+      } else if (dst_rows[row] == appended) {
+        appended_rows.push_back(row);
+      } else {
+        replaced_rows.push_back(row);
+      }
+    }
+    const size_t load_size = hit_size + appended_rows.size();
+    if (load_size > staging_buf_bag.embedding.get_dimensions()[0]) {
+      CK_THROW_(Error_t::OutOfBound, "the keys of the next pass exceed the staging buffer");
+    }
+
+    #pragma omp parallel for
+    for (size_t j = 0; j < replaced_rows.size(); j++) {
+      const size_t row = replaced_rows[j];
+      const size_t dst_row = dst_rows[row];
+      if (!is_distributed) {
+        Tensor2<size_t>::stretch_from(staging_buf_bag.slot_id).get_ptr()[dst_row] =
+            Tensor2<size_t>::stretch_from(buf_bag.slot_id).get_ptr()[row];
+      }
+      memcpy(staging_buf_bag.embedding.get_ptr() + dst_row * emb_vec_size,
+             buf_bag.embedding.get_ptr() + row * emb_vec_size, emb_vec_size * sizeof(float));
+    }
+    copy_rows<TypeKey>(buf_bag, appended_rows, staging_buf_bag, hit_size, emb_vec_size,
+                       !is_distributed);
+    embeddings_[i]->load_parameters(staging_buf_bag, load_size);
+    // the kept keys are pulled with the vectors prefetched from the sparse model, the appended
+    // ones are new
+    set_pulled_(i, staging_buf_bag, hit_size, prefetched_fingerprints_[i]);
+
+    // the staging buffer bag is free once loaded, and holds the evicted keys to be pushed
+    copy_rows<TypeKey>(buf_bag, evicted_rows, staging_buf_bag, 0, emb_vec_size,
+                       !is_distributed);
+    const size_t num_pushed = evicted_rows.size();
+    num_dumped_ += num_evicted;
+    num_pushed_ += num_pushed;
+    if (async_write_back_) {
+      run_in_background_([ptr_ps, &staging_buf_bag, num_pushed]() {
+        ptr_ps->push(staging_buf_bag, num_pushed);
+      });
+    } else {
+      ptr_ps->push(staging_buf_bag, num_pushed);
+    }
+  }
+}
+
+template <typename TypeKey>
+void ModelOversubscriberImpl<TypeKey>::find_dirty_rows_(size_t i, BufferBag& buf_bag,
+    size_t num, std::vector<uint64_t>& fingerprints, std::vector<char>& is_dirty) {
+  get_fingerprints(buf_bag, num, embeddings_[i]->get_embedding_params().embedding_vec_size,
+                   fingerprints);
+  const TypeKey *key_ptr = Tensor2<TypeKey>::stretch_from(buf_bag.keys).get_ptr();
+  const auto& pulled_keys = pulled_keys_[i];
+  const auto& pulled_fingerprints = pulled_fingerprints_[i];
+  is_dirty.resize(num);
+  #pragma omp parallel for
+  for (size_t row = 0; row < num; row++) {
+    auto it = std::lower_bound(pulled_keys.begin(), pulled_keys.end(), key_ptr[row]);
+    is_dirty[row] = it == pulled_keys.end() || *it != key_ptr[row] ||
+                    pulled_fingerprints[it - pulled_keys.begin()] != fingerprints[row];
+  }
+}
+
+template <typename TypeKey>
+void ModelOversubscriberImpl<TypeKey>::set_pulled_(size_t i, BufferBag& buf_bag, size_t num,
+    const std::vector<uint64_t>& fingerprints) {
+  const TypeKey *key_ptr = Tensor2<TypeKey>::stretch_from(buf_bag.keys).get_ptr();
+  auto& pulled_keys = pulled_keys_[i];
+  auto& pulled_fingerprints = pulled_fingerprints_[i];
+  pulled_keys.assign(key_ptr, key_ptr + num);
+  pulled_fingerprints.assign(fingerprints.begin(), fingerprints.begin() + num);
+  if (std::is_sorted(pulled_keys.begin(), pulled_keys.end())) return;
+
+  std::vector<size_t> order(num);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(std::execution::par, order.begin(), order.end(),
+            [key_ptr](size_t a, size_t b) { return key_ptr[a] < key_ptr[b]; });
+  #pragma omp parallel for
+  for (size_t j = 0; j < num; j++) {
+    pulled_keys[j] = key_ptr[order[j]];
+    pulled_fingerprints[j] = fingerprints[order[j]];
+  }
+}
+
+template <typename TypeKey>
+void ModelOversubscriberImpl<TypeKey>::dump_() {
+  BufferBag& buf_bag = ps_manager_.get_buffer_bag();
+  for (size_t i = 0; i < embeddings_.size(); i++) {
+    auto ptr_ps = ps_manager_.get_parameter_server(i);
+    const size_t emb_vec_size = embeddings_[i]->get_embedding_params().embedding_vec_size;
+    const bool is_distributed = embeddings_[i]->get_embedding_type() ==
+                                Embedding_t::DistributedSlotSparseEmbeddingHash;
+
+    size_t dump_size = 0;
+    embeddings_[i]->dump_parameters(buf_bag, &dump_size);
+    std::vector<uint64_t> fingerprints;
+    std::vector<char> is_dirty;
+    find_dirty_rows_(i, buf_bag, dump_size, fingerprints, is_dirty);
+    // the sparse model holds all of them once pushed
+    set_pulled_(i, buf_bag, dump_size, fingerprints);
 
-      size_t dump_size = 0;
-      embeddings_[i]->dump_parameters(ps_manager_.get_buffer_bag(), &dump_size);
-      ptr_ps->push(ps_manager_.get_buffer_bag(), dump_size);
+    // move the dirty rows to the front
+    TypeKey *key_ptr = Tensor2<TypeKey>::stretch_from(buf_bag.keys).get_ptr();
+    size_t *slot_id_ptr = Tensor2<size_t>::stretch_from(buf_bag.slot_id).get_ptr();
+    float *vec_ptr = buf_bag.embedding.get_ptr();
+    size_t num_dirty = 0;
+    for (size_t row = 0; row < dump_size; row++) {
+      if (!is_dirty[row]) continue;
+      if (row != num_dirty) {
+        key_ptr[num_dirty] = key_ptr[row];
+        if (!is_distributed) slot_id_ptr[num_dirty] = slot_id_ptr[row];
+        memcpy(vec_ptr + num_dirty * emb_vec_size, vec_ptr + row * emb_vec_size,
+               emb_vec_size * sizeof(float));
+      }
+      num_dirty++;
     }
+    num_dumped_ += dump_size;
+    num_pushed_ += num_dirty;
+    ptr_ps->push(buf_bag, num_dirty);
+  }
 #ifdef ENABLE_MPI
-    CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
+  CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
 #endif
+}
+
+template <typename TypeKey>
+void ModelOversubscriberImpl<TypeKey>::dump() {
+  try {
+    wait_for_background_();
+    num_dumped_ = num_pushed_ = 0;
+    dump_();
+    MESSAGE_("Pushed " + std::to_string(num_pushed_) + " of " + std::to_string(num_dumped_) +
+             " vectors dumped from the devices, the others are unchanged");
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
     throw rt_err;
@@ -97,16 +343,36 @@ void ModelOversubscriberImpl<TypeKey>::update(
 #ifndef KEY_HIT_RATIO
     MESSAGE_("Preparing embedding table for next pass", false, false);
 #endif
-    dump();
-    for (auto& one_embedding : embeddings_) {
-      one_embedding->reset();
+    Timer timer;
+    timer.start();
+    const bool is_prefetched = !prefetched_keyset_file_list_.empty() &&
+                               prefetched_keyset_file_list_ == keyset_file_list;
+    prefetched_keyset_file_list_.clear();
+    wait_for_background_();
+    const double wait_seconds = timer.elapsedSeconds();
+    num_dumped_ = num_pushed_ = 0;
+    if (is_prefetched) {
+      switch_to_prefetched_();
+    } else {
+      dump_();
+      for (auto& one_embedding : embeddings_) {
+        one_embedding->reset();
+      }
+      load_(keyset_file_list);
     }
-    load_(keyset_file_list);
 #ifdef ENABLE_MPI
     CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
 #endif
+    timer.stop();
 #ifndef KEY_HIT_RATIO
-    MESSAGE_(" [DONE]", false, true, false);
+    MESSAGE_(" [DONE] in " + std::to_string(timer.elapsedSeconds()) + "s", false, true, false);
+    if (is_prefetched) {
+      MESSAGE_("Prefetched embedding table in " + std::to_string(prefetch_seconds_) +
+               "s in the background, waited " + std::to_string(wait_seconds) + "s for it");
+    }
+    MESSAGE_("Pushed " + std::to_string(num_pushed_) + " of " + std::to_string(num_dumped_) +
+             (is_prefetched ? " evicted" : "") +
+             " vectors dumped from the devices, the others are unchanged");
 #endif
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
@@ -124,6 +390,57 @@ void ModelOversubscriberImpl<TypeKey>::update(
   update(keyset_file_list);
 }
 
+template <typename TypeKey>
+void ModelOversubscriberImpl<TypeKey>::prefetch(
+    std::vector<std::string>& keyset_file_list) {
+  try {
+    if (keyset_file_list.size() != embeddings_.size()) {
+      CK_THROW_(Error_t::WrongInput,
+                "num of keyset_file and num of embeddings don't equal");
+    }
+    if (!ps_manager_.has_staging_buffer_bags()) {
+      std::vector<size_t> buffer_sizes;
+      for (auto& one_embedding : embeddings_) {
+        buffer_sizes.push_back(one_embedding->get_max_vocabulary_size());
+      }
+      ps_manager_.allocate_staging_buffer_bags(buffer_sizes);
+    }
+
+    // the members written in the background are only read after wait_for_background_()
+    prefetched_keyset_file_list_ = keyset_file_list;
+    run_in_background_([this, keyset_file_list]() {
+      Timer timer;
+      timer.start();
+      std::vector<size_t> hit_sizes(ps_manager_.get_size(), 0);
+      std::vector<std::vector<uint64_t>> fingerprints(ps_manager_.get_size());
+      for (size_t i = 0; i < ps_manager_.get_size(); i++) {
+        ps_manager_.get_parameter_server(i)->prefetch(keyset_file_list[i],
+            ps_manager_.get_staging_buffer_bag(i), hit_sizes[i]);
+        get_fingerprints(ps_manager_.get_staging_buffer_bag(i), hit_sizes[i],
+                         embeddings_[i]->get_embedding_params().embedding_vec_size,
+                         fingerprints[i]);
+      }
+      timer.stop();
+      prefetched_hit_sizes_ = hit_sizes;
+      prefetched_fingerprints_ = std::move(fingerprints);
+      prefetch_seconds_ = timer.elapsedSeconds();
+    });
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw rt_err;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw err;
+  }
+}
+
+template <typename TypeKey>
+void ModelOversubscriberImpl<TypeKey>::prefetch(
+    std::string& keyset_file) {
+  std::vector<std::string> keyset_file_list(embeddings_.size(), keyset_file);
+  prefetch(keyset_file_list);
+}
+
 template class ModelOversubscriberImpl<long long>;
 template class ModelOversubscriberImpl<unsigned>;
 
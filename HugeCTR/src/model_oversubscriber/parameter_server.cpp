@@ -16,6 +16,8 @@
 
 #include <model_oversubscriber/parameter_server.hpp>
 
+#include <algorithm>
+#include <execution>
 #include <fstream>
 #include <experimental/filesystem>
 
@@ -34,31 +36,42 @@ void open_and_get_size(const std::string& file_name, std::ifstream& stream,
   file_size_in_byte = fs::file_size(file_name);
 }
 
+template <typename TypeKey>
+void read_keyset(const std::string& keyset_file, std::vector<TypeKey>& keyset) {
+  std::ifstream keyset_stream;
+  size_t file_size_in_byte = 0;
+  open_and_get_size(keyset_file, keyset_stream, file_size_in_byte);
+
+  if (file_size_in_byte == 0) {
+    CK_THROW_(Error_t::WrongInput, std::string(keyset_file) + " is empty");
+  }
+
+  size_t num_keys_in_file = file_size_in_byte / sizeof(TypeKey);
+  keyset.resize(num_keys_in_file);
+  keyset_stream.read((char*)keyset.data(), file_size_in_byte);
+  // the sparse model looks the keys up in sorted arrays, which is fastest in key order
+  if (!std::is_sorted(keyset.begin(), keyset.end())) {
+    std::sort(std::execution::par, keyset.begin(), keyset.end());
+  }
+}
+
 } // namespace
 
 template <typename TypeKey>
 ParameterServer<TypeKey>::ParameterServer(bool use_host_ps,
     const std::string &sparse_model_file, Embedding_t embedding_type,
-    size_t emb_vec_size, std::shared_ptr<ResourceManager> resource_manager)
+    size_t emb_vec_size, std::shared_ptr<ResourceManager> resource_manager,
+    bool use_log_structured_store)
     : use_host_ps_(use_host_ps),
       sparse_model_entity_(SparseModelEntity<TypeKey>(use_host_ps,
-      sparse_model_file, embedding_type, emb_vec_size, resource_manager)) {}
+      sparse_model_file, embedding_type, emb_vec_size, resource_manager,
+      use_log_structured_store)) {}
 
 template <typename TypeKey>
 void ParameterServer<TypeKey>::load_keyset_from_file(
 	std::string keyset_file) {
   try {
-    std::ifstream keyset_stream;
-    size_t file_size_in_byte = 0;
-    open_and_get_size(keyset_file, keyset_stream, file_size_in_byte);
-
-    if (file_size_in_byte == 0) {
-      CK_THROW_(Error_t::WrongInput, std::string(keyset_file) + " is empty");
-    }
-
-    size_t num_keys_in_file = file_size_in_byte / sizeof(TypeKey);
-    keyset_.resize(num_keys_in_file);
-    keyset_stream.read((char*)keyset_.data(), file_size_in_byte);
+    read_keyset(keyset_file, keyset_);
 #ifdef ENABLE_MPI
     CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
 #endif
@@ -79,6 +92,13 @@ void ParameterServer<TypeKey>::pull(BufferBag& buf_bag, size_t& hit_size) {
   sparse_model_entity_.load_vec_by_key(keyset_, buf_bag, hit_size);
 }
 
+template <typename TypeKey>
+void ParameterServer<TypeKey>::prefetch(const std::string& keyset_file,
+                                       BufferBag& buf_bag, size_t& hit_size) {
+  read_keyset(keyset_file, keyset_);
+  sparse_model_entity_.load_vec_by_key(keyset_, buf_bag, hit_size);
+}
+
 template <typename TypeKey>
 void ParameterServer<TypeKey>::push(BufferBag &buf_bag, size_t dump_size) {
   if (dump_size == 0) return;
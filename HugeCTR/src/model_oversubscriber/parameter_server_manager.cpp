@@ -24,7 +24,8 @@ ParameterServerManager<TypeKey>::ParameterServerManager(bool use_host_ps,
     const std::vector<std::string>& sparse_embedding_files,
     const std::vector<Embedding_t>& embedding_types,
     const std::vector<SparseEmbeddingHashParams>& embedding_params,
-    size_t buffer_size, std::shared_ptr<ResourceManager> resource_manager) {
+    size_t buffer_size, std::shared_ptr<ResourceManager> resource_manager,
+    bool use_log_structured_store) {
   try {
     if (sparse_embedding_files.size() == 0)
       CK_THROW_(Error_t::WrongInput, "must provide sparse_model_file. \
@@ -45,6 +46,7 @@ ParameterServerManager<TypeKey>::ParameterServerManager(bool use_host_ps,
     size_t max_vec_size = 0, max_voc_size_per_gpu = 0;
     for (int i = 0; i < static_cast<int>(embedding_params.size()); i++) {
       size_t ith_vec_size = embedding_params[i].embedding_vec_size;
+      emb_vec_sizes_.push_back(ith_vec_size);
       max_vec_size = (ith_vec_size > max_vec_size) ? ith_vec_size : max_vec_size;
 
       size_t tmp_voc_size = embedding_params[i].max_vocabulary_size_per_gpu;
@@ -54,7 +56,7 @@ ParameterServerManager<TypeKey>::ParameterServerManager(bool use_host_ps,
       MESSAGE_("construct sparse models for model oversubscriber: " + sparse_embedding_files[i]);
       ps_.push_back(std::make_shared<ParameterServer<TypeKey>>(use_host_ps,
           sparse_embedding_files[i], embedding_types[i], embedding_params[i].embedding_vec_size,
-          resource_manager));
+          resource_manager, use_log_structured_store));
     }
 
     bool has_localized_embedding = false;
@@ -129,6 +131,41 @@ ParameterServerManager<TypeKey>::ParameterServerManager(bool use_host_ps,
   }
 }
 
+template <typename TypeKey>
+void ParameterServerManager<TypeKey>::allocate_staging_buffer_bags(
+    const std::vector<size_t>& buffer_sizes) {
+  try {
+    if (buffer_sizes.size() != ps_.size()) {
+      CK_THROW_(Error_t::WrongInput, "buffer_sizes.size() != num of parameter servers");
+    }
+    auto host_blobs_buff = GeneralBuffer2<CudaHostAllocator>::create();
+    staging_buf_bags_.resize(ps_.size());
+    for (size_t i = 0; i < ps_.size(); i++) {
+      BufferBag& staging_buf_bag = staging_buf_bags_[i];
+      Tensor2<TypeKey> tensor_keys;
+      Tensor2<size_t> tensor_slot_id;
+      host_blobs_buff->reserve({buffer_sizes[i]}, &tensor_keys);
+      host_blobs_buff->reserve({buffer_sizes[i]}, &tensor_slot_id);
+      host_blobs_buff->reserve({buffer_sizes[i], emb_vec_sizes_[i]},
+                               &(staging_buf_bag.embedding));
+      staging_buf_bag.keys = tensor_keys.shrink();
+      staging_buf_bag.slot_id = tensor_slot_id.shrink();
+
+      staging_buf_bag.h_value_tensors = buf_bag_.h_value_tensors;
+      staging_buf_bag.h_slot_id_tensors = buf_bag_.h_slot_id_tensors;
+      staging_buf_bag.uvm_key_tensor_bags = buf_bag_.uvm_key_tensor_bags;
+      staging_buf_bag.d_value_index_tensors = buf_bag_.d_value_index_tensors;
+    }
+    host_blobs_buff->allocate();
+  } catch (const internal_runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw rt_err;
+  } catch (const std::exception& err) {
+    std::cerr << err.what() << std::endl;
+    throw err;
+  }
+}
+
 template class ParameterServerManager<long long>;
 template class ParameterServerManager<unsigned>;
 
@@ -35,14 +35,25 @@ namespace HugeCTR {
 template <typename TypeKey>
 SparseModelEntity<TypeKey>::SparseModelEntity(bool use_host_ps, 
     const std::string &sparse_model_file, Embedding_t embedding_type,
-    size_t emb_vec_size, std::shared_ptr<ResourceManager> resource_manager)
+    size_t emb_vec_size, std::shared_ptr<ResourceManager> resource_manager,
+    bool use_log_structured_store)
   : use_host_ps_(use_host_ps),
     is_distributed_(embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash),
-    emb_vec_size_(emb_vec_size), resource_manager_(resource_manager),
-    sparse_model_file_(SparseModelFile<TypeKey>(sparse_model_file, embedding_type,
-                                                emb_vec_size, resource_manager)) {
+    emb_vec_size_(emb_vec_size), resource_manager_(resource_manager) {
+  if (use_log_structured_store) {
+    sparse_model_store_.reset(new SparseModelStore<TypeKey>(sparse_model_file, embedding_type,
+                                                            emb_vec_size, resource_manager));
+  } else {
+    sparse_model_file_.reset(new SparseModelFile<TypeKey>(sparse_model_file, embedding_type,
+                                                          emb_vec_size, resource_manager));
+  }
   if (use_host_ps_) {
-    sparse_model_file_.load_emb_tbl_to_mem(exist_key_idx_mapping_, host_emb_tabel_);
+    if (sparse_model_store_) {
+      sparse_model_store_->load_emb_tbl_to_mem(exist_key_idx_mapping_, host_emb_tabel_);
+    } else {
+      sparse_model_file_->load_emb_tbl_to_mem(exist_key_idx_mapping_, host_emb_tabel_);
+    }
+    is_dirty_row_.resize(host_emb_tabel_.size() / emb_vec_size_, 0);
   }
 }
 
@@ -84,22 +95,14 @@ void SparseModelEntity<TypeKey>::load_vec_by_key(std::vector<TypeKey>& keys,
         chunk_idx_exist[tid].reserve(sub_chunk_size);
         if (!is_distributed_) chunk_slot_id[tid].reserve(sub_chunk_size);
 
-        auto insert_key_op = [&](auto iter) {
-          chunk_keys[tid].push_back(iter->first);
-          chunk_idx_exist[tid].push_back(iter->second.second);
-          if (!is_distributed_) chunk_slot_id[tid].push_back(iter->second.first);
-        };
-
         for (size_t i = 0; i < sub_chunk_size; i++) {
           auto key = keys[idx + i];
-          auto iter = exist_key_idx_mapping_.find(key);
-          if (iter != exist_key_idx_mapping_.end()) {
-            insert_key_op(iter);
-          } else {
-            iter = new_key_idx_mapping_.find(key);
-            if (iter != new_key_idx_mapping_.end()) {
-              insert_key_op(iter);
-            }
+          size_t slot_id, vec_idx;
+          if (exist_key_idx_mapping_.find(key, slot_id, vec_idx) ||
+              new_key_idx_mapping_.find(key, slot_id, vec_idx)) {
+            chunk_keys[tid].push_back(key);
+            chunk_idx_exist[tid].push_back(vec_idx);
+            if (!is_distributed_) chunk_slot_id[tid].push_back(slot_id);
           }
         }
       }
@@ -151,18 +154,17 @@ void SparseModelEntity<TypeKey>::load_vec_by_key(std::vector<TypeKey>& keys,
       std::vector<TypeKey> exist_keys;
       exist_keys.reserve(keys.size());
       
-      const auto ssd_key_idx_mapping = sparse_model_file_.get_key_index_map();
-      auto is_key_exist_op = [&ssd_key_idx_mapping](TypeKey key) {
-        auto iter = ssd_key_idx_mapping.find(key);
-        if (iter == ssd_key_idx_mapping.end()) return false;
-        return true;
-      };
+      auto is_key_exist_op = [this](TypeKey key) { return ssd_contains_(key); };
       copy_if(keys.begin(), keys.end(), std::back_inserter(exist_keys), is_key_exist_op);
       hit_size = exist_keys.size();
 
       std::vector<size_t> slots;
       std::vector<float> vecs;
-      sparse_model_file_.load_exist_vec_by_key(exist_keys, slots, vecs);
+      if (sparse_model_store_) {
+        sparse_model_store_->load_exist_vec_by_key(exist_keys, slots, vecs);
+      } else {
+        sparse_model_file_->load_exist_vec_by_key(exist_keys, slots, vecs);
+      }
 
       memcpy(key_ptr, exist_keys.data(), exist_keys.size() * sizeof(TypeKey));
       memcpy(vec_ptr, vecs.data(), vecs.size() * sizeof(float));
@@ -228,21 +230,20 @@ void SparseModelEntity<TypeKey>::dump_vec_by_key(BufferBag &buf_bag,
 
         for (size_t i = 0; i < sub_chunk_size; i++) {
           const auto key = key_ptr[idx + i];
-          auto iter = exist_key_idx_mapping_.find(key);
-          if (iter != exist_key_idx_mapping_.end()) {
-            chunk_idx_dst[tid].push_back(iter->second.second);
+          size_t slot_id, vec_idx;
+          if (exist_key_idx_mapping_.find(key, slot_id, vec_idx)) {
+            chunk_idx_dst[tid].push_back(vec_idx);
             continue;
           }
 
-          iter = new_key_idx_mapping_.find(key);
-          if (iter == new_key_idx_mapping_.end()) {
+          if (!new_key_idx_mapping_.find(key, slot_id, vec_idx)) {
             size_t slot_id_temp = is_distributed_ ? 0 : slot_id_ptr[idx + i];
             size_t vec_idx_temp = num_exist_vecs + chunk_cnt_new_keys[tid]++;
             chunk_new_key_idx_mapping[tid].emplace(
                 key, std::make_pair(slot_id_temp, vec_idx_temp));
             chunk_idx_dst[tid].push_back(-1 * vec_idx_temp - 1);
           } else {
-            chunk_idx_dst[tid].push_back(iter->second.second);
+            chunk_idx_dst[tid].push_back(vec_idx);
           }
         }
       }
@@ -281,8 +282,9 @@ void SparseModelEntity<TypeKey>::dump_vec_by_key(BufferBag &buf_bag,
 
       cnt_new_keys = 0;
       for (size_t tid = 0; tid < chunk_num; tid++) {
-        new_key_idx_mapping_.insert(chunk_new_key_idx_mapping[tid].begin(),
-                                    chunk_new_key_idx_mapping[tid].end());
+        for (const auto& pair : chunk_new_key_idx_mapping[tid]) {
+          new_key_idx_mapping_.insert(pair.first, pair.second.first, pair.second.second);
+        }
 
         cnt_new_keys += chunk_new_key_idx_mapping[tid].size();
       }
@@ -290,6 +292,7 @@ void SparseModelEntity<TypeKey>::dump_vec_by_key(BufferBag &buf_bag,
       size_t extended_table_size = host_emb_tabel_.size() +
                                    cnt_new_keys * emb_vec_size_;
       host_emb_tabel_.resize(extended_table_size);
+      is_dirty_row_.resize(extended_table_size / emb_vec_size_, 0);
 
       #pragma omp parallel num_threads(chunk_num)
       {
@@ -306,43 +309,53 @@ void SparseModelEntity<TypeKey>::dump_vec_by_key(BufferBag &buf_bag,
           size_t dst_idx = idx_dst[idx + i] * emb_vec_size_;
           memcpy(&host_emb_tabel_[dst_idx], &vec_ptr[src_idx],
                  emb_vec_size_ * sizeof(float));
+          is_dirty_row_[idx_dst[idx + i]] = 1;
         }
       }
     } else {
       std::vector<TypeKey> exist_keys, new_keys;
-      std::vector<size_t> exist_vec_idx, new_vec_idx;
+      std::vector<size_t> exist_vec_idx, new_vec_idx, new_slots;
       exist_keys.reserve(dump_size);
       exist_vec_idx.reserve(dump_size);
       new_keys.reserve(dump_size);
       new_vec_idx.reserve(dump_size);
 
-      const auto ssd_key_idx_map = sparse_model_file_.get_key_index_map();
       for (size_t cnt = 0; cnt < dump_size; cnt++) {
-        auto iter = ssd_key_idx_map.find(key_ptr[cnt]);
-        if (iter != ssd_key_idx_map.end()) {
+        if (ssd_contains_(key_ptr[cnt])) {
           exist_keys.push_back(key_ptr[cnt]);
           exist_vec_idx.push_back(cnt);
         } else {
           new_keys.push_back(key_ptr[cnt]);
           new_vec_idx.push_back(cnt);
+          // the slots are appended in the order of new_keys
+          if (!is_distributed_) new_slots.push_back(slot_id_ptr[cnt]);
         }
       }
       cnt_new_keys = new_keys.size();
 
+      if (sparse_model_store_) {
+        // each rank has a store of its own, and the pass is committed at once
+        std::vector<TypeKey> keys(key_ptr, key_ptr + dump_size);
+        std::vector<size_t> vec_idx(dump_size);
+        std::iota(vec_idx.begin(), vec_idx.end(), 0);
+        sparse_model_store_->commit(keys, slot_id_ptr, vec_idx, vec_ptr);
+      } else {
 #ifdef ENABLE_MPI
-      CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
-      int num_proc = resource_manager_->get_num_process();
-      int my_rank = resource_manager_->get_process_id();
-      for (int pid = 0; pid < num_proc; pid++) {
-        if (my_rank == pid) {
+        CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
+        int num_proc = resource_manager_->get_num_process();
+        int my_rank = resource_manager_->get_process_id();
+        for (int pid = 0; pid < num_proc; pid++) {
+          if (my_rank == pid) {
 #endif
-          sparse_model_file_.dump_exist_vec_by_key(exist_keys, exist_vec_idx, vec_ptr);
-          sparse_model_file_.append_new_vec_and_key(new_keys, slot_id_ptr, new_vec_idx, vec_ptr);
-#ifdef ENABLE_MPI 
+            sparse_model_file_->dump_exist_vec_by_key(exist_keys, exist_vec_idx, vec_ptr);
+            sparse_model_file_->append_new_vec_and_key(new_keys, new_slots.data(), new_vec_idx,
+                                                       vec_ptr);
+#ifdef ENABLE_MPI
+          }
+          CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
         }
-        CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
-      }
 #endif
+      }
     }
 
 #ifdef KEY_HIT_RATIO
@@ -371,7 +384,7 @@ void SparseModelEntity<TypeKey>::flush_emb_tbl_to_ssd() {
     MESSAGE_("Updating sparse model in SSD", false, false);
 
     std::vector<TypeKey> exist_keys, new_keys;
-    std::vector<size_t> exist_vec_idx, new_vec_idx, new_slots;
+    std::vector<size_t> exist_vec_idx, exist_slots, new_vec_idx, new_slots;
 
     exist_keys.reserve(exist_key_idx_mapping_.size());
     exist_vec_idx.reserve(exist_key_idx_mapping_.size());
@@ -379,19 +392,36 @@ void SparseModelEntity<TypeKey>::flush_emb_tbl_to_ssd() {
     new_slots.reserve(new_key_idx_mapping_.size());
     new_vec_idx.reserve(new_key_idx_mapping_.size());
 
-    for (const auto& exist_pair : exist_key_idx_mapping_) {
-      exist_keys.push_back(exist_pair.first);
-      exist_vec_idx.push_back(exist_pair.second.second);
+    // the other vectors in the file are up to date
+    exist_key_idx_mapping_.for_each([&](TypeKey key, size_t slot_id, size_t vec_idx) {
+      if (!is_dirty_row_[vec_idx]) return;
+      exist_keys.push_back(key);
+      exist_vec_idx.push_back(vec_idx);
+      if (sparse_model_store_) exist_slots.push_back(slot_id);
+    });
+    new_key_idx_mapping_.for_each([&](TypeKey key, size_t slot_id, size_t vec_idx) {
+      new_keys.push_back(key);
+      new_slots.push_back(slot_id);
+      new_vec_idx.push_back(vec_idx);
+    });
+
+    for (size_t i = 0; i < new_keys.size(); i++) {
+      exist_key_idx_mapping_.insert(new_keys[i], new_slots[i], new_vec_idx[i]);
     }
-    for (const auto& new_pair : new_key_idx_mapping_) {
-      new_keys.push_back(new_pair.first);
-      new_slots.push_back(new_pair.second.first);
-      new_vec_idx.push_back(new_pair.second.second);
-    }
-
-    exist_key_idx_mapping_.insert(new_key_idx_mapping_.begin(),
-                                  new_key_idx_mapping_.end());
+    exist_key_idx_mapping_.merge();
     new_key_idx_mapping_.clear();
+    std::fill(is_dirty_row_.begin(), is_dirty_row_.end(), 0);
+
+    if (sparse_model_store_) {
+      // the whole table is committed as one pass
+      exist_keys.insert(exist_keys.end(), new_keys.begin(), new_keys.end());
+      exist_slots.insert(exist_slots.end(), new_slots.begin(), new_slots.end());
+      exist_vec_idx.insert(exist_vec_idx.end(), new_vec_idx.begin(), new_vec_idx.end());
+      sparse_model_store_->commit(exist_keys, exist_slots.data(), exist_vec_idx,
+                                  host_emb_tabel_.data());
+      MESSAGE_(" [DONE]", false, true, false);
+      return;
+    }
 
 #ifdef ENABLE_MPI
     CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
@@ -400,8 +430,8 @@ void SparseModelEntity<TypeKey>::flush_emb_tbl_to_ssd() {
     for (int pid = 0; pid < num_proc; pid++) {
       if (my_rank == pid) {
 #endif
-        sparse_model_file_.dump_exist_vec_by_key(exist_keys, exist_vec_idx, host_emb_tabel_.data());
-        sparse_model_file_.append_new_vec_and_key(new_keys, new_slots.data(), new_vec_idx, host_emb_tabel_.data());
+        sparse_model_file_->dump_exist_vec_by_key(exist_keys, exist_vec_idx, host_emb_tabel_.data());
+        sparse_model_file_->append_new_vec_and_key(new_keys, new_slots.data(), new_vec_idx, host_emb_tabel_.data());
 #ifdef ENABLE_MPI 
       }
       CK_MPI_THROW_(MPI_Barrier(MPI_COMM_WORLD));
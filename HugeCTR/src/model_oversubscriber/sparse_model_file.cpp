@@ -17,9 +17,18 @@
 #include <model_oversubscriber/sparse_model_file.hpp>
 
 #include <map>
+#include <atomic>
+#include <chrono>
+#include <numeric>
 #include <algorithm>
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
+#include <execution>
 #include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/io.h>
@@ -45,6 +54,55 @@ void open_and_get_size(
   file_size_in_byte = fs::file_size(file_name);
 }
 
+constexpr size_t kIoAlignment = 4096;
+constexpr size_t kMaxGapBytes = 4096;                 // smaller gaps are read back and rewritten
+constexpr size_t kMinDirectBytes = 1024 * 1024;       // smaller runs go through the page cache
+constexpr size_t kStagingBytes = 64 * 1024 * 1024;    // written between two syncs
+
+size_t align_up(size_t offset) { return (offset + kIoAlignment - 1) / kIoAlignment * kIoAlignment; }
+
+/**
+ * The byte range [begin, end) of the embedding file written at once, which holds the rows
+ * [first, last) of the sorted dump.
+ */
+struct WriteRun {
+  size_t begin;
+  size_t end;
+  size_t first;
+  size_t last;
+  bool has_gaps;
+  bool direct;
+};
+
+void pwrite_all(int fd, const char *buf, size_t bytes, size_t offset) {
+  while (bytes > 0) {
+    ssize_t ret = pwrite(fd, buf, bytes, offset);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      CK_THROW_(Error_t::BrokenFile, std::string("pwrite() failed: ") + strerror(errno));
+    }
+    buf += ret;
+    bytes -= ret;
+    offset += ret;
+  }
+}
+
+void pread_all(int fd, char *buf, size_t bytes, size_t offset) {
+  while (bytes > 0) {
+    ssize_t ret = pread(fd, buf, bytes, offset);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      CK_THROW_(Error_t::BrokenFile, std::string("pread() failed: ") + strerror(errno));
+    }
+    if (ret == 0) {
+      CK_THROW_(Error_t::BrokenFile, "pread() reached the end of the embedding file");
+    }
+    buf += ret;
+    bytes -= ret;
+    offset += ret;
+  }
+}
+
 } // namespace
 
 template <typename TypeKey>
@@ -210,6 +268,8 @@ SparseModelFile<TypeKey>::SparseModelFile(
 
     // each rank stores a subset of embedding table
     int my_rank = resource_manager_->get_process_id();
+    std::vector<TypeKey> my_keys;
+    std::vector<size_t> my_slot_ids, my_indices;
     for (size_t i = 0; i < num_key; i++) {
       int dst_rank;
       if (is_distributed_) {
@@ -222,10 +282,12 @@ SparseModelFile<TypeKey>::SparseModelFile(
         dst_rank = resource_manager_->get_process_id_from_gpu_global_id(gid);
       }
       if (my_rank == dst_rank) {
-        size_t slot_id = is_distributed_ ? 0 : slot_id_vec[i];
-        key_idx_map_.insert({key_vec[i], {slot_id, i}});
+        my_keys.push_back(key_vec[i]);
+        if (!is_distributed_) my_slot_ids.push_back(slot_id_vec[i]);
+        my_indices.push_back(i);
       }
     }
+    key_idx_map_.build(my_keys, my_slot_ids, my_indices);
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
     throw;
@@ -248,6 +310,7 @@ void SparseModelFile<TypeKey>::load_exist_vec_by_key(const std::vector<TypeKey>&
     const size_t emb_vec_size_in_byte = emb_vec_size_ * sizeof(float);
 
     map_embedding_to_memory_();
+    std::atomic<bool> all_keys_found(true);
     #pragma omp parallel num_threads(8)
     {
       const size_t tid = omp_get_thread_num();
@@ -259,9 +322,13 @@ void SparseModelFile<TypeKey>::load_exist_vec_by_key(const std::vector<TypeKey>&
       if (tid == thread_num - 1) sub_chunk_size += res_chunk_size;
 
       for (size_t i = 0; i < sub_chunk_size; i++) {
-        const auto& pair = key_idx_map_.at(keys[idx + i]);
-        if (!is_distributed_) slots[idx + i] = pair.first;
-        size_t src_vec_idx = pair.second * emb_vec_size_;
+        size_t slot_id, vec_idx;
+        if (!key_idx_map_.find(keys[idx + i], slot_id, vec_idx)) {
+          all_keys_found = false;
+          continue;
+        }
+        if (!is_distributed_) slots[idx + i] = slot_id;
+        size_t src_vec_idx = vec_idx * emb_vec_size_;
         size_t dst_vec_idx = (idx + i) * emb_vec_size_;
         memcpy(&vecs[dst_vec_idx], &(mmap_handler_.mmaped_table_[src_vec_idx]),
                emb_vec_size_in_byte);
@@ -269,6 +336,9 @@ void SparseModelFile<TypeKey>::load_exist_vec_by_key(const std::vector<TypeKey>&
     }
     sync_mmaped_embedding_with_disk_();
     unmap_embedding_from_memory_();
+    if (!all_keys_found) {
+      CK_THROW_(Error_t::WrongInput, "Some keys don't exist in the embedding file");
+    }
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
     throw;
@@ -278,6 +348,164 @@ void SparseModelFile<TypeKey>::load_exist_vec_by_key(const std::vector<TypeKey>&
   }
 }
 
+template <typename TypeKey>
+void SparseModelFile<TypeKey>::write_rows_(std::vector<std::pair<size_t, size_t>>& rows,
+                                           const float *vecs) {
+  const auto start = std::chrono::steady_clock::now();
+  const size_t emb_vec_size_in_byte = emb_vec_size_ * sizeof(float);
+  const char *emb_vec_file = mmap_handler_.get_vec_file();
+  DumpStats stats;
+
+  // sort the rows by their offset in the file, of the vectors dumped to the same row the last
+  // one in the input is written, as if they were copied one after another
+  std::stable_sort(std::execution::par, rows.begin(), rows.end(),
+                   [](const std::pair<size_t, size_t> &a, const std::pair<size_t, size_t> &b) {
+                     return a.first < b.first;
+                   });
+  size_t num_rows = 0;
+  for (size_t i = 0; i < rows.size(); i++) {
+    if (i + 1 < rows.size() && rows[i + 1].first == rows[i].first) continue;
+    rows[num_rows++] = rows[i];
+  }
+  rows.resize(num_rows);
+  stats.rows = rows.size();
+
+  // coalesce the rows into runs, bridging the small gaps between them
+  std::vector<WriteRun> runs;
+  for (size_t i = 0; i < rows.size(); i++) {
+    const size_t begin = rows[i].first * emb_vec_size_in_byte;
+    const size_t end = begin + emb_vec_size_in_byte;
+    if (!runs.empty() && begin <= runs.back().end + kMaxGapBytes &&
+        end - runs.back().begin <= kStagingBytes / 2) {
+      runs.back().has_gaps |= begin != runs.back().end;
+      runs.back().end = end;
+      runs.back().last = i + 1;
+    } else {
+      runs.push_back({begin, end, i, i + 1, false, false});
+    }
+  }
+
+  int fd = open(emb_vec_file, O_RDWR);
+  if (fd == -1) {
+    CK_THROW_(Error_t::FileCannotOpen, std::string("Cannot open the file: ") + emb_vec_file);
+  }
+  // only the large runs which start and end on a page bypass the page cache, so that no page is
+  // read back for them. Not every file system supports O_DIRECT, they are buffered there.
+  int direct_fd = open(emb_vec_file, O_WRONLY | O_DIRECT);
+  for (auto &run : runs) {
+    run.direct = direct_fd != -1 && run.begin % kIoAlignment == 0 &&
+                 run.end % kIoAlignment == 0 && run.end - run.begin >= kMinDirectBytes;
+  }
+
+  char *staging = nullptr;
+  if (posix_memalign(reinterpret_cast<void **>(&staging), kIoAlignment, kStagingBytes) != 0) {
+    close(fd);
+    if (direct_fd != -1) close(direct_fd);
+    CK_THROW_(Error_t::OutOfMemory, "posix_memalign failed");
+  }
+  try {
+    size_t next_run = 0;
+    while (next_run < runs.size()) {
+      // lay out as many runs as fit in the staging buffer
+      const size_t first_run = next_run;
+      std::vector<size_t> run_offsets;
+      size_t staging_bytes = 0;
+      while (next_run < runs.size()) {
+        const size_t run_bytes = align_up(runs[next_run].end - runs[next_run].begin);
+        if (staging_bytes + run_bytes > kStagingBytes) break;
+        run_offsets.push_back(staging_bytes);
+        staging_bytes += run_bytes;
+        next_run++;
+      }
+
+      // the gaps and the partial pages of the buffered runs are read ahead in the background,
+      // instead of one run after another by pread() and pwrite(), then the gaps are read back
+      for (size_t r = first_run; r < next_run; r++) {
+        const auto &run = runs[r];
+        if (run.has_gaps || (!run.direct && (run.begin | run.end) % kIoAlignment != 0)) {
+          posix_fadvise(fd, run.begin, run.end - run.begin, POSIX_FADV_WILLNEED);
+        }
+      }
+      for (size_t r = first_run; r < next_run; r++) {
+        const auto &run = runs[r];
+        if (run.has_gaps) {
+          pread_all(fd, staging + run_offsets[r - first_run], run.end - run.begin, run.begin);
+          stats.bytes_read += run.end - run.begin;
+        }
+      }
+
+      // copy the vectors into place
+      const size_t first_row = runs[first_run].first;
+      std::vector<char *> row_dst(runs[next_run - 1].last - first_row);
+      for (size_t r = first_run; r < next_run; r++) {
+        const auto &run = runs[r];
+        char *buf = staging + run_offsets[r - first_run];
+        for (size_t i = run.first; i < run.last; i++) {
+          row_dst[i - first_row] = buf + (rows[i].first * emb_vec_size_in_byte - run.begin);
+        }
+      }
+      #pragma omp parallel for num_threads(8)
+      for (size_t i = 0; i < row_dst.size(); i++) {
+        memcpy(row_dst[i], &vecs[rows[first_row + i].second * emb_vec_size_],
+               emb_vec_size_in_byte);
+      }
+
+      // write the runs, then start the write-back of the span of those written through the page
+      // cache, in which only the dirty pages are written, while the next batch is staged
+      size_t sync_begin = std::numeric_limits<size_t>::max(), sync_end = 0;
+      for (size_t r = first_run; r < next_run; r++) {
+        auto &run = runs[r];
+        const char *buf = staging + run_offsets[r - first_run];
+        const size_t bytes = run.end - run.begin;
+        if (run.direct) {
+          ssize_t ret = pwrite(direct_fd, buf, bytes, run.begin);
+          if (ret == static_cast<ssize_t>(bytes)) {
+            stats.direct_runs++;
+            stats.bytes_written += bytes;
+            continue;
+          }
+          // a short or refused direct write is redone through the page cache
+          run.direct = false;
+        }
+        pwrite_all(fd, buf, bytes, run.begin);
+        stats.bytes_written += bytes;
+        sync_begin = std::min(sync_begin, run.begin);
+        sync_end = std::max(sync_end, run.end);
+      }
+      if (sync_begin < sync_end &&
+          sync_file_range(fd, sync_begin, sync_end - sync_begin, SYNC_FILE_RANGE_WRITE) != 0) {
+        CK_THROW_(Error_t::BrokenFile, std::string("sync_file_range() failed: ") + strerror(errno));
+      }
+    }
+    // sync_file_range() is only a hint: it neither covers the O_DIRECT runs nor flushes the
+    // metadata and the write cache of the device. One fdatasync() of the file makes both the
+    // buffered and the direct runs durable before the dump is reported done.
+    if (fdatasync(fd) != 0) {
+      CK_THROW_(Error_t::BrokenFile, std::string("fdatasync() failed: ") + strerror(errno));
+    }
+  } catch (...) {
+    free(staging);
+    close(fd);
+    if (direct_fd != -1) close(direct_fd);
+    throw;
+  }
+  free(staging);
+  close(fd);
+  if (direct_fd != -1) close(direct_fd);
+
+  stats.runs = runs.size();
+  stats.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  last_dump_stats_ = stats;
+  std::stringstream ss;
+  ss << "Dumped " << stats.rows << " vectors to " << emb_vec_file << " in " << stats.runs
+     << " runs (" << stats.direct_runs << " O_DIRECT), " << std::fixed << std::setprecision(2)
+     << stats.bytes_written / 1048576.0 << " MiB written, " << stats.bytes_read / 1048576.0
+     << " MiB read back, " << stats.bytes_written / 1048576.0 / std::max(stats.seconds, 1e-9)
+     << " MiB/s";
+  MESSAGE_(ss.str());
+}
+
 template <typename TypeKey>
 void SparseModelFile<TypeKey>::dump_exist_vec_by_key(const std::vector<TypeKey>& keys,
     const std::vector<size_t>& vec_indices, const float *vecs) {
@@ -287,29 +515,22 @@ void SparseModelFile<TypeKey>::dump_exist_vec_by_key(const std::vector<TypeKey>&
     }
     if (keys.size() == 0) return;
 
-    const size_t emb_vec_size_in_byte = emb_vec_size_ * sizeof(float);
-
-    map_embedding_to_memory_();
-    #pragma omp parallel num_threads(8)
-    {
-      const size_t tid = omp_get_thread_num();
-      const size_t thread_num = omp_get_num_threads();
-      size_t sub_chunk_size = keys.size() / thread_num;
-      size_t res_chunk_size = keys.size() % thread_num;
-      const size_t idx = tid * sub_chunk_size;
-
-      if (tid == thread_num - 1) sub_chunk_size += res_chunk_size;
-
-      for (size_t i = 0; i < sub_chunk_size; i++) {
-        size_t src_vec_idx = vec_indices[idx + i] * emb_vec_size_;
-        const auto& pair = key_idx_map_.at(keys[idx + i]);
-        size_t dst_vec_idx = pair.second * emb_vec_size_;
-        memcpy(&(mmap_handler_.mmaped_table_[dst_vec_idx]),
-               &vecs[src_vec_idx], emb_vec_size_in_byte);
+    // <row in the file, index in vecs> of each key
+    std::vector<std::pair<size_t, size_t>> rows(keys.size());
+    std::atomic<bool> all_keys_found(true);
+    #pragma omp parallel for num_threads(8)
+    for (size_t i = 0; i < keys.size(); i++) {
+      size_t slot_id, vec_idx;
+      if (!key_idx_map_.find(keys[i], slot_id, vec_idx)) {
+        all_keys_found = false;
+        continue;
       }
+      rows[i] = {vec_idx, vec_indices[i]};
     }
-    sync_mmaped_embedding_with_disk_();
-    unmap_embedding_from_memory_();
+    if (!all_keys_found) {
+      CK_THROW_(Error_t::WrongInput, "Some keys don't exist in the embedding file");
+    }
+    write_rows_(rows, vecs);
   } catch (const internal_runtime_error& rt_err) {
     std::cerr << rt_err.what() << std::endl;
     throw;
@@ -328,7 +549,7 @@ void SparseModelFile<TypeKey>::append_new_vec_and_key(
       CK_THROW_(Error_t::WrongInput, "keys.size() != vec_indices.size()");
     }
     auto check_key_exists_op = [this] (auto key) {
-      if (this->key_idx_map_.find(key) != this->key_idx_map_.end())
+      if (this->key_idx_map_.contains(key))
         CK_THROW_(Error_t::WrongInput, std::to_string(key) + " exists in key_idx_map_!");
     };
     std::for_each(keys.begin(), keys.end(), check_key_exists_op);
@@ -368,7 +589,7 @@ void SparseModelFile<TypeKey>::append_new_vec_and_key(
     // update key_idx_map_
     for (size_t i = 0; i < keys.size(); i++) {
       size_t slot_id = is_distributed_ ? 0 : slots[i];
-      key_idx_map_.insert({keys[i], {slot_id, num_vec_in_file + i}});
+      key_idx_map_.insert(keys[i], slot_id, num_vec_in_file + i);
     }
 
     // write embedding vector to disk
@@ -384,21 +605,23 @@ void SparseModelFile<TypeKey>::append_new_vec_and_key(
 
 template <typename TypeKey>
 void SparseModelFile<TypeKey>::load_emb_tbl_to_mem(
-    HashTableType& mem_key_index_map, std::vector<float>& vecs) {
+    KeyIndexType& mem_key_index_map, std::vector<float>& vecs) {
   try {
     const size_t num_vecs = key_idx_map_.size();
-    mem_key_index_map.clear();
-    mem_key_index_map.reserve(num_vecs);
     vecs.resize(num_vecs * emb_vec_size_);
 
+    // the vectors are loaded in key order, so the memory index of a key is its position
     std::vector<TypeKey> exist_key;
+    std::vector<size_t> exist_slot_id, mem_idx(num_vecs);
     exist_key.reserve(num_vecs);
-    size_t counter = 0;
-    for (auto key_idx_pair : key_idx_map_) {
-      exist_key.push_back(key_idx_pair.first);
-      key_idx_pair.second.second = counter++;
-      mem_key_index_map.emplace(std::move(key_idx_pair));
-    }
+    if (!is_distributed_) exist_slot_id.reserve(num_vecs);
+    key_idx_map_.merge();
+    key_idx_map_.for_each([&](TypeKey key, size_t slot_id, size_t) {
+      exist_key.push_back(key);
+      if (!is_distributed_) exist_slot_id.push_back(slot_id);
+    });
+    std::iota(mem_idx.begin(), mem_idx.end(), 0);
+    mem_key_index_map.build(exist_key, exist_slot_id, mem_idx);
 
     std::vector<size_t> temp_slots;
     load_exist_vec_by_key(exist_key, temp_slots, vecs);
@@ -0,0 +1,850 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <model_oversubscriber/sparse_model_store.hpp>
+#include <data_readers/crc32c.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <experimental/filesystem>
+
+namespace fs = std::experimental::filesystem;
+
+namespace HugeCTR {
+
+namespace {
+
+constexpr uint64_t kSegmentMagic = 0x3147455352544348;  // "HCTRSEG1"
+constexpr uint32_t kWalMagic = 0x4C415748;              // "HWAL"
+constexpr int kManifestVersion = 1;
+constexpr size_t kWriteBufferBytes = 4 * 1024 * 1024;
+
+/**
+ * A segment file: the header, the keys as long long like in the sparse model file, the slot_ids
+ * of a localized embedding, then the vectors, all in key order.
+ */
+struct SegmentHeader {
+  uint64_t magic;
+  uint64_t num_keys;
+  uint64_t emb_vec_size;
+  uint64_t has_slots;
+};
+
+/**
+ * A pass in the WAL: the header, then the keys, the slot_ids and the vectors like in a segment.
+ * crc covers num_keys and the payload, so that a torn record is told from a complete one.
+ */
+struct WalRecordHeader {
+  uint32_t magic;
+  uint32_t crc;
+  uint64_t num_keys;
+};
+
+void write_all(int fd, const char *buf, size_t bytes) {
+  while (bytes > 0) {
+    ssize_t ret = write(fd, buf, bytes);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      CK_THROW_(Error_t::BrokenFile, std::string("write() failed: ") + strerror(errno));
+    }
+    buf += ret;
+    bytes -= ret;
+  }
+}
+
+void sync_fd(int fd) {
+  if (fdatasync(fd) != 0) {
+    CK_THROW_(Error_t::BrokenFile, std::string("fdatasync() failed: ") + strerror(errno));
+  }
+}
+
+/**
+ * Make the creations, renames and removals of files in a folder durable.
+ */
+void sync_folder(const std::string &folder_name) {
+  int fd = open(folder_name.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd == -1) {
+    CK_THROW_(Error_t::FileCannotOpen, "Cannot open the folder: " + folder_name);
+  }
+  fsync(fd);
+  close(fd);
+}
+
+/**
+ * Sequential writes to a new file through a large buffer.
+ */
+class FileWriter {
+  int fd_;
+  std::vector<char> buffer_;
+  size_t size_{0};
+
+ public:
+  FileWriter(const std::string &file_name) : buffer_(kWriteBufferBytes) {
+    fd_ = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ == -1) {
+      CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + file_name);
+    }
+  }
+  ~FileWriter() { close(fd_); }
+
+  void append(const void *data, size_t bytes) {
+    const char *src = reinterpret_cast<const char *>(data);
+    if (size_ + bytes > buffer_.size()) {
+      write_all(fd_, buffer_.data(), size_);
+      size_ = 0;
+      if (bytes > buffer_.size()) {
+        write_all(fd_, src, bytes);
+        return;
+      }
+    }
+    memcpy(buffer_.data() + size_, src, bytes);
+    size_ += bytes;
+  }
+
+  void sync() {
+    write_all(fd_, buffer_.data(), size_);
+    size_ = 0;
+    sync_fd(fd_);
+  }
+};
+
+}  // namespace
+
+template <typename TypeKey>
+struct SparseModelStore<TypeKey>::Segment {
+  uint64_t id{0};
+  std::string file_name;
+  size_t num_keys{0};
+  char *mapped{nullptr};
+  size_t mapped_bytes{0};
+  const long long *keys{nullptr};
+  const size_t *slots{nullptr};
+  const float *vecs{nullptr};
+  KeyIndexType index; /**< key --> slot_id, row */
+
+  Segment(uint64_t segment_id, const std::string &segment_file, size_t emb_vec_size,
+          bool is_distributed)
+      : id(segment_id), file_name(segment_file) {
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd == -1) {
+      CK_THROW_(Error_t::FileCannotOpen, "Cannot open the segment: " + file_name);
+    }
+    mapped_bytes = fs::file_size(file_name);
+    if (mapped_bytes >= sizeof(SegmentHeader)) {
+      mapped = reinterpret_cast<char *>(mmap(NULL, mapped_bytes, PROT_READ, MAP_PRIVATE, fd, 0));
+    }
+    close(fd);
+    if (mapped == nullptr || mapped == MAP_FAILED) {
+      mapped = nullptr;
+      CK_THROW_(Error_t::BrokenFile, "Cannot map the segment: " + file_name);
+    }
+    const SegmentHeader *header = reinterpret_cast<const SegmentHeader *>(mapped);
+    num_keys = header->num_keys;
+    const size_t row_bytes = sizeof(long long) + (is_distributed ? 0 : sizeof(size_t)) +
+                             emb_vec_size * sizeof(float);
+    if (header->magic != kSegmentMagic || header->emb_vec_size != emb_vec_size ||
+        header->has_slots != !is_distributed ||
+        mapped_bytes != sizeof(SegmentHeader) + num_keys * row_bytes) {
+      munmap(mapped, mapped_bytes);
+      mapped = nullptr;
+      CK_THROW_(Error_t::BrokenFile, "Broken segment: " + file_name);
+    }
+    keys = reinterpret_cast<const long long *>(mapped + sizeof(SegmentHeader));
+    const char *next = mapped + sizeof(SegmentHeader) + num_keys * sizeof(long long);
+    if (!is_distributed) {
+      slots = reinterpret_cast<const size_t *>(next);
+      next += num_keys * sizeof(size_t);
+    }
+    vecs = reinterpret_cast<const float *>(next);
+
+    std::vector<TypeKey> index_keys(num_keys);
+    std::vector<size_t> index_slots(is_distributed ? 0 : num_keys), rows(num_keys);
+    for (size_t i = 0; i < num_keys; i++) {
+      index_keys[i] = static_cast<TypeKey>(keys[i]);
+      if (!is_distributed) index_slots[i] = slots[i];
+    }
+    std::iota(rows.begin(), rows.end(), 0);
+    index.build(index_keys, index_slots, rows);
+  }
+
+  ~Segment() {
+    if (mapped != nullptr) munmap(mapped, mapped_bytes);
+  }
+
+  TypeKey key(size_t row) const { return static_cast<TypeKey>(keys[row]); }
+  size_t slot(size_t row) const { return slots ? slots[row] : 0; }
+};
+
+template <typename TypeKey>
+std::string SparseModelStore<TypeKey>::file_name_(const std::string &kind, uint64_t id) const {
+  return folder_name_ + "/" + kind + "_" + std::to_string(id);
+}
+
+template <typename TypeKey>
+std::vector<typename SparseModelStore<TypeKey>::SegmentPtr>
+SparseModelStore<TypeKey>::get_segments_() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return segments_;
+}
+
+/**
+ * Called with mutex_ held.
+ */
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::write_manifest_() {
+  std::stringstream ss;
+  ss << "HugeCTR sparse model store " << kManifestVersion << "\n";
+  ss << "emb_vec_size " << emb_vec_size_ << "\n";
+  ss << "distributed " << is_distributed_ << "\n";
+  ss << "num_processes " << resource_manager_->get_num_process() << "\n";
+  ss << "next_file_id " << next_file_id_ << "\n";
+  ss << "wal " << wal_id_ << "\n";
+  ss << "segments";
+  for (const auto &segment : segments_) {
+    ss << " " << segment->id;
+  }
+  ss << "\n";
+  const std::string content = ss.str();
+
+  const std::string manifest = folder_name_ + "/MANIFEST";
+  const std::string temp_manifest = manifest + ".tmp";
+  int fd = open(temp_manifest.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + temp_manifest);
+  }
+  try {
+    write_all(fd, content.data(), content.size());
+    sync_fd(fd);
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+  if (rename(temp_manifest.c_str(), manifest.c_str()) != 0) {
+    CK_THROW_(Error_t::BrokenFile, std::string("rename() failed: ") + strerror(errno));
+  }
+  sync_folder(folder_name_);
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::recover_() {
+  const std::string manifest = folder_name_ + "/MANIFEST";
+  if (!fs::exists(manifest)) {
+    fs::create_directories(folder_name_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    next_file_id_ = 1;
+    wal_id_ = next_file_id_++;
+    write_manifest_();
+    return;
+  }
+
+  std::ifstream manifest_stream(manifest);
+  std::string line;
+  std::getline(manifest_stream, line);
+  if (line != "HugeCTR sparse model store " + std::to_string(kManifestVersion)) {
+    CK_THROW_(Error_t::BrokenFile, "Not a sparse model store manifest: " + manifest);
+  }
+  size_t emb_vec_size = 0, num_processes = 0;
+  bool is_distributed = false;
+  std::vector<uint64_t> segment_ids;
+  while (std::getline(manifest_stream, line)) {
+    std::stringstream ss(line);
+    std::string name;
+    ss >> name;
+    if (name == "emb_vec_size") {
+      ss >> emb_vec_size;
+    } else if (name == "distributed") {
+      ss >> is_distributed;
+    } else if (name == "num_processes") {
+      ss >> num_processes;
+    } else if (name == "next_file_id") {
+      ss >> next_file_id_;
+    } else if (name == "wal") {
+      ss >> wal_id_;
+    } else if (name == "segments") {
+      for (uint64_t id; ss >> id;) segment_ids.push_back(id);
+    }
+  }
+  if (emb_vec_size != emb_vec_size_ || is_distributed != is_distributed_) {
+    CK_THROW_(Error_t::WrongInput, folder_name_ + " was written with another embedding");
+  }
+  if (num_processes != static_cast<size_t>(resource_manager_->get_num_process())) {
+    CK_THROW_(Error_t::WrongInput, folder_name_ + " was written by " +
+                                       std::to_string(num_processes) + " processes");
+  }
+
+  for (uint64_t id : segment_ids) {
+    segments_.push_back(
+        std::make_shared<Segment>(id, file_name_("segment", id), emb_vec_size_, is_distributed_));
+  }
+
+  // the files of a flush or a compaction which was interrupted before its manifest
+  std::set<std::string> live_files{manifest, file_name_("wal", wal_id_)};
+  for (const auto &segment : segments_) {
+    live_files.insert(segment->file_name);
+  }
+  for (const auto &entry : fs::directory_iterator(folder_name_)) {
+    if (live_files.find(entry.path().string()) == live_files.end()) {
+      MESSAGE_("Removing " + entry.path().string() + " of an interrupted update");
+      fs::remove(entry.path());
+    }
+  }
+  replay_wal_();
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::replay_wal_() {
+  const std::string wal_file = file_name_("wal", wal_id_);
+  if (!fs::exists(wal_file)) return;
+  std::ifstream wal_stream(wal_file, std::ifstream::binary);
+  std::vector<char> wal((std::istreambuf_iterator<char>(wal_stream)),
+                        std::istreambuf_iterator<char>());
+
+  const size_t row_bytes = sizeof(long long) + (is_distributed_ ? 0 : sizeof(size_t)) +
+                           emb_vec_size_ * sizeof(float);
+  size_t offset = 0, num_passes = 0;
+  while (offset + sizeof(WalRecordHeader) <= wal.size()) {
+    WalRecordHeader header;
+    memcpy(&header, wal.data() + offset, sizeof(header));
+    const size_t payload_bytes = header.num_keys * row_bytes;
+    const char *payload = wal.data() + offset + sizeof(header);
+    if (header.magic != kWalMagic || header.num_keys > wal.size() ||
+        offset + sizeof(header) + payload_bytes > wal.size()) {
+      break;
+    }
+    uint32_t crc = crc32c_extend(0, reinterpret_cast<const char *>(&header.num_keys),
+                                 sizeof(header.num_keys));
+    if (crc32c_extend(crc, payload, payload_bytes) != header.crc) {
+      break;
+    }
+    const size_t num_keys = header.num_keys;
+    const long long *keys = reinterpret_cast<const long long *>(payload);
+    const size_t *slots =
+        is_distributed_ ? nullptr
+                        : reinterpret_cast<const size_t *>(payload + num_keys * sizeof(long long));
+    const float *vecs = reinterpret_cast<const float *>(
+        payload + num_keys * (sizeof(long long) + (is_distributed_ ? 0 : sizeof(size_t))));
+    for (size_t i = 0; i < num_keys; i++) {
+      insert_to_memtable_(static_cast<TypeKey>(keys[i]), slots ? slots[i] : 0,
+                          vecs + i * emb_vec_size_);
+    }
+    offset += sizeof(header) + payload_bytes;
+    num_passes++;
+  }
+  if (offset != wal.size()) {
+    MESSAGE_("Dropping the incomplete pass at the end of " + wal_file);
+    if (truncate(wal_file.c_str(), offset) != 0) {
+      CK_THROW_(Error_t::BrokenFile, std::string("truncate() failed: ") + strerror(errno));
+    }
+  }
+  wal_bytes_ = offset;
+  if (num_passes > 0) {
+    MESSAGE_("Replayed " + std::to_string(num_passes) + " passes of " + wal_file);
+  }
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::open_wal_() {
+  const std::string wal_file = file_name_("wal", wal_id_);
+  wal_fd_ = open(wal_file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (wal_fd_ == -1) {
+    CK_THROW_(Error_t::FileCannotOpen, "Cannot open the file: " + wal_file);
+  }
+  // commit() only syncs the data of the WAL, so its directory entry is synced here
+  sync_folder(folder_name_);
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::insert_to_memtable_(TypeKey key, size_t slot_id,
+                                                    const float *vec) {
+  size_t mem_slot_id, row;
+  if (!mem_index_.find(key, mem_slot_id, row)) {
+    row = mem_keys_.size();
+    mem_index_.insert(key, slot_id, row);
+    mem_keys_.push_back(key);
+    mem_slots_.push_back(slot_id);
+    mem_vecs_.resize(mem_vecs_.size() + emb_vec_size_);
+  }
+  memcpy(&mem_vecs_[row * emb_vec_size_], vec, emb_vec_size_ * sizeof(float));
+}
+
+template <typename TypeKey>
+typename SparseModelStore<TypeKey>::SegmentPtr SparseModelStore<TypeKey>::write_segment_(
+    uint64_t id, const std::vector<TypeKey> &keys, const std::vector<size_t> &slots,
+    const std::vector<const float *> &vecs) {
+  const std::string segment_file = file_name_("segment", id);
+  {
+    FileWriter writer(segment_file);
+    SegmentHeader header = {kSegmentMagic, keys.size(), emb_vec_size_, !is_distributed_};
+    writer.append(&header, sizeof(header));
+    for (TypeKey key : keys) {
+      long long i64_key = static_cast<long long>(key);
+      writer.append(&i64_key, sizeof(i64_key));
+    }
+    if (!is_distributed_) {
+      writer.append(slots.data(), slots.size() * sizeof(size_t));
+    }
+    for (const float *vec : vecs) {
+      writer.append(vec, emb_vec_size_ * sizeof(float));
+    }
+    writer.sync();
+  }
+  return std::make_shared<Segment>(id, segment_file, emb_vec_size_, is_distributed_);
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::flush_memtable_(SegmentPtr pass_segment) {
+  uint64_t segment_id, new_wal_id;
+  {
+    // bound the read amplification if the compaction falls behind
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] {
+      return segments_.size() < 2 * max_segments_ || !compaction_error_.empty();
+    });
+    segment_id = next_file_id_++;
+    new_wal_id = next_file_id_++;
+  }
+  check_compaction_error_();
+
+  SegmentPtr mem_segment;
+  if (!mem_keys_.empty()) {
+    std::vector<size_t> order(mem_keys_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [this](size_t a, size_t b) { return mem_keys_[a] < mem_keys_[b]; });
+    std::vector<TypeKey> keys(order.size());
+    std::vector<size_t> slots(is_distributed_ ? 0 : order.size());
+    std::vector<const float *> vecs(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      keys[i] = mem_keys_[order[i]];
+      if (!is_distributed_) slots[i] = mem_slots_[order[i]];
+      vecs[i] = &mem_vecs_[order[i] * emb_vec_size_];
+    }
+    mem_segment = write_segment_(segment_id, keys, slots, vecs);
+  }
+
+  const std::string old_wal_file = file_name_("wal", wal_id_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (mem_segment) segments_.push_back(mem_segment);
+    if (pass_segment) segments_.push_back(pass_segment);
+    wal_id_ = new_wal_id;
+    write_manifest_();
+    if (segments_.size() > max_segments_) {
+      compaction_requested_ = true;
+      cond_.notify_all();
+    }
+  }
+  close(wal_fd_);
+  wal_fd_ = -1;
+  fs::remove(old_wal_file);
+  open_wal_();
+  wal_bytes_ = 0;
+
+  mem_index_.clear();
+  std::vector<TypeKey>().swap(mem_keys_);
+  std::vector<size_t>().swap(mem_slots_);
+  std::vector<float>().swap(mem_vecs_);
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::check_compaction_error_() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!compaction_error_.empty()) {
+    CK_THROW_(Error_t::BrokenFile, "Compaction of " + folder_name_ + " failed: " +
+                                       compaction_error_);
+  }
+}
+
+template <typename TypeKey>
+template <typename Func>
+void SparseModelStore<TypeKey>::for_each_live_(const std::vector<SegmentPtr> &segments,
+                                               bool with_memtable, Func func) {
+  std::vector<size_t> mem_order;
+  if (with_memtable) {
+    mem_order.resize(mem_keys_.size());
+    std::iota(mem_order.begin(), mem_order.end(), 0);
+    std::sort(mem_order.begin(), mem_order.end(),
+              [this](size_t a, size_t b) { return mem_keys_[a] < mem_keys_[b]; });
+  }
+  // source s < segments.size() is a segment, the memtable is the newest source
+  const size_t num_sources = segments.size() + (with_memtable ? 1 : 0);
+  auto size_of = [&](size_t s) {
+    return s < segments.size() ? segments[s]->num_keys : mem_order.size();
+  };
+  auto key_of = [&](size_t s, size_t pos) {
+    return s < segments.size() ? segments[s]->key(pos) : mem_keys_[mem_order[pos]];
+  };
+
+  // the smallest key first, and of the same keys the one of the newest source
+  using Entry = std::pair<TypeKey, size_t>;
+  auto later = [](const Entry &a, const Entry &b) {
+    return a.first != b.first ? b.first < a.first : a.second < b.second;
+  };
+  std::priority_queue<Entry, std::vector<Entry>, decltype(later)> heap(later);
+  std::vector<size_t> positions(num_sources, 0);
+  for (size_t s = 0; s < num_sources; s++) {
+    if (size_of(s) > 0) heap.push({key_of(s, 0), s});
+  }
+  bool has_last = false;
+  TypeKey last_key = 0;
+  while (!heap.empty()) {
+    const auto entry = heap.top();
+    heap.pop();
+    const size_t s = entry.second;
+    const size_t pos = positions[s]++;
+    if (!has_last || last_key != entry.first) {
+      if (s < segments.size()) {
+        func(entry.first, segments[s]->slot(pos), segments[s]->vecs + pos * emb_vec_size_);
+      } else {
+        const size_t row = mem_order[pos];
+        func(entry.first, mem_slots_[row], &mem_vecs_[row * emb_vec_size_]);
+      }
+      has_last = true;
+      last_key = entry.first;
+    }
+    if (positions[s] < size_of(s)) heap.push({key_of(s, positions[s]), s});
+  }
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::compact_() {
+  const auto segments = get_segments_();
+  if (segments.size() < 2) return;
+  uint64_t segment_id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    segment_id = next_file_id_++;
+  }
+
+  size_t num_versions = 0;
+  for (const auto &segment : segments) {
+    num_versions += segment->num_keys;
+  }
+  std::vector<TypeKey> keys;
+  std::vector<size_t> slots;
+  std::vector<const float *> vecs;
+  keys.reserve(num_versions);
+  vecs.reserve(num_versions);
+  if (!is_distributed_) slots.reserve(num_versions);
+  for_each_live_(segments, false, [&](TypeKey key, size_t slot_id, const float *vec) {
+    keys.push_back(key);
+    if (!is_distributed_) slots.push_back(slot_id);
+    vecs.push_back(vec);
+  });
+  auto merged = write_segment_(segment_id, keys, slots, vecs);
+
+  {
+    // the segments flushed in the meantime are newer, so they stay after the merged one
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segments_.size() < segments.size() ||
+        !std::equal(segments.begin(), segments.end(), segments_.begin())) {
+      CK_THROW_(Error_t::UnspecificError, "The segments changed during the compaction");
+    }
+    segments_.erase(segments_.begin(), segments_.begin() + segments.size());
+    segments_.insert(segments_.begin(), merged);
+    write_manifest_();
+  }
+  for (const auto &segment : segments) {
+    fs::remove(segment->file_name);
+  }
+  MESSAGE_("Compacted " + std::to_string(segments.size()) + " segments of " + folder_name_ +
+           ", " + std::to_string(num_versions) + " versions into " +
+           std::to_string(keys.size()) + " keys");
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::compaction_loop_() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [this] { return stop_ || compaction_requested_; });
+    if (stop_) break;
+    compaction_requested_ = false;
+    compacting_ = true;
+    lock.unlock();
+    std::string error;
+    try {
+      compact_();
+    } catch (const std::exception &err) {
+      error = err.what();
+    }
+    lock.lock();
+    if (!error.empty()) compaction_error_ = error;
+    compacting_ = false;
+    cond_.notify_all();
+  }
+}
+
+template <typename TypeKey>
+SparseModelStore<TypeKey>::SparseModelStore(const std::string &sparse_model_store,
+                                            Embedding_t embedding_type, size_t emb_vec_size,
+                                            std::shared_ptr<ResourceManager> resource_manager,
+                                            size_t max_memtable_bytes, size_t max_segments)
+    : folder_name_(sparse_model_store + "/rank_" +
+                   std::to_string(resource_manager->get_process_id())),
+      is_distributed_(embedding_type == Embedding_t::DistributedSlotSparseEmbeddingHash),
+      emb_vec_size_(emb_vec_size),
+      max_memtable_bytes_(max_memtable_bytes),
+      max_segments_(std::max<size_t>(max_segments, 1)),
+      resource_manager_(resource_manager) {
+  try {
+    if (fs::exists(sparse_model_store + "/key")) {
+      CK_THROW_(Error_t::WrongInput,
+                sparse_model_store + " is a sparse model file, not a sparse model store");
+    }
+    recover_();
+    open_wal_();
+    compaction_thread_ = std::thread([this] { compaction_loop_(); });
+    if (get_num_segments() > max_segments_) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      compaction_requested_ = true;
+      cond_.notify_all();
+    }
+  } catch (const internal_runtime_error &rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception &err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeKey>
+SparseModelStore<TypeKey>::~SparseModelStore() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if (compaction_thread_.joinable()) {
+    compaction_thread_.join();
+  }
+  if (wal_fd_ != -1) {
+    close(wal_fd_);
+  }
+}
+
+template <typename TypeKey>
+bool SparseModelStore<TypeKey>::contains(TypeKey key) const {
+  if (mem_index_.contains(key)) return true;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &segment : segments_) {
+    if (segment->index.contains(key)) return true;
+  }
+  return false;
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::load_exist_vec_by_key(const std::vector<TypeKey> &keys,
+                                                      std::vector<size_t> &slots,
+                                                      std::vector<float> &vecs) {
+  try {
+    const auto segments = get_segments_();
+    vecs.resize(keys.size() * emb_vec_size_);
+    if (!is_distributed_) slots.resize(keys.size());
+
+    std::atomic<bool> all_keys_found(true);
+    #pragma omp parallel for num_threads(8)
+    for (size_t i = 0; i < keys.size(); i++) {
+      size_t slot_id, row;
+      const float *src = nullptr;
+      if (mem_index_.find(keys[i], slot_id, row)) {
+        src = &mem_vecs_[row * emb_vec_size_];
+      } else {
+        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+          if ((*it)->index.find(keys[i], slot_id, row)) {
+            src = (*it)->vecs + row * emb_vec_size_;
+            break;
+          }
+        }
+      }
+      if (src == nullptr) {
+        all_keys_found = false;
+        continue;
+      }
+      memcpy(&vecs[i * emb_vec_size_], src, emb_vec_size_ * sizeof(float));
+      if (!is_distributed_) slots[i] = slot_id;
+    }
+    if (!all_keys_found) {
+      CK_THROW_(Error_t::WrongInput, "Some keys don't exist in the sparse model store");
+    }
+  } catch (const internal_runtime_error &rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception &err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::commit(const std::vector<TypeKey> &keys, const size_t *slots,
+                                       const std::vector<size_t> &vec_indices,
+                                       const float *vecs) {
+  try {
+    if (keys.size() != vec_indices.size()) {
+      CK_THROW_(Error_t::WrongInput, "keys.size() != vec_indices.size()");
+    }
+    if (!is_distributed_ && slots == nullptr && !keys.empty()) {
+      CK_THROW_(Error_t::WrongInput, "slots are needed by a localized embedding");
+    }
+    check_compaction_error_();
+    if (keys.empty()) return;
+
+    const size_t num_keys = keys.size();
+    const size_t row_bytes = sizeof(long long) + (is_distributed_ ? 0 : sizeof(size_t)) +
+                             emb_vec_size_ * sizeof(float);
+    const size_t record_bytes = sizeof(WalRecordHeader) + num_keys * row_bytes;
+
+    if (record_bytes > max_memtable_bytes_) {
+      // a large pass is committed as a segment of its own, the last vector of a key kept
+      std::vector<size_t> order(num_keys);
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(),
+                       [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+      std::vector<TypeKey> pass_keys;
+      std::vector<size_t> pass_slots;
+      std::vector<const float *> pass_vecs;
+      pass_keys.reserve(num_keys);
+      pass_vecs.reserve(num_keys);
+      for (size_t i = 0; i < num_keys; i++) {
+        if (i + 1 < num_keys && keys[order[i + 1]] == keys[order[i]]) continue;
+        pass_keys.push_back(keys[order[i]]);
+        if (!is_distributed_) pass_slots.push_back(slots[order[i]]);
+        pass_vecs.push_back(vecs + vec_indices[order[i]] * emb_vec_size_);
+      }
+      uint64_t segment_id;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segment_id = next_file_id_++;
+      }
+      flush_memtable_(write_segment_(segment_id, pass_keys, pass_slots, pass_vecs));
+      return;
+    }
+
+    std::vector<char> record(record_bytes);
+    WalRecordHeader header = {kWalMagic, 0, num_keys};
+    char *payload = record.data() + sizeof(header);
+    long long *record_keys = reinterpret_cast<long long *>(payload);
+    size_t *record_slots = reinterpret_cast<size_t *>(payload + num_keys * sizeof(long long));
+    float *record_vecs = reinterpret_cast<float *>(
+        payload + num_keys * (sizeof(long long) + (is_distributed_ ? 0 : sizeof(size_t))));
+    for (size_t i = 0; i < num_keys; i++) {
+      record_keys[i] = static_cast<long long>(keys[i]);
+      if (!is_distributed_) record_slots[i] = slots[i];
+      memcpy(record_vecs + i * emb_vec_size_, vecs + vec_indices[i] * emb_vec_size_,
+             emb_vec_size_ * sizeof(float));
+    }
+    const uint32_t crc = crc32c_extend(0, reinterpret_cast<const char *>(&header.num_keys),
+                                       sizeof(header.num_keys));
+    header.crc = crc32c_extend(crc, payload, record_bytes - sizeof(header));
+    memcpy(record.data(), &header, sizeof(header));
+    write_all(wal_fd_, record.data(), record.size());
+    sync_fd(wal_fd_);
+    wal_bytes_ += record_bytes;
+
+    for (size_t i = 0; i < num_keys; i++) {
+      insert_to_memtable_(keys[i], is_distributed_ ? 0 : slots[i],
+                          record_vecs + i * emb_vec_size_);
+    }
+    if (wal_bytes_ >= max_memtable_bytes_) {
+      flush_memtable_(nullptr);
+    }
+  } catch (const internal_runtime_error &rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception &err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::flush() {
+  try {
+    if (!mem_keys_.empty()) {
+      flush_memtable_(nullptr);
+    }
+  } catch (const internal_runtime_error &rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception &err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::compact() {
+  try {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      compaction_requested_ = true;
+      cond_.notify_all();
+      cond_.wait(lock, [this] {
+        return (!compaction_requested_ && !compacting_) || !compaction_error_.empty();
+      });
+    }
+    check_compaction_error_();
+  } catch (const internal_runtime_error &rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception &err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template <typename TypeKey>
+void SparseModelStore<TypeKey>::load_emb_tbl_to_mem(KeyIndexType &mem_key_index_map,
+                                                    std::vector<float> &vecs) {
+  try {
+    std::vector<TypeKey> keys;
+    std::vector<size_t> slots;
+    vecs.clear();
+    for_each_live_(get_segments_(), true, [&](TypeKey key, size_t slot_id, const float *vec) {
+      keys.push_back(key);
+      if (!is_distributed_) slots.push_back(slot_id);
+      vecs.insert(vecs.end(), vec, vec + emb_vec_size_);
+    });
+    std::vector<size_t> mem_idx(keys.size());
+    std::iota(mem_idx.begin(), mem_idx.end(), 0);
+    mem_key_index_map.build(keys, slots, mem_idx);
+  } catch (const internal_runtime_error &rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    throw;
+  } catch (const std::exception &err) {
+    std::cerr << err.what() << std::endl;
+    throw;
+  }
+}
+
+template class SparseModelStore<long long>;
+template class SparseModelStore<unsigned>;
+
+}  // namespace HugeCTR
@@ -61,7 +61,8 @@ void create_datareader<TypeKey>::operator()(
   auto dense_dim = get_value_from_json<int>(j_dense, "dense_dim");
 
   const std::map<std::string, Check_t> CHECK_TYPE_MAP = {{"Sum", Check_t::Sum},
-                                                         {"None", Check_t::None}};
+                                                         {"None", Check_t::None},
+                                                         {"CRC32C", Check_t::CRC32C}};
 
   Check_t check_type;
   const auto check_str = get_value_from_json<std::string>(j, "check");
@@ -158,7 +159,15 @@ void create_datareader<TypeKey>::operator()(
   switch (format) {
     case DataReaderType_t::Norm: {
       bool start_right_now = repeat_dataset_;
-      train_data_reader->create_drwg_norm(source_data, check_type, start_right_now);
+      // the samples of the training data set are drawn at random from a pool of several files
+      ShuffleBufferParam shuffle_buffer;
+      shuffle_buffer.memory_bytes =
+          get_value_from_json_soft<size_t>(j, "shuffle_buffer_mb", 0) << 20;
+      shuffle_buffer.num_open_files = get_value_from_json_soft<int>(j, "shuffle_open_files", 4);
+      shuffle_buffer.seed = get_value_from_json_soft<unsigned long long>(j, "shuffle_seed", 0);
+      const bool shuffle_blocks = get_value_from_json_soft<bool>(j, "shuffle_blocks", false);
+      train_data_reader->create_drwg_norm(source_data, check_type, start_right_now,
+                                          shuffle_blocks, shuffle_buffer);
       evaluate_data_reader->create_drwg_norm(eval_source, check_type, start_right_now);
       break;
     }
@@ -166,10 +175,13 @@ void create_datareader<TypeKey>::operator()(
       const auto num_samples = get_value_from_json<long long>(j, "num_samples");
       const auto eval_num_samples = get_value_from_json<long long>(j, "eval_num_samples");
       bool float_label_dense = get_value_from_json_soft<bool>(j, "float_label_dense", false);
+      const auto seed = get_value_from_json_soft<unsigned long long>(j, "shuffle_seed", 0);
+      const bool use_huge_pages = get_value_from_json_soft<bool>(j, "use_huge_pages", false);
       train_data_reader->create_drwg_raw(source_data, num_samples, float_label_dense,
-                                         true, false);
+                                         true, false, seed, use_huge_pages);
       evaluate_data_reader->create_drwg_raw(eval_source, eval_num_samples,
-                                            float_label_dense, false, false);
+                                            float_label_dense, false, false, seed,
+                                            use_huge_pages);
 
       break;
     }
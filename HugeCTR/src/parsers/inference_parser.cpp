@@ -22,12 +22,29 @@ InferenceParams::InferenceParams(const std::string& model_name, const size_t max
                   const std::string& dense_model_file, const std::vector<std::string>& sparse_model_files,
                   const int device_id, const bool use_gpu_embedding_cache, const float cache_size_percentage,
                   const bool i64_input_key, const bool use_mixed_precision, const float scaler,
-                  const bool use_algorithm_search, const bool use_cuda_graph)
+                  const bool use_algorithm_search, const bool use_cuda_graph,
+                  const bool use_mmap_sparse_model, const bool use_host_embedding_cache,
+                  const float host_cache_size_percentage, const size_t host_cache_set_associativity,
+                  const CacheEvictionPolicy_t host_cache_eviction_policy,
+                  const size_t host_cache_lfu_aging_queries_per_way,
+                  const bool use_bf16_packed_weights,
+                  const size_t num_cpu_workspaces,
+                  const size_t num_look_up_threads,
+                  const std::string& sparse_model_index_cache_dir)
   : model_name(model_name), max_batchsize(max_batchsize), hit_rate_threshold(hit_rate_threshold),
     dense_model_file(dense_model_file), sparse_model_files(sparse_model_files), device_id(device_id),
     use_gpu_embedding_cache(use_gpu_embedding_cache), cache_size_percentage(cache_size_percentage),
     i64_input_key(i64_input_key), use_mixed_precision(use_mixed_precision), scaler(scaler),
-    use_algorithm_search(use_algorithm_search), use_cuda_graph(use_cuda_graph) {}
+    use_algorithm_search(use_algorithm_search), use_cuda_graph(use_cuda_graph),
+    use_mmap_sparse_model(use_mmap_sparse_model), use_host_embedding_cache(use_host_embedding_cache),
+    host_cache_size_percentage(host_cache_size_percentage),
+    host_cache_set_associativity(host_cache_set_associativity),
+    host_cache_eviction_policy(host_cache_eviction_policy),
+    host_cache_lfu_aging_queries_per_way(host_cache_lfu_aging_queries_per_way),
+    use_bf16_packed_weights(use_bf16_packed_weights),
+    num_cpu_workspaces(num_cpu_workspaces),
+    num_look_up_threads(num_look_up_threads),
+    sparse_model_index_cache_dir(sparse_model_index_cache_dir) {}
 
 template <typename TypeEmbeddingComp>
 void InferenceParser::create_pipeline_inference(const InferenceParams& inference_params,
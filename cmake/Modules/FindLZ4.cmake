@@ -0,0 +1,41 @@
+# 
+# Copyright (c) 2021, NVIDIA CORPORATION.
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+# 
+#      http://www.apache.org/licenses/LICENSE-2.0
+# 
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+set(LZ4_INC_PATHS
+    /usr/include
+    /usr/local/include
+    $ENV{LZ4_DIR}/include
+    )
+
+set(LZ4_LIB_PATHS
+    /lib
+    /lib64
+    /usr/lib
+    /usr/lib64
+    /usr/local/lib
+    /usr/local/lib64
+    $ENV{LZ4_DIR}/lib
+    )
+
+find_path(LZ4_INCLUDE_DIR NAMES lz4.h PATHS ${LZ4_INC_PATHS})
+find_library(LZ4_LIBRARIES NAMES lz4 PATHS ${LZ4_LIB_PATHS})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(LZ4 DEFAULT_MSG LZ4_INCLUDE_DIR LZ4_LIBRARIES)
+
+if (LZ4_FOUND)
+  message(STATUS "Found LZ4    (include: ${LZ4_INCLUDE_DIR}, library: ${LZ4_LIBRARIES})")
+  mark_as_advanced(LZ4_INCLUDE_DIR LZ4_LIBRARIES)
+endif ()
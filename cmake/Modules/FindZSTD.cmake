@@ -0,0 +1,41 @@
+# 
+# Copyright (c) 2021, NVIDIA CORPORATION.
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+# 
+#      http://www.apache.org/licenses/LICENSE-2.0
+# 
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+set(ZSTD_INC_PATHS
+    /usr/include
+    /usr/local/include
+    $ENV{ZSTD_DIR}/include
+    )
+
+set(ZSTD_LIB_PATHS
+    /lib
+    /lib64
+    /usr/lib
+    /usr/lib64
+    /usr/local/lib
+    /usr/local/lib64
+    $ENV{ZSTD_DIR}/lib
+    )
+
+find_path(ZSTD_INCLUDE_DIR NAMES zstd.h PATHS ${ZSTD_INC_PATHS})
+find_library(ZSTD_LIBRARIES NAMES zstd PATHS ${ZSTD_LIB_PATHS})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(ZSTD DEFAULT_MSG ZSTD_INCLUDE_DIR ZSTD_LIBRARIES)
+
+if (ZSTD_FOUND)
+  message(STATUS "Found ZSTD    (include: ${ZSTD_INCLUDE_DIR}, library: ${ZSTD_LIBRARIES})")
+  mark_as_advanced(ZSTD_INCLUDE_DIR ZSTD_LIBRARIES)
+endif ()
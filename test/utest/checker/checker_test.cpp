@@ -14,9 +14,12 @@
  * limitations under the License.
  */
 
+#include "HugeCTR/include/data_readers/check_crc32c.hpp"
 #include "HugeCTR/include/data_readers/check_sum.hpp"
 #include "HugeCTR/include/common.hpp"
 #include "HugeCTR/include/data_readers/file_source.hpp"
+#include "HugeCTR/include/data_readers/norm_v2.hpp"
+#include "HugeCTR/include/data_readers/norm_v2_block_list.hpp"
 #include "gtest/gtest.h"
 
 using namespace HugeCTR;
@@ -64,3 +67,286 @@ TEST(checker, CheckSum) {
   // }
   EXPECT_EQ(strncmp(tmp1, str, NUM_CHAR), 0);
 }
+
+TEST(checker, FileSourceChunks) {
+  // a file a few chunks long, read in pieces that straddle the chunk boundaries
+  const size_t chunk_size = 4096;
+  std::vector<char> data(3 * chunk_size + 123);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i * 7 + i / 251);
+  }
+  {
+    std::ofstream out_stream("file2.txt", std::ofstream::binary);
+    out_stream.write(data.data(), data.size());
+    out_stream.close();
+    out_stream.open("file_list2.txt", std::ofstream::out);
+    out_stream << "1\nfile2.txt";
+  }
+
+  for (bool view : {false, true}) {
+    FileSource file_source(0, 1, "file_list2.txt", true, chunk_size);
+    ASSERT_EQ(file_source.next_source(), Error_t::Success);
+    std::vector<char> buffer(data.size());
+    size_t pos = 0;
+    for (size_t len = 1; pos + len <= data.size(); len = len * 3 % 1021 + 1) {
+      if (view) {
+        const char* ptr = nullptr;
+        ASSERT_EQ(file_source.read_view(&ptr, len), Error_t::Success);
+        memcpy(buffer.data() + pos, ptr, len);
+      } else {
+        ASSERT_EQ(file_source.read(buffer.data() + pos, len), Error_t::Success);
+      }
+      pos += len;
+    }
+    ASSERT_EQ(file_source.read(buffer.data() + pos, data.size() - pos), Error_t::Success);
+    EXPECT_EQ(memcmp(buffer.data(), data.data(), data.size()), 0);
+    char tmp;
+    EXPECT_EQ(file_source.read(&tmp, 1), Error_t::OutOfBound);
+  }
+}
+
+TEST(checker, CheckSumView) {
+  // many small blocks, so that some block and check_sum end up across the chunk boundaries
+  const size_t chunk_size = 4096;
+  const int num_blocks = 1000;
+  {
+    std::ofstream out_stream("file3.txt", std::ofstream::binary);
+    for (int i = 0; i < num_blocks; i++) {
+      std::string str(i % 13 + 1, static_cast<char>('a' + i % 26));
+      int count = str.length();
+      char sum = 0;
+      for (char c : str) {
+        sum += c;
+      }
+      if (i == num_blocks / 2) {
+        sum++;
+      }
+      out_stream.write(reinterpret_cast<char*>(&count), sizeof(int));
+      out_stream.write(str.c_str(), count);
+      out_stream.write(reinterpret_cast<char*>(&sum), sizeof(char));
+    }
+    out_stream.close();
+    out_stream.open("file_list3.txt", std::ofstream::out);
+    out_stream << "1\nfile3.txt";
+  }
+
+  FileSource file_source(0, 1, "file_list3.txt", true, chunk_size);
+  CheckSum check_sum(file_source);
+  check_sum.next_source();
+  for (int i = 0; i < num_blocks; i++) {
+    const size_t count = i % 13 + 1;
+    const char* ptr = nullptr;
+    const Error_t end_of_block =
+        i == num_blocks / 2 ? Error_t::DataCheckError : Error_t::Success;
+    // the first byte alone, then the rest of the block
+    ASSERT_EQ(check_sum.read_view(&ptr, 1), count == 1 ? end_of_block : Error_t::Success);
+    EXPECT_EQ(*ptr, static_cast<char>('a' + i % 26));
+    if (count > 1) {
+      EXPECT_EQ(check_sum.read_view(&ptr, count - 1), end_of_block);
+      EXPECT_EQ(std::string(ptr, count - 1), std::string(count - 1, 'a' + i % 26));
+    }
+  }
+}
+
+TEST(checker, CRC32C) {
+  // the check value of CRC-32C
+  EXPECT_EQ(crc32c("123456789", 9), 0xe3069283u);
+
+  std::vector<char> data(1000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i * 31 + i / 7);
+  }
+  for (size_t len : {0, 1, 7, 8, 9, 63, 1000}) {
+    const uint32_t crc = crc32c(data.data(), len);
+    EXPECT_EQ(~crc32c_internal::update_sw(~0u, data.data(), len), crc);
+    EXPECT_EQ(crc32c_extend(crc32c(data.data(), len / 3), data.data() + len / 3, len - len / 3),
+              crc);
+  }
+}
+
+TEST(checker, CheckCRC32CView) {
+  // blocks of the size of a sample, some end up across the chunk boundaries
+  const size_t chunk_size = 4096;
+  const int num_blocks = 300;
+  {
+    std::ofstream out_stream("file4.txt", std::ofstream::binary);
+    for (int i = 0; i < num_blocks; i++) {
+      std::string str(i % 61 + 1, static_cast<char>('a' + i % 26));
+      int count = str.length();
+      uint32_t crc = crc32c(str.c_str(), count);
+      if (i == num_blocks / 2) {
+        crc++;
+      }
+      out_stream.write(reinterpret_cast<char*>(&count), sizeof(int));
+      out_stream.write(str.c_str(), count);
+      out_stream.write(reinterpret_cast<char*>(&crc), sizeof(uint32_t));
+    }
+    out_stream.close();
+    out_stream.open("file_list4.txt", std::ofstream::out);
+    out_stream << "1\nfile4.txt";
+  }
+
+  FileSource file_source(0, 1, "file_list4.txt", true, chunk_size);
+  CheckCRC32C check_crc32c(file_source);
+  check_crc32c.next_source();
+  for (int i = 0; i < num_blocks; i++) {
+    const size_t count = i % 61 + 1;
+    const Error_t end_of_block =
+        i == num_blocks / 2 ? Error_t::DataCheckError : Error_t::Success;
+    // the first byte copied, then the rest of the block viewed
+    char first;
+    ASSERT_EQ(check_crc32c.read(&first, 1), count == 1 ? end_of_block : Error_t::Success);
+    EXPECT_EQ(first, static_cast<char>('a' + i % 26));
+    if (count > 1) {
+      const char* ptr = nullptr;
+      EXPECT_EQ(check_crc32c.read_view(&ptr, count - 1), end_of_block);
+      EXPECT_EQ(std::string(ptr, count - 1), std::string(count - 1, 'a' + i % 26));
+    }
+  }
+  // past the end of the file
+  char tmp;
+  EXPECT_EQ(check_crc32c.read(&tmp, 1), Error_t::OutOfBound);
+}
+
+void norm_v2_test_impl(Compression_t compression) {
+  // 2 v1 files of 1 slot, the key of each record is its global index
+  const int num_records[] = {1000, 77};
+  const long long records_per_block = 64;
+  {
+    std::ofstream file_list("file_list5.txt", std::ofstream::out);
+    file_list << "2\nfile5_0.v2\nfile5_1.v2";
+  }
+  long long key = 0;
+  for (int f = 0; f < 2; f++) {
+    std::vector<char> data;
+    DataSetHeader header = {1, num_records[f], 1, 2, 1, 0, 0, 0};
+    norm_v2_internal::append_checked(data, reinterpret_cast<char*>(&header), sizeof(header),
+                                     Check_t::Sum);
+    for (int i = 0; i < num_records[f]; i++, key++) {
+      std::vector<char> record(sizeof(float) * 3 + sizeof(int) + sizeof(long long));
+      int nnz = 1;
+      memcpy(record.data() + sizeof(float) * 3, &nnz, sizeof(int));
+      memcpy(record.data() + sizeof(float) * 3 + sizeof(int), &key, sizeof(long long));
+      norm_v2_internal::append_checked(data, record.data(), record.size(), Check_t::Sum);
+    }
+    const std::string src = "file5_" + std::to_string(f) + ".txt";
+    std::ofstream(src, std::ofstream::binary).write(data.data(), data.size());
+    const std::string dst = "file5_" + std::to_string(f) + ".v2";
+    EXPECT_FALSE(is_norm_v2_file(src));
+    EXPECT_EQ(convert_norm_to_v2<long long>(src, dst, Check_t::Sum, records_per_block, true,
+                                            compression),
+              (num_records[f] + records_per_block - 1) / records_per_block);
+    EXPECT_TRUE(is_norm_v2_file(dst));
+    NormV2Footer footer;
+    auto blocks = read_norm_v2_index(dst, &footer);
+    EXPECT_EQ(footer.has_key_range, 1);
+    EXPECT_EQ(footer.compression, static_cast<long long>(compression));
+    EXPECT_EQ(blocks.back().num_records, (num_records[f] - 1) % records_per_block + 1);
+  }
+  EXPECT_TRUE(is_norm_v2_file_list("file_list5.txt"));
+
+  // 2 sources read every other shuffled block of both files, every record is read once per
+  // epoch
+  auto block_list = std::make_shared<NormV2BlockList>("file_list5.txt", true, 7);
+  EXPECT_EQ(block_list->get_num_blocks(), 16 + 2);
+  const size_t max_record_bytes = get_norm_v2_max_record_bytes(3, 1, 1, sizeof(long long));
+  std::vector<std::unique_ptr<FileSource>> sources;
+  std::vector<std::unique_ptr<CheckSum>> checkers;
+  for (int i = 0; i < 2; i++) {
+    sources.emplace_back(new FileSource(block_list, i, 2, false, max_record_bytes, 4096));
+    checkers.emplace_back(new CheckSum(*sources.back()));
+  }
+  std::vector<int> seen(key, 0);
+  std::vector<long long> first_keys[2];
+  for (int turn = 0; turn < 2 * 9 + 2; turn++) {
+    CheckSum& checker = *checkers[turn % 2];
+    if (checker.next_source() == Error_t::EndOfFile) {
+      EXPECT_GE(turn, 2 * 9);
+      continue;
+    }
+    DataSetHeader header;
+    ASSERT_EQ(checker.read(reinterpret_cast<char*>(&header), sizeof(header)), Error_t::Success);
+    ASSERT_LE(header.number_of_records, records_per_block);
+    long long first_key = -1;
+    for (long long i = 0; i < header.number_of_records; i++) {
+      const char* ptr = nullptr;
+      ASSERT_EQ(checker.read_view(&ptr, sizeof(float) * 3), Error_t::Success);
+      int nnz;
+      ASSERT_EQ(checker.read(reinterpret_cast<char*>(&nnz), sizeof(int)), Error_t::Success);
+      ASSERT_EQ(nnz, 1);
+      long long record_key;
+      ASSERT_EQ(checker.read(reinterpret_cast<char*>(&record_key), sizeof(long long)),
+                Error_t::Success);
+      if (first_key < 0) {
+        first_key = record_key;
+        first_keys[turn % 2].push_back(first_key);
+      }
+      EXPECT_EQ(record_key, first_key + i);
+      seen[record_key]++;
+    }
+    char tmp;
+    EXPECT_NE(sources[turn % 2]->read(&tmp, 1), Error_t::Success);
+  }
+  EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), key);
+
+  // the blocks of each position only depend on the seed and the epoch
+  NormV2BlockList same_seed("file_list5.txt", true, 7), other_seed("file_list5.txt", true, 8);
+  bool is_other_order = false, is_other_epoch = false;
+  for (unsigned long long position = 0; position < 18; position++) {
+    NormV2BlockList::Block block, same_block, other_block, next_epoch_block;
+    ASSERT_TRUE(block_list->get_block(position, false, &block));
+    ASSERT_TRUE(same_seed.get_block(position, false, &same_block));
+    ASSERT_TRUE(other_seed.get_block(position, false, &other_block));
+    ASSERT_TRUE(block_list->get_block(position + 18, true, &next_epoch_block));
+    EXPECT_EQ(block.info.offset, same_block.info.offset);
+    EXPECT_EQ(block.file_id, same_block.file_id);
+    is_other_order |= block.info.offset != other_block.info.offset ||
+                      block.file_id != other_block.file_id;
+    is_other_epoch |= block.info.offset != next_epoch_block.info.offset ||
+                      block.file_id != next_epoch_block.file_id;
+  }
+  EXPECT_TRUE(is_other_order);
+  EXPECT_TRUE(is_other_epoch);
+  NormV2BlockList::Block block;
+  EXPECT_FALSE(block_list->get_block(18, false, &block));
+  EXPECT_EQ(first_keys[0].size(), 9u);
+  EXPECT_EQ(first_keys[1].size(), 9u);
+
+  // a decompressed size beyond the records of the block is a broken file, not an allocation
+  if (compression != Compression_t::None) {
+    FileSource small_records(block_list, 0, 1, false, 1);
+    EXPECT_EQ(small_records.next_source(), Error_t::BrokenFile);
+  }
+}
+
+TEST(checker, NormV2) { norm_v2_test_impl(Compression_t::None); }
+#ifdef ENABLE_COMPRESSION
+TEST(checker, NormV2LZ4) { norm_v2_test_impl(Compression_t::LZ4); }
+TEST(checker, NormV2Zstd) { norm_v2_test_impl(Compression_t::Zstd); }
+
+TEST(checker, BlockCodec) {
+  std::vector<char> data(100000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i % 251 < 100 ? i % 7 : i % 251);
+  }
+  for (Compression_t compression : {Compression_t::LZ4, Compression_t::Zstd}) {
+    std::vector<char> block;
+    compress_block(compression, data.data(), data.size(), &block);
+    EXPECT_LT(block.size(), data.size());
+    ASSERT_EQ(get_decompressed_size(block.data(), block.size()), data.size());
+    std::vector<char> out(data.size());
+    EXPECT_TRUE(decompress_block(compression, block.data(), block.size(), out.data()));
+    EXPECT_EQ(out, data);
+    // a truncated block is detected
+    EXPECT_FALSE(decompress_block(compression, block.data(), block.size() / 2, out.data()));
+  }
+}
+#else
+TEST(checker, BlockCodecDisabled) {
+  std::vector<char> data(1000), block;
+  EXPECT_THROW(compress_block(Compression_t::LZ4, data.data(), data.size(), &block),
+               internal_runtime_error);
+  EXPECT_THROW(check_compression(Compression_t::Zstd), internal_runtime_error);
+  EXPECT_NO_THROW(check_compression(Compression_t::None));
+}
+#endif
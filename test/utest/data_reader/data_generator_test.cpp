@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <iterator>
+
+#include "HugeCTR/include/data_readers/mmap_offset_list.hpp"
+#include "HugeCTR/include/parallel_data_generator.hpp"
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+
+namespace {
+
+const int label_dim = 1;
+const int dense_dim = 13;
+const std::vector<size_t> voc_size_array = {100, 20000, 7, 3000};
+const std::vector<int> nnz_array = {1, 3, 1, 2};
+
+std::vector<char> read_file(const std::string& file_name) {
+  std::ifstream stream(file_name, std::ifstream::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(stream),
+                           std::istreambuf_iterator<char>());
+}
+
+std::vector<char> generate_norm(const std::string& name, int num_threads, uint64_t seed,
+                                Compression_t compression = Compression_t::None) {
+  const std::string file_list_name = "./" + name + "_file_list.txt";
+  std::remove(file_list_name.c_str());
+  parallel_data_generation_for_norm<long long, Check_t::Sum>(
+      file_list_name, "./" + name + "/gen_", 3, 5000, voc_size_array.size(), voc_size_array,
+      label_dim, dense_dim, nnz_array, true, 1.3, seed, num_threads, compression);
+  std::vector<char> data;
+  for (int k = 0; k < 3; k++) {
+    auto file = read_file("./" + name + "/gen_" + std::to_string(k) + ".data");
+    data.insert(data.end(), file.begin(), file.end());
+  }
+  return data;
+}
+
+std::vector<char> read_raw(const std::string& file_name, long long num_samples, long long stride) {
+  MmapOffsetList offset_list(file_name, num_samples, stride, num_samples, false, 1, false);
+  MmapOffset offset;
+  offset_list.get_offset(0, 0, &offset);
+  RawBatchBuffer batch_buffer;
+  if (offset_list.is_compressed()) {
+    offset_list.decompress_batch(&offset, &batch_buffer);
+  }
+  std::vector<char> data;
+  for (const MmapChunk& chunk : offset.chunks) {
+    data.insert(data.end(), chunk.offset, chunk.offset + chunk.samples * stride);
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(data_generator, norm_deterministic) {
+  const auto data = generate_norm("gen_norm_1", 1, 42);
+  // the same data set whatever the number of threads, another one with another seed
+  EXPECT_EQ(generate_norm("gen_norm_3", 3, 42), data);
+  EXPECT_NE(generate_norm("gen_norm_seed", 3, 43), data);
+  // the keys are in the range of their slot
+  const long long stride_header = sizeof(DataSetHeader) + sizeof(int) + sizeof(char);
+  const char* ptr = data.data() + stride_header;
+  for (int i = 0; i < 5000; i++) {
+    ptr += sizeof(int) + (label_dim + dense_dim) * sizeof(float);
+    size_t first_key = 0;
+    for (size_t k = 0; k < voc_size_array.size(); k++) {
+      int nnz;
+      memcpy(&nnz, ptr, sizeof(int));
+      ASSERT_EQ(nnz, nnz_array[k]);
+      ptr += sizeof(int);
+      for (int j = 0; j < nnz; j++) {
+        long long key;
+        memcpy(&key, ptr, sizeof(long long));
+        ASSERT_GE(key, first_key);
+        ASSERT_LT(key, first_key + voc_size_array[k]);
+        ptr += sizeof(long long);
+      }
+      first_key += voc_size_array[k];
+    }
+    ptr += sizeof(char);
+  }
+}
+
+#ifdef ENABLE_COMPRESSION
+TEST(data_generator, norm_compressed) {
+  generate_norm("gen_norm_lz4", 2, 42, Compression_t::LZ4);
+  for (int k = 0; k < 3; k++) {
+    NormV2Footer footer;
+    auto blocks = read_norm_v2_index("./gen_norm_lz4/gen_" + std::to_string(k) + ".data", &footer);
+    EXPECT_EQ(footer.compression, static_cast<long long>(Compression_t::LZ4));
+    EXPECT_EQ(blocks.size(), 2);
+  }
+}
+#endif
+
+TEST(data_generator, raw_deterministic) {
+  const long long num_samples = 100000;
+  const long long samples_per_block = 500;
+  long long stride = (label_dim + dense_dim) * sizeof(float);
+  for (int nnz : nnz_array) {
+    stride += nnz * sizeof(unsigned int);
+  }
+  auto generate = [&](const std::string& file_name, int num_threads, Compression_t compression) {
+    std::remove(file_name.c_str());
+    parallel_data_generation_for_raw<unsigned int>(file_name, num_samples, label_dim, dense_dim,
+                                                   true, voc_size_array, nnz_array, false, 0, 7,
+                                                   num_threads, compression, samples_per_block);
+    return read_raw(file_name, num_samples, stride);
+  };
+  const auto data = generate("./gen_raw_1.bin", 1, Compression_t::None);
+  ASSERT_EQ(data.size(), num_samples * stride);
+  EXPECT_EQ(read_file("./gen_raw_1.bin"), data);
+  EXPECT_EQ(generate("./gen_raw_4.bin", 4, Compression_t::None), data);
+#ifdef ENABLE_COMPRESSION
+  // compressed or not, the samples are the same
+  EXPECT_EQ(generate("./gen_raw_zstd.bin", 4, Compression_t::Zstd), data);
+  EXPECT_LT(read_file("./gen_raw_zstd.bin").size(), data.size());
+#endif
+}
@@ -314,6 +314,98 @@ void data_reader_raw_test_impl(const std::vector<int> &device_list, int num_thre
   }
 }
 
+void mmap_offset_list_shuffle_test_impl(long long chunk_samples, int num_workers, bool repeat,
+                                        Compression_t compression = Compression_t::None) {
+  // every sample of the file is its index
+  const long long num_samples = 1000;
+  const long long batchsize = 64;
+  const std::string shuffle_file_name = "./shuffle_data.bin";
+  if (compression != Compression_t::None) {
+    // the blocks are the chunks of the shuffle
+    RawCompressedWriter writer(shuffle_file_name, sizeof(long long), chunk_samples, compression);
+    for (long long i = 0; i < num_samples; i++) {
+      writer.append(reinterpret_cast<const char*>(&i));
+    }
+  } else {
+    std::ofstream out_stream(shuffle_file_name, std::ofstream::binary);
+    for (long long i = 0; i < num_samples; i++) {
+      out_stream.write(reinterpret_cast<const char*>(&i), sizeof(long long));
+    }
+  }
+  const long long num_batches = (num_samples - 1) / batchsize + 1;
+  auto read_epochs = [&](long long readahead_batches, uint64_t seed) {
+    MmapOffsetList offset_list(shuffle_file_name, num_samples, sizeof(long long), batchsize, true,
+                               num_workers, repeat, chunk_samples, seed, readahead_batches);
+    EXPECT_EQ(offset_list.is_compressed(), compression != Compression_t::None);
+    std::vector<long long> samples;
+    MmapOffset offset;
+    RawBatchBuffer batch_buffer;
+    const long long num_epochs = repeat ? 3 : 1;
+    for (long long pos = 0; pos < num_batches * num_epochs; pos++) {
+      offset_list.get_offset(pos / num_workers, pos % num_workers, &offset);
+      EXPECT_EQ(offset.samples, pos % num_batches == num_batches - 1
+                                    ? num_samples - (num_batches - 1) * batchsize
+                                    : batchsize);
+      if (offset_list.is_compressed()) {
+        offset_list.decompress_batch(&offset, &batch_buffer);
+      }
+      for (const MmapChunk& chunk : offset.chunks) {
+        const long long* first = reinterpret_cast<const long long*>(chunk.offset);
+        samples.insert(samples.end(), first, first + chunk.samples);
+      }
+    }
+    if (!repeat) {
+      EXPECT_THROW(offset_list.get_offset(num_batches / num_workers, num_batches % num_workers,
+                                          &offset),
+                   internal_runtime_error);
+    }
+    return samples;
+  };
+
+  std::vector<long long> samples = read_epochs(0, 1234);
+  // reproducible, with or without the readahead, and another seed gives another order
+  EXPECT_EQ(read_epochs(2 * num_workers, 1234), samples);
+  EXPECT_NE(read_epochs(0, 4321), samples);
+  for (size_t epoch = 0; epoch * num_samples < samples.size(); epoch++) {
+    std::vector<long long> epoch_samples(samples.begin() + epoch * num_samples,
+                                         samples.begin() + (epoch + 1) * num_samples);
+    // shuffled, in runs of chunk_samples
+    EXPECT_NE(epoch_samples[0] + chunk_samples, epoch_samples[chunk_samples]);
+    for (long long i = 0; i < num_samples; i++) {
+      if (i % chunk_samples != 0) {
+        EXPECT_EQ(epoch_samples[i], epoch_samples[i - 1] + 1);
+      }
+    }
+    std::sort(epoch_samples.begin(), epoch_samples.end());
+    for (long long i = 0; i < num_samples; i++) {
+      ASSERT_EQ(epoch_samples[i], i);
+    }
+  }
+  if (repeat) {
+    // each epoch has its own order
+    EXPECT_FALSE(std::equal(samples.begin(), samples.begin() + num_samples,
+                            samples.begin() + num_samples));
+  }
+}
+
+TEST(data_reader_raw, mmap_offset_list_shuffle_test_1) {
+  mmap_offset_list_shuffle_test_impl(8, 1, true);
+}
+TEST(data_reader_raw, mmap_offset_list_shuffle_test_2) {
+  mmap_offset_list_shuffle_test_impl(5, 3, true);
+}
+TEST(data_reader_raw_epoch, mmap_offset_list_shuffle_test_1) {
+  mmap_offset_list_shuffle_test_impl(16, 2, false);
+}
+#ifdef ENABLE_COMPRESSION
+TEST(data_reader_raw, mmap_offset_list_lz4_test) {
+  mmap_offset_list_shuffle_test_impl(8, 2, true, Compression_t::LZ4);
+}
+TEST(data_reader_raw_epoch, mmap_offset_list_zstd_test) {
+  mmap_offset_list_shuffle_test_impl(16, 3, false, Compression_t::Zstd);
+}
+#endif
+
 TEST(data_reader_raw, data_reader_worker_raw_float_test) {
   data_reader_worker_raw_test_impl(true, true);
 }
@@ -213,6 +213,36 @@ void data_reader_norm_test_impl(const std::vector<int> &device_list, int num_thr
 
 }
 
+TEST(data_reader_worker, buffer_state_handoff_test) {
+  // a worker and a collector hand 1 buffer back and forth
+  WaitableBufferState state(BufferState::ReadyForWrite);
+  const int num_batches = 10000;
+  long long payload = 0;
+  std::thread worker([&]() {
+    for (int i = 0; i < num_batches; i++) {
+      ASSERT_TRUE(state.wait_and_exchange(BufferState::ReadyForWrite, BufferState::Writing,
+                                          []() { return false; }));
+      payload = i;
+      state.store(BufferState::ReadyForRead);
+    }
+  });
+  for (int i = 0; i < num_batches; i++) {
+    state.wait_and_exchange(BufferState::ReadyForRead, BufferState::Reading);
+    ASSERT_EQ(payload, i);
+    state.store(BufferState::ReadyForWrite);
+  }
+  worker.join();
+
+  // a wait gives up once its abort condition is set
+  std::atomic<bool> stop{false};
+  std::thread waiter([&]() {
+    EXPECT_FALSE(state.wait_for(BufferState::FileEOF, [&]() { return stop.load(); }));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  stop = true;
+  waiter.join();
+}
+
 TEST(data_reader_worker, data_reader_worker_test_1) {
   data_reader_worker_norm_test_impl(true);
 }
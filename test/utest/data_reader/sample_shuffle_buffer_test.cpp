@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <set>
+#include <thread>
+
+#include "HugeCTR/include/data_generator.hpp"
+#include "HugeCTR/include/data_readers/data_reader_common.hpp"
+#include "HugeCTR/include/data_readers/data_reader_worker.hpp"
+#include "HugeCTR/include/data_readers/sample_shuffle_buffer.hpp"
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+
+namespace {
+
+using TypeKey = long long;
+
+const std::string file_list_name = "./shuffle_buffer_file_list.txt";
+const int num_files = 4;
+const int samples_per_file = 500;
+const int slot_num = 2;
+const int max_nnz = 3;
+const int batch_size = 64;
+
+/**
+ * The label of a sample is its id in the data set, its nnz and keys are derived from the id.
+ */
+void generate_data_set() {
+  std::ofstream file_list(file_list_name, std::ofstream::out);
+  file_list << num_files << "\n";
+  for (int f = 0; f < num_files; f++) {
+    const std::string file_name = "./shuffle_buffer_" + std::to_string(f) + ".data";
+    file_list << file_name << "\n";
+    std::ofstream out_stream(file_name, std::ofstream::binary);
+    DataWriter<Check_t::Sum> data_writer(out_stream);
+    DataSetHeader header = {1, samples_per_file, 1, 0, slot_num, 0, 0, 0};
+    data_writer.append(reinterpret_cast<char*>(&header), sizeof(DataSetHeader));
+    data_writer.write();
+    for (int i = 0; i < samples_per_file; i++) {
+      const int id = f * samples_per_file + i;
+      float label = id;
+      data_writer.append(reinterpret_cast<char*>(&label), sizeof(float));
+      for (int k = 0; k < slot_num; k++) {
+        int nnz = 1 + (id + k) % max_nnz;
+        data_writer.append(reinterpret_cast<char*>(&nnz), sizeof(int));
+        for (int j = 0; j < nnz; j++) {
+          TypeKey key = id * 10 + k;
+          data_writer.append(reinterpret_cast<char*>(&key), sizeof(TypeKey));
+        }
+      }
+      data_writer.write();
+    }
+  }
+}
+
+/**
+ * Read the data set with a worker without a device.
+ * @return the ids of the samples in the order of the batches
+ */
+std::vector<int> read_data_set(const ShuffleBufferParam& shuffle_buffer,
+                               ShuffleBufferStats* stats = nullptr) {
+  const DataReaderSparseParam param("data", max_nnz, false, slot_num);
+  auto buffer = std::make_shared<ThreadBuffer>();
+  buffer->is_fixed_length.push_back(false);
+  buffer->state.store(BufferState::ReadyForWrite);
+  buffer->current_batch_size = 0;
+  buffer->batch_size = batch_size;
+  buffer->param_num = 1;
+  buffer->label_dim = 1;
+  buffer->dense_dim = 0;
+  buffer->batch_size_start_idx = 0;
+  buffer->batch_size_end_idx = batch_size;
+
+  int loop_flag = 1;
+  DataReaderWorker<TypeKey> worker(0, 1, nullptr, &loop_flag, buffer, file_list_name,
+                                   param.max_feature_num, false, Check_t::Sum, {param}, nullptr,
+                                   shuffle_buffer);
+  // the next batch is only read once the host buffers of the last one are checked
+  std::atomic<bool> next{true};
+  std::atomic<bool> done{false};
+  std::thread reader([&worker, &next, &done]() {
+    while (true) {
+      while (!next.load() && !done.load()) {
+        std::this_thread::yield();
+      }
+      if (done.load()) {
+        break;
+      }
+      next.store(false);
+      worker.read_a_batch();
+    }
+  });
+
+  std::vector<int> ids;
+  while (true) {
+    buffer->state.wait_for(BufferState::ReadyForRead, []() { return false; });
+    const float* labels = worker.get_host_dense_buffer().get_ptr();
+    const auto& csr = worker.get_host_sparse_buffers()[0];
+    const TypeKey* row_offsets = csr.get_row_offset_tensor().get_ptr();
+    const TypeKey* keys = csr.get_value_tensor().get_ptr();
+    for (long long i = 0; i < buffer->current_batch_size; i++) {
+      const int id = static_cast<int>(labels[i]);
+      // the keys of the sample follow it
+      for (int k = 0; k < slot_num; k++) {
+        const TypeKey begin = row_offsets[i * slot_num + k];
+        const TypeKey end = row_offsets[i * slot_num + k + 1];
+        EXPECT_EQ(end - begin, 1 + (id + k) % max_nnz);
+        for (TypeKey j = begin; j < end; j++) {
+          EXPECT_EQ(keys[j], id * 10 + k);
+        }
+      }
+      ids.push_back(id);
+    }
+    if (buffer->current_batch_size == 0) {
+      buffer->state.store(BufferState::ReadyForWrite);
+      buffer->state.wait_for(BufferState::FileEOF, []() { return false; });
+      done.store(true);
+      buffer->state.store(BufferState::ReadyForWrite);
+      break;
+    }
+    buffer->state.store(BufferState::ReadyForWrite);
+    next.store(true);
+  }
+  reader.join();
+  if (stats) {
+    *stats = worker.get_shuffle_buffer_stats();
+  }
+  return ids;
+}
+
+}  // namespace
+
+TEST(sample_shuffle_buffer, draw) {
+  const size_t sample_bytes = sizeof(int);
+  SampleShuffleBuffer shuffle_buffer(sample_bytes, 100 * sample_bytes + 3, 42);
+  EXPECT_EQ(shuffle_buffer.capacity(), 100);
+  std::vector<int> drawn;
+  int next = 0;
+  // draw half of the pool between the fills, like the batches of the worker
+  for (int round = 0; round < 10; round++) {
+    while (!shuffle_buffer.full()) {
+      memcpy(shuffle_buffer.free_entry(), &next, sizeof(int));
+      shuffle_buffer.commit();
+      next++;
+    }
+    for (int i = 0; i < 50; i++) {
+      int value;
+      memcpy(&value, shuffle_buffer.draw(), sizeof(int));
+      drawn.push_back(value);
+    }
+  }
+  while (!shuffle_buffer.empty()) {
+    int value;
+    memcpy(&value, shuffle_buffer.draw(), sizeof(int));
+    drawn.push_back(value);
+  }
+  ASSERT_EQ(drawn.size(), next);
+  EXPECT_FALSE(std::is_sorted(drawn.begin(), drawn.end()));
+  std::sort(drawn.begin(), drawn.end());
+  for (int i = 0; i < next; i++) {
+    EXPECT_EQ(drawn[i], i);
+  }
+  EXPECT_THROW(SampleShuffleBuffer(sample_bytes, sample_bytes - 1, 42), internal_runtime_error);
+}
+
+TEST(sample_shuffle_buffer, worker) {
+  generate_data_set();
+  const int num_samples = num_files * samples_per_file;
+
+  // without a shuffle buffer, the files are read one after another in order
+  auto ids = read_data_set(ShuffleBufferParam());
+  ASSERT_EQ(ids.size(), num_samples);
+  for (int i = 0; i < num_samples; i++) {
+    EXPECT_EQ(ids[i], i);
+  }
+
+  // a pool of 200 samples of the largest size, drawn from the 4 files
+  ShuffleBufferParam shuffle_buffer;
+  shuffle_buffer.memory_bytes =
+      200 * (sizeof(float) + slot_num * sizeof(int) + slot_num * max_nnz * sizeof(TypeKey));
+  shuffle_buffer.num_open_files = num_files;
+  shuffle_buffer.seed = 7;
+  ShuffleBufferStats stats;
+  ids = read_data_set(shuffle_buffer, &stats);
+  EXPECT_EQ(stats.capacity, 200);
+  EXPECT_EQ(stats.samples, num_samples);
+
+  // every file shows up in the first batch
+  std::set<int> first_batch_files;
+  for (int i = 0; i < batch_size; i++) {
+    first_batch_files.insert(ids[i] / samples_per_file);
+  }
+  EXPECT_EQ(first_batch_files.size(), num_files);
+
+  // the same seed gives the same order, another one another order
+  EXPECT_EQ(read_data_set(shuffle_buffer), ids);
+  shuffle_buffer.seed = 8;
+  EXPECT_NE(read_data_set(shuffle_buffer), ids);
+
+  // each sample is read once
+  std::sort(ids.begin(), ids.end());
+  ASSERT_EQ(ids.size(), num_samples);
+  for (int i = 0; i < num_samples; i++) {
+    EXPECT_EQ(ids[i], i);
+  }
+}
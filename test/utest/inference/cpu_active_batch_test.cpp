@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/cpu/layers/fully_connected_layer_cpu.hpp"
+#include "HugeCTR/include/cpu/layers/reshape_layer_cpu.hpp"
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utest/test_utils.h"
+
+using namespace HugeCTR;
+
+namespace {
+
+// a reshape of [batch_size, slot_num, vec_size] into [batch_size * slot_num, vec_size], followed
+// by a fully connected layer on the rows of the slots
+void reshape_partial_batch_test(size_t batch_size, size_t slot_num, size_t vec_size,
+                                size_t out_dim, size_t num_samples) {
+  auto blob_buf = GeneralBuffer2<HostAllocator>::create();
+  auto weight_buf = blob_buf->create_block<float>();
+  auto wgrad_buf = blob_buf->create_block<float>();
+
+  Tensor2<float> input, reshaped, output;
+  blob_buf->reserve({batch_size, slot_num, vec_size}, &input);
+  ReshapeLayerCPU<float> reshape_layer(input, reshaped, blob_buf, vec_size);
+  blob_buf->reserve({batch_size * slot_num, out_dim}, &output);
+  FullyConnectedLayerCPU<float> fc_layer(weight_buf, wgrad_buf, reshaped, output, false);
+  blob_buf->allocate();
+  ASSERT_EQ(reshaped.get_dimensions()[0], batch_size * slot_num);
+
+  test::GaussianDataSimulator data_sim(0.0f, 1.0f);
+  Tensor2<float> weight = weight_buf->as_tensor();
+  data_sim.fill(weight.get_ptr(), weight.get_num_elements());
+  data_sim.fill(input.get_ptr(), input.get_num_elements());
+
+  std::vector<LayerCPU*> layers = {&reshape_layer, &fc_layer};
+  for (LayerCPU* layer : layers) {
+    layer->fprop(false);
+  }
+  std::vector<float> full_output(output.get_ptr(), output.get_ptr() + output.get_num_elements());
+
+  // every row of the samples is computed again, the others are left alone
+  std::fill(output.get_ptr(), output.get_ptr() + output.get_num_elements(), 0.0f);
+  for (LayerCPU* layer : layers) {
+    layer->set_active_batch_size(num_samples, batch_size);
+    layer->fprop(false);
+  }
+  const size_t active_elements = num_samples * slot_num * out_dim;
+  for (size_t i = 0; i < active_elements; i++) {
+    ASSERT_FLOAT_EQ(output.get_ptr()[i], full_output[i]) << "at " << i;
+  }
+  for (size_t i = active_elements; i < output.get_num_elements(); i++) {
+    ASSERT_EQ(output.get_ptr()[i], 0.0f) << "at " << i;
+  }
+}
+
+}  // namespace
+
+TEST(cpu_active_batch, reshape_fc_3_of_8) { reshape_partial_batch_test(8, 3, 4, 5, 3); }
+TEST(cpu_active_batch, reshape_fc_1_of_16) { reshape_partial_batch_test(16, 26, 16, 7, 1); }
+TEST(cpu_active_batch, reshape_fc_full) { reshape_partial_batch_test(8, 3, 4, 5, 8); }
@@ -20,10 +20,12 @@
 #include "HugeCTR/include/utils.hpp"
 #include "HugeCTR/include/cpu/embedding_feature_combiner_cpu.hpp"
 #include "HugeCTR/include/cpu/session_inference_cpu.hpp"
+#include "HugeCTR/include/cpu/batching_scheduler_cpu.hpp"
 #include <vector>
 #include "gtest/gtest.h"
 #include "utest/test_utils.h"
 #include <fstream>
+#include <thread>
 #include <vector>
 #include <cuda_profiler_api.h>
 
@@ -310,8 +312,163 @@ void session_inference_generated_test(const std::string& config_file, const std:
   host_allocator.deallocate(h_embeddingcolumns);
 }
 
+// Several threads predict on one session at once, each must get the result of a lone predict
+template <typename TypeHashKey>
+void session_inference_concurrent_test(const std::string& config_file, const std::string& model, int batchsize,
+                                       size_t num_threads, size_t num_iterations) {
+  InferenceInfo inference_info(read_json_file(config_file));
+  int batch_size = batchsize;
+  int dense_dim = inference_info.dense_dim;
+  int slot_num = inference_info.slot_num[0];
+  int max_feature_num_per_sample = inference_info.max_feature_num_per_sample[0];
+
+  // 1 hot samples, a different batch for each thread
+  std::vector<std::vector<int>> h_row_ptrs(num_threads, std::vector<int>(batch_size * slot_num + 1));
+  std::vector<std::vector<float>> h_dense(num_threads, std::vector<float>(batch_size * dense_dim));
+  std::vector<std::vector<TypeHashKey>> h_keys(num_threads, std::vector<TypeHashKey>(batch_size * max_feature_num_per_sample));
+  FloatUniformDataSimulator<float> fdata_sim(0, 1);
+  for (size_t t = 0; t < num_threads; t++) {
+    for (size_t i = 0; i < h_row_ptrs[t].size(); i++) {
+      h_row_ptrs[t][i] = i;
+    }
+    for (auto& v : h_dense[t]) {
+      v = fdata_sim.get_num();
+    }
+    for (int i = 0; i < batch_size; i++) {
+      for (int j = 0; j < slot_num; j++) {
+        IntUniformDataSimulator<int> ldata_sim(RANGE[j], RANGE[j+1]-1);
+        h_keys[t][i*slot_num + j] = static_cast<TypeHashKey>(ldata_sim.get_num());
+      }
+    }
+  }
+
+  // inference session
+  std::string dense_model{"/hugectr/test/utest/_dense_10000.model"};
+  std::vector<std::string> sparse_models{"/hugectr/test/utest/0_sparse_10000.model"};
+  InferenceParams infer_param(model, batchsize, 0.5, dense_model, sparse_models, 0, true, 0.8, false);
+  infer_param.num_cpu_workspaces = num_threads;
+  std::vector<InferenceParams> inference_params{infer_param};
+  std::vector<std::string> model_config_path{config_file};
+  std::shared_ptr<HugectrUtility<TypeHashKey>> parameter_server(HugectrUtility<TypeHashKey>::Create_Parameter_Server(INFER_TYPE::TRITON, model_config_path, inference_params));
+  InferenceSessionCPU<TypeHashKey> sess(model_config_path[0], inference_params[0], parameter_server);
+
+  std::vector<std::vector<float>> h_ref(num_threads, std::vector<float>(batch_size));
+  for (size_t t = 0; t < num_threads; t++) {
+    sess.predict(h_dense[t].data(), h_keys[t].data(), h_row_ptrs[t].data(), h_ref[t].data(), batch_size);
+  }
+
+  std::vector<std::vector<float>> h_out(num_threads, std::vector<float>(batch_size * num_iterations));
+  HugeCTR::Timer timer_inference;
+  timer_inference.start();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < num_iterations; i++) {
+        sess.predict(h_dense[t].data(), h_keys[t].data(), h_row_ptrs[t].data(), h_out[t].data() + i * batch_size, batch_size);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  timer_inference.stop();
+
+  for (size_t t = 0; t < num_threads; t++) {
+    for (size_t i = 0; i < num_iterations; i++) {
+      for (int j = 0; j < batch_size; j++) {
+        ASSERT_NEAR(h_out[t][i * batch_size + j], h_ref[t][j], 1e-6) << "thread " << t << ", sample " << j;
+      }
+    }
+  }
+  MESSAGE_("Batch size: " + std::to_string(batch_size)
+        + ", Threads: " + std::to_string(num_threads)
+        + ", Throughput: " + std::to_string(num_threads * num_iterations * batch_size / timer_inference.elapsedSeconds()) + " samples/s");
+}
+
+// Small requests from several threads go through the batching scheduler, each must get the result
+// of a lone predict
+template <typename TypeHashKey>
+void batching_scheduler_test(const std::string& config_file, const std::string& model, int batchsize,
+                             size_t num_clients, size_t num_requests, size_t max_queue_delay_us) {
+  InferenceInfo inference_info(read_json_file(config_file));
+  int dense_dim = inference_info.dense_dim;
+  int slot_num = inference_info.slot_num[0];
+  const int max_request_size = 8;
+
+  // 1 hot samples of up to max_request_size samples per request
+  struct Request {
+    std::vector<int> h_row_ptrs;
+    std::vector<float> h_dense;
+    std::vector<TypeHashKey> h_keys;
+    std::vector<float> h_ref;
+    std::vector<float> h_out;
+  };
+  std::vector<Request> requests(num_clients * num_requests);
+  IntUniformDataSimulator<int> size_sim(1, max_request_size);
+  FloatUniformDataSimulator<float> fdata_sim(0, 1);
+  for (auto& request : requests) {
+    int num_samples = size_sim.get_num();
+    request.h_row_ptrs.resize(num_samples * slot_num + 1);
+    for (size_t i = 0; i < request.h_row_ptrs.size(); i++) {
+      request.h_row_ptrs[i] = i;
+    }
+    request.h_dense.resize(num_samples * dense_dim);
+    for (auto& v : request.h_dense) {
+      v = fdata_sim.get_num();
+    }
+    request.h_keys.resize(num_samples * slot_num);
+    for (int i = 0; i < num_samples; i++) {
+      for (int j = 0; j < slot_num; j++) {
+        IntUniformDataSimulator<int> ldata_sim(RANGE[j], RANGE[j+1]-1);
+        request.h_keys[i*slot_num + j] = static_cast<TypeHashKey>(ldata_sim.get_num());
+      }
+    }
+    request.h_ref.resize(num_samples);
+    request.h_out.resize(num_samples);
+  }
+
+  // inference session
+  std::string dense_model{"/hugectr/test/utest/_dense_10000.model"};
+  std::vector<std::string> sparse_models{"/hugectr/test/utest/0_sparse_10000.model"};
+  InferenceParams infer_param(model, batchsize, 0.5, dense_model, sparse_models, 0, true, 0.8, false);
+  std::vector<InferenceParams> inference_params{infer_param};
+  std::vector<std::string> model_config_path{config_file};
+  std::shared_ptr<HugectrUtility<TypeHashKey>> parameter_server(HugectrUtility<TypeHashKey>::Create_Parameter_Server(INFER_TYPE::TRITON, model_config_path, inference_params));
+  InferenceSessionCPU<TypeHashKey> sess(model_config_path[0], inference_params[0], parameter_server);
+  for (auto& request : requests) {
+    sess.predict(request.h_dense.data(), request.h_keys.data(), request.h_row_ptrs.data(),
+                 request.h_ref.data(), request.h_ref.size());
+  }
+
+  BatchingSchedulerCPU<TypeHashKey> scheduler(sess, max_queue_delay_us);
+  std::vector<std::thread> clients;
+  for (size_t c = 0; c < num_clients; c++) {
+    clients.emplace_back([&, c] {
+      for (size_t i = 0; i < num_requests; i++) {
+        Request& request = requests[c * num_requests + i];
+        scheduler.predict(request.h_dense.data(), request.h_keys.data(), request.h_row_ptrs.data(),
+                          request.h_out.data(), request.h_out.size());
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+
+  for (size_t r = 0; r < requests.size(); r++) {
+    for (size_t i = 0; i < requests[r].h_out.size(); i++) {
+      ASSERT_NEAR(requests[r].h_out[i], requests[r].h_ref[i], 1e-6) << "request " << r << ", sample " << i;
+    }
+  }
+  BatchingStatsCPU stats = scheduler.get_stats();
+  ASSERT_EQ(stats.num_requests, requests.size());
+  MESSAGE_(stats.to_string());
+}
+
 }  // namespace
 
 
 TEST(session_inference_cpu, criteo_dcn) { session_inference_criteo_test<unsigned int>("/hugectr_ci_workdir/test/utest/simple_inference_config.json", "DCN", "/hugectr/test/utest/dcn_csr.txt", 32); }
-TEST(session_inference_cpu, generated_dcn_32) { session_inference_generated_test<unsigned int>("/hugectr_ci_workdir/test/utest/simple_inference_config.json", "DCN", 32, 32); }
\ No newline at end of file
+TEST(session_inference_cpu, generated_dcn_32) { session_inference_generated_test<unsigned int>("/hugectr_ci_workdir/test/utest/simple_inference_config.json", "DCN", 32, 32); }
+TEST(session_inference_cpu, concurrent_dcn_32) { session_inference_concurrent_test<unsigned int>("/hugectr_ci_workdir/test/utest/simple_inference_config.json", "DCN", 32, 4, 16); }
+TEST(session_inference_cpu, batching_scheduler_dcn_32) { batching_scheduler_test<unsigned int>("/hugectr_ci_workdir/test/utest/simple_inference_config.json", "DCN", 32, 8, 32, 500); }
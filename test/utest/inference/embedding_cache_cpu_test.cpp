@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/cpu/embedding_cache_cpu.hpp"
+#include "HugeCTR/include/utils.hpp"
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+
+namespace {
+
+const float eps = 1e-6f;
+
+// emb_vec of key k in table t is {k + t, k + t + 1, ...}
+template <typename TypeHashKey>
+float expected_value(TypeHashKey key, size_t embedding_table_id, size_t i) {
+  return static_cast<float>((key + embedding_table_id + i) % 1000003);
+}
+
+// Parameter server stub, counts the keys queried through it
+template <typename TypeHashKey>
+class CountingParameterServer : public HugectrUtility<TypeHashKey> {
+ public:
+  explicit CountingParameterServer(size_t embedding_vec_size)
+      : embedding_vec_size_(embedding_vec_size), num_queried_keys(0) {}
+  void look_up(const TypeHashKey* h_embeddingcolumns, size_t length,
+               float* h_embeddingoutputvector, const std::string& model_name,
+               size_t embedding_table_id) override {
+    for (size_t i = 0; i < length; i++) {
+      for (size_t j = 0; j < embedding_vec_size_; j++) {
+        h_embeddingoutputvector[i * embedding_vec_size_ + j] =
+            expected_value(h_embeddingcolumns[i], embedding_table_id, j);
+      }
+    }
+    num_queried_keys += length;
+  }
+  size_t embedding_vec_size_;
+  std::atomic<size_t> num_queried_keys;
+};
+
+template <typename TypeHashKey>
+void check_output(const std::vector<TypeHashKey>& keys, const std::vector<float>& output,
+                  size_t embedding_vec_size, size_t embedding_table_id) {
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < embedding_vec_size; j++) {
+      ASSERT_NEAR(output[i * embedding_vec_size + j],
+                  expected_value(keys[i], embedding_table_id, j), eps);
+    }
+  }
+}
+
+template <typename TypeHashKey>
+void embedding_cache_cpu_test(size_t num_keys, size_t embedding_vec_size, size_t batch_size,
+                              size_t set_associativity, CacheEvictionPolicy_t eviction_policy) {
+  auto ps = std::make_shared<CountingParameterServer<TypeHashKey>>(embedding_vec_size);
+  const size_t num_tables = 2;
+  EmbeddingCacheCPU<TypeHashKey> cache("test", std::vector<size_t>(num_tables, embedding_vec_size),
+                                       std::vector<size_t>(num_tables, num_keys / 4),
+                                       set_associativity, eviction_policy, ps);
+
+  // Zipf-like key distribution, the head of the key range is hot
+  std::mt19937_64 gen(0);
+  std::exponential_distribution<double> dist(16.0 / num_keys);
+  std::vector<TypeHashKey> keys(batch_size);
+  std::vector<float> output(batch_size * embedding_vec_size);
+  const size_t num_batches = 64;
+  Timer timer;
+  timer.start();
+  for (size_t batch = 0; batch < num_batches; batch++) {
+    const size_t table_id = batch % num_tables;
+    for (auto& key : keys) {
+      key = static_cast<TypeHashKey>(static_cast<size_t>(dist(gen)) % num_keys);
+    }
+    double hit_rate = -1.0;
+    cache.look_up(keys.data(), batch_size, output.data(), table_id, &hit_rate);
+    ASSERT_GE(hit_rate, 0.0);
+    ASSERT_LE(hit_rate, 1.0);
+    check_output(keys, output, embedding_vec_size, table_id);
+  }
+  timer.stop();
+  const double cumulative_hit_rate = cache.get_hit_rate(0);
+  MESSAGE_("Host embedding cache: " + std::to_string(num_batches * batch_size) + " keys in " +
+           std::to_string(timer.elapsedSeconds()) + " s, hit rate " +
+           std::to_string(cumulative_hit_rate) + ", " +
+           std::to_string(ps->num_queried_keys.load()) + " keys queried from the parameter server");
+  ASSERT_GT(cumulative_hit_rate, 0.3);
+  ASSERT_LT(ps->num_queried_keys.load(), num_batches * batch_size);
+
+  // A batch that has just been looked up is served from the cache
+  const size_t num_queried_keys = ps->num_queried_keys;
+  std::vector<TypeHashKey> hot_keys(16);
+  for (size_t i = 0; i < hot_keys.size(); i++) {
+    hot_keys[i] = static_cast<TypeHashKey>(i);
+  }
+  std::vector<float> hot_output(hot_keys.size() * embedding_vec_size);
+  double hit_rate = 0.0;
+  cache.look_up(hot_keys.data(), hot_keys.size(), hot_output.data(), 1, &hit_rate);
+  cache.look_up(hot_keys.data(), hot_keys.size(), hot_output.data(), 1, &hit_rate);
+  ASSERT_NEAR(hit_rate, 1.0, eps);
+  ASSERT_LE(ps->num_queried_keys - num_queried_keys, hot_keys.size());
+  check_output(hot_keys, hot_output, embedding_vec_size, 1);
+}
+
+// 1 set of 2 ways, access A B B B A, then insert C: LRU evicts B, LFU evicts A
+template <typename TypeHashKey>
+void embedding_cache_cpu_eviction_test(CacheEvictionPolicy_t eviction_policy,
+                                       TypeHashKey expected_victim) {
+  const size_t embedding_vec_size = 4;
+  auto ps = std::make_shared<CountingParameterServer<TypeHashKey>>(embedding_vec_size);
+  EmbeddingCacheCPU<TypeHashKey> cache("test", {embedding_vec_size}, {2}, 2, eviction_policy, ps);
+  const TypeHashKey a = 1, b = 2, c = 3;
+  std::vector<float> output(embedding_vec_size);
+  for (TypeHashKey key : {a, b, b, b, a, c}) {
+    cache.look_up(&key, 1, output.data(), 0);
+  }
+  ASSERT_EQ(ps->num_queried_keys.load(), 3u);
+
+  const TypeHashKey survivor = expected_victim == a ? b : a;
+  double hit_rate = 0.0;
+  cache.look_up(&survivor, 1, output.data(), 0, &hit_rate);
+  ASSERT_NEAR(hit_rate, 1.0, eps);
+  cache.look_up(&c, 1, output.data(), 0, &hit_rate);
+  ASSERT_NEAR(hit_rate, 1.0, eps);
+  cache.look_up(&expected_victim, 1, output.data(), 0, &hit_rate);
+  ASSERT_NEAR(hit_rate, 0.0, eps);
+}
+
+// 1 set of 2 ways, B is hot then A is: once the LFU counters have aged, inserting C evicts the
+// stale B rather than A. Without aging, B keeps its way.
+template <typename TypeHashKey>
+void embedding_cache_cpu_lfu_aging_test(size_t lfu_aging_queries_per_way,
+                                        TypeHashKey expected_victim) {
+  const size_t embedding_vec_size = 4;
+  auto ps = std::make_shared<CountingParameterServer<TypeHashKey>>(embedding_vec_size);
+  EmbeddingCacheCPU<TypeHashKey> cache("test", {embedding_vec_size}, {2}, 2,
+                                       CacheEvictionPolicy_t::LFU, ps, lfu_aging_queries_per_way);
+  const TypeHashKey a = 1, b = 2, c = 3;
+  std::vector<float> output(embedding_vec_size);
+  cache.look_up(&a, 1, output.data(), 0);
+  for (size_t i = 0; i < 100; i++) {
+    cache.look_up(&b, 1, output.data(), 0);
+  }
+  for (size_t i = 0; i < 64; i++) {
+    cache.look_up(&a, 1, output.data(), 0);
+  }
+  cache.look_up(&c, 1, output.data(), 0);
+  ASSERT_EQ(ps->num_queried_keys.load(), 3u);
+
+  const TypeHashKey survivor = expected_victim == a ? b : a;
+  double hit_rate = 0.0;
+  cache.look_up(&survivor, 1, output.data(), 0, &hit_rate);
+  ASSERT_NEAR(hit_rate, 1.0, eps);
+  cache.look_up(&c, 1, output.data(), 0, &hit_rate);
+  ASSERT_NEAR(hit_rate, 1.0, eps);
+  cache.look_up(&expected_victim, 1, output.data(), 0, &hit_rate);
+  ASSERT_NEAR(hit_rate, 0.0, eps);
+}
+
+// Sessions sharing one cache look it up concurrently
+template <typename TypeHashKey>
+void embedding_cache_cpu_shared_test(size_t num_threads, size_t num_keys,
+                                     size_t embedding_vec_size) {
+  auto ps = std::make_shared<CountingParameterServer<TypeHashKey>>(embedding_vec_size);
+  auto cache = std::make_shared<EmbeddingCacheCPU<TypeHashKey>>(
+      "test", std::vector<size_t>{embedding_vec_size}, std::vector<size_t>{num_keys / 2}, 4,
+      CacheEvictionPolicy_t::LRU, ps);
+  std::vector<std::thread> threads;
+  std::atomic<size_t> num_errors(0);
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::mt19937_64 gen(t);
+      std::uniform_int_distribution<size_t> dist(0, num_keys - 1);
+      std::vector<TypeHashKey> keys(256);
+      std::vector<float> output(keys.size() * embedding_vec_size);
+      for (size_t batch = 0; batch < 200; batch++) {
+        for (auto& key : keys) {
+          key = static_cast<TypeHashKey>(dist(gen));
+        }
+        cache->look_up(keys.data(), keys.size(), output.data(), 0);
+        for (size_t i = 0; i < keys.size(); i++) {
+          for (size_t j = 0; j < embedding_vec_size; j++) {
+            if (output[i * embedding_vec_size + j] != expected_value(keys[i], 0, j)) {
+              num_errors++;
+            }
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(num_errors.load(), 0u);
+  MESSAGE_("Shared host embedding cache, " + std::to_string(num_threads) + " threads, hit rate " +
+           std::to_string(cache->get_hit_rate(0)));
+}
+
+}  // namespace
+
+TEST(embedding_cache_cpu, lru_uint32) {
+  embedding_cache_cpu_test<unsigned int>(100000, 16, 4096, 8, CacheEvictionPolicy_t::LRU);
+}
+TEST(embedding_cache_cpu, lfu_int64) {
+  embedding_cache_cpu_test<long long>(100000, 16, 4096, 8, CacheEvictionPolicy_t::LFU);
+}
+TEST(embedding_cache_cpu, direct_mapped_int64) {
+  embedding_cache_cpu_test<long long>(100000, 32, 1024, 1, CacheEvictionPolicy_t::LRU);
+}
+TEST(embedding_cache_cpu, lru_eviction) {
+  embedding_cache_cpu_eviction_test<long long>(CacheEvictionPolicy_t::LRU, 2);
+}
+TEST(embedding_cache_cpu, lfu_eviction) {
+  embedding_cache_cpu_eviction_test<long long>(CacheEvictionPolicy_t::LFU, 1);
+}
+TEST(embedding_cache_cpu, lfu_aging) { embedding_cache_cpu_lfu_aging_test<long long>(8, 2); }
+TEST(embedding_cache_cpu, lfu_no_aging) { embedding_cache_cpu_lfu_aging_test<long long>(0, 1); }
+TEST(embedding_cache_cpu, shared_8_threads) {
+  embedding_cache_cpu_shared_test<unsigned int>(8, 10000, 16);
+}
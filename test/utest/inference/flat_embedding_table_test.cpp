@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/inference/flat_embedding_table.hpp"
+#include <cstring>
+#include <experimental/filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+namespace fs = std::experimental::filesystem;
+
+namespace {
+
+const float eps = 1e-6f;
+
+template <typename TypeHashKey>
+void flat_embedding_table_test(size_t num_keys, size_t embedding_vec_size, size_t num_queries,
+                               float miss_ratio, size_t num_threads = 1) {
+  const float default_emb_vec_value = 0.5f;
+  std::mt19937_64 gen(0);
+
+  // Unique, non-contiguous keys, the top half of the key range is used for the missing keys
+  std::vector<TypeHashKey> keys(num_keys);
+  const TypeHashKey max_key = std::numeric_limits<TypeHashKey>::max() / 2;
+  std::uniform_int_distribution<TypeHashKey> key_dist(0, max_key);
+  {
+    std::unordered_map<TypeHashKey, size_t> dedup;
+    size_t i = 0;
+    while (i < num_keys) {
+      TypeHashKey key = key_dist(gen);
+      if (dedup.emplace(key, i).second) {
+        keys[i++] = key;
+      }
+    }
+  }
+  std::vector<float> vectors(num_keys * embedding_vec_size);
+  std::uniform_real_distribution<float> val_dist(-1.0f, 1.0f);
+  for (auto& val : vectors) {
+    val = val_dist(gen);
+  }
+
+  // Reference: the per-key std::vector<float> layout
+  std::unordered_map<TypeHashKey, std::vector<float>> ref_table;
+  ref_table.reserve(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    ref_table.emplace(keys[i], std::vector<float>(vectors.begin() + i * embedding_vec_size,
+                                                  vectors.begin() + (i + 1) * embedding_vec_size));
+  }
+
+  flat_embedding_table<TypeHashKey> table(embedding_vec_size, default_emb_vec_value);
+  table.load(keys.data(), num_keys, std::vector<float>(vectors), num_threads);
+  ASSERT_EQ(table.size(), num_keys);
+
+  // Queries, miss_ratio of them are not in the table
+  std::vector<TypeHashKey> queries(num_queries);
+  std::uniform_int_distribution<size_t> idx_dist(0, num_keys - 1);
+  std::uniform_real_distribution<float> miss_dist(0.0f, 1.0f);
+  for (auto& query : queries) {
+    query = miss_dist(gen) < miss_ratio ? static_cast<TypeHashKey>(max_key + 1 + idx_dist(gen))
+                                        : keys[idx_dist(gen)];
+  }
+
+  std::vector<float> ref_output(num_queries * embedding_vec_size);
+  for (size_t i = 0; i < num_queries; i++) {
+    float* dst = ref_output.data() + i * embedding_vec_size;
+    auto result = ref_table.find(queries[i]);
+    if (result != ref_table.end()) {
+      memcpy(dst, result->second.data(), sizeof(float) * embedding_vec_size);
+    } else {
+      std::vector<float> default_emb_vec(embedding_vec_size, default_emb_vec_value);
+      memcpy(dst, default_emb_vec.data(), sizeof(float) * embedding_vec_size);
+    }
+  }
+
+  std::vector<float> output(num_queries * embedding_vec_size);
+  table.look_up(queries.data(), num_queries, output.data());
+
+  for (size_t i = 0; i < output.size(); i++) {
+    ASSERT_NEAR(output[i], ref_output[i], eps);
+  }
+}
+
+// Write a sparse model folder, then check that the mmap load modes match the in-memory table
+template <typename TypeHashKey>
+void flat_embedding_table_mmap_test(size_t num_keys, size_t embedding_vec_size, size_t num_threads) {
+  const std::string sparse_model = "flat_embedding_table_test_sparse_model";
+  const std::string key_file = sparse_model + "/key";
+  const std::string vec_file = sparse_model + "/emb_vector";
+  const std::string index_file = sparse_model + "/key_index";
+  fs::remove_all(sparse_model);
+  fs::create_directories(sparse_model);
+
+  std::mt19937_64 gen(0);
+  std::uniform_int_distribution<long long> key_dist(0, std::numeric_limits<unsigned int>::max());
+  std::uniform_real_distribution<float> val_dist(-1.0f, 1.0f);
+  std::vector<long long> i64_keys(num_keys);
+  for (auto& key : i64_keys) {
+    key = key_dist(gen);
+  }
+  std::vector<float> vectors(num_keys * embedding_vec_size);
+  for (auto& val : vectors) {
+    val = val_dist(gen);
+  }
+  {
+    std::ofstream key_stream(key_file, std::ofstream::binary);
+    std::ofstream vec_stream(vec_file, std::ofstream::binary);
+    key_stream.write(reinterpret_cast<const char*>(i64_keys.data()), num_keys * sizeof(long long));
+    vec_stream.write(reinterpret_cast<const char*>(vectors.data()), vectors.size() * sizeof(float));
+  }
+
+  std::vector<TypeHashKey> keys(i64_keys.begin(), i64_keys.end());
+  flat_embedding_table<TypeHashKey> ref_table(embedding_vec_size, 0.0f);
+  ref_table.load(keys.data(), num_keys, std::vector<float>(vectors));
+
+  flat_embedding_table<TypeHashKey> mmap_table(embedding_vec_size, 0.0f);
+  mmap_table.load_mmap(i64_keys.data(), num_keys, vec_file, num_threads);
+  mmap_table.dump_index(index_file, key_file);
+  ASSERT_TRUE(mmap_table.is_mapped());
+  ASSERT_EQ(mmap_table.size(), ref_table.size());
+
+  flat_embedding_table<TypeHashKey> index_table(embedding_vec_size, 0.0f);
+  ASSERT_TRUE(index_table.load_mmap_from_index(index_file, vec_file, key_file));
+  ASSERT_EQ(index_table.size(), ref_table.size());
+
+  // A table with another emb_vec size must not accept the index
+  flat_embedding_table<TypeHashKey> wrong_table(embedding_vec_size + 1, 0.0f);
+  ASSERT_FALSE(wrong_table.load_mmap_from_index(index_file, vec_file, key_file));
+
+  // Nor does a copy of the key file which keeps its size and mtime, like cp -p or rsync -a
+  {
+    const std::string copied_key_file = key_file + ".copy";
+    fs::copy_file(key_file, copied_key_file);
+    fs::last_write_time(copied_key_file, fs::last_write_time(key_file));
+    flat_embedding_table<TypeHashKey> copied_table(embedding_vec_size, 0.0f);
+    ASSERT_FALSE(copied_table.load_mmap_from_index(index_file, vec_file, copied_key_file));
+  }
+
+  // The same keys always give the same index file
+  {
+    const std::string rebuilt_index_file = index_file + ".rebuilt";
+    flat_embedding_table<TypeHashKey> rebuilt_table(embedding_vec_size, 0.0f);
+    rebuilt_table.load_mmap(i64_keys.data(), num_keys, vec_file, num_threads);
+    rebuilt_table.dump_index(rebuilt_index_file, key_file);
+    std::ifstream index_stream(index_file, std::ifstream::binary);
+    std::ifstream rebuilt_index_stream(rebuilt_index_file, std::ifstream::binary);
+    ASSERT_TRUE(std::equal(std::istreambuf_iterator<char>(index_stream),
+                           std::istreambuf_iterator<char>(),
+                           std::istreambuf_iterator<char>(rebuilt_index_stream),
+                           std::istreambuf_iterator<char>()));
+  }
+
+  // Query all the keys in a shuffled order plus the same number of (mostly) missing keys
+  std::vector<TypeHashKey> queries(keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    queries.push_back(static_cast<TypeHashKey>(key_dist(gen)));
+  }
+  std::shuffle(queries.begin(), queries.end(), gen);
+  std::vector<float> ref_output(queries.size() * embedding_vec_size);
+  std::vector<float> mmap_output(queries.size() * embedding_vec_size);
+  std::vector<float> index_output(queries.size() * embedding_vec_size);
+  ref_table.look_up(queries.data(), queries.size(), ref_output.data());
+  mmap_table.look_up(queries.data(), queries.size(), mmap_output.data());
+  index_table.look_up(queries.data(), queries.size(), index_output.data());
+  for (size_t i = 0; i < ref_output.size(); i++) {
+    ASSERT_EQ(mmap_output[i], ref_output[i]);
+    ASSERT_EQ(index_output[i], ref_output[i]);
+  }
+  fs::remove_all(sparse_model);
+}
+
+// Compare the batch look_up of a single thread against multiple threads, 16 threads take
+// 16 * MIN_QUERIES_PER_THREAD_ queries or more
+template <typename TypeHashKey>
+void flat_embedding_table_look_up_scaling_test(size_t num_keys, size_t embedding_vec_size,
+                                               size_t num_queries) {
+  std::mt19937_64 gen(0);
+  std::vector<TypeHashKey> keys(num_keys);
+  std::iota(keys.begin(), keys.end(), TypeHashKey(0));
+  std::vector<float> vectors(num_keys * embedding_vec_size);
+  std::uniform_real_distribution<float> val_dist(-1.0f, 1.0f);
+  for (auto& val : vectors) {
+    val = val_dist(gen);
+  }
+  flat_embedding_table<TypeHashKey> table(embedding_vec_size, 0.5f);
+  table.load(keys.data(), num_keys, std::move(vectors), 8);
+
+  // 10% of the queries are missing keys
+  std::vector<TypeHashKey> queries(num_queries);
+  std::uniform_int_distribution<size_t> idx_dist(0, num_keys + num_keys / 10);
+  for (auto& query : queries) {
+    query = static_cast<TypeHashKey>(idx_dist(gen));
+  }
+
+  std::vector<float> ref_output(num_queries * embedding_vec_size);
+  std::vector<float> output(num_queries * embedding_vec_size);
+  for (size_t num_threads : {1, 4, 16}) {
+    std::vector<float>& dst = num_threads == 1 ? ref_output : output;
+    table.look_up(queries.data(), num_queries, dst.data(), num_threads);
+    if (num_threads != 1) {
+      ASSERT_TRUE(std::equal(output.begin(), output.end(), ref_output.begin()));
+    }
+  }
+}
+
+}  // namespace
+
+TEST(flat_embedding_table, uint_1000_16_1000_0) { flat_embedding_table_test<unsigned int>(1000, 16, 1000, 0.0f); }
+TEST(flat_embedding_table, uint_1000_16_1000_0_5) { flat_embedding_table_test<unsigned int>(1000, 16, 1000, 0.5f); }
+TEST(flat_embedding_table, long_long_1000_16_1000_0_5) { flat_embedding_table_test<long long>(1000, 16, 1000, 0.5f); }
+TEST(flat_embedding_table, uint_200k_16_100k_0_1_4) { flat_embedding_table_test<unsigned int>(200000, 16, 100000, 0.1f, 4); }
+TEST(flat_embedding_table, long_long_200k_64_100k_0_1_4) { flat_embedding_table_test<long long>(200000, 64, 100000, 0.1f, 4); }
+TEST(flat_embedding_table, mmap_uint_1000_16_1) { flat_embedding_table_mmap_test<unsigned int>(1000, 16, 1); }
+TEST(flat_embedding_table, mmap_long_long_1000_16_4) { flat_embedding_table_mmap_test<long long>(1000, 16, 4); }
+TEST(flat_embedding_table, mmap_uint_200k_16_4) { flat_embedding_table_mmap_test<unsigned int>(200000, 16, 4); }
+TEST(flat_embedding_table, mmap_long_long_200k_16_4) { flat_embedding_table_mmap_test<long long>(200000, 16, 4); }
+TEST(flat_embedding_table, look_up_scaling_uint_100k_16_40k) { flat_embedding_table_look_up_scaling_test<unsigned int>(100000, 16, 40000); }
+TEST(flat_embedding_table, look_up_scaling_long_long_100k_64_40k) { flat_embedding_table_look_up_scaling_test<long long>(100000, 64, 40000); }
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/cpu/gemm_cpu.hpp"
+#include "HugeCTR/include/utils.hpp"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+
+namespace {
+
+// The kernel FullyConnectedLayerCPU used before gemm_cpu
+void naive_mm(const float* a, const float* b, float* c, size_t m, size_t k, size_t n) {
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      c[i * n + j] = 0.0f;
+      for (size_t kk = 0; kk < k; ++kk) c[i * n + j] += a[i * k + kk] * b[kk * n + j];
+    }
+  }
+}
+
+const char* isa_name(GemmIsaCPU isa) {
+  switch (isa) {
+    case GemmIsaCPU::AVX512:
+      return "avx512";
+    case GemmIsaCPU::AVX2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
+
+float round_to_bf16(float v) {
+  const uint32_t bits = static_cast<uint32_t>(float_to_bf16_cpu(v)) << 16;
+  float r;
+  std::memcpy(&r, &bits, sizeof(r));
+  return r;
+}
+
+void gemm_cpu_test(size_t m, size_t k, size_t n, GemmActivationCPU act, bool bf16 = false) {
+  std::mt19937 gen(m * k + n);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> a(m * k), b(k * n), bias(n);
+  for (auto& v : a) v = dist(gen);
+  for (auto& v : b) v = dist(gen);
+  for (auto& v : bias) v = dist(gen);
+
+  std::vector<float> ref(m * n);
+  if (bf16) {
+    // the reference multiplies by the bf16 weights the kernels see
+    for (auto& v : b) v = round_to_bf16(v);
+  }
+  naive_mm(a.data(), b.data(), ref.data(), m, k, n);
+  std::vector<float> ref_pre_act(m * n);
+  for (size_t i = 0; i < m; i++) {
+    for (size_t j = 0; j < n; j++) {
+      ref_pre_act[i * n + j] = ref[i * n + j] + bias[j];
+      ref[i * n + j] = act == GemmActivationCPU::Relu ? std::max(0.0f, ref_pre_act[i * n + j])
+                                                      : ref_pre_act[i * n + j];
+    }
+  }
+
+  PackedMatrixCPU packed;
+  packed.pack(b.data(), k, n, bf16);
+  for (auto isa : {GemmIsaCPU::Scalar, GemmIsaCPU::AVX2, GemmIsaCPU::AVX512}) {
+    if (!is_gemm_isa_supported_cpu(isa)) {
+      continue;
+    }
+    std::vector<float> c(m * n, NAN), pre_act(m * n, NAN);
+    gemm_cpu(a.data(), k, m, packed, bias.data(), act, c.data(), n, pre_act.data(), isa);
+    const float eps = 1e-4f * std::sqrt(static_cast<float>(k) + 1.0f);
+    for (size_t i = 0; i < m * n; i++) {
+      ASSERT_NEAR(c[i], ref[i], eps) << isa_name(isa) << " at " << i;
+      ASSERT_NEAR(pre_act[i], ref_pre_act[i], eps) << isa_name(isa) << " at " << i;
+    }
+  }
+}
+
+void gemm_cpu_perf_test(size_t m, size_t k, size_t n) {
+  std::mt19937 gen(m + k + n);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> a(m * k), b(k * n), bias(n), c(m * n);
+  for (auto& v : a) v = dist(gen);
+  for (auto& v : b) v = dist(gen);
+  for (auto& v : bias) v = dist(gen);
+  const double gflop = 2.0 * m * k * n * 1e-9;
+
+  Timer timer;
+  timer.start();
+  naive_mm(a.data(), b.data(), c.data(), m, k, n);
+  timer.stop();
+  const double naive_seconds = timer.elapsedSeconds();
+  MESSAGE_("naive " + std::to_string(m) + "x" + std::to_string(k) + "x" + std::to_string(n) + ": " +
+           std::to_string(gflop / naive_seconds) + " GFLOPS");
+
+  for (bool bf16 : {false, true}) {
+    PackedMatrixCPU packed;
+    packed.pack(b.data(), k, n, bf16);
+    for (auto isa : {GemmIsaCPU::Scalar, GemmIsaCPU::AVX2, GemmIsaCPU::AVX512}) {
+      if (!is_gemm_isa_supported_cpu(isa)) {
+        continue;
+      }
+      const size_t num_iterations = 5;
+      timer.start();
+      for (size_t i = 0; i < num_iterations; i++) {
+        gemm_cpu(a.data(), k, m, packed, bias.data(), GemmActivationCPU::Relu, c.data(), n,
+                 nullptr, isa);
+      }
+      timer.stop();
+      const double seconds = timer.elapsedSeconds() / num_iterations;
+      MESSAGE_(std::string("gemm_cpu ") + isa_name(isa) + (bf16 ? " bf16" : " fp32") + ": " +
+               std::to_string(gflop / seconds) + " GFLOPS, " +
+               std::to_string(naive_seconds / seconds) + "x naive");
+    }
+  }
+}
+
+// Every half value survives a round trip, and the vectorized and scalar conversions agree
+void half_conversion_test() {
+  std::vector<uint16_t> h(1 << 16);
+  for (size_t i = 0; i < h.size(); i++) h[i] = static_cast<uint16_t>(i);
+  std::vector<float> f(h.size());
+  half_to_float_cpu(h.data(), f.data(), h.size());
+  std::vector<uint16_t> h_back(h.size());
+  float_to_half_cpu(f.data(), h_back.data(), f.size());
+  for (size_t i = 0; i < h.size(); i++) {
+    float f_scalar;
+    half_to_float_cpu(&h[i], &f_scalar, 1);
+    if (std::isnan(f[i])) {
+      ASSERT_TRUE(std::isnan(f_scalar)) << i;
+      ASSERT_EQ(h_back[i] & 0x7c00, 0x7c00) << i;
+      continue;
+    }
+    ASSERT_EQ(f_scalar, f[i]) << i;
+    ASSERT_EQ(h_back[i], h[i]) << i;
+  }
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-70000.0f, 70000.0f);
+  std::vector<float> src(1 << 16);
+  for (size_t i = 0; i < src.size(); i++) {
+    // cover the subnormal range too
+    src[i] = i % 2 ? dist(gen) : dist(gen) * 1e-9f;
+  }
+  std::vector<uint16_t> dst(src.size());
+  float_to_half_cpu(src.data(), dst.data(), src.size());
+  for (size_t i = 0; i < src.size(); i++) {
+    uint16_t scalar;
+    float_to_half_cpu(&src[i], &scalar, 1);
+    ASSERT_EQ(scalar, dst[i]) << src[i];
+  }
+}
+
+}  // namespace
+
+TEST(gemm_cpu, tiny) { gemm_cpu_test(1, 1, 1, GemmActivationCPU::None); }
+TEST(gemm_cpu, row_and_column_tails) { gemm_cpu_test(13, 37, 23, GemmActivationCPU::Relu); }
+TEST(gemm_cpu, single_row) { gemm_cpu_test(1, 429, 1024, GemmActivationCPU::Relu); }
+TEST(gemm_cpu, k_blocks) { gemm_cpu_test(97, 600, 80, GemmActivationCPU::None); }
+TEST(gemm_cpu, mlp_layer) { gemm_cpu_test(256, 512, 256, GemmActivationCPU::Relu); }
+TEST(gemm_cpu, bf16_row_and_column_tails) {
+  gemm_cpu_test(13, 37, 23, GemmActivationCPU::Relu, true);
+}
+TEST(gemm_cpu, bf16_mlp_layer) { gemm_cpu_test(256, 512, 256, GemmActivationCPU::Relu, true); }
+TEST(gemm_cpu, half_conversion) { half_conversion_test(); }
+TEST(gemm_cpu, perf_batch_1024) { gemm_cpu_perf_test(1024, 1024, 512); }
+TEST(gemm_cpu, perf_batch_16) { gemm_cpu_perf_test(16, 1024, 1024); }
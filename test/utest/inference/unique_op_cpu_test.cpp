@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HugeCTR/include/cpu/unique_op_cpu.hpp"
+#include "HugeCTR/include/utils.hpp"
+#include <algorithm>
+#include <random>
+#include <unordered_set>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+
+namespace {
+
+// duplicate_ratio of the keys repeat a key that is already in the query
+template <typename TypeHashKey>
+void unique_op_cpu_test(size_t capacity, size_t len, double duplicate_ratio,
+                        size_t embedding_vec_size) {
+  std::mt19937_64 gen(len);
+  const size_t num_distinct = std::max<size_t>(1, static_cast<size_t>(len * (1.0 - duplicate_ratio)));
+  std::uniform_int_distribution<size_t> dist(0, num_distinct - 1);
+  std::vector<TypeHashKey> h_key(len);
+  for (size_t i = 0; i < len; i++) {
+    h_key[i] = static_cast<TypeHashKey>((i < num_distinct ? i : dist(gen)) * 2654435761ULL);
+  }
+  std::shuffle(h_key.begin(), h_key.end(), gen);
+
+  UniqueOpCPU<TypeHashKey> unique_op(capacity);
+  std::vector<uint64_t> h_output_index(len);
+  std::vector<TypeHashKey> h_unique_key(len);
+  size_t num_unique = 0;
+  // Run it several times to go through the reuse of the hash table
+  for (int i = 0; i < 3; i++) {
+    num_unique = unique_op.unique(h_key.data(), len, h_output_index.data(), h_unique_key.data());
+  }
+
+  std::unordered_set<TypeHashKey> ref(h_key.begin(), h_key.end());
+  ASSERT_EQ(num_unique, ref.size());
+  std::unordered_set<TypeHashKey> unique_set(h_unique_key.begin(),
+                                             h_unique_key.begin() + num_unique);
+  ASSERT_EQ(unique_set.size(), num_unique);
+  for (size_t i = 0; i < len; i++) {
+    ASSERT_LT(h_output_index[i], num_unique);
+    ASSERT_EQ(h_unique_key[h_output_index[i]], h_key[i]);
+  }
+
+  // The emb_vec of a unique key k is {k % 1024, k % 1024 + 1, ...}, expanded back to every key
+  std::vector<float> h_unique_vec(num_unique * embedding_vec_size);
+  for (size_t i = 0; i < num_unique; i++) {
+    for (size_t j = 0; j < embedding_vec_size; j++) {
+      h_unique_vec[i * embedding_vec_size + j] = static_cast<float>(h_unique_key[i] % 1024 + j);
+    }
+  }
+  std::vector<float> h_vec(len * embedding_vec_size);
+  decompress_emb_vec_cpu(h_unique_vec.data(), h_output_index.data(), h_vec.data(), len,
+                         embedding_vec_size);
+  for (size_t i = 0; i < len; i++) {
+    for (size_t j = 0; j < embedding_vec_size; j++) {
+      ASSERT_EQ(h_vec[i * embedding_vec_size + j], static_cast<float>(h_key[i] % 1024 + j));
+    }
+  }
+
+  const size_t num_iterations = std::max<size_t>(1, (1 << 22) / len);
+  Timer timer;
+  timer.start();
+  for (size_t i = 0; i < num_iterations; i++) {
+    unique_op.unique(h_key.data(), len, h_output_index.data(), h_unique_key.data());
+  }
+  timer.stop();
+  MESSAGE_("unique " + std::to_string(len) + " keys (" + std::to_string(num_unique) +
+           " unique): " + std::to_string(timer.elapsedSeconds() * 1e9 / (num_iterations * len)) +
+           " ns/key");
+}
+
+}  // namespace
+
+TEST(unique_op_cpu, small_query_uint32) { unique_op_cpu_test<unsigned int>(1 << 20, 64, 0.7, 16); }
+TEST(unique_op_cpu, no_duplicate_int64) { unique_op_cpu_test<long long>(4096, 4096, 0.0, 8); }
+TEST(unique_op_cpu, all_duplicate_int64) { unique_op_cpu_test<long long>(4096, 4096, 1.0, 8); }
+TEST(unique_op_cpu, batch_uint32) { unique_op_cpu_test<unsigned int>(1 << 16, 1 << 16, 0.7, 16); }
+TEST(unique_op_cpu, batch_int64) { unique_op_cpu_test<long long>(1 << 20, 1 << 20, 0.8, 32); }
+TEST(unique_op_cpu, over_capacity) {
+  UniqueOpCPU<long long> unique_op(16);
+  std::vector<long long> h_key(17, 0);
+  std::vector<uint64_t> h_output_index(17);
+  std::vector<long long> h_unique_key(17);
+  EXPECT_THROW(
+      unique_op.unique(h_key.data(), h_key.size(), h_output_index.data(), h_unique_key.data()),
+      internal_runtime_error);
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <unordered_map>
+
+#include "HugeCTR/include/model_oversubscriber/key_index.hpp"
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+
+namespace {
+
+/**
+ * Check a KeyIndex against an unordered_map with the same keys, and keys which are in neither.
+ */
+template <typename TypeKey>
+void check_key_index(const KeyIndex<TypeKey>& key_index,
+                     const std::unordered_map<TypeKey, std::pair<size_t, size_t>>& ref,
+                     const std::vector<TypeKey>& missing_keys) {
+  ASSERT_EQ(key_index.size(), ref.size());
+  for (const auto& pair : ref) {
+    size_t slot_id, index;
+    ASSERT_TRUE(key_index.find(pair.first, slot_id, index)) << pair.first;
+    EXPECT_EQ(slot_id, pair.second.first);
+    EXPECT_EQ(index, pair.second.second);
+  }
+  for (TypeKey key : missing_keys) {
+    if (ref.find(key) == ref.end()) {
+      EXPECT_FALSE(key_index.contains(key)) << key;
+    }
+  }
+  size_t num_keys = 0;
+  key_index.for_each([&](TypeKey key, size_t slot_id, size_t index) {
+    auto iter = ref.find(key);
+    ASSERT_NE(iter, ref.end());
+    EXPECT_EQ(slot_id, iter->second.first);
+    EXPECT_EQ(index, iter->second.second);
+    num_keys++;
+  });
+  EXPECT_EQ(num_keys, ref.size());
+}
+
+/**
+ * Build from keys drawn by gen, then insert more of them until they are merged.
+ */
+template <typename TypeKey, typename Gen>
+void key_index_test(Gen gen, bool with_slots) {
+  std::mt19937_64 rng(42);
+  const size_t num_keys = 200000;
+  std::unordered_map<TypeKey, std::pair<size_t, size_t>> ref;
+  std::vector<TypeKey> keys, missing_keys;
+  std::vector<size_t> slot_ids, indices;
+  for (size_t i = 0; i < num_keys; i++) {
+    const TypeKey key = gen(rng);
+    const size_t slot_id = with_slots ? rng() % 26 : 0;
+    keys.push_back(key);
+    if (with_slots) {
+      slot_ids.push_back(slot_id);
+    }
+    indices.push_back(i);
+    // the first of the duplicate keys is kept
+    ref.insert({key, {slot_id, i}});
+    missing_keys.push_back(gen(rng));
+  }
+  KeyIndex<TypeKey> key_index;
+  key_index.build(keys, slot_ids, indices);
+  check_key_index(key_index, ref, missing_keys);
+
+  // more than kMinMergeSize new keys, so that some of them are merged and some are not
+  const size_t num_new_keys = 100000;
+  for (size_t i = 0; i < num_new_keys; i++) {
+    const TypeKey key = missing_keys[i];
+    const size_t slot_id = with_slots ? rng() % 26 : 0;
+    const bool is_new = ref.insert({key, {slot_id, num_keys + i}}).second;
+    EXPECT_EQ(key_index.insert(key, slot_id, num_keys + i), is_new);
+  }
+  check_key_index(key_index, ref, missing_keys);
+  key_index.merge();
+  check_key_index(key_index, ref, missing_keys);
+
+  key_index.clear();
+  EXPECT_TRUE(key_index.empty());
+  EXPECT_FALSE(key_index.contains(keys[0]));
+}
+
+}  // namespace
+
+TEST(key_index, uniform_long_long) {
+  key_index_test<long long>([](std::mt19937_64& rng) { return static_cast<long long>(rng()); },
+                            true);
+}
+
+TEST(key_index, dense_unsigned) {
+  key_index_test<unsigned>([](std::mt19937_64& rng) { return static_cast<unsigned>(rng() % 400000); },
+                           false);
+}
+
+TEST(key_index, skewed_long_long) {
+  // most keys in a narrow range, a few spread over the whole range
+  key_index_test<long long>(
+      [](std::mt19937_64& rng) {
+        return rng() % 8 == 0 ? static_cast<long long>(rng())
+                              : static_cast<long long>(1000000 + rng() % 1000000);
+      },
+      true);
+}
+
+TEST(key_index, edge_cases) {
+  KeyIndex<long long> key_index;
+  size_t slot_id, index;
+  EXPECT_FALSE(key_index.find(0, slot_id, index));
+  key_index.build({5}, {}, {7});
+  ASSERT_TRUE(key_index.find(5, slot_id, index));
+  EXPECT_EQ(slot_id, 0);
+  EXPECT_EQ(index, 7);
+  EXPECT_FALSE(key_index.contains(4));
+  EXPECT_FALSE(key_index.contains(6));
+
+  const long long min_key = std::numeric_limits<long long>::min();
+  const long long max_key = std::numeric_limits<long long>::max();
+  key_index.build({max_key, min_key, 0}, {1, 2, 3}, {0, 1, 2});
+  ASSERT_TRUE(key_index.find(min_key, slot_id, index));
+  EXPECT_EQ(slot_id, 2);
+  ASSERT_TRUE(key_index.find(max_key, slot_id, index));
+  EXPECT_EQ(index, 0);
+  EXPECT_FALSE(key_index.contains(-1));
+
+  EXPECT_THROW(key_index.insert(1, 0, size_t(1) << 40), internal_runtime_error);
+  EXPECT_THROW(key_index.build({1, 2}, {}, {0}), internal_runtime_error);
+}
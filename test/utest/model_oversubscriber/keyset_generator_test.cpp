@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+#include "HugeCTR/include/data_generator.hpp"
+#include "HugeCTR/include/model_oversubscriber/keyset_generator.hpp"
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+
+namespace {
+
+const std::string file_list_name = "./keyset_generator_file_list.txt";
+const std::string raw_file_name = "./keyset_generator_raw.data";
+const std::string keyset_prefix = "./keyset_generator";
+const int num_files = 3;
+const int samples_per_file = 1000;
+const std::vector<int> slot_num = {2, 1};
+const int max_nnz = 3;
+
+/**
+ * The key j of a sample in a slot, the slots 0 and 1 belong to the first embedding and slot 2 to
+ * the second one.
+ */
+long long get_key(int id, int slot, int j) {
+  return slot < 2 ? (id * 3 + j) % (slot == 0 ? 50 : 7) + 100 * slot : (id + j) % 300;
+}
+
+/**
+ * The counts of the keys of each embedding.
+ */
+template <typename TypeKey>
+std::vector<std::map<TypeKey, uint64_t>> generate_norm_data_set() {
+  std::vector<std::map<TypeKey, uint64_t>> counts(slot_num.size());
+  std::ofstream file_list(file_list_name, std::ofstream::out);
+  file_list << num_files << "\n";
+  for (int f = 0; f < num_files; f++) {
+    const std::string file_name = "./keyset_generator_" + std::to_string(f) + ".data";
+    file_list << file_name << "\n";
+    std::ofstream out_stream(file_name, std::ofstream::binary);
+    DataWriter<Check_t::Sum> data_writer(out_stream);
+    DataSetHeader header = {1, samples_per_file, 1, 0, 3, 0, 0, 0};
+    data_writer.append(reinterpret_cast<char*>(&header), sizeof(DataSetHeader));
+    data_writer.write();
+    for (int i = 0; i < samples_per_file; i++) {
+      const int id = f * samples_per_file + i;
+      float label = id;
+      data_writer.append(reinterpret_cast<char*>(&label), sizeof(float));
+      for (int k = 0; k < 3; k++) {
+        int nnz = 1 + (id + k) % max_nnz;
+        data_writer.append(reinterpret_cast<char*>(&nnz), sizeof(int));
+        for (int j = 0; j < nnz; j++) {
+          TypeKey key = get_key(id, k, j);
+          data_writer.append(reinterpret_cast<char*>(&key), sizeof(TypeKey));
+          counts[k < 2 ? 0 : 1][key]++;
+        }
+      }
+      data_writer.write();
+    }
+  }
+  return counts;
+}
+
+template <typename TypeKey>
+std::vector<TypeKey> load_keyset(const std::string& file_name) {
+  std::ifstream stream(file_name, std::ifstream::binary | std::ifstream::ate);
+  const size_t file_size = stream.tellg();
+  stream.seekg(0);
+  std::vector<TypeKey> keys(file_size / sizeof(TypeKey));
+  stream.read(reinterpret_cast<char*>(keys.data()), file_size);
+  return keys;
+}
+
+template <typename TypeKey>
+void keyset_generator_norm_test(int num_threads) {
+  auto counts = generate_norm_data_set<TypeKey>();
+  KeysetGeneratorParams params;
+  params.format = DataReaderType_t::Norm;
+  params.check_type = Check_t::Sum;
+  params.slot_num = slot_num;
+  params.num_threads = num_threads;
+  params.write_counts = true;
+  auto keyset_files = get_keyset_file_names(keyset_prefix, slot_num.size());
+  ASSERT_EQ(keyset_files[1], keyset_prefix + ".1.keyset");
+
+  // all the keys, sorted
+  KeysetGenerator<TypeKey> generator(params);
+  KeysetStats stats = generator.generate(file_list_name, keyset_files);
+  EXPECT_EQ(stats.samples, num_files * samples_per_file);
+  EXPECT_EQ(stats.skipped_samples, 0);
+  for (size_t i = 0; i < slot_num.size(); i++) {
+    auto keys = load_keyset<TypeKey>(keyset_files[i]);
+    auto key_counts = load_keyset<uint64_t>(keyset_files[i] + ".count");
+    ASSERT_EQ(keys.size(), counts[i].size());
+    ASSERT_EQ(key_counts.size(), counts[i].size());
+    EXPECT_EQ(stats.unique_keys[i], counts[i].size());
+    size_t j = 0;
+    for (const auto& key_count : counts[i]) {
+      EXPECT_EQ(keys[j], key_count.first);
+      EXPECT_EQ(key_counts[j], key_count.second);
+      j++;
+    }
+  }
+
+  // the most frequent keys, in the background
+  params.top_k = 10;
+  params.write_counts = false;
+  KeysetGenerator<TypeKey> top_k_generator(params);
+  stats = top_k_generator.generate_async(file_list_name, keyset_files).get();
+  for (size_t i = 0; i < slot_num.size(); i++) {
+    std::vector<std::pair<uint64_t, TypeKey>> by_count;
+    for (const auto& key_count : counts[i]) {
+      by_count.emplace_back(key_count.second, key_count.first);
+    }
+    std::sort(by_count.begin(), by_count.end(), [](const auto& a, const auto& b) {
+      return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    auto keys = load_keyset<TypeKey>(keyset_files[i]);
+    ASSERT_EQ(keys.size(), 10);
+    EXPECT_EQ(stats.written_keys[i], 10);
+    for (size_t j = 0; j < keys.size(); j++) {
+      EXPECT_EQ(keys[j], by_count[j].second);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(keyset_generator, norm_long_long_1_thread) { keyset_generator_norm_test<long long>(1); }
+TEST(keyset_generator, norm_long_long_4_threads) { keyset_generator_norm_test<long long>(4); }
+TEST(keyset_generator, norm_unsigned_2_threads) { keyset_generator_norm_test<unsigned int>(2); }
+
+TEST(keyset_generator, raw) {
+  const int label_dim = 1;
+  const int dense_dim = 2;
+  const int num_samples = 5000;
+  std::map<long long, uint64_t> counts;
+  {
+    std::ofstream out_stream(raw_file_name, std::ofstream::binary);
+    for (int i = 0; i < num_samples; i++) {
+      int sample[label_dim + dense_dim + 1] = {i % 2, i, -i, (i * 7) % 1009};
+      out_stream.write(reinterpret_cast<char*>(sample), sizeof(sample));
+      counts[sample[label_dim + dense_dim]]++;
+    }
+  }
+  KeysetGeneratorParams params;
+  params.format = DataReaderType_t::Raw;
+  params.slot_num = {1};
+  params.label_dim = label_dim;
+  params.dense_dim = dense_dim;
+  params.num_samples = num_samples;
+  params.num_threads = 3;
+  params.min_count = 5;
+  auto keyset_files = get_keyset_file_names(keyset_prefix, 1);
+  ASSERT_EQ(keyset_files[0], keyset_prefix + ".keyset");
+  KeysetGenerator<long long> generator(params);
+  KeysetStats stats = generator.generate(raw_file_name, keyset_files);
+  EXPECT_EQ(stats.samples, num_samples);
+  EXPECT_EQ(stats.unique_keys[0], counts.size());
+
+  std::vector<long long> expected;
+  for (const auto& key_count : counts) {
+    if (key_count.second >= 5) {
+      expected.push_back(key_count.first);
+    }
+  }
+  EXPECT_EQ(load_keyset<long long>(keyset_files[0]), expected);
+}
@@ -29,6 +29,7 @@ const char* file_list_name_eval = "file_list_eval.txt";
 const char* snapshot_src_file = "distributed_snapshot_src";
 const char* snapshot_dst_file = "distributed_snapshot_dst";
 const char* keyset_file_name = "keyset_file.bin";
+const char* half_keyset_file_name = "half_keyset_file.bin";
 
 const int batchsize = 4096;
 const long long label_dim = 1;
@@ -51,7 +52,7 @@ const int batch_num_eval = 1;
 
 template <typename TypeKey>
 void do_upload_and_download_snapshot(
-    int batch_num_train, bool use_host_ps, bool is_distributed) {
+    int batch_num_train, bool use_host_ps, bool is_distributed, bool use_prefetch = false) {
   Embedding_t embedding_type = is_distributed ? 
                                Embedding_t::DistributedSlotSparseEmbeddingHash :
                                Embedding_t::LocalizedSlotSparseEmbeddingHash;
@@ -153,6 +154,10 @@ void do_upload_and_download_snapshot(
     std::ofstream key_ofs(keyset_file_name, std::ofstream::binary |
                                             std::ofstream::trunc);
     key_ofs.write(reinterpret_cast<char *>(key_ptr), num_keys * sizeof(TypeKey));
+
+    std::ofstream half_key_ofs(half_keyset_file_name, std::ofstream::binary |
+                                                      std::ofstream::trunc);
+    half_key_ofs.write(reinterpret_cast<char *>(key_ptr), num_keys / 2 * sizeof(TypeKey));
   }
 
   std::vector<std::string> keyset_file_list;
@@ -174,8 +179,22 @@ void do_upload_and_download_snapshot(
   timer_ps.start();
 
   // upload embedding table from disk according to keyset
-  model_oversubscriber->update(keyset_file_list);
+  if (use_prefetch) {
+    // switch between the passes of half and all of the keys through the staging buffers, the
+    // half kept on the device and the other half prefetched, then evicted and pushed back
+    std::vector<std::string> half_keyset_file_list;
+    half_keyset_file_list.emplace_back(half_keyset_file_name);
+    model_oversubscriber->update(half_keyset_file_list);
+    model_oversubscriber->prefetch(keyset_file_list);
+    model_oversubscriber->update(keyset_file_list);
+    model_oversubscriber->prefetch(half_keyset_file_list);
+    model_oversubscriber->update(half_keyset_file_list);
+  } else {
+    model_oversubscriber->update(keyset_file_list);
+  }
+  // nothing is trained since the keys were loaded, so no vector is pushed
   model_oversubscriber->dump();
+  ASSERT_EQ(model_oversubscriber->get_num_pushed_vectors(), 0ul);
   model_oversubscriber->update_sparse_model_file();
 
   MESSAGE_("Batch_num=" + std::to_string(batch_num_train) +
@@ -188,6 +207,18 @@ void do_upload_and_download_snapshot(
   if (!is_distributed) {
     ASSERT_TRUE(check_vector_equality(snapshot_src_file, snapshot_dst_file, "slot_id"));
   }
+
+  // the vectors trained on the device are pushed, and the sparse model has them all
+  data_reader_train->read_a_batch_to_device();
+  embedding->forward(true);
+  embedding->backward();
+  embedding->update_params();
+  model_oversubscriber->dump();
+  ASSERT_GT(model_oversubscriber->get_num_pushed_vectors(), 0ul);
+  model_oversubscriber->update_sparse_model_file();
+  embedding->dump_parameters(snapshot_src_file);
+  ASSERT_TRUE(check_vector_inclusion(snapshot_src_file, snapshot_dst_file, emb_vec_size,
+                                     !is_distributed));
 }
 
 TEST(model_oversubscriber_test, long_long_ssd_distributed) {
@@ -206,4 +237,12 @@ TEST(model_oversubscriber_test, unsigned_host_localized) {
   do_upload_and_download_snapshot<unsigned>(20, true, false);
 }
 
+TEST(model_oversubscriber_test, long_long_ssd_distributed_prefetch) {
+  do_upload_and_download_snapshot<long long>(20, false, true, true);
+}
+
+TEST(model_oversubscriber_test, unsigned_host_localized_prefetch) {
+  do_upload_and_download_snapshot<unsigned>(20, true, false, true);
+}
+
 }  // namespace
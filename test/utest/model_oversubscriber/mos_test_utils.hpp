@@ -30,6 +30,7 @@
 #include <fstream>
 #include <iterator>
 #include <string>
+#include <unordered_map>
 #include <experimental/filesystem>
 
 namespace fs = std::experimental::filesystem;
@@ -113,6 +114,45 @@ inline bool check_vector_equality(const char *sparse_model_src,
   return flag;
 }
 
+/**
+ * Whether every key of sparse_model_src is in sparse_model_dst with the same embedding vector,
+ * and the same slot_id if check_slot_id.
+ */
+inline bool check_vector_inclusion(const char *sparse_model_src,
+    const char *sparse_model_dst, size_t emb_vec_size, bool check_slot_id) {
+  auto load = [check_slot_id](const char *sparse_model, std::vector<char>& keys,
+                              std::vector<char>& vecs, std::vector<char>& slots) {
+    keys = load_to_vector(std::string(sparse_model) + "/key");
+    vecs = load_to_vector(std::string(sparse_model) + "/emb_vector");
+    if (check_slot_id) slots = load_to_vector(std::string(sparse_model) + "/slot_id");
+  };
+  std::vector<char> keys_src, vecs_src, slots_src, keys_dst, vecs_dst, slots_dst;
+  load(sparse_model_src, keys_src, vecs_src, slots_src);
+  load(sparse_model_dst, keys_dst, vecs_dst, slots_dst);
+
+  const long long *key_ptr_src = reinterpret_cast<const long long *>(keys_src.data());
+  const long long *key_ptr_dst = reinterpret_cast<const long long *>(keys_dst.data());
+  std::unordered_map<long long, size_t> dst_rows;
+  for (size_t i = 0; i < keys_dst.size() / sizeof(long long); i++) {
+    dst_rows[key_ptr_dst[i]] = i;
+  }
+  const size_t vec_size_in_byte = emb_vec_size * sizeof(float);
+  for (size_t i = 0; i < keys_src.size() / sizeof(long long); i++) {
+    auto it = dst_rows.find(key_ptr_src[i]);
+    if (it == dst_rows.end()) return false;
+    if (!test::compare_array_approx<char>(vecs_src.data() + i * vec_size_in_byte,
+            vecs_dst.data() + it->second * vec_size_in_byte, vec_size_in_byte, 0)) {
+      return false;
+    }
+    if (check_slot_id &&
+        reinterpret_cast<const size_t *>(slots_src.data())[i] !=
+        reinterpret_cast<const size_t *>(slots_dst.data())[it->second]) {
+      return false;
+    }
+  }
+  return true;
+}
+
 template <typename TypeKey, Check_t check>
 inline void generate_sparse_model_impl(std::string sparse_model_name,
     std::string file_list_name_train, std::string file_list_name_eval,
@@ -180,6 +180,71 @@ void sparse_model_entity_test(int batch_num_train, bool use_host_mem, bool is_di
   ASSERT_TRUE(check_vector_equality(snapshot_src_file, snapshot_dst_file, "emb_vector"));
 }
 
+template <typename TypeKey>
+void sparse_model_entity_store_test(bool use_host_mem, bool is_distributed) {
+  Embedding_t embedding_type = is_distributed ? Embedding_t::DistributedSlotSparseEmbeddingHash :
+                                                Embedding_t::LocalizedSlotSparseEmbeddingHash;
+  std::vector<std::vector<int>> vvgpu;
+  vvgpu.push_back({0});
+  const auto resource_manager = ResourceManager::create(vvgpu, 0);
+  const char *store_name = "./sparse_model_entity_store";
+  fs::remove_all(store_name);
+
+  const size_t num_keys = 10000;
+  BufferBag buf_bag;
+  {
+    std::shared_ptr<GeneralBuffer2<CudaHostAllocator>> blobs_buff =
+      GeneralBuffer2<CudaHostAllocator>::create();
+    Tensor2<TypeKey> tensor_keys;
+    Tensor2<size_t> tensor_slot_id;
+    blobs_buff->reserve({num_keys}, &tensor_keys);
+    blobs_buff->reserve({num_keys}, &tensor_slot_id);
+    blobs_buff->reserve({num_keys, emb_vec_size}, &(buf_bag.embedding));
+    blobs_buff->allocate();
+    buf_bag.keys = tensor_keys.shrink();
+    buf_bag.slot_id = tensor_slot_id.shrink();
+  }
+  TypeKey *key_ptr = Tensor2<TypeKey>::stretch_from(buf_bag.keys).get_ptr();
+  size_t *slot_id_ptr = Tensor2<size_t>::stretch_from(buf_bag.slot_id).get_ptr();
+  float *emb_ptr = buf_bag.embedding.get_ptr();
+
+  // two passes, the second one half updates and half new keys, flushed after each of them so
+  // that the keys only in the first pass are not written again
+  std::vector<TypeKey> keys(num_keys + num_keys / 2);
+  iota(keys.begin(), keys.end(), 0);
+  std::vector<float> vecs(keys.size() * emb_vec_size);
+  std::default_random_engine generator;
+  std::uniform_real_distribution<float> real_distribution(0.0f, 1.0f);
+  for_each(vecs.begin(), vecs.end(), [&](float& elem) { elem = real_distribution(generator); });
+  {
+    HugeCTR::SparseModelEntity<TypeKey> sparse_model_entity(use_host_mem, store_name,
+        embedding_type, emb_vec_size, resource_manager, true);
+    for (size_t offset : {size_t(0), num_keys / 2}) {
+      memcpy(key_ptr, keys.data() + offset, num_keys * sizeof(TypeKey));
+      for (size_t i = 0; i < num_keys; i++) slot_id_ptr[i] = (offset + i) % slot_num;
+      memcpy(emb_ptr, vecs.data() + offset * emb_vec_size,
+             num_keys * emb_vec_size * sizeof(float));
+      sparse_model_entity.dump_vec_by_key(buf_bag, num_keys);
+      sparse_model_entity.flush_emb_tbl_to_ssd();
+    }
+  }
+
+  HugeCTR::SparseModelEntity<TypeKey> sparse_model_entity(use_host_mem, store_name,
+      embedding_type, emb_vec_size, resource_manager, true);
+  std::vector<TypeKey> load_keys(keys.begin() + num_keys / 4,
+                                 keys.begin() + num_keys / 4 + num_keys);
+  size_t hit_size;
+  sparse_model_entity.load_vec_by_key(load_keys, buf_bag, hit_size);
+  ASSERT_EQ(hit_size, num_keys);
+  ASSERT_TRUE(test::compare_array_approx<float>(emb_ptr,
+      vecs.data() + num_keys / 4 * emb_vec_size, num_keys * emb_vec_size, 0));
+  if (!is_distributed) {
+    for (size_t i = 0; i < num_keys; i++) {
+      ASSERT_EQ(slot_id_ptr[i], (num_keys / 4 + i) % slot_num);
+    }
+  }
+}
+
 TEST(sparse_model_entity_test, long_long_ssd_distributed) {
   sparse_model_entity_test<long long>(30, false, true);
 }
@@ -196,5 +261,13 @@ TEST(sparse_model_entity_test, unsigned_host_localized) {
   sparse_model_entity_test<unsigned>(20, true, false);
 }
 
+TEST(sparse_model_entity_test, long_long_ssd_store_distributed) {
+  sparse_model_entity_store_test<long long>(false, true);
+}
+
+TEST(sparse_model_entity_test, unsigned_host_store_localized) {
+  sparse_model_entity_store_test<unsigned>(true, false);
+}
+
 
 }  // namespace
@@ -78,7 +78,7 @@ void sparse_model_file_test(int batch_num_train, bool is_distributed) {
     HugeCTR::SparseModelFile<TypeKey> sparse_model_file(snapshot_dst_file,
         embedding_type, emb_vec_size, resource_manager);
 
-    std::unordered_map<TypeKey, std::pair<size_t, size_t>> mem_key_index_map;
+    HugeCTR::KeyIndex<TypeKey> mem_key_index_map;
     std::vector<float> mem_emb_table;
     sparse_model_file.load_emb_tbl_to_mem(mem_key_index_map, mem_emb_table);
 
@@ -96,9 +96,9 @@ void sparse_model_file_test(int batch_num_train, bool is_distributed) {
     }
 
     std::map<size_t, std::pair<TypeKey, size_t>> index_key_map;
-    for_each(mem_key_index_map.begin(), mem_key_index_map.end(),
-      [&index_key_map](const auto& pair) {
-        index_key_map.insert({pair.second.second, {pair.first, pair.second.first}});
+    mem_key_index_map.for_each(
+      [&index_key_map](TypeKey key, size_t slot_id, size_t mem_idx) {
+        index_key_map.insert({mem_idx, {key, slot_id}});
     });
     ASSERT_TRUE(index_key_map.size() == mem_key_index_map.size());
 
@@ -266,6 +266,23 @@ void sparse_model_file_test(int batch_num_train, bool is_distributed) {
         reinterpret_cast<char *>(load_slots.data()),
         reinterpret_cast<char *>(re_load_slots.data()), load_slots.size() * sizeof(size_t), 0));
     }
+
+    const DumpStats& dump_stats = sparse_model_file.get_last_dump_stats();
+    ASSERT_TRUE(dump_stats.rows == selt_keys.size());
+    ASSERT_TRUE(dump_stats.runs > 0 && dump_stats.runs <= dump_stats.rows);
+    ASSERT_TRUE(dump_stats.bytes_written >= selt_keys.size() * emb_vec_size * sizeof(float));
+
+    // a key dumped twice gets the last of its vectors in the input, wherever it is in vecs
+    std::vector<TypeKey> dup_keys{selt_keys[0], selt_keys[0]};
+    std::vector<size_t> dup_indices{1, 0};
+    std::vector<float> dup_vecs(2 * emb_vec_size);
+    for_each(dup_vecs.begin(), dup_vecs.end(), gen_real_rand_op);
+    sparse_model_file.dump_exist_vec_by_key(dup_keys, dup_indices, dup_vecs.data());
+    sparse_model_file.load_exist_vec_by_key({selt_keys[0]}, re_load_slots, re_load_vecs);
+    ASSERT_TRUE(test::compare_array_approx<char>(
+        reinterpret_cast<char *>(dup_vecs.data()),
+        reinterpret_cast<char *>(re_load_vecs.data()), emb_vec_size * sizeof(float), 0));
+    ASSERT_TRUE(sparse_model_file.get_last_dump_stats().rows == 1);
   }
 }
 
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <experimental/filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+
+#include "HugeCTR/include/model_oversubscriber/sparse_model_store.hpp"
+#include "gtest/gtest.h"
+
+using namespace HugeCTR;
+
+namespace fs = std::experimental::filesystem;
+
+namespace {
+
+const char* store_name = "./sparse_model_store_test";
+const size_t emb_vec_size = 16;
+
+template <typename TypeKey>
+using RefTable = std::map<TypeKey, std::pair<size_t, std::vector<float>>>;
+
+std::shared_ptr<ResourceManager> create_resource_manager() {
+  std::vector<std::vector<int>> vvgpu;
+  vvgpu.push_back({0});
+  return ResourceManager::create(vvgpu, 0);
+}
+
+/**
+ * Check every key of ref through load_exist_vec_by_key, contains and load_emb_tbl_to_mem.
+ */
+template <typename TypeKey>
+void check_store(SparseModelStore<TypeKey>& store, const RefTable<TypeKey>& ref,
+                 bool is_distributed) {
+  std::vector<TypeKey> keys;
+  for (const auto& pair : ref) keys.push_back(pair.first);
+  std::vector<size_t> slots;
+  std::vector<float> vecs;
+  store.load_exist_vec_by_key(keys, slots, vecs);
+  for (size_t i = 0; i < keys.size(); i++) {
+    const auto& expected = ref.at(keys[i]);
+    ASSERT_TRUE(std::equal(expected.second.begin(), expected.second.end(),
+                           vecs.begin() + i * emb_vec_size))
+        << keys[i];
+    if (!is_distributed) EXPECT_EQ(slots[i], expected.first);
+  }
+  EXPECT_FALSE(store.contains(static_cast<TypeKey>(123456789)));
+  EXPECT_THROW(store.load_exist_vec_by_key({static_cast<TypeKey>(123456789)}, slots, vecs),
+               internal_runtime_error);
+
+  KeyIndex<TypeKey> mem_key_index_map;
+  store.load_emb_tbl_to_mem(mem_key_index_map, vecs);
+  ASSERT_EQ(mem_key_index_map.size(), ref.size());
+  ASSERT_EQ(vecs.size(), ref.size() * emb_vec_size);
+  for (const auto& pair : ref) {
+    size_t slot_id, mem_idx;
+    ASSERT_TRUE(mem_key_index_map.find(pair.first, slot_id, mem_idx));
+    if (!is_distributed) EXPECT_EQ(slot_id, pair.second.first);
+    ASSERT_TRUE(std::equal(pair.second.second.begin(), pair.second.second.end(),
+                           vecs.begin() + mem_idx * emb_vec_size));
+  }
+}
+
+/**
+ * Commit passes of updated and new keys, some of them larger than the memtable, so that there
+ * are flushes and compactions, then reopen the store.
+ */
+template <typename TypeKey>
+void sparse_model_store_test(bool is_distributed) {
+  Embedding_t embedding_type = is_distributed ? Embedding_t::DistributedSlotSparseEmbeddingHash
+                                              : Embedding_t::LocalizedSlotSparseEmbeddingHash;
+  auto resource_manager = create_resource_manager();
+  fs::remove_all(store_name);
+  const size_t max_memtable_bytes = 256 * 1024;
+  const size_t max_segments = 2;
+
+  std::mt19937_64 rng(7);
+  RefTable<TypeKey> ref;
+  {
+    SparseModelStore<TypeKey> store(store_name, embedding_type, emb_vec_size, resource_manager,
+                                    max_memtable_bytes, max_segments);
+    for (int pass = 0; pass < 30; pass++) {
+      // every 10th pass is larger than the memtable
+      const size_t num_keys = pass % 10 == 9 ? 5000 : 500;
+      std::vector<TypeKey> keys(num_keys);
+      std::vector<size_t> slots(num_keys), vec_indices(num_keys);
+      std::vector<float> vecs(num_keys * emb_vec_size);
+      for (size_t i = 0; i < num_keys; i++) {
+        keys[i] = static_cast<TypeKey>(rng() % 20000);
+        slots[i] = keys[i] % 26;
+        vec_indices[i] = num_keys - 1 - i;
+        for (size_t j = 0; j < emb_vec_size; j++) {
+          vecs[vec_indices[i] * emb_vec_size + j] = pass * 100000.f + i + j * 0.5f;
+        }
+        auto& entry = ref[keys[i]];
+        entry.first = slots[i];
+        entry.second.assign(vecs.begin() + vec_indices[i] * emb_vec_size,
+                            vecs.begin() + (vec_indices[i] + 1) * emb_vec_size);
+      }
+      store.commit(keys, is_distributed ? nullptr : slots.data(), vec_indices, vecs.data());
+    }
+    EXPECT_LE(store.get_num_segments(), 2 * max_segments);
+    check_store(store, ref, is_distributed);
+  }
+
+  // the memtable is replayed from the WAL
+  {
+    SparseModelStore<TypeKey> store(store_name, embedding_type, emb_vec_size, resource_manager,
+                                    max_memtable_bytes, max_segments);
+    check_store(store, ref, is_distributed);
+    store.flush();
+    store.compact();
+    EXPECT_EQ(store.get_num_segments(), 1);
+    check_store(store, ref, is_distributed);
+  }
+  {
+    SparseModelStore<TypeKey> store(store_name, embedding_type, emb_vec_size, resource_manager);
+    EXPECT_EQ(store.get_num_segments(), 1);
+    check_store(store, ref, is_distributed);
+  }
+  // a store is not opened with another embedding
+  EXPECT_THROW(SparseModelStore<TypeKey>(store_name, embedding_type, emb_vec_size + 1,
+                                         resource_manager),
+               internal_runtime_error);
+}
+
+}  // namespace
+
+TEST(sparse_model_store_test, long_long_distributed) {
+  sparse_model_store_test<long long>(true);
+}
+
+TEST(sparse_model_store_test, unsigned_localized) {
+  sparse_model_store_test<unsigned>(false);
+}
+
+TEST(sparse_model_store_test, torn_wal) {
+  auto resource_manager = create_resource_manager();
+  const Embedding_t embedding_type = Embedding_t::DistributedSlotSparseEmbeddingHash;
+  fs::remove_all(store_name);
+  std::vector<float> vecs(2 * emb_vec_size, 1.f);
+  std::fill(vecs.begin() + emb_vec_size, vecs.end(), 2.f);
+  {
+    SparseModelStore<long long> store(store_name, embedding_type, emb_vec_size,
+                                      resource_manager);
+    store.commit({1, 2}, nullptr, {0, 1}, vecs.data());
+    store.commit({2, 3}, nullptr, {0, 1}, vecs.data());
+  }
+
+  // cut the last pass in the middle, and leave a segment of an interrupted flush
+  std::string wal_file;
+  for (const auto& entry : fs::directory_iterator(std::string(store_name) + "/rank_0")) {
+    if (entry.path().filename().string().find("wal_") == 0) wal_file = entry.path().string();
+  }
+  ASSERT_FALSE(wal_file.empty());
+  fs::resize_file(wal_file, fs::file_size(wal_file) - 10);
+  const std::string stray_segment = std::string(store_name) + "/rank_0/segment_999";
+  std::ofstream(stray_segment) << "partial";
+
+  SparseModelStore<long long> store(store_name, embedding_type, emb_vec_size, resource_manager);
+  EXPECT_FALSE(fs::exists(stray_segment));
+  EXPECT_TRUE(store.contains(1));
+  EXPECT_FALSE(store.contains(3));
+  std::vector<size_t> slots;
+  std::vector<float> loaded;
+  store.load_exist_vec_by_key({2}, slots, loaded);
+  EXPECT_EQ(loaded[0], 2.f);
+
+  // the passes after the cut are appended to the complete ones
+  store.commit({3}, nullptr, {0}, vecs.data());
+  EXPECT_TRUE(store.contains(3));
+}
@@ -16,20 +16,28 @@
 
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <ios>
 #include <iostream>
-#include <sstream>
-#include <unordered_set>
+#include <limits>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "HugeCTR/include/data_generator.hpp"
+#include "HugeCTR/include/data_readers/norm_v2.hpp"
 
 using namespace HugeCTR;
 
 static std::string usage_str =
     "usage: ./criteo2hugectr in.txt dir/prefix file_list.txt [option:#keys for wide model,default "
-    "is 0] [option: Number of files in each file_list.txt,default is 0(all in one file)]";
+    "is 0] [option: Number of files in each file_list.txt,default is 0(all in one file)] [option: "
+    "--compression <None | LZ4 | Zstd: None>] [option: --threads <number of threads: #cores>]";
 static const int N = 40960;  // number of samples per data file
 static int KEYS_WIDE_MODEL = 0;
 static const int KEYS_DENSE_MODEL = 26;
@@ -38,19 +46,366 @@ typedef unsigned int T;
 static const long long label_dim = 1;
 static int SLOT_NUM = 26;
 static int FILELIST_LENGTH = 0;  // number of files in each file_list.txt
-std::unordered_set<unsigned int> keyset;
+static Compression_t compression = Compression_t::None;
+static const long long RECORDS_PER_BLOCK = 4096;  // records of each compressed block
+static int NUM_THREADS = 1;
+static const size_t READ_SIZE = 16 << 20;  // bytes read from in.txt at once
+
+/**
+ * A flat hash set of keys. clear() is O(1): a slot only belongs to the set if it carries the
+ * current stamp, so a worker can reuse the same table for every data file.
+ */
+class KeySet {
+  std::vector<T> keys_;
+  std::vector<unsigned int> stamps_;
+  unsigned int stamp_{1};
+  int bits_{0};
+  size_t size_{0};
+
+  size_t slot(T key) const {
+    return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ULL) >>
+                               (64 - bits_));
+  }
+
+  void rehash(int bits) {
+    std::vector<T> keys;
+    keys.reserve(size_);
+    for (size_t i = 0; i < stamps_.size(); i++) {
+      if (stamps_[i] == stamp_) {
+        keys.push_back(keys_[i]);
+      }
+    }
+    bits_ = bits;
+    keys_.assign(size_t(1) << bits, 0);
+    stamps_.assign(size_t(1) << bits, 0);
+    stamp_ = 1;
+    size_ = 0;
+    for (T key : keys) {
+      insert(key);
+    }
+  }
+
+ public:
+  explicit KeySet(size_t capacity) {
+    int bits = 4;
+    while ((size_t(1) << bits) < 2 * capacity) {
+      bits++;
+    }
+    rehash(bits);
+  }
+
+  /**
+   * @return true if key was not in the set
+   */
+  bool insert(T key) {
+    if (2 * (size_ + 1) > stamps_.size()) {
+      rehash(bits_ + 1);
+    }
+    size_t i = slot(key);
+    while (stamps_[i] == stamp_) {
+      if (keys_[i] == key) {
+        return false;
+      }
+      i = (i + 1) & (stamps_.size() - 1);
+    }
+    stamps_[i] = stamp_;
+    keys_[i] = key;
+    size_++;
+    return true;
+  }
 
-std::vector<std::string> &split(const std::string &s, char delim, std::vector<std::string> &elems) {
-  std::stringstream ss(s);
-  std::string item;
-  while (std::getline(ss, item, delim)) {
-    elems.push_back(item);
+  void clear() {
+    size_ = 0;
+    if (++stamp_ == 0) {
+      std::fill(stamps_.begin(), stamps_.end(), 0);
+      stamp_ = 1;
+    }
+  }
+
+  size_t size() const { return size_; }
+};
+
+/**
+ * Reads in.txt in large reads and hands out whole lines.
+ */
+class LineReader {
+  std::ifstream &stream_;
+  std::vector<char> buffer_;
+  size_t begin_{0};
+  size_t end_{0};
+  bool eof_{false};
+
+  void fill() {
+    memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+    end_ -= begin_;
+    begin_ = 0;
+    if (end_ == buffer_.size()) {
+      // a line longer than the buffer
+      buffer_.resize(2 * buffer_.size());
+    }
+    stream_.read(buffer_.data() + end_, buffer_.size() - end_);
+    end_ += stream_.gcount();
+    eof_ = stream_.gcount() == 0;
   }
-  return elems;
+
+ public:
+  LineReader(std::ifstream &stream) : stream_(stream), buffer_(READ_SIZE) {}
+
+  /**
+   * Replace the content of out with the next max_lines lines, each ending with '\n'.
+   * @return the number of lines, 0 at the end of the file
+   */
+  long long read_lines(long long max_lines, std::vector<char> *out) {
+    out->clear();
+    long long lines = 0;
+    while (lines < max_lines) {
+      const char *first = buffer_.data() + begin_;
+      const char *newline = static_cast<const char *>(memchr(first, '\n', end_ - begin_));
+      if (newline == nullptr) {
+        if (!eof_) {
+          fill();
+          continue;
+        }
+        // the last line may miss its '\n'
+        if (begin_ < end_) {
+          out->insert(out->end(), first, static_cast<const char *>(buffer_.data()) + end_);
+          out->push_back('\n');
+          begin_ = end_;
+          lines++;
+        }
+        break;
+      }
+      out->insert(out->end(), first, newline + 1);
+      begin_ = newline + 1 - buffer_.data();
+      lines++;
+    }
+    return lines;
+  }
+};
+
+// the parsers only read up to the ' ' or '\n' which ends the field, unlike std::stoll they do not
+// allocate, and a key is read in hex if it starts with 0x
+static const char *parse_key(const char *p, T *key) {
+  bool negative = false;
+  if (*p == '-' || *p == '+') {
+    negative = *p == '-';
+    p++;
+  }
+  unsigned long long value = 0;
+  if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+    for (p += 2;; p++) {
+      const char c = *p;
+      if (c >= '0' && c <= '9') {
+        value = value * 16 + (c - '0');
+      } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+        value = value * 16 + ((c | 0x20) - 'a' + 10);
+      } else {
+        break;
+      }
+    }
+  } else {
+    for (; *p >= '0' && *p <= '9'; p++) {
+      value = value * 10 + (*p - '0');
+    }
+  }
+  *key = static_cast<T>(negative ? 0 - value : value);
+  return p;
+}
+
+static const char *parse_float(const char *p, float *result) {
+  // digits[.digits] is read exactly: with at most 15 digits, the mantissa and the power of 10 are
+  // exact doubles and the division rounds as strtod does
+  const char *begin = p;
+  bool negative = false;
+  if (*p == '-' || *p == '+') {
+    negative = *p == '-';
+    p++;
+  }
+  static const double powers_of_10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int fraction_digits = 0;
+  for (; *p >= '0' && *p <= '9'; p++, digits++) {
+    mantissa = mantissa * 10 + (*p - '0');
+  }
+  if (*p == '.') {
+    for (p++; *p >= '0' && *p <= '9'; p++, digits++, fraction_digits++) {
+      mantissa = mantissa * 10 + (*p - '0');
+    }
+  }
+  // an exponent or a hex float is left to strtod
+  if (digits > 0 && digits <= 15 && *p != 'e' && *p != 'E' && *p != 'x' && *p != 'X') {
+    const double value = mantissa / powers_of_10[fraction_digits];
+    *result = static_cast<float>(negative ? -value : value);
+    return p;
+  }
+  char *end;
+  const double value = strtod(begin, &end);
+  *result = static_cast<float>(value);
+  return end == begin ? nullptr : end;
+}
+
+/**
+ * The lines of a data file, parsed and written by a worker, then merged in order by main().
+ */
+struct FileTask {
+  enum class State { Free, Read, Parsed };
+  State state{State::Free};
+  long long file_id{-1};
+  std::vector<char> text;  // the lines of the file
+  long long num_lines{0};
+  std::vector<T> keys;     // the distinct keys of the file, in order of first appearance
+  std::string error;       // the line which could not be parsed
+};
+
+/**
+ * Parse the lines of task into a data file, and collect its distinct keys with key_set.
+ */
+static void parse_file(FileTask *task, const std::string &data_file_name, KeySet *key_set,
+                       std::vector<char> *out, std::vector<char> *record) {
+  using norm_v2_internal::append_checked;
+  const int num_fields = KEYS_WIDE_MODEL + KEYS_DENSE_MODEL + dense_dim + label_dim;
+  const int record_size = (dense_dim + label_dim) * sizeof(float) +
+                          (KEYS_WIDE_MODEL != 0 ? sizeof(int) : 0) + KEYS_WIDE_MODEL * sizeof(T) +
+                          KEYS_DENSE_MODEL * (sizeof(int) + sizeof(T));
+  record->resize(record_size);
+  out->clear();
+  task->keys.clear();
+  task->error.clear();
+  key_set->clear();
+
+  DataSetHeader header = {1,
+                          task->num_lines,
+                          label_dim,
+                          dense_dim,
+                          static_cast<long long>(SLOT_NUM),
+                          0,
+                          0,
+                          0};
+  append_checked(*out, reinterpret_cast<const char *>(&header), sizeof(DataSetHeader),
+                 Check_t::Sum);
+
+  const char *p = task->text.data();
+  for (long long line = 0; line < task->num_lines; line++) {
+    const char *line_begin = p;
+    char *dst = record->data();
+    int field = 0;
+    bool good = true;
+    // a field ends at a ' ', and a trailing ' ' does not start an empty field
+    for (; *p != '\n'; field++) {
+      if (field >= num_fields) {
+        good = false;
+        break;
+      }
+      if (*p == ' ') {
+        good = false;  // an empty field
+        break;
+      }
+      const char *end;
+      if (field < dense_dim + label_dim) {
+        float label_dense;
+        end = parse_float(p, &label_dense);
+        memcpy(dst, &label_dense, sizeof(float));
+        dst += sizeof(float);
+      } else {
+        if (field == dense_dim + label_dim && KEYS_WIDE_MODEL != 0) {
+          memcpy(dst, &KEYS_WIDE_MODEL, sizeof(int));
+          dst += sizeof(int);
+        }
+        if (field >= KEYS_WIDE_MODEL + dense_dim + label_dim) {
+          const int nnz = 1;
+          memcpy(dst, &nnz, sizeof(int));
+          dst += sizeof(int);
+        }
+        T key;
+        end = parse_key(p, &key);
+        memcpy(dst, &key, sizeof(T));
+        dst += sizeof(T);
+        if (key_set->insert(key)) {
+          task->keys.push_back(key);
+        }
+      }
+      if (end == nullptr || end == p) {
+        good = false;
+        break;
+      }
+      // skip what the parsers ignore, e.g. the ".0" of a key
+      p = end;
+      while (*p != ' ' && *p != '\n') {
+        p++;
+      }
+      if (*p == ' ') {
+        p++;
+      }
+    }
+    if (!good || field != num_fields) {
+      const char *line_end = static_cast<const char *>(
+          memchr(line_begin, '\n', task->text.data() + task->text.size() - line_begin));
+      task->error.assign(line_begin, line_end);
+      return;
+    }
+    append_checked(*out, record->data(), record_size, Check_t::Sum);
+    p++;
+  }
+
+  std::ofstream data_file(data_file_name, std::ofstream::binary);
+  if (!data_file.is_open()) {
+    task->error = "Cannot open " + data_file_name;
+    return;
+  }
+  data_file.write(out->data(), out->size());
+  data_file.close();
+  if (!data_file.good()) {
+    task->error = "Cannot write " + data_file_name;
+    return;
+  }
+  if (compression == Compression_t::None) {
+    return;
+  }
+  // rewrite the data file into the compressed Norm v2 layout, see norm_v2.hpp
+  const std::string tmp_name = data_file_name + ".tmp";
+  if (std::rename(data_file_name.c_str(), tmp_name.c_str()) != 0) {
+    task->error = "Cannot rename " + data_file_name;
+    return;
+  }
+  try {
+    convert_norm_to_v2<T>(tmp_name, data_file_name, Check_t::Sum, RECORDS_PER_BLOCK, true,
+                          compression);
+  } catch (const std::runtime_error &rt_err) {
+    task->error = rt_err.what();
+    return;
+  }
+  std::remove(tmp_name.c_str());
+}
+
+// remove --option and its value from argv, so that the positional arguments stay in place
+static std::string remove_option(const std::string &option, int &argc, char *argv[]) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (argv[i] == "--" + option) {
+      std::string value(argv[i + 1]);
+      std::copy(argv + i + 2, argv + argc, argv + i);
+      argc -= 2;
+      return value;
+    }
+  }
+  return std::string();
 }
 
 int main(int argc, char *argv[]) {
-  const std::string tmp_file_list_name("file_list.tmp");
+  const std::string compression_str = remove_option("compression", argc, argv);
+  if (!compression_str.empty()) {
+    auto it = get_compression_type_map().find(compression_str);
+    if (it == get_compression_type_map().end()) {
+      std::cerr << "Not supported compression: " << compression_str << std::endl;
+      exit(-1);
+    }
+    compression = it->second;
+  }
+  const std::string threads_str = remove_option("threads", argc, argv);
+  NUM_THREADS = threads_str.empty() ? std::thread::hardware_concurrency()
+                                    : atoi(threads_str.c_str());
+  NUM_THREADS = std::max(1, NUM_THREADS);
 
   if (argc != 4 && argc != 5 && argc != 6) {
     std::cout << usage_str << std::endl;
@@ -84,6 +439,7 @@ int main(int argc, char *argv[]) {
   std::ifstream txt_file(argv[1], std::ifstream::binary);
   if (!txt_file.is_open()) {
     std::cerr << "Cannot open argv[1]" << std::endl;
+    exit(-1);
   }
   // create a data file under prefix
   std::string data_prefix(argv[2]);
@@ -103,209 +459,139 @@ int main(int argc, char *argv[]) {
   std::string file_name_prefix = file_name.substr(0, last_point_idx);
   std::string file_name_postfix = file_name.substr(last_point_idx);
 
-  int file_counter = 0;
-  std::ofstream file_list_tmp(tmp_file_list_name, std::ofstream::out);
-
-  if (!file_list_tmp.is_open()) {
-    std::cerr << "Cannot open file_list.tmp" << std::endl;
-  }
-
-  std::string keyset_name(file_name_prefix + ".keyset");
-  if (FILELIST_LENGTH > 0) {
-    keyset_name = file_name_prefix + "." + std::to_string(file_counter) + ".keyset";
-  }
-  std::ofstream keyset_file(keyset_name, std::ofstream::binary);
-  DataWriter<Check_t::None> keyset_writer(keyset_file);
-
-  do {
-    std::string data_file_name(data_prefix + std::to_string(file_counter) + ".data");
-    std::ofstream data_file(data_file_name, std::ofstream::binary);
-    file_list_tmp << (data_file_name + "\n");
-    std::cout << data_file_name << std::endl;
-    if (!data_file.is_open()) {
-      std::cerr << "Cannot open data_file" << std::endl;
-    }
-
-    DataWriter<Check_t::Sum> data_writer(data_file);
-    DataSetHeader header = {
-        1, static_cast<long long>(N), label_dim, dense_dim, static_cast<long long>(SLOT_NUM), 0, 0,
-        0};
-    data_writer.append(reinterpret_cast<char *>(&header), sizeof(DataSetHeader));
-    data_writer.write();
-    // read N lines
-    int i = 0;
-    for (; i < N; i++) {
-      // read a line
-      std::string line;
-      std::getline(txt_file, line);
-      // if end
-      if (txt_file.eof()) {
-        txt_file.close();
-        if (i == 0 && keyset.size() == 0) {
-          return 0;
-        }
-        data_file.seekp(std::ios_base::beg);
-        DataSetHeader last_header = {1,
-                                     static_cast<long long>(i),
-                                     label_dim,
-                                     dense_dim,
-                                     static_cast<long long>(SLOT_NUM),
-                                     0,
-                                     0,
-                                     0};
-        data_writer.append(reinterpret_cast<char *>(&last_header), sizeof(DataSetHeader));
-        data_writer.write();
-        data_file.close();
-        std::cout << "last keyset size is:" << keyset.size() << std::endl;
-        keyset_writer.write();
-        keyset_file.close();
-
-        file_list_tmp.close();
-        // redirect
-        {
-          std::ifstream tmp(tmp_file_list_name);
-          if (!tmp.is_open()) {
-            std::cerr << "Cannot open " << tmp_file_list_name << std::endl;
-          }
-
-          std::cout << "Opening " << argv[3] << std::endl;
-          // std::ofstream file_list(argv[3], std::ofstream::out);
-
-          std::string file_list_name = file_name;
-
-          if (FILELIST_LENGTH > 0) {
-            file_list_name = file_name_prefix + "." +
-                             std::to_string((file_counter / FILELIST_LENGTH)) + file_name_postfix;
-          }
-
-          std::ofstream file_list(file_list_name, std::ofstream::out);
-
-          if (!file_list.is_open()) {
-            std::cerr << "Cannot open " << argv[3] << std::endl;
-          }
-
-          // file_list << (std::to_string(file_counter + 1) + "\n");
-          if (i != 0) {
-            file_counter++;
-          }
-          if (FILELIST_LENGTH == 0) {
-            file_list << (std::to_string(file_counter) + "\n");
-          } else if (file_counter % FILELIST_LENGTH != 0 && FILELIST_LENGTH != 1) {
-            file_list << (std::to_string(file_counter % FILELIST_LENGTH) + "\n");
-          } else {
-            file_list << (std::to_string(FILELIST_LENGTH) + "\n");
-          }
-
-          file_list << tmp.rdbuf();
-
-          tmp.close();
-          file_list.close();
-        }
-
-        return 0;
-      }
-      std::vector<std::string> vec_string;
-      split(line, ' ', vec_string);
-      if (vec_string.size() != (unsigned int)(KEYS_WIDE_MODEL + KEYS_DENSE_MODEL + dense_dim +
-                                              label_dim))  // first one is label
+  // a reader thread splits in.txt into the lines of each data file, the workers parse and write
+  // the data files, and the distinct keys of the files are merged here in the order of the files
+  std::vector<FileTask> tasks(2 * NUM_THREADS);
+  std::mutex mutex;
+  std::condition_variable cv;
+  long long num_files = std::numeric_limits<long long>::max();  // known at the end of in.txt
+  long long next_parse = 0;
+  auto get_data_file_name = [&](long long file_id) {
+    return data_prefix + std::to_string(file_id) + ".data";
+  };
+
+  std::thread reader([&]() {
+    LineReader line_reader(txt_file);
+    for (long long file_id = 0;; file_id++) {
+      FileTask &task = tasks[file_id % tasks.size()];
       {
-        std::cerr << "vec_string.size() != KEYS_WIDE_MODEL+KEYS_DENSE_MODEL+dense_dim+label_dim"
-                  << std::endl;
-        std::cerr << line << std::endl;
-        exit(-1);
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return task.state == FileTask::State::Free; });
       }
-#ifndef NDEBUG
-      std::cout << std::endl;
-#endif
-      for (int j = 0; j < dense_dim + label_dim; j++) {
-        float label_dense = std::stod(vec_string[j]);
-        data_writer.append(reinterpret_cast<char *>(&label_dense), sizeof(float));
-#ifndef NDEBUG
-        std::cout << label_dense << ' ';
-#endif
+      task.num_lines = line_reader.read_lines(N, &task.text);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (task.num_lines == 0) {
+        num_files = file_id;
+        cv.notify_all();
+        return;
       }
-
-      if (KEYS_WIDE_MODEL != 0) {
-        data_writer.append(reinterpret_cast<char *>(&KEYS_WIDE_MODEL), sizeof(int));
-        for (int j = dense_dim + label_dim; j < KEYS_WIDE_MODEL + dense_dim + label_dim; j++) {
-          T key = static_cast<T>(std::stoll(vec_string[j]));
-          data_writer.append(reinterpret_cast<char *>(&key), sizeof(T));
-          if (keyset.find(key) == keyset.end()) {
-            keyset.insert(key);
-            keyset_writer.append(reinterpret_cast<char *>(&key), sizeof(T));
+      task.file_id = file_id;
+      task.state = FileTask::State::Read;
+      cv.notify_all();
+    }
+  });
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < NUM_THREADS; i++) {
+    workers.emplace_back([&]() {
+      KeySet key_set(1 << 16);
+      std::vector<char> out;
+      std::vector<char> record;
+      for (;;) {
+        FileTask *task;
+        long long file_id;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          file_id = next_parse++;
+          task = &tasks[file_id % tasks.size()];
+          // the slot may still hold the file of the previous round
+          cv.wait(lock, [&]() {
+            return (task->state == FileTask::State::Read && task->file_id == file_id) ||
+                   file_id >= num_files;
+          });
+          if (file_id >= num_files) {
+            return;
           }
-
-#ifndef NDEBUG
-          std::cout << key << ',';
-#endif
         }
+        parse_file(task, get_data_file_name(file_id), &key_set, &out, &record);
+        std::lock_guard<std::mutex> lock(mutex);
+        task->state = FileTask::State::Parsed;
+        cv.notify_all();
       }
-      int nnz = 1;
-      for (int j = KEYS_WIDE_MODEL + dense_dim + label_dim;
-           j < KEYS_WIDE_MODEL + KEYS_DENSE_MODEL + dense_dim + label_dim; j++) {
-        T key = static_cast<T>(std::stoll(vec_string[j]));
-        data_writer.append(reinterpret_cast<char *>(&nnz), sizeof(int));
-        data_writer.append(reinterpret_cast<char *>(&key), sizeof(T));
-        if (keyset.find(key) == keyset.end()) {
-          keyset.insert(key);
-          keyset_writer.append(reinterpret_cast<char *>(&key), sizeof(T));
-        }
-#ifndef NDEBUG
-        std::cout << key << ',';
-#endif
-      }
-      data_writer.write();
+    });
+  }
+
+  // the files of a file list share a keyset file, with the keys in order of first appearance
+  KeySet keyset(1 << 20);
+  std::ofstream keyset_file;
+  std::vector<std::string> group_files;
+  auto close_group = [&](long long group) {
+    std::string file_list_name = file_name;
+    if (FILELIST_LENGTH > 0) {
+      file_list_name = file_name_prefix + "." + std::to_string(group) + file_name_postfix;
     }
-    data_file.close();
-
-    if (FILELIST_LENGTH > 0 && (file_counter + 1) % FILELIST_LENGTH == 0) {
-      int NOFile = (file_counter / FILELIST_LENGTH);
-      file_list_tmp.close();
-      std::ifstream tmp(tmp_file_list_name);
-      if (!tmp.is_open()) {
-        std::cerr << "Cannot open " << tmp_file_list_name << std::endl;
+    std::cout << "Opening " << file_list_name << std::endl;
+    std::ofstream file_list(file_list_name, std::ofstream::out);
+    if (!file_list.is_open()) {
+      std::cerr << "Cannot open " << file_list_name << std::endl;
+    }
+    file_list << (std::to_string(group_files.size()) + "\n");
+    for (const auto &name : group_files) {
+      file_list << (name + "\n");
+    }
+    file_list.close();
+    std::cout << std::to_string(group) << " keyset size is: " << keyset.size() << std::endl;
+    keyset_file.close();
+    keyset.clear();
+    group_files.clear();
+  };
+
+  long long file_id = 0;
+  for (;; file_id++) {
+    FileTask &task = tasks[file_id % tasks.size()];
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&]() {
+        return (task.state == FileTask::State::Parsed && task.file_id == file_id) ||
+               file_id >= num_files;
+      });
+      if (file_id >= num_files) {
+        break;
       }
-
-      std::cout << "Opening " << argv[3] << std::endl;
-
-      std::string file_list_name =
-          file_name_prefix + "." + std::to_string(NOFile) + file_name_postfix;
-
-      std::ofstream file_list(file_list_name, std::ofstream::out);
-      if (!file_list.is_open()) {
-        std::cerr << "Cannot open " << argv[3] << std::endl;
+    }
+    if (!task.error.empty()) {
+      std::cerr << "Cannot parse the line of file " << file_id << ": " << task.error << std::endl;
+      exit(-1);
+    }
+    const long long group = FILELIST_LENGTH > 0 ? file_id / FILELIST_LENGTH : 0;
+    if (group_files.empty()) {
+      std::string keyset_name(file_name_prefix + ".keyset");
+      if (FILELIST_LENGTH > 0) {
+        keyset_name = file_name_prefix + "." + std::to_string(group) + ".keyset";
       }
-
-      file_list << (std::to_string(FILELIST_LENGTH) + "\n");
-      file_list << tmp.rdbuf();
-
-      tmp.close();
-      file_list.close();
-
-      std::cout << std::to_string(NOFile) << " keyset size is: " << keyset.size() << std::endl;
-      keyset.clear();
-      keyset_writer.write();
-      keyset_file.close();
-      keyset_name = file_name_prefix + "." + std::to_string(NOFile + 1) + ".keyset";
       keyset_file.open(keyset_name, std::ofstream::binary);
-      DataWriter<Check_t::None> keyset_writer(keyset_file);
-
-      std::cout << "reopen file_list_tmp" << std::endl;
-      file_list_tmp.open(tmp_file_list_name);
-      if (!file_list_tmp.is_open()) {
-        std::cerr << "Cannot open file_list.tmp during iteration" << std::endl;
+    }
+    for (T key : task.keys) {
+      if (keyset.insert(key)) {
+        keyset_file.write(reinterpret_cast<const char *>(&key), sizeof(T));
       }
     }
-    file_counter++;
-
-#ifndef NDEBUG
-    std::cout << std::endl;
-    if (file_counter > 2) {
-      break;
+    group_files.push_back(get_data_file_name(file_id));
+    std::cout << group_files.back() << std::endl;
+    if (FILELIST_LENGTH > 0 && (file_id + 1) % FILELIST_LENGTH == 0) {
+      close_group(group);
     }
-#endif
-  } while (1);
+    std::lock_guard<std::mutex> lock(mutex);
+    task.state = FileTask::State::Free;
+    cv.notify_all();
+  }
+  if (!group_files.empty()) {
+    close_group(FILELIST_LENGTH > 0 ? file_id / FILELIST_LENGTH : 0);
+  }
 
+  reader.join();
+  for (auto &worker : workers) {
+    worker.join();
+  }
   return 0;
 }
-
@@ -14,12 +14,13 @@
  * limitations under the License.
  */
 
-#include "HugeCTR/include/data_generator.hpp"
+#include "HugeCTR/include/parallel_data_generator.hpp"
 #include <sys/stat.h>
 #include <fstream>
 #include <ios>
 #include <iostream>
 #include <sstream>
+#include <thread>
 #include <vector>
 #include "HugeCTR/include/parser.hpp"
 #include "nlohmann/json.hpp"
@@ -30,15 +31,18 @@
 #endif
 using namespace HugeCTR;
 
-static std::string usage_str_raw = "usage: ./data_generator --config-file your_config.json --distribution <powerlaw | unified> [option: --nnz-array <nnz array in csv: one hot>] [option: --alpha xxx or --longtail <long | medium | short>]";
+static std::string usage_str_raw = "usage: ./data_generator --config-file your_config.json --distribution <powerlaw | unified> [option: --nnz-array <nnz array in csv: one hot>] [option: --alpha xxx or --longtail <long | medium | short>] [option:--threads <number of threads: #cores>] [option:--seed <seed: 0>] [option:--compression <None | LZ4 | Zstd: None>] [option:--samples-per-block <samples: 64KiB of samples>]";
 static std::string usage_str =
-    "usage: ./data_generator --config-file your_config.json --voc-size-array <vocabulary size array in csv> --distribution <powerlaw | unified> [option: --nnz-array <nnz array in csv: one hot>] [option: --alpha xxx or --longtail <long | medium | short>] [option:--data-folder <folder_path: ./>] [option:--files <number of files: 128>] [option:--samples <samples per file: 40960>]";
+    "usage: ./data_generator --config-file your_config.json --voc-size-array <vocabulary size array in csv> --distribution <powerlaw | unified> [option: --nnz-array <nnz array in csv: one hot>] [option: --alpha xxx or --longtail <long | medium | short>] [option:--data-folder <folder_path: ./>] [option:--files <number of files: 128>] [option:--samples <samples per file: 40960>] [option:--threads <number of threads: #cores>] [option:--seed <seed: 0>] [option:--compression <None | LZ4 | Zstd: None>]";
 static int NUM_FILES = 128;
 static int NUM_SAMPLES_PER_FILE = 40960;
 static std::unordered_set<std::string> TAIL_TYPE{"long", "medium", "short"};
 static std::string TAIL{"medium"};
 static bool use_long_tail = false;
 static float alpha = 0.0;
+static int NUM_THREADS = 1;
+static uint64_t SEED = 0;  // the eval data set uses SEED + 1
+static Compression_t COMPRESSION = Compression_t::None;
 
 
 
@@ -84,7 +88,8 @@ static void parse_norm_arguments(const nlohmann::json& j,
                              Check_t& check_type){
 
   const std::map<std::string, Check_t> CHECK_TYPE_MAP = {{"Sum", Check_t::Sum},
-                                                         {"None", Check_t::None}};
+                                                         {"None", Check_t::None},
+                                                         {"CRC32C", Check_t::CRC32C}};
 
   const auto check_str = get_value_from_json<std::string>(j, "check");
   if (!find_item_in_map(check_type, check_str, CHECK_TYPE_MAP)) {
@@ -126,6 +131,30 @@ void parse_raw_arguments(const nlohmann::json& j,
 
 
 
+template <typename T>
+static void generate_norm(Check_t check_type, const std::string& file_list_name,
+                          const std::string& data_prefix, int num_slot,
+                          const std::vector<size_t>& voc_size_array, int label_dim, int dense_dim,
+                          const std::vector<int>& nnz_array, uint64_t seed) {
+  switch (check_type) {
+    case Check_t::Sum:
+      parallel_data_generation_for_norm<T, Check_t::Sum>(
+          file_list_name, data_prefix, NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot, voc_size_array,
+          label_dim, dense_dim, nnz_array, use_long_tail, alpha, seed, NUM_THREADS, COMPRESSION);
+      break;
+    case Check_t::CRC32C:
+      parallel_data_generation_for_norm<T, Check_t::CRC32C>(
+          file_list_name, data_prefix, NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot, voc_size_array,
+          label_dim, dense_dim, nnz_array, use_long_tail, alpha, seed, NUM_THREADS, COMPRESSION);
+      break;
+    default:
+      parallel_data_generation_for_norm<T, Check_t::None>(
+          file_list_name, data_prefix, NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot, voc_size_array,
+          label_dim, dense_dim, nnz_array, use_long_tail, alpha, seed, NUM_THREADS, COMPRESSION);
+      break;
+  }
+}
+
 int main(int argc, char* argv[]) {
   if (ArgParser::has_arg("help", argc, argv)){
     std::cout << "To generate raw format: " << usage_str_raw << std::endl;
@@ -185,6 +214,15 @@ int main(int argc, char* argv[]) {
 
   std::vector<int> nnz_array =  ArgParser::get_arg<std::vector<int>>("nnz-array", argc, argv, std::vector<int>());
 
+  // the data sets only depend on the seed, the files or segments are generated in parallel
+  NUM_THREADS = ArgParser::get_arg<int>(
+      "threads", argc, argv, std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+  SEED = ArgParser::get_arg<size_t>("seed", argc, argv, 0);
+  const auto compression_str = ArgParser::get_arg<std::string>("compression", argc, argv, "None");
+  if (!find_item_in_map(COMPRESSION, compression_str, get_compression_type_map())) {
+    CK_THROW_(Error_t::WrongInput, "Not supported compression: " + compression_str);
+  }
+
   
   switch (format) {
     case DataReaderType_t::Norm: {
@@ -212,38 +250,17 @@ int main(int argc, char* argv[]) {
 
       check_make_dir(data_folder);
 
-      if (check_type == Check_t::Sum) {
-        if (i64_input_key) {  // I64 = long long
-          data_generation_for_test2<long long, Check_t::Sum>(
-              source_data, data_folder + "/train/gen_", NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot,
-              voc_size_array, label_dim, dense_dim, nnz_array, use_long_tail, alpha);
-          data_generation_for_test2<long long, Check_t::Sum>(
-              eval_source, data_folder + "/val/gen_", NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot,
-              voc_size_array, label_dim, dense_dim, nnz_array, use_long_tail, alpha);
-        } else {  // I32 = unsigned int
-          data_generation_for_test2<unsigned int, Check_t::Sum>(
-              source_data, data_folder + "/train/gen_", NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot,
-              voc_size_array, label_dim, dense_dim, nnz_array, use_long_tail, alpha);
-          data_generation_for_test2<unsigned int, Check_t::Sum>(
-              eval_source, data_folder + "/val/gen_", NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot,
-              voc_size_array, label_dim, dense_dim, nnz_array, use_long_tail, alpha);
-        }
-      } else {
-        if (i64_input_key) {  // I64 = long long
-          data_generation_for_test2<long long, Check_t::None>(
-              source_data, data_folder + "/train/gen_", NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot,
-              voc_size_array, label_dim, dense_dim, nnz_array, use_long_tail, alpha);
-          data_generation_for_test2<long long, Check_t::None>(
-              eval_source, data_folder + "/val/gen_", NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot,
-              voc_size_array, label_dim, dense_dim, nnz_array, use_long_tail, alpha);
-        } else {  // I32 = unsigned int
-          data_generation_for_test2<unsigned int, Check_t::None>(
-              source_data, data_folder + "/train/gen_", NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot,
-              voc_size_array, label_dim, dense_dim, nnz_array, use_long_tail, alpha);
-          data_generation_for_test2<unsigned int, Check_t::None>(
-              eval_source, data_folder + "/val/gen_", NUM_FILES, NUM_SAMPLES_PER_FILE, num_slot,
-              voc_size_array, label_dim, dense_dim, nnz_array, use_long_tail, alpha);
-        }
+      if (i64_input_key) {  // I64 = long long
+        generate_norm<long long>(check_type, source_data, data_folder + "/train/gen_", num_slot,
+                                 voc_size_array, label_dim, dense_dim, nnz_array, SEED);
+        generate_norm<long long>(check_type, eval_source, data_folder + "/val/gen_", num_slot,
+                                 voc_size_array, label_dim, dense_dim, nnz_array, SEED + 1);
+      } else {  // I32 = unsigned int
+        generate_norm<unsigned int>(check_type, source_data, data_folder + "/train/gen_",
+                                    num_slot, voc_size_array, label_dim, dense_dim, nnz_array,
+                                    SEED);
+        generate_norm<unsigned int>(check_type, eval_source, data_folder + "/val/gen_", num_slot,
+                                    voc_size_array, label_dim, dense_dim, nnz_array, SEED + 1);
       }
       break;
     }
@@ -299,30 +316,33 @@ int main(int argc, char* argv[]) {
       check_make_dir(eval_dir);
 
 
+      const long long samples_per_block =
+          ArgParser::get_arg<size_t>("samples-per-block", argc, argv, 0);
       if (i64_input_key) {  // I64 = long long
 	// train data
-	data_generation_for_raw<long long>(source_data, num_samples, label_dim, dense_dim,
-					   float_label_dense, slot_size_array, nnz_array,
-					   use_long_tail, alpha, nullptr);
+	parallel_data_generation_for_raw<long long>(source_data, num_samples, label_dim, dense_dim,
+						    float_label_dense, slot_size_array, nnz_array,
+						    use_long_tail, alpha, SEED, NUM_THREADS,
+						    COMPRESSION, samples_per_block);
 	// eval data
-	data_generation_for_raw<long long>(eval_source, eval_num_samples, label_dim, dense_dim,
-					   float_label_dense, slot_size_array, nnz_array,
-					   use_long_tail, alpha, nullptr);
+	parallel_data_generation_for_raw<long long>(eval_source, eval_num_samples, label_dim, dense_dim,
+						    float_label_dense, slot_size_array, nnz_array,
+						    use_long_tail, alpha, SEED + 1, NUM_THREADS,
+						    COMPRESSION, samples_per_block);
       }
       else {
 	// train data
-	data_generation_for_raw<unsigned int>(source_data, num_samples, label_dim, dense_dim,
-					      float_label_dense, slot_size_array, nnz_array,
-					      use_long_tail, alpha, nullptr);
+	parallel_data_generation_for_raw<unsigned int>(source_data, num_samples, label_dim, dense_dim,
+						       float_label_dense, slot_size_array, nnz_array,
+						       use_long_tail, alpha, SEED, NUM_THREADS,
+						       COMPRESSION, samples_per_block);
 	// eval data
-	data_generation_for_raw<unsigned int>(eval_source, eval_num_samples, label_dim, dense_dim,
-					      float_label_dense, slot_size_array, nnz_array,
-					      use_long_tail, alpha, nullptr);
+	parallel_data_generation_for_raw<unsigned int>(eval_source, eval_num_samples, label_dim,
+						       dense_dim, float_label_dense, slot_size_array,
+						       nnz_array, use_long_tail, alpha, SEED + 1,
+						       NUM_THREADS, COMPRESSION, samples_per_block);
       }
 
-
-
-
       break;
     }
     default: {
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Host-only benchmark of flat_embedding_table, the CPU embedding table of the inference parameter
+ * server:
+ *   table: build and look_up time and host memory, against the former
+ *          std::unordered_map<key, std::vector<float>> table,
+ *   mmap:  time to build the key index over a mapped emb_vector file, against the time to load
+ *          the index persisted by dump_index,
+ *   scale: look_up rate of one batch of num-queries keys split across each of look-up-threads.
+ * The keys are unique random keys, miss-ratio of the queries are keys which are not in the table.
+ */
+
+#include <cstring>
+#include <experimental/filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "HugeCTR/include/inference/flat_embedding_table.hpp"
+#include "HugeCTR/include/utils.hpp"
+using namespace HugeCTR;
+namespace fs = std::experimental::filesystem;
+
+static std::string usage_str =
+    "usage: ./embedding_table_benchmark [option: --key-type <I32 | I64 | Both: Both>] [option: "
+    "--num-keys <keys: 2000000>] [option: --vec-sizes <list: 16,64>] [option: --num-queries "
+    "<queries: 4000000>] [option: --miss-ratio <ratio: 0.1>] [option: --build-threads <threads: "
+    "8>] [option: --look-up-threads <list: 1,4,16>] [option: --data-dir <directory: "
+    "./embedding_table_benchmark_data>]";
+
+namespace {
+
+struct Config {
+  size_t num_keys;
+  size_t num_queries;
+  float miss_ratio;
+  size_t build_threads;
+  std::vector<size_t> look_up_threads;
+  std::string data_dir;
+};
+
+constexpr float kDefaultEmbVecValue = 0.5f;
+constexpr double kMiB = 1024.0 * 1024.0;
+
+// Per-key host memory of the std::unordered_map<TypeHashKey, std::vector<float>> table:
+// bucket pointer + node (next pointer, key, vector header) + emb_vec payload + 2 malloc headers
+template <typename TypeHashKey>
+size_t unordered_map_footprint_in_byte(
+    const std::unordered_map<TypeHashKey, std::vector<float>>& map, size_t embedding_vec_size) {
+  const size_t malloc_header = 16;
+  const size_t node_size = sizeof(void*) + sizeof(std::pair<const TypeHashKey, std::vector<float>>);
+  return map.bucket_count() * sizeof(void*) +
+         map.size() * (node_size + embedding_vec_size * sizeof(float) + 2 * malloc_header);
+}
+
+// Unique keys in the lower half of the key range, the upper half is left for the missing keys
+template <typename TypeHashKey>
+std::vector<TypeHashKey> generate_keys(size_t num_keys, std::mt19937_64& gen) {
+  const TypeHashKey max_key = std::numeric_limits<TypeHashKey>::max() / 2;
+  std::uniform_int_distribution<TypeHashKey> key_dist(0, max_key);
+  std::vector<TypeHashKey> keys;
+  keys.reserve(num_keys);
+  std::unordered_map<TypeHashKey, size_t> dedup;
+  while (keys.size() < num_keys) {
+    TypeHashKey key = key_dist(gen);
+    if (dedup.emplace(key, keys.size()).second) {
+      keys.push_back(key);
+    }
+  }
+  return keys;
+}
+
+template <typename TypeHashKey>
+std::vector<TypeHashKey> generate_queries(const std::vector<TypeHashKey>& keys, size_t num_queries,
+                                          float miss_ratio, std::mt19937_64& gen) {
+  const TypeHashKey max_key = std::numeric_limits<TypeHashKey>::max() / 2;
+  std::uniform_int_distribution<size_t> idx_dist(0, keys.size() - 1);
+  std::uniform_real_distribution<float> miss_dist(0.0f, 1.0f);
+  std::vector<TypeHashKey> queries(num_queries);
+  for (auto& query : queries) {
+    query = miss_dist(gen) < miss_ratio ? static_cast<TypeHashKey>(max_key + 1 + idx_dist(gen))
+                                        : keys[idx_dist(gen)];
+  }
+  return queries;
+}
+
+template <typename TypeHashKey>
+void benchmark_table(const Config& config, size_t embedding_vec_size, const std::string& key_type) {
+  std::mt19937_64 gen(0);
+  const auto keys = generate_keys<TypeHashKey>(config.num_keys, gen);
+  std::vector<float> vectors(config.num_keys * embedding_vec_size);
+  std::uniform_real_distribution<float> val_dist(-1.0f, 1.0f);
+  for (auto& val : vectors) {
+    val = val_dist(gen);
+  }
+  const auto queries = generate_queries(keys, config.num_queries, config.miss_ratio, gen);
+  std::vector<float> output(queries.size() * embedding_vec_size);
+  Timer timer;
+
+  timer.start();
+  std::unordered_map<TypeHashKey, std::vector<float>> map_table;
+  map_table.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    map_table.emplace(keys[i], std::vector<float>(vectors.begin() + i * embedding_vec_size,
+                                                  vectors.begin() + (i + 1) * embedding_vec_size));
+  }
+  timer.stop();
+  const double map_build_time = timer.elapsedSeconds();
+  timer.start();
+  for (size_t i = 0; i < queries.size(); i++) {
+    float* dst = output.data() + i * embedding_vec_size;
+    auto result = map_table.find(queries[i]);
+    if (result != map_table.end()) {
+      memcpy(dst, result->second.data(), sizeof(float) * embedding_vec_size);
+    } else {
+      std::vector<float> default_emb_vec(embedding_vec_size, kDefaultEmbVecValue);
+      memcpy(dst, default_emb_vec.data(), sizeof(float) * embedding_vec_size);
+    }
+  }
+  timer.stop();
+  const double map_look_up_time = timer.elapsedSeconds();
+  const size_t map_footprint = unordered_map_footprint_in_byte(map_table, embedding_vec_size);
+  map_table.clear();
+
+  timer.start();
+  flat_embedding_table<TypeHashKey> table(embedding_vec_size, kDefaultEmbVecValue);
+  table.load(keys.data(), keys.size(), std::vector<float>(vectors), config.build_threads);
+  timer.stop();
+  const double build_time = timer.elapsedSeconds();
+  timer.start();
+  table.look_up(queries.data(), queries.size(), output.data());
+  timer.stop();
+  const double look_up_time = timer.elapsedSeconds();
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "table " << key_type << " vec_size " << embedding_vec_size
+            << ": unordered_map build " << map_build_time << "s, look_up "
+            << queries.size() / map_look_up_time / 1e6 << " Mkeys/s, "
+            << map_footprint / kMiB << " MiB (estimated) | flat_embedding_table build "
+            << build_time << "s, look_up " << queries.size() / look_up_time / 1e6 << " Mkeys/s, "
+            << table.memory_footprint_in_byte() / kMiB << " MiB" << std::endl;
+}
+
+template <typename TypeHashKey>
+void benchmark_mmap(const Config& config, size_t embedding_vec_size, const std::string& key_type) {
+  const std::string sparse_model = config.data_dir + "/sparse_model";
+  const std::string key_file = sparse_model + "/key";
+  const std::string vec_file = sparse_model + "/emb_vector";
+  const std::string index_file = sparse_model + "/key_index";
+  fs::remove_all(sparse_model);
+  fs::create_directories(sparse_model);
+
+  std::mt19937_64 gen(0);
+  const auto keys = generate_keys<TypeHashKey>(config.num_keys, gen);
+  const std::vector<long long> i64_keys(keys.begin(), keys.end());
+  {
+    std::vector<float> vectors(config.num_keys * embedding_vec_size);
+    std::uniform_real_distribution<float> val_dist(-1.0f, 1.0f);
+    for (auto& val : vectors) {
+      val = val_dist(gen);
+    }
+    std::ofstream key_stream(key_file, std::ofstream::binary);
+    std::ofstream vec_stream(vec_file, std::ofstream::binary);
+    key_stream.write(reinterpret_cast<const char*>(i64_keys.data()),
+                     i64_keys.size() * sizeof(long long));
+    vec_stream.write(reinterpret_cast<const char*>(vectors.data()),
+                     vectors.size() * sizeof(float));
+  }
+
+  Timer timer;
+  timer.start();
+  flat_embedding_table<TypeHashKey> built_table(embedding_vec_size, kDefaultEmbVecValue);
+  built_table.load_mmap(i64_keys.data(), i64_keys.size(), vec_file, config.build_threads);
+  timer.stop();
+  const double build_time = timer.elapsedSeconds();
+  built_table.dump_index(index_file, key_file);
+
+  timer.start();
+  flat_embedding_table<TypeHashKey> index_table(embedding_vec_size, kDefaultEmbVecValue);
+  if (!index_table.load_mmap_from_index(index_file, vec_file, key_file)) {
+    CK_THROW_(Error_t::BrokenFile, "Cannot load the index just dumped: " + index_file);
+  }
+  timer.stop();
+  const double index_load_time = timer.elapsedSeconds();
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "mmap  " << key_type << " vec_size " << embedding_vec_size << ": build index with "
+            << config.build_threads << " threads " << build_time << "s, load persisted index "
+            << index_load_time << "s, host memory " << index_table.memory_footprint_in_byte() / kMiB
+            << " MiB" << std::endl;
+  fs::remove_all(sparse_model);
+}
+
+template <typename TypeHashKey>
+void benchmark_scaling(const Config& config, size_t embedding_vec_size,
+                       const std::string& key_type) {
+  std::mt19937_64 gen(0);
+  const auto keys = generate_keys<TypeHashKey>(config.num_keys, gen);
+  std::vector<float> vectors(config.num_keys * embedding_vec_size);
+  std::uniform_real_distribution<float> val_dist(-1.0f, 1.0f);
+  for (auto& val : vectors) {
+    val = val_dist(gen);
+  }
+  flat_embedding_table<TypeHashKey> table(embedding_vec_size, kDefaultEmbVecValue);
+  table.load(keys.data(), keys.size(), std::move(vectors), config.build_threads);
+  const auto queries = generate_queries(keys, config.num_queries, config.miss_ratio, gen);
+  std::vector<float> output(queries.size() * embedding_vec_size);
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "scale " << key_type << " vec_size " << embedding_vec_size << ":";
+  Timer timer;
+  for (size_t num_threads : config.look_up_threads) {
+    timer.start();
+    table.look_up(queries.data(), queries.size(), output.data(), num_threads);
+    timer.stop();
+    std::cout << " " << num_threads << " threads " << queries.size() / timer.elapsedSeconds() / 1e6
+              << " Mkeys/s";
+  }
+  std::cout << std::endl;
+}
+
+template <typename TypeHashKey>
+void benchmark(const Config& config, const std::vector<size_t>& vec_sizes,
+               const std::string& key_type) {
+  for (size_t embedding_vec_size : vec_sizes) {
+    benchmark_table<TypeHashKey>(config, embedding_vec_size, key_type);
+    benchmark_mmap<TypeHashKey>(config, embedding_vec_size, key_type);
+    benchmark_scaling<TypeHashKey>(config, embedding_vec_size, key_type);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (ArgParser::has_arg("help", argc, argv)) {
+    std::cout << usage_str << std::endl;
+    exit(-1);
+  }
+  try {
+    auto key_type = ArgParser::get_arg<std::string>("key-type", argc, argv, "Both");
+    auto vec_sizes = ArgParser::get_arg<std::vector<size_t>>("vec-sizes", argc, argv, {16, 64});
+    Config config;
+    config.num_keys = ArgParser::get_arg<size_t>("num-keys", argc, argv, 2000000);
+    config.num_queries = ArgParser::get_arg<size_t>("num-queries", argc, argv, 4000000);
+    config.miss_ratio = ArgParser::get_arg<float>("miss-ratio", argc, argv, 0.1f);
+    config.build_threads = ArgParser::get_arg<size_t>("build-threads", argc, argv, 8);
+    config.look_up_threads =
+        ArgParser::get_arg<std::vector<size_t>>("look-up-threads", argc, argv, {1, 4, 16});
+    config.data_dir =
+        ArgParser::get_arg<std::string>("data-dir", argc, argv, "./embedding_table_benchmark_data");
+
+    if (key_type != "I32" && key_type != "I64" && key_type != "Both") {
+      CK_THROW_(Error_t::WrongInput, "key-type must be {I32, I64 or Both}");
+    }
+    if (config.num_keys == 0 || config.num_queries == 0 || config.build_threads == 0) {
+      CK_THROW_(Error_t::WrongInput, "num-keys, num-queries and build-threads must be > 0");
+    }
+    if (config.miss_ratio < 0.0f || config.miss_ratio > 1.0f) {
+      CK_THROW_(Error_t::WrongInput, "miss-ratio must be in [0, 1]");
+    }
+    if (key_type != "I64") {
+      benchmark<unsigned int>(config, vec_sizes, "I32");
+    }
+    if (key_type != "I32") {
+      benchmark<long long>(config, vec_sizes, "I64");
+    }
+    fs::remove_all(config.data_dir);
+  } catch (const std::runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
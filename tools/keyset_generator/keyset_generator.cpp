@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "HugeCTR/include/model_oversubscriber/keyset_generator.hpp"
+#include "HugeCTR/include/utils.hpp"
+using namespace HugeCTR;
+
+static std::string usage_str =
+    "usage: ./keyset_generator --format <Norm | Raw> --source <file list or file, comma "
+    "separated for several passes> --keyset-prefix <prefix of the keyset files, comma separated "
+    "for several passes> --slot-num <slots of each embedding, comma separated> [option: --check "
+    "<Sum | None | CRC32C: Sum>] [option: --key-type <I32 | I64: I64>] [option: --num-samples "
+    "<samples of a Raw data set>] [option: --label-dim <1>] [option: --dense-dim <13>] [option: "
+    "--threads <hardware threads>] [option: --min-count <1>] [option: --top-k <keys: 0>] [option: "
+    "--counts <0 | 1: 0>]";
+
+static std::vector<std::string> split(const std::string& str) {
+  std::vector<std::string> tokens;
+  std::stringstream ss(str);
+  for (std::string token; std::getline(ss, token, ',');) {
+    if (!token.empty()) {
+      tokens.push_back(token);
+    }
+  }
+  return tokens;
+}
+
+template <typename TypeKey>
+static void generate_keysets(const KeysetGeneratorParams& params,
+                             const std::vector<std::string>& sources,
+                             const std::vector<std::string>& keyset_prefixes) {
+  KeysetGenerator<TypeKey> generator(params);
+  for (size_t pass = 0; pass < sources.size(); pass++) {
+    auto keyset_files = get_keyset_file_names(keyset_prefixes[pass], params.slot_num.size());
+    KeysetStats stats = generator.generate(sources[pass], keyset_files);
+    MESSAGE_(sources[pass] + ": " + std::to_string(stats.samples) + " samples, " +
+             std::to_string(stats.skipped_samples) + " skipped, " +
+             std::to_string(stats.seconds) + " s");
+    for (size_t i = 0; i < keyset_files.size(); i++) {
+      MESSAGE_(keyset_files[i] + ": " + std::to_string(stats.written_keys[i]) + " of " +
+               std::to_string(stats.unique_keys[i]) + " unique keys");
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  if (ArgParser::has_arg("help", argc, argv) || !ArgParser::has_arg("source", argc, argv)) {
+    std::cout << usage_str << std::endl;
+    exit(-1);
+  }
+  try {
+    auto format_str = ArgParser::get_arg<std::string>("format", argc, argv);
+    auto sources = split(ArgParser::get_arg<std::string>("source", argc, argv));
+    auto keyset_prefixes = split(ArgParser::get_arg<std::string>("keyset-prefix", argc, argv));
+    auto check_str = ArgParser::get_arg<std::string>("check", argc, argv, "Sum");
+    auto key_type = ArgParser::get_arg<std::string>("key-type", argc, argv, "I64");
+
+    KeysetGeneratorParams params;
+    params.slot_num = ArgParser::get_arg<std::vector<int>>("slot-num", argc, argv);
+    params.label_dim = ArgParser::get_arg<int>("label-dim", argc, argv, 1);
+    params.dense_dim = ArgParser::get_arg<int>("dense-dim", argc, argv, 13);
+    params.num_threads = ArgParser::get_arg<int>(
+        "threads", argc, argv, std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+    params.min_count = ArgParser::get_arg<size_t>("min-count", argc, argv, 1);
+    params.top_k = ArgParser::get_arg<size_t>("top-k", argc, argv, 0);
+    params.write_counts = ArgParser::get_arg<int>("counts", argc, argv, 0) != 0;
+
+    const std::map<std::string, DataReaderType_t> FORMAT_MAP = {{"Norm", DataReaderType_t::Norm},
+                                                                {"Raw", DataReaderType_t::Raw}};
+    auto format_it = FORMAT_MAP.find(format_str);
+    if (format_it == FORMAT_MAP.end()) {
+      CK_THROW_(Error_t::WrongInput, "Not supported format: " + format_str);
+    }
+    params.format = format_it->second;
+    const std::map<std::string, Check_t> CHECK_TYPE_MAP = {{"Sum", Check_t::Sum},
+                                                           {"None", Check_t::None},
+                                                           {"CRC32C", Check_t::CRC32C}};
+    auto check_it = CHECK_TYPE_MAP.find(check_str);
+    if (check_it == CHECK_TYPE_MAP.end()) {
+      CK_THROW_(Error_t::WrongInput, "Not supported check type: " + check_str);
+    }
+    params.check_type = check_it->second;
+    if (params.format == DataReaderType_t::Raw) {
+      params.num_samples = ArgParser::get_arg<size_t>("num-samples", argc, argv);
+    }
+    if (keyset_prefixes.size() != sources.size()) {
+      CK_THROW_(Error_t::WrongInput, "a keyset prefix per source is needed");
+    }
+    if (key_type == "I64") {
+      generate_keysets<long long>(params, sources, keyset_prefixes);
+    } else if (key_type == "I32") {
+      generate_keysets<unsigned int>(params, sources, keyset_prefixes);
+    } else {
+      CK_THROW_(Error_t::WrongInput, "key_type must be {I64 or I32}");
+    }
+  } catch (const std::runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
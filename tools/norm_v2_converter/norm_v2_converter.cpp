@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include "HugeCTR/include/data_readers/file_list.hpp"
+#include "HugeCTR/include/data_readers/norm_v2.hpp"
+#include "HugeCTR/include/utils.hpp"
+using namespace HugeCTR;
+
+static std::string usage_str =
+    "usage: ./norm_v2_converter --file-list <file list of the Norm data set> --output-file-list "
+    "<file list to write> --check <Sum | None | CRC32C> [option: --input-key-type <I32 | I64: "
+    "I32>] [option: --records-per-block <records: 4096>] [option: --key-range <0 | 1: 1>] [option: "
+    "--compression <None | LZ4 | Zstd: None>]";
+
+int main(int argc, char* argv[]) {
+  if (ArgParser::has_arg("help", argc, argv) || !ArgParser::has_arg("file-list", argc, argv)) {
+    std::cout << usage_str << std::endl;
+    exit(-1);
+  }
+  try {
+    auto file_list_name = ArgParser::get_arg<std::string>("file-list", argc, argv);
+    auto output_file_list_name = ArgParser::get_arg<std::string>("output-file-list", argc, argv);
+    auto check_str = ArgParser::get_arg<std::string>("check", argc, argv);
+    auto key_type = ArgParser::get_arg<std::string>("input-key-type", argc, argv, "I32");
+    const long long records_per_block =
+        ArgParser::get_arg<size_t>("records-per-block", argc, argv, 4096);
+    const bool key_range = ArgParser::get_arg<int>("key-range", argc, argv, 1) != 0;
+    auto compression_str = ArgParser::get_arg<std::string>("compression", argc, argv, "None");
+
+    const std::map<std::string, Check_t> CHECK_TYPE_MAP = {{"Sum", Check_t::Sum},
+                                                           {"None", Check_t::None},
+                                                           {"CRC32C", Check_t::CRC32C}};
+    auto it = CHECK_TYPE_MAP.find(check_str);
+    if (it == CHECK_TYPE_MAP.end()) {
+      CK_THROW_(Error_t::WrongInput, "Not supported check type: " + check_str);
+    }
+    const Check_t check_type = it->second;
+    auto compression_it = get_compression_type_map().find(compression_str);
+    if (compression_it == get_compression_type_map().end()) {
+      CK_THROW_(Error_t::WrongInput, "Not supported compression: " + compression_str);
+    }
+    const Compression_t compression = compression_it->second;
+    if (key_type != "I32" && key_type != "I64") {
+      CK_THROW_(Error_t::WrongInput, "input_key_type must be {I64 or I32}");
+    }
+
+    // the v2 files are written next to the source files
+    FileList file_list(file_list_name);
+    std::vector<std::string> output_files;
+    for (unsigned int id = 0;; id++) {
+      std::string file_name = file_list.get_a_file_with_id(id, false);
+      if (file_name.empty()) {
+        break;
+      }
+      std::string output_file = file_name + ".v2";
+      long long num_blocks =
+          key_type == "I64"
+              ? convert_norm_to_v2<long long>(file_name, output_file, check_type,
+                                              records_per_block, key_range, compression)
+              : convert_norm_to_v2<unsigned int>(file_name, output_file, check_type,
+                                                 records_per_block, key_range, compression);
+      MESSAGE_(output_file + ": " + std::to_string(num_blocks) + " blocks");
+      output_files.push_back(output_file);
+    }
+
+    std::ofstream output_file_list(output_file_list_name, std::ofstream::out);
+    output_file_list << output_files.size() << "\n";
+    for (const auto& output_file : output_files) {
+      output_file_list << output_file << "\n";
+    }
+  } catch (const std::runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
@@ -15,6 +15,9 @@
  */
 
 #include "HugeCTR/include/utils.hpp"
+#include "HugeCTR/include/data_readers/raw_compressed.hpp"
+#include <algorithm>
+#include <memory>
 #include <fstream>
 #include <iostream>
 #include <ios>
@@ -23,7 +26,9 @@
 #include <vector>
 using namespace HugeCTR;
 
-static std::string usage_str = "usage: ./criteo2raw in.txt out.bin"; 
+static std::string usage_str =
+    "usage: ./criteo2raw in.txt out.bin [option: --compression <None | LZ4 | Zstd: None>] "
+    "[option: --samples-per-block <samples: 64KiB of samples>]";
 
 static const int dense_dim = 13;
 static const int label_dim = 1;
@@ -38,7 +43,36 @@ std::vector<std::string> &split(const std::string &s, char delim, std::vector<st
     return elems;
 }
 
+// remove an option and its value from argv, so that the positional arguments stay in place
+static void remove_option(const std::string& option, int& argc, char* argv[]) {
+  for (int i = 1; i + 1 < argc; i++) {
+    if (argv[i] == "--" + option) {
+      std::copy(argv + i + 2, argv + argc, argv + i);
+      argc -= 2;
+      return;
+    }
+  }
+}
+
 int main(int argc, char* argv[]){
+  const int stride = (dense_dim + label_dim) * sizeof(float) + SLOT_NUM * sizeof(int);
+  Compression_t compression = Compression_t::None;
+  long long samples_per_block = 65536 / stride;
+  try {
+    auto compression_str = ArgParser::get_arg<std::string>("compression", argc, argv, "None");
+    auto it = get_compression_type_map().find(compression_str);
+    if (it == get_compression_type_map().end()) {
+      CK_THROW_(Error_t::WrongInput, "Not supported compression: " + compression_str);
+    }
+    compression = it->second;
+    samples_per_block =
+        ArgParser::get_arg<size_t>("samples-per-block", argc, argv, samples_per_block);
+  } catch (const std::runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    exit(-1);
+  }
+  remove_option("compression", argc, argv);
+  remove_option("samples-per-block", argc, argv);
   if (argc != 3){
     std::cout << usage_str << std::endl;
     exit(-1);
@@ -50,14 +84,26 @@ int main(int argc, char* argv[]){
     std::cerr << "Cannot open argv[1]" << std::endl;
   }
 
-  std::ofstream out_file(argv[2], std::ofstream::out);
+  // the compressed layout is written block by block, see raw_compressed.hpp
+  std::unique_ptr<RawCompressedWriter> writer;
+  std::ofstream out_file;
+  if (compression != Compression_t::None) {
+    writer.reset(new RawCompressedWriter(argv[2], stride, samples_per_block, compression));
+  } else {
+    out_file.open(argv[2], std::ofstream::out);
+  }
+  std::vector<char> sample(stride);
   int num_samples = 0;
   do{
     std::string line;
     std::getline(txt_file, line);
     if(txt_file.eof()){
       txt_file.close();
-      out_file.close();
+      if (writer) {
+        writer->close();
+      } else {
+        out_file.close();
+      }
       std::cout << "#samples: " << num_samples << std::endl;
       break;
     }
@@ -67,13 +113,21 @@ int main(int argc, char* argv[]){
       std::cout << "Error: vec_string.size() != dense_dim+label_dim+SLOT_NUM" << std::endl;
       exit(-1);
     }
+    char* ptr = sample.data();
     for(int j = 0; j < dense_dim+label_dim; j++){
       float label_dense = std::stod(vec_string[j]);
-      out_file.write(reinterpret_cast<char*>(&label_dense), sizeof(float));
+      memcpy(ptr, &label_dense, sizeof(float));
+      ptr += sizeof(float);
     }
     for(int j = dense_dim+label_dim; j < dense_dim+label_dim+SLOT_NUM; j++){
       int sparse = std::stod(vec_string[j]);
-      out_file.write(reinterpret_cast<char*>(&sparse), sizeof(int));
+      memcpy(ptr, &sparse, sizeof(int));
+      ptr += sizeof(int);
+    }
+    if (writer) {
+      writer->append(sample.data());
+    } else {
+      out_file.write(sample.data(), stride);
     }
     num_samples++;
   }while(1);
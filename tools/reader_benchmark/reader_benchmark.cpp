@@ -0,0 +1,606 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Host-only throughput benchmark of the Norm and Raw data readers.
+ *
+ * The workers run without a GPU resource, so the batches are parsed into host memory and handed
+ * to a host sink instead of being copied to the device. Each configuration is timed in 3 passes
+ * over the same data set:
+ *   io:    the bytes of the data set are read (Norm) or paged in (Raw) and not decoded,
+ *   parse: the samples are decoded in place without building the CSR buffers,
+ *   full:  the data reader workers read, parse and build the CSR buffers of the batches.
+ * The time of a stage is the difference of the passes, e.g. csr = full - parse.
+ * With --shuffle-buffer-mb, the Norm workers of the full pass draw the samples from a shuffle
+ * buffer, its memory is printed and the time to draw the samples is reported as draw_s, the mean of
+ * the workers.
+ * With --raw-shuffle, the chunks of the Raw data set are shuffled like with data_shuffle, and
+ * --raw-readahead sets the batches per worker that are read ahead (0 turns the readahead off). The
+ * Raw workers log their major page faults when they are destroyed, so with --cold the fault stalls
+ * can be compared with and without the readahead.
+ * The Parquet reader is not covered, its parsing runs on the device in cuDF.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "HugeCTR/include/data_generator.hpp"
+#include "HugeCTR/include/data_readers/data_reader_common.hpp"
+#include "HugeCTR/include/data_readers/data_reader_worker.hpp"
+#include "HugeCTR/include/data_readers/data_reader_worker_raw.hpp"
+#include "HugeCTR/include/utils.hpp"
+using namespace HugeCTR;
+
+static std::string usage_str =
+    "usage: ./reader_benchmark [option: --format <Norm | Raw | Both: Both>] [option: --workers "
+    "<list: 1,2,4,8>] [option: --batch-sizes <list: 1024,16384>] [option: --slots <list: 26>] "
+    "[option: --max-nnz <list: 1,10>] [option: --nnz-dist <list of fixed | uniform | powerlaw: "
+    "fixed,uniform>] [option: --num-samples <samples: 262144>] [option: --num-files <files: 8>] "
+    "[option: --dense-dim <dim: 13>] [option: --check <Sum | None | CRC32C: Sum>] [option: "
+    "--data-dir <directory: ./reader_benchmark_data>] [option: --cold <0 | 1: 0>] [option: "
+    "--shuffle-buffer-mb <MiB: 0>] [option: --shuffle-open-files <files: 4>] [option: "
+    "--raw-shuffle <0 | 1: 0>] [option: --raw-readahead <batches per worker: 2>]";
+
+namespace {
+
+using TypeKey = unsigned int;
+
+constexpr int kLabelDim = 1;
+constexpr TypeKey kVocabularySizePerSlot = 1 << 20;
+constexpr float kPowerLawAlpha = -1.5f;
+constexpr size_t kIOViewSize = 1024 * 1024;
+constexpr size_t kPageSize = 4096;
+// the samples of the Raw data set are chunked like in DataReaderWorkerGroupRaw
+constexpr long long kRawChunkBytes = 64 * 1024;
+
+struct DataSet {
+  std::string format;
+  std::string file_list;  /**< Norm */
+  std::vector<std::string> files;
+  long long num_samples;
+  size_t num_bytes;
+  int slot_num;
+  int max_nnz;
+  std::string nnz_dist;
+};
+
+struct Config {
+  Check_t check_type;
+  int dense_dim;
+  bool cold;
+  ShuffleBufferParam shuffle_buffer; /**< of all the workers, Norm only */
+  bool raw_shuffle;
+  long long raw_readahead_batches; /**< per worker */
+};
+
+struct PassResult {
+  double seconds{0.0};
+  double draw_seconds{0.0}; /**< in the shuffle buffers */
+  long long samples{0};
+  unsigned long long digest{0}; /**< keeps the decoding from being optimized away */
+};
+
+std::vector<std::string> split(const std::string& str) {
+  std::vector<std::string> ret;
+  std::stringstream ss(str);
+  for (std::string item; std::getline(ss, item, ',');) {
+    if (!item.empty()) {
+      ret.push_back(item);
+    }
+  }
+  return ret;
+}
+
+size_t get_file_size(const std::string& file_name) {
+  std::ifstream stream(file_name, std::ifstream::binary | std::ifstream::ate);
+  if (!stream.is_open()) {
+    CK_THROW_(Error_t::FileCannotOpen, "Cannot open " + file_name);
+  }
+  return stream.tellg();
+}
+
+/**
+ * Evict the files from the page cache, so that the next pass reads them from the device.
+ */
+void drop_page_cache(const std::vector<std::string>& files) {
+  for (const auto& file_name : files) {
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+      continue;
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+std::shared_ptr<IDataSimulator<int>> create_nnz_simulator(const std::string& nnz_dist,
+                                                          int max_nnz) {
+  if (nnz_dist == "fixed") {
+    return std::make_shared<IntUniformDataSimulator<int>>(max_nnz, max_nnz);
+  } else if (nnz_dist == "uniform") {
+    return std::make_shared<IntUniformDataSimulator<int>>(1, max_nnz);
+  } else if (nnz_dist == "powerlaw") {
+    return std::make_shared<IntPowerLawDataSimulator<int>>(1, max_nnz, kPowerLawAlpha);
+  }
+  CK_THROW_(Error_t::WrongInput, "Not supported nnz distribution: " + nnz_dist);
+  return nullptr;
+}
+
+template <Check_t CK_T>
+void generate_norm_file(const std::string& file_name, long long num_samples, int dense_dim,
+                        int slot_num, IDataSimulator<int>& nnz_sim) {
+  std::ofstream out_stream(file_name, std::ofstream::binary);
+  DataWriter<CK_T> data_writer(out_stream);
+  DataSetHeader header = {
+      Checker_Traits<CK_T>::ID(), num_samples, kLabelDim, dense_dim, slot_num, 0, 0, 0};
+  data_writer.append(reinterpret_cast<char*>(&header), sizeof(DataSetHeader));
+  data_writer.write();
+
+  std::mt19937 gen(std::random_device{}());
+  std::uniform_real_distribution<float> label_dense_dis(0, 1);
+  std::uniform_int_distribution<TypeKey> key_dis(0, kVocabularySizePerSlot - 1);
+  for (long long i = 0; i < num_samples; i++) {
+    for (int j = 0; j < kLabelDim + dense_dim; j++) {
+      float label_dense = label_dense_dis(gen);
+      data_writer.append(reinterpret_cast<char*>(&label_dense), sizeof(float));
+    }
+    for (int k = 0; k < slot_num; k++) {
+      int nnz = nnz_sim.get_num();
+      data_writer.append(reinterpret_cast<char*>(&nnz), sizeof(int));
+      for (int j = 0; j < nnz; j++) {
+        // the key belongs to the slot k
+        TypeKey key = key_dis(gen) * static_cast<TypeKey>(slot_num) + static_cast<TypeKey>(k);
+        data_writer.append(reinterpret_cast<char*>(&key), sizeof(TypeKey));
+      }
+    }
+    data_writer.write();
+  }
+}
+
+DataSet generate_norm_data_set(const std::string& data_dir, const Config& config,
+                               long long num_samples, int num_files, int slot_num, int max_nnz,
+                               const std::string& nnz_dist) {
+  DataSet data_set{"Norm", data_dir + "/norm_file_list.txt", {}, 0, 0, slot_num, max_nnz,
+                   nnz_dist};
+  auto nnz_sim = create_nnz_simulator(nnz_dist, max_nnz);
+  std::ofstream file_list_stream(data_set.file_list, std::ofstream::out);
+  file_list_stream << num_files << "\n";
+  for (int k = 0; k < num_files; k++) {
+    std::string file_name = data_dir + "/norm" + std::to_string(k) + ".data";
+    const long long file_samples = num_samples / num_files + (k < num_samples % num_files);
+    switch (config.check_type) {
+      case Check_t::Sum:
+        generate_norm_file<Check_t::Sum>(file_name, file_samples, config.dense_dim, slot_num,
+                                         *nnz_sim);
+        break;
+      case Check_t::None:
+        generate_norm_file<Check_t::None>(file_name, file_samples, config.dense_dim, slot_num,
+                                          *nnz_sim);
+        break;
+      case Check_t::CRC32C:
+        generate_norm_file<Check_t::CRC32C>(file_name, file_samples, config.dense_dim, slot_num,
+                                            *nnz_sim);
+        break;
+      default:
+        assert(!"Error: no such Check_t && should never get here!!");
+    }
+    file_list_stream << file_name << "\n";
+    data_set.files.push_back(file_name);
+    data_set.num_samples += file_samples;
+    data_set.num_bytes += get_file_size(file_name);
+  }
+  return data_set;
+}
+
+DataSet generate_raw_data_set(const std::string& data_dir, const Config& config,
+                              long long num_samples, int slot_num) {
+  DataSet data_set{"Raw", "", {data_dir + "/raw.data"}, num_samples, 0, slot_num, 1, "fixed"};
+  data_generation_for_raw<TypeKey>(data_set.files[0], num_samples, kLabelDim, config.dense_dim,
+                                   false,
+                                   std::vector<size_t>(slot_num, kVocabularySizePerSlot));
+  data_set.num_bytes = get_file_size(data_set.files[0]);
+  return data_set;
+}
+
+std::shared_ptr<Checker> create_checker(Check_t check_type, Source& source) {
+  switch (check_type) {
+    case Check_t::Sum:
+      return std::make_shared<CheckSum>(source);
+    case Check_t::None:
+      return std::make_shared<CheckNone>(source);
+    case Check_t::CRC32C:
+      return std::make_shared<CheckCRC32C>(source);
+    default:
+      CK_THROW_(Error_t::WrongInput, "Not supported check type");
+  }
+  return nullptr;
+}
+
+/**
+ * Run func(worker_id) on num_workers threads.
+ */
+template <typename Func>
+PassResult run_pass(int num_workers, Func func) {
+  std::vector<PassResult> results(num_workers);
+  std::vector<std::thread> threads;
+  Timer timer;
+  timer.start();
+  for (int i = 0; i < num_workers; i++) {
+    threads.emplace_back([&results, &func, i]() { results[i] = func(i); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  timer.stop();
+  PassResult result;
+  result.seconds = timer.elapsedSeconds();
+  for (const auto& worker_result : results) {
+    result.draw_seconds += worker_result.draw_seconds / num_workers;
+    result.samples += worker_result.samples;
+    result.digest += worker_result.digest;
+  }
+  return result;
+}
+
+PassResult norm_io(const DataSet& data_set, int worker_id, int num_workers) {
+  PassResult result;
+  FileSource source(worker_id, num_workers, data_set.file_list, false);
+  while (source.next_source() == Error_t::Success) {
+    const char* ptr = nullptr;
+    while (source.read_view(&ptr, kIOViewSize) == Error_t::Success) {
+      result.digest += ptr[0];
+    }
+  }
+  return result;
+}
+
+PassResult norm_parse(const DataSet& data_set, const Config& config, int worker_id,
+                      int num_workers) {
+  PassResult result;
+  FileSource source(worker_id, num_workers, data_set.file_list, false);
+  auto checker = create_checker(config.check_type, source);
+  const size_t label_dense_length = sizeof(float) * (kLabelDim + config.dense_dim);
+  auto read_view = [&checker](size_t bytes_to_read) {
+    const char* ptr = nullptr;
+    Error_t err = checker->read_view(&ptr, bytes_to_read);
+    CK_THROW_(err, "failure in parsing the data set");
+    return ptr;
+  };
+  while (checker->next_source() == Error_t::Success) {
+    DataSetHeader header;
+    Error_t err = checker->read(reinterpret_cast<char*>(&header), sizeof(DataSetHeader));
+    CK_THROW_(err, "failure in reading the header");
+    for (long long i = 0; i < header.number_of_records; i++) {
+      const float* label_dense = reinterpret_cast<const float*>(read_view(label_dense_length));
+      result.digest += static_cast<unsigned long long>(label_dense[0] * 1024);
+      for (int k = 0; k < header.slot_num; k++) {
+        int nnz;
+        memcpy(&nnz, read_view(sizeof(int)), sizeof(int));
+        const char* keys = read_view(sizeof(TypeKey) * nnz);
+        for (int j = 0; j < nnz; j++) {
+          TypeKey key;
+          memcpy(&key, keys + sizeof(TypeKey) * j, sizeof(TypeKey));
+          result.digest += key;
+        }
+      }
+    }
+    result.samples += header.number_of_records;
+  }
+  return result;
+}
+
+std::shared_ptr<MmapOffsetList> create_raw_offset_list(const DataSet& data_set,
+                                                       const Config& config, long long batch_size,
+                                                       int num_workers) {
+  const long long stride = data_set.slot_num * sizeof(int) + (kLabelDim + config.dense_dim) * sizeof(int);
+  return std::make_shared<MmapOffsetList>(
+      data_set.files[0], data_set.num_samples, stride, batch_size, config.raw_shuffle, num_workers,
+      false, std::max(kRawChunkBytes / stride, 1ll), 0, config.raw_readahead_batches * num_workers);
+}
+
+/**
+ * Walk the samples of the batches of a worker, with decode(sample) or, when decode is null,
+ * touching each page of them once.
+ */
+template <typename Decode>
+PassResult raw_walk(const std::shared_ptr<MmapOffsetList>& offset_list, const DataSet& data_set,
+                    const Config& config, int worker_id, Decode decode) {
+  PassResult result;
+  MmapSource source(offset_list, worker_id);
+  const size_t stride = data_set.slot_num * sizeof(int) + (kLabelDim + config.dense_dim) * sizeof(int);
+  while (source.next_source() == Error_t::Success) {
+    for (const MmapChunk& chunk : source.get_chunks()) {
+      decode(chunk.offset, chunk.samples * stride, &result);
+    }
+    result.samples += source.get_num_of_items_in_source();
+  }
+  return result;
+}
+
+PassResult raw_io(const std::shared_ptr<MmapOffsetList>& offset_list, const DataSet& data_set,
+                  const Config& config, int worker_id) {
+  return raw_walk(offset_list, data_set, config, worker_id,
+                  [](const char* ptr, size_t length, PassResult* result) {
+                    for (size_t i = 0; i < length; i += kPageSize) {
+                      result->digest += ptr[i];
+                    }
+                  });
+}
+
+PassResult raw_parse(const std::shared_ptr<MmapOffsetList>& offset_list, const DataSet& data_set,
+                     const Config& config, int worker_id) {
+  const int label_dense_dim = kLabelDim + config.dense_dim;
+  const int slot_num = data_set.slot_num;
+  return raw_walk(offset_list, data_set, config, worker_id,
+                  [label_dense_dim, slot_num](const char* ptr, size_t length, PassResult* result) {
+                    const size_t stride = (label_dense_dim + slot_num) * sizeof(int);
+                    for (const char* sample = ptr; sample < ptr + length; sample += stride) {
+                      const int* label_dense = reinterpret_cast<const int*>(sample);
+                      float dense = 0.f;
+                      for (int j = kLabelDim; j < label_dense_dim; j++) {
+                        dense += log(label_dense[j] + 1.f);
+                      }
+                      result->digest += label_dense[0] + static_cast<unsigned long long>(dense);
+                      const int* feature_ids = label_dense + label_dense_dim;
+                      for (int k = 0; k < slot_num; k++) {
+                        result->digest += feature_ids[k];
+                      }
+                    }
+                  });
+}
+
+/**
+ * Drain the batches of a worker: the host sink takes the place of the collector, it hands each
+ * batch back as soon as it is ready and releases the worker at the end of the data set.
+ */
+long long drain_worker(const std::shared_ptr<IDataReaderWorker>& worker,
+                       const std::shared_ptr<ThreadBuffer>& buffer) {
+  std::atomic<bool> done{false};
+  std::thread reader([&worker, &done]() {
+    while (!done.load()) {
+      worker->read_a_batch();
+    }
+  });
+  long long samples = 0;
+  while (true) {
+    buffer->state.wait_for(BufferState::ReadyForRead, []() { return false; });
+    samples += buffer->current_batch_size;
+    if (buffer->current_batch_size == 0) {
+      // the empty batch is followed by FileEOF
+      buffer->state.store(BufferState::ReadyForWrite);
+      buffer->state.wait_for(BufferState::FileEOF, []() { return false; });
+      done.store(true);
+      buffer->state.store(BufferState::ReadyForWrite);
+      break;
+    }
+    buffer->state.store(BufferState::ReadyForWrite);
+  }
+  reader.join();
+  return samples;
+}
+
+std::shared_ptr<ThreadBuffer> create_host_sink_buffer(const Config& config, int batch_size,
+                                                      const DataReaderSparseParam& param) {
+  auto buffer = std::make_shared<ThreadBuffer>();
+  buffer->is_fixed_length.push_back(param.is_fixed_length);
+  buffer->state.store(BufferState::ReadyForWrite);
+  buffer->current_batch_size = 0;
+  buffer->batch_size = batch_size;
+  buffer->param_num = 1;
+  buffer->label_dim = kLabelDim;
+  buffer->dense_dim = config.dense_dim;
+  buffer->batch_size_start_idx = 0;
+  buffer->batch_size_end_idx = batch_size;
+  return buffer;
+}
+
+PassResult run_workers(const DataSet& data_set, const Config& config, int batch_size,
+                       int num_workers) {
+  const DataReaderSparseParam param("data", data_set.max_nnz, data_set.nnz_dist == "fixed",
+                                    data_set.slot_num);
+  std::shared_ptr<MmapOffsetList> offset_list;
+  if (data_set.format == "Raw") {
+    offset_list = create_raw_offset_list(data_set, config, batch_size, num_workers);
+  }
+  ShuffleBufferParam shuffle_buffer = config.shuffle_buffer;
+  shuffle_buffer.memory_bytes /= num_workers;
+  int loop_flag = 1;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::vector<std::shared_ptr<IDataReaderWorker>> workers;
+  for (int i = 0; i < num_workers; i++) {
+    buffers.push_back(create_host_sink_buffer(config, batch_size, param));
+    if (data_set.format == "Raw") {
+      workers.emplace_back(new DataReaderWorkerRaw<TypeKey>(
+          i, num_workers, nullptr, &loop_flag, buffers[i], offset_list, false, {param}, false));
+    } else {
+      workers.emplace_back(new DataReaderWorker<TypeKey>(
+          i, num_workers, nullptr, &loop_flag, buffers[i], data_set.file_list,
+          param.max_feature_num, false, config.check_type, {param}, nullptr, shuffle_buffer));
+    }
+  }
+  return run_pass(num_workers, [&workers, &buffers](int i) {
+    PassResult result;
+    result.samples = drain_worker(workers[i], buffers[i]);
+    auto norm_worker = std::dynamic_pointer_cast<DataReaderWorker<TypeKey>>(workers[i]);
+    if (norm_worker) {
+      result.draw_seconds = norm_worker->get_shuffle_buffer_stats().draw_seconds;
+    }
+    return result;
+  });
+}
+
+void benchmark(const DataSet& data_set, const Config& config, const std::vector<int>& batch_sizes,
+               const std::vector<int>& workers) {
+  for (int batch_size : batch_sizes) {
+    for (int num_workers : workers) {
+      auto timed = [&data_set, &config](std::function<PassResult()> pass) {
+        if (config.cold) {
+          drop_page_cache(data_set.files);
+        }
+        return pass();
+      };
+      PassResult io, parse, full;
+      if (data_set.format == "Raw") {
+        io = timed([&]() {
+          auto offset_list = create_raw_offset_list(data_set, config, batch_size, num_workers);
+          return run_pass(num_workers, [&](int i) {
+            return raw_io(offset_list, data_set, config, i);
+          });
+        });
+        parse = timed([&]() {
+          auto offset_list = create_raw_offset_list(data_set, config, batch_size, num_workers);
+          return run_pass(num_workers, [&](int i) {
+            return raw_parse(offset_list, data_set, config, i);
+          });
+        });
+      } else {
+        io = timed([&]() {
+          return run_pass(num_workers,
+                          [&](int i) { return norm_io(data_set, i, num_workers); });
+        });
+        parse = timed([&]() {
+          return run_pass(num_workers,
+                          [&](int i) { return norm_parse(data_set, config, i, num_workers); });
+        });
+      }
+      full = timed([&]() { return run_workers(data_set, config, batch_size, num_workers); });
+
+      if (parse.samples != data_set.num_samples) {
+        CK_THROW_(Error_t::DataCheckError,
+                  "parsed " + std::to_string(parse.samples) + " samples of " +
+                      std::to_string(data_set.num_samples));
+      }
+      std::cout << std::left << std::setw(6) << data_set.format << std::right << std::setw(8)
+                << num_workers << std::setw(8) << batch_size << std::setw(7) << data_set.slot_num
+                << std::setw(8) << data_set.max_nnz << std::setw(10) << data_set.nnz_dist
+                << std::fixed << std::setprecision(0) << std::setw(14)
+                << data_set.num_samples / full.seconds << std::setprecision(1) << std::setw(10)
+                << data_set.num_bytes / full.seconds / (1024 * 1024) << std::setprecision(3)
+                << std::setw(9) << io.seconds << std::setw(9)
+                << std::max(parse.seconds - io.seconds, 0.0) << std::setw(9)
+                << std::max(full.seconds - parse.seconds, 0.0) << std::setw(9)
+                << full.draw_seconds << std::setw(9) << full.seconds << std::endl;
+    }
+  }
+}
+
+void print_table_header() {
+  std::cout << std::left << std::setw(6) << "format" << std::right << std::setw(8) << "workers"
+            << std::setw(8) << "batch" << std::setw(7) << "slots" << std::setw(8) << "max_nnz"
+            << std::setw(10) << "nnz_dist" << std::setw(14) << "samples/s" << std::setw(10)
+            << "MB/s" << std::setw(9) << "io_s" << std::setw(9) << "parse_s" << std::setw(9)
+            << "csr_s" << std::setw(9) << "draw_s" << std::setw(9) << "total_s" << std::endl;
+}
+
+void remove_data_set(const DataSet& data_set) {
+  for (const auto& file_name : data_set.files) {
+    std::remove(file_name.c_str());
+  }
+  if (!data_set.file_list.empty()) {
+    std::remove(data_set.file_list.c_str());
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (ArgParser::has_arg("help", argc, argv)) {
+    std::cout << usage_str << std::endl;
+    exit(-1);
+  }
+  try {
+    auto format = ArgParser::get_arg<std::string>("format", argc, argv, "Both");
+    auto workers = ArgParser::get_arg<std::vector<int>>("workers", argc, argv, {1, 2, 4, 8});
+    auto batch_sizes =
+        ArgParser::get_arg<std::vector<int>>("batch-sizes", argc, argv, {1024, 16384});
+    auto slots = ArgParser::get_arg<std::vector<int>>("slots", argc, argv, {26});
+    auto max_nnzs = ArgParser::get_arg<std::vector<int>>("max-nnz", argc, argv, {1, 10});
+    auto nnz_dists = split(ArgParser::get_arg<std::string>("nnz-dist", argc, argv, "fixed,uniform"));
+    const long long num_samples = ArgParser::get_arg<size_t>("num-samples", argc, argv, 262144);
+    const int num_files = ArgParser::get_arg<int>("num-files", argc, argv, 8);
+    auto check_str = ArgParser::get_arg<std::string>("check", argc, argv, "Sum");
+    auto data_dir =
+        ArgParser::get_arg<std::string>("data-dir", argc, argv, "./reader_benchmark_data");
+
+    const std::map<std::string, Check_t> CHECK_TYPE_MAP = {{"Sum", Check_t::Sum},
+                                                           {"None", Check_t::None},
+                                                           {"CRC32C", Check_t::CRC32C}};
+    auto it = CHECK_TYPE_MAP.find(check_str);
+    if (it == CHECK_TYPE_MAP.end()) {
+      CK_THROW_(Error_t::WrongInput, "Not supported check type: " + check_str);
+    }
+    if (format != "Norm" && format != "Raw" && format != "Both") {
+      CK_THROW_(Error_t::WrongInput, "format must be {Norm, Raw or Both}");
+    }
+    if (num_samples <= 0 || num_files <= 0) {
+      CK_THROW_(Error_t::WrongInput, "num-samples and num-files must be > 0");
+    }
+    Config config;
+    config.check_type = it->second;
+    config.dense_dim = ArgParser::get_arg<int>("dense-dim", argc, argv, 13);
+    config.cold = ArgParser::get_arg<int>("cold", argc, argv, 0) != 0;
+    config.shuffle_buffer.memory_bytes =
+        ArgParser::get_arg<size_t>("shuffle-buffer-mb", argc, argv, 0) << 20;
+    config.shuffle_buffer.num_open_files =
+        ArgParser::get_arg<int>("shuffle-open-files", argc, argv, 4);
+    config.raw_shuffle = ArgParser::get_arg<int>("raw-shuffle", argc, argv, 0) != 0;
+    config.raw_readahead_batches = ArgParser::get_arg<int>("raw-readahead", argc, argv, 2);
+    if (config.raw_readahead_batches < 0) {
+      CK_THROW_(Error_t::WrongInput, "raw-readahead must be >= 0");
+    }
+    check_make_dir(data_dir);
+
+    if (config.shuffle_buffer.enabled()) {
+      std::cout << "shuffle buffer: " << (config.shuffle_buffer.memory_bytes >> 20)
+                << " MiB in all the workers, " << config.shuffle_buffer.num_open_files
+                << " open files per worker" << std::endl;
+    }
+    print_table_header();
+    for (int slot_num : slots) {
+      if (format != "Raw") {
+        for (const auto& nnz_dist : nnz_dists) {
+          for (int max_nnz : max_nnzs) {
+            DataSet data_set = generate_norm_data_set(data_dir, config, num_samples, num_files,
+                                                      slot_num, max_nnz, nnz_dist);
+            benchmark(data_set, config, batch_sizes, workers);
+            remove_data_set(data_set);
+          }
+        }
+      }
+      // a Raw sample has one key per slot
+      if (format != "Norm") {
+        DataSet data_set = generate_raw_data_set(data_dir, config, num_samples, slot_num);
+        benchmark(data_set, config, batch_sizes, workers);
+        remove_data_set(data_set);
+      }
+    }
+  } catch (const std::runtime_error& rt_err) {
+    std::cerr << rt_err.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}